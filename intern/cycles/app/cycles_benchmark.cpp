@@ -0,0 +1,746 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+/* Benchmark
+ *
+ * Renders a fixed set of procedurally generated XML scenes on the CPU device, and reports the
+ * scene update statistics and the number of samples rendered per second as JSON. Scenes are
+ * generated from a fixed seed, so reports of different builds on the same hardware can be
+ * compared directly. */
+
+#include <stdio.h>
+
+#include "device/device.h"
+#include "scene/camera.h"
+#include "scene/film.h"
+#include "scene/pass.h"
+#include "scene/scene.h"
+#include "scene/stats.h"
+#include "session/buffers.h"
+#include "session/session.h"
+
+#include "util/args.h"
+#include "util/foreach.h"
+#include "util/log.h"
+#include "util/path.h"
+#include "util/progress.h"
+#include "util/string.h"
+#include "util/time.h"
+#include "util/version.h"
+
+#include "app/cycles_xml.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Procedural Scenes */
+
+namespace {
+
+/* Deterministic random numbers, so every build renders exactly the same scenes. */
+class BenchmarkRandom {
+ public:
+  float next()
+  {
+    state = state * 1103515245u + 12345u;
+    return float((state >> 8) & 0xffffff) / float(0x1000000);
+  }
+
+  float next(const float min, const float max)
+  {
+    return min + (max - min) * next();
+  }
+
+ protected:
+  uint state = 1;
+};
+
+void xml_float3(string &xml, const float x, const float y, const float z)
+{
+  xml += string_printf("%g %g %g ", x, y, z);
+}
+
+void xml_begin(string &xml, const int width, const int height, const bool use_adaptive_sampling)
+{
+  xml += "<cycles>\n";
+  xml += string_printf(
+      "<transform translate=\"0 0 -5\">\n"
+      "  <camera width=\"%d\" height=\"%d\" />\n"
+      "</transform>\n",
+      width,
+      height);
+  xml += string_printf(
+      "<integrator use_adaptive_sampling=\"%s\" adaptive_threshold=\"0.02\" />\n",
+      (use_adaptive_sampling) ? "true" : "false");
+  xml +=
+      "<background>\n"
+      "  <background name=\"bg\" color=\"0.6 0.7 0.9\" strength=\"0.5\" />\n"
+      "  <connect from=\"bg background\" to=\"output surface\" />\n"
+      "</background>\n";
+}
+
+void xml_end(string &xml)
+{
+  xml += "</cycles>\n";
+}
+
+/* Grid of size x size quads in the XY plane facing the camera, with random displacement. */
+void xml_grid_mesh(string &xml, const int size, const float extent, const float displacement)
+{
+  BenchmarkRandom rng;
+
+  xml += "<mesh P=\"";
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      const float u = (float(x) / size - 0.5f) * extent;
+      const float v = (float(y) / size - 0.5f) * extent;
+      xml_float3(xml, u, v, rng.next(0.0f, displacement));
+    }
+  }
+
+  xml += "\" nverts=\"";
+  for (int i = 0; i < size * size; i++) {
+    xml += "4 ";
+  }
+
+  xml += "\" verts=\"";
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int v = y * (size + 1) + x;
+      xml += string_printf("%d %d %d %d ", v, v + 1, v + size + 2, v + size + 1);
+    }
+  }
+  xml += "\" />\n";
+}
+
+void xml_cube_mesh(string &xml, const float size)
+{
+  const float s = size * 0.5f;
+
+  xml += "<mesh P=\"";
+  for (int i = 0; i < 8; i++) {
+    xml_float3(xml, (i & 1) ? s : -s, (i & 2) ? s : -s, (i & 4) ? s : -s);
+  }
+  xml +=
+      "\" nverts=\"4 4 4 4 4 4\" "
+      "verts=\"0 2 3 1  4 5 7 6  0 1 5 4  2 6 7 3  0 4 6 2  1 3 7 5\" />\n";
+}
+
+void xml_diffuse_shader(string &xml, const char *name, const char *color)
+{
+  xml += string_printf(
+      "<shader name=\"%s\">\n"
+      "  <diffuse_bsdf name=\"bsdf\" color=\"%s\" />\n"
+      "  <connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+      "</shader>\n",
+      name,
+      color);
+}
+
+/* Large displaced grid, most of the time goes into building the BVH. */
+string scene_bvh_build(const int width, const int height)
+{
+  string xml;
+  xml_begin(xml, width, height, false);
+  xml_diffuse_shader(xml, "diffuse", "0.8 0.8 0.8");
+  xml += "<state shader=\"diffuse\">\n";
+  xml_grid_mesh(xml, 1024, 6.0f, 0.5f);
+  xml += "</state>\n";
+  xml_end(xml);
+  return xml;
+}
+
+/* Long chain of procedural textures feeding a principled BSDF and bump. */
+string scene_svm_shading(const int width, const int height)
+{
+  string xml;
+  xml_begin(xml, width, height, false);
+  xml +=
+      "<shader name=\"procedural\">\n"
+      "  <texture_coordinate name=\"coord\" />\n"
+      "  <noise_texture name=\"noise\" scale=\"6\" detail=\"15\" />\n"
+      "  <voronoi_texture name=\"voronoi\" scale=\"12\" />\n"
+      "  <wave_texture name=\"wave\" scale=\"3\" distortion=\"4\" detail=\"10\" />\n"
+      "  <noise_texture name=\"noise_rough\" scale=\"20\" detail=\"15\" />\n"
+      "  <mix_color name=\"mix\" fac=\"0.5\" />\n"
+      "  <mix_color name=\"mix2\" fac=\"0.3\" />\n"
+      "  <bump name=\"bump\" strength=\"0.5\" />\n"
+      "  <principled_bsdf name=\"bsdf\" metallic=\"0.3\" />\n"
+      "  <connect from=\"coord generated\" to=\"noise vector\" />\n"
+      "  <connect from=\"noise color\" to=\"voronoi vector\" />\n"
+      "  <connect from=\"coord object\" to=\"wave vector\" />\n"
+      "  <connect from=\"noise color\" to=\"mix a\" />\n"
+      "  <connect from=\"voronoi color\" to=\"mix b\" />\n"
+      "  <connect from=\"mix result\" to=\"mix2 a\" />\n"
+      "  <connect from=\"wave color\" to=\"mix2 b\" />\n"
+      "  <connect from=\"mix2 result\" to=\"bsdf base_color\" />\n"
+      "  <connect from=\"noise_rough fac\" to=\"bsdf roughness\" />\n"
+      "  <connect from=\"voronoi distance\" to=\"bump height\" />\n"
+      "  <connect from=\"bump normal\" to=\"bsdf normal\" />\n"
+      "  <connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+      "</shader>\n";
+  xml += "<state shader=\"procedural\">\n";
+  xml_grid_mesh(xml, 64, 6.0f, 0.2f);
+  xml += "</state>\n";
+  xml_end(xml);
+  return xml;
+}
+
+/* Rotated texture mapping and a chain of math nodes, as commonly found in procedural
+ * materials. */
+string scene_svm_math(const int width, const int height)
+{
+  const char *math_types[] = {"multiply", "sine", "add", "fraction", "power", "multiply"};
+  const int num_math = sizeof(math_types) / sizeof(*math_types);
+
+  string xml;
+  xml_begin(xml, width, height, false);
+  xml +=
+      "<shader name=\"procedural\">\n"
+      "  <texture_coordinate name=\"coord\" />\n"
+      "  <mapping name=\"mapping\" mapping_type=\"point\" location=\"0.1 0.2 0.3\" "
+      "rotation=\"0.3 0.6 0.9\" scale=\"4 4 4\" />\n"
+      "  <noise_texture name=\"noise\" detail=\"2\" />\n"
+      "  <principled_bsdf name=\"bsdf\" />\n"
+      "  <connect from=\"coord object\" to=\"mapping vector\" />\n"
+      "  <connect from=\"mapping vector\" to=\"noise vector\" />\n"
+      "  <connect from=\"noise color\" to=\"bsdf base_color\" />\n";
+  for (int i = 0; i < num_math; i++) {
+    xml += string_printf(
+        "  <math name=\"math%d\" math_type=\"%s\" value2=\"1.5\" />\n", i, math_types[i]);
+    xml += string_printf("  <connect from=\"%s\" to=\"math%d value1\" />\n",
+                         (i == 0) ? "noise fac" : string_printf("math%d value", i - 1).c_str(),
+                         i);
+  }
+  xml += string_printf("  <connect from=\"math%d value\" to=\"bsdf roughness\" />\n",
+                       num_math - 1);
+  xml +=
+      "  <connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+      "</shader>\n";
+  xml += "<state shader=\"procedural\">\n";
+  xml_grid_mesh(xml, 64, 6.0f, 0.2f);
+  xml += "</state>\n";
+  xml_end(xml);
+  return xml;
+}
+
+/* Cube filled with a homogeneous scattering volume. */
+string scene_volume(const int width, const int height)
+{
+  string xml;
+  xml_begin(xml, width, height, false);
+  xml +=
+      "<shader name=\"volume\">\n"
+      "  <scatter_volume name=\"scatter\" color=\"0.8 0.8 0.8\" density=\"2\" />\n"
+      "  <connect from=\"scatter volume\" to=\"output volume\" />\n"
+      "</shader>\n";
+  xml += "<state shader=\"volume\">\n";
+  xml_cube_mesh(xml, 3.0f);
+  xml += "</state>\n";
+  xml_end(xml);
+  return xml;
+}
+
+/* Patch of curly hair strands. */
+string scene_hair(const int width, const int height)
+{
+  const int num_strands = 128;
+  const int num_keys = 8;
+  BenchmarkRandom rng;
+
+  string xml;
+  xml_begin(xml, width, height, false);
+  xml +=
+      "<shader name=\"hair\">\n"
+      "  <principled_hair_bsdf name=\"bsdf\" />\n"
+      "  <connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+      "</shader>\n";
+  xml += "<state shader=\"hair\">\n";
+
+  xml += "<hair radius=\"0.005\" P=\"";
+  for (int y = 0; y < num_strands; y++) {
+    for (int x = 0; x < num_strands; x++) {
+      const float u = (float(x) / num_strands - 0.5f) * 4.0f + rng.next(-0.01f, 0.01f);
+      const float v = (float(y) / num_strands - 0.5f) * 4.0f + rng.next(-0.01f, 0.01f);
+      const float phase = rng.next(0.0f, 6.0f);
+      for (int k = 0; k < num_keys; k++) {
+        const float t = float(k) / (num_keys - 1);
+        xml_float3(xml,
+                   u + 0.05f * t * cosf(phase + t * 8.0f),
+                   v + 0.05f * t * sinf(phase + t * 8.0f),
+                   1.0f - t);
+      }
+    }
+  }
+
+  xml += "\" nkeys=\"";
+  for (int i = 0; i < num_strands * num_strands; i++) {
+    xml += string_printf("%d ", num_keys);
+  }
+  xml += "\" />\n";
+
+  xml += "</state>\n";
+  xml_end(xml);
+  return xml;
+}
+
+/* Ground plane lit by a grid of small point lights. */
+string scene_many_lights(const int width, const int height)
+{
+  const int num_lights = 32;
+  BenchmarkRandom rng;
+
+  string xml;
+  xml_begin(xml, width, height, false);
+  xml_diffuse_shader(xml, "diffuse", "0.8 0.8 0.8");
+  xml +=
+      "<shader name=\"emission\">\n"
+      "  <emission name=\"emission\" color=\"1 1 1\" strength=\"1\" />\n"
+      "  <connect from=\"emission emission\" to=\"output surface\" />\n"
+      "</shader>\n";
+
+  xml += "<state shader=\"diffuse\">\n";
+  xml_grid_mesh(xml, 16, 8.0f, 0.0f);
+  xml += "</state>\n";
+
+  xml += "<state shader=\"emission\">\n";
+  for (int y = 0; y < num_lights; y++) {
+    for (int x = 0; x < num_lights; x++) {
+      const float u = (float(x) / (num_lights - 1) - 0.5f) * 6.0f;
+      const float v = (float(y) / (num_lights - 1) - 0.5f) * 6.0f;
+      xml += string_printf(
+          "<light light_type=\"point\" co=\"%g %g -0.2\" size=\"0.02\" "
+          "strength=\"%g %g %g\" />\n",
+          u,
+          v,
+          rng.next(0.0f, 2.0f),
+          rng.next(0.0f, 2.0f),
+          rng.next(0.0f, 2.0f));
+    }
+  }
+  xml += "</state>\n";
+
+  xml_end(xml);
+  return xml;
+}
+
+/* Mostly smooth background and a few detailed regions, so that pixels converge at very
+ * different numbers of samples. */
+string scene_adaptive_sampling(const int width, const int height)
+{
+  string xml;
+  xml_begin(xml, width, height, true);
+  xml +=
+      "<shader name=\"glossy\">\n"
+      "  <noise_texture name=\"noise\" scale=\"40\" detail=\"4\" />\n"
+      "  <glossy_bsdf name=\"bsdf\" roughness=\"0.3\" />\n"
+      "  <connect from=\"noise color\" to=\"bsdf color\" />\n"
+      "  <connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+      "</shader>\n";
+  xml += "<state shader=\"glossy\">\n";
+  xml += "<transform translate=\"0 0 1\">\n";
+  xml_cube_mesh(xml, 1.5f);
+  xml += "</transform>\n";
+  xml += "</state>\n";
+  xml_end(xml);
+  return xml;
+}
+
+struct BenchmarkScene {
+  const char *name;
+  const char *description;
+  int samples;
+  string (*generate)(const int width, const int height);
+};
+
+const BenchmarkScene benchmark_scenes[] = {
+    {"bvh_build", "Displaced grid of 2M triangles", 4, scene_bvh_build},
+    {"svm_shading", "Procedural texture node graph", 64, scene_svm_shading},
+    {"svm_math", "Texture mapping and math node chain", 64, scene_svm_math},
+    {"volume", "Homogeneous scattering volume", 32, scene_volume},
+    {"hair", "16k curly hair strands", 16, scene_hair},
+    {"many_lights", "1024 point lights", 16, scene_many_lights},
+    {"adaptive_sampling", "Adaptive sampling with noisy glossy", 256, scene_adaptive_sampling},
+};
+
+}  // namespace
+
+/* Options */
+
+struct BenchmarkOptions {
+  string scenes;
+  string output_filepath;
+  string scene_directory;
+  int width = 640;
+  int height = 360;
+  int samples = 0;
+  int threads = 0;
+  int repeat = 3;
+};
+
+struct BenchmarkRun {
+  double update_time = 0.0;
+  double render_time = 0.0;
+  double samples_per_second = 0.0;
+  uint64_t pixel_samples = 0;
+  vector<std::pair<string, NamedTimeStats>> phases;
+};
+
+struct BenchmarkResult {
+  const BenchmarkScene *scene = nullptr;
+  int samples = 0;
+  vector<BenchmarkRun> runs;
+};
+
+static bool benchmark_scene_selected(const BenchmarkOptions &options, const BenchmarkScene &scene)
+{
+  if (options.scenes.empty()) {
+    return true;
+  }
+
+  vector<string> tokens;
+  string_split(tokens, options.scenes, ",");
+  foreach (const string &token, tokens) {
+    if (token == scene.name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void benchmark_collect_phases(const SceneUpdateStats &stats, BenchmarkRun &run)
+{
+  const std::pair<const char *, const UpdateTimeStats *> phases[] = {
+      {"scene", &stats.scene},
+      {"geometry", &stats.geometry},
+      {"image", &stats.image},
+      {"light", &stats.light},
+      {"object", &stats.object},
+      {"background", &stats.background},
+      {"bake", &stats.bake},
+      {"camera", &stats.camera},
+      {"film", &stats.film},
+      {"integrator", &stats.integrator},
+      {"osl", &stats.osl},
+      {"particles", &stats.particles},
+      {"svm", &stats.svm},
+      {"tables", &stats.tables},
+      {"procedurals", &stats.procedurals},
+  };
+
+  for (const auto &phase : phases) {
+    run.phases.emplace_back(phase.first, phase.second->times);
+  }
+}
+
+static bool benchmark_run(const BenchmarkOptions &options,
+                          const DeviceInfo &device,
+                          const string &filepath,
+                          const int samples,
+                          BenchmarkRun &run)
+{
+  SessionParams session_params;
+  session_params.device = device;
+  session_params.background = true;
+  session_params.samples = samples;
+  session_params.threads = options.threads;
+
+  SceneParams scene_params;
+  scene_params.shadingsystem = SHADINGSYSTEM_SVM;
+
+  Session session(session_params, scene_params);
+  Scene *scene = session.scene;
+  scene->enable_update_stats();
+
+  {
+    thread_scoped_lock scene_lock(scene->mutex);
+
+    xml_read_file(scene, filepath.c_str());
+    scene->camera->compute_auto_viewplane();
+
+    Pass *pass = scene->create_node<Pass>();
+    pass->set_name(ustring("combined"));
+    pass->set_type(PASS_COMBINED);
+  }
+
+  BufferParams buffer_params;
+  buffer_params.width = scene->camera->get_full_width();
+  buffer_params.height = scene->camera->get_full_height();
+  buffer_params.full_width = buffer_params.width;
+  buffer_params.full_height = buffer_params.height;
+
+  session.reset(session_params, buffer_params);
+  session.start();
+  session.wait();
+
+  if (session.progress.get_error()) {
+    fprintf(stderr, "Error: %s\n", session.progress.get_error_message().c_str());
+    return false;
+  }
+
+  double total_time, render_time;
+  session.progress.get_time(total_time, render_time);
+
+  run.update_time = scene->update_stats->scene.times.total_time;
+  run.render_time = render_time;
+  run.pixel_samples = session.progress.get_pixel_samples();
+  run.samples_per_second = (render_time > 0.0) ? run.pixel_samples / render_time : 0.0;
+  benchmark_collect_phases(*scene->update_stats, run);
+
+  return true;
+}
+
+/* Report */
+
+static string json_escape(const string &str)
+{
+  string result;
+  foreach (const char c, str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    }
+    else if ((unsigned char)c < 0x20) {
+      result += string_printf("\\u%04x", c);
+    }
+    else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+static string benchmark_report(const BenchmarkOptions &options,
+                               const DeviceInfo &device,
+                               const vector<BenchmarkResult> &results)
+{
+  string json = "{\n";
+  json += string_printf("  \"version\": \"%s\",\n", CYCLES_VERSION_STRING);
+  json += string_printf("  \"device\": \"%s\",\n", json_escape(device.description).c_str());
+  json += string_printf("  \"threads\": %d,\n", options.threads);
+  json += string_printf("  \"width\": %d,\n", options.width);
+  json += string_printf("  \"height\": %d,\n", options.height);
+  json += "  \"scenes\": [\n";
+
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchmarkResult &result = results[i];
+
+    json += "    {\n";
+    json += string_printf("      \"name\": \"%s\",\n", result.scene->name);
+    json += string_printf("      \"samples\": %d,\n", result.samples);
+    json += "      \"runs\": [\n";
+
+    for (size_t j = 0; j < result.runs.size(); j++) {
+      const BenchmarkRun &run = result.runs[j];
+
+      json += "        {\n";
+      json += string_printf("          \"update_time\": %.6f,\n", run.update_time);
+      json += string_printf("          \"render_time\": %.6f,\n", run.render_time);
+      json += string_printf("          \"pixel_samples\": %llu,\n",
+                            (unsigned long long)run.pixel_samples);
+      json += string_printf("          \"samples_per_second\": %.1f,\n", run.samples_per_second);
+      json += "          \"phases\": {\n";
+
+      for (size_t k = 0; k < run.phases.size(); k++) {
+        const NamedTimeStats &times = run.phases[k].second;
+
+        json += string_printf("            \"%s\": {\"total\": %.6f, \"entries\": {",
+                              run.phases[k].first.c_str(),
+                              times.total_time);
+        for (size_t e = 0; e < times.entries.size(); e++) {
+          json += string_printf("%s\"%s\": %.6f",
+                                (e == 0) ? "" : ", ",
+                                json_escape(times.entries[e].name).c_str(),
+                                times.entries[e].time);
+        }
+        json += string_printf("}}%s\n", (k + 1 < run.phases.size()) ? "," : "");
+      }
+
+      json += "          }\n";
+      json += string_printf("        }%s\n", (j + 1 < result.runs.size()) ? "," : "");
+    }
+
+    json += "      ]\n";
+    json += string_printf("    }%s\n", (i + 1 < results.size()) ? "," : "");
+  }
+
+  json += "  ]\n";
+  json += "}\n";
+  return json;
+}
+
+/* Main */
+
+static void options_parse(int argc, const char **argv, BenchmarkOptions &options)
+{
+  bool list = false, help = false, debug = false, version = false;
+  int verbosity = 1;
+
+  ArgParse ap;
+  ap.options("Usage: cycles_benchmark [options]",
+             "--scenes %s",
+             &options.scenes,
+             "Comma separated names of scenes to render, all by default",
+             "--output %s",
+             &options.output_filepath,
+             "File path to write JSON report to",
+             "--scene-dir %s",
+             &options.scene_directory,
+             "Directory to write generated XML scenes to",
+             "--repeat %d",
+             &options.repeat,
+             "Number of times to render every scene",
+             "--samples %d",
+             &options.samples,
+             "Override number of samples of all scenes",
+             "--threads %d",
+             &options.threads,
+             "CPU Rendering Threads",
+             "--width %d",
+             &options.width,
+             "Image width in pixels",
+             "--height %d",
+             &options.height,
+             "Image height in pixels",
+             "--list",
+             &list,
+             "List available scenes",
+#ifdef WITH_CYCLES_LOGGING
+             "--debug",
+             &debug,
+             "Enable debug logging",
+             "--verbose %d",
+             &verbosity,
+             "Set verbosity of the logger",
+#endif
+             "--help",
+             &help,
+             "Print help message",
+             "--version",
+             &version,
+             "Print version number",
+             NULL);
+
+  if (ap.parse(argc, argv) < 0) {
+    fprintf(stderr, "%s\n", ap.geterror().c_str());
+    ap.usage();
+    exit(EXIT_FAILURE);
+  }
+
+  if (debug) {
+    util_logging_start();
+    util_logging_verbosity_set(verbosity);
+  }
+
+  if (list) {
+    printf("Scenes:\n");
+    for (const BenchmarkScene &scene : benchmark_scenes) {
+      printf("    %-20s%s\n", scene.name, scene.description);
+    }
+    exit(EXIT_SUCCESS);
+  }
+  else if (version) {
+    printf("%s\n", CYCLES_VERSION_STRING);
+    exit(EXIT_SUCCESS);
+  }
+  else if (help) {
+    ap.usage();
+    exit(EXIT_SUCCESS);
+  }
+
+  if (options.width <= 0 || options.height <= 0) {
+    fprintf(stderr, "Invalid resolution: %dx%d\n", options.width, options.height);
+    exit(EXIT_FAILURE);
+  }
+  else if (options.samples < 0) {
+    fprintf(stderr, "Invalid number of samples: %d\n", options.samples);
+    exit(EXIT_FAILURE);
+  }
+  else if (options.repeat < 1) {
+    fprintf(stderr, "Invalid number of repeats: %d\n", options.repeat);
+    exit(EXIT_FAILURE);
+  }
+
+  if (options.scene_directory.empty()) {
+    options.scene_directory = path_cache_get("benchmark");
+  }
+}
+
+static int benchmark_main(int argc, const char **argv)
+{
+  BenchmarkOptions options;
+  options_parse(argc, argv, options);
+
+  vector<DeviceInfo> devices = Device::available_devices(DEVICE_MASK_CPU);
+  if (devices.empty()) {
+    fprintf(stderr, "No CPU device available\n");
+    return EXIT_FAILURE;
+  }
+  const DeviceInfo &device = devices.front();
+
+  path_create_directories(path_join(options.scene_directory, ""));
+
+  vector<BenchmarkResult> results;
+
+  for (const BenchmarkScene &scene : benchmark_scenes) {
+    if (!benchmark_scene_selected(options, scene)) {
+      continue;
+    }
+
+    const string filepath = path_join(options.scene_directory, string(scene.name) + ".xml");
+    string xml = scene.generate(options.width, options.height);
+    if (!path_write_text(filepath, xml)) {
+      fprintf(stderr, "Failed to write scene %s\n", filepath.c_str());
+      return EXIT_FAILURE;
+    }
+
+    BenchmarkResult result;
+    result.scene = &scene;
+    result.samples = (options.samples) ? options.samples : scene.samples;
+
+    for (int i = 0; i < options.repeat; i++) {
+      BenchmarkRun run;
+      if (!benchmark_run(options, device, filepath, result.samples, run)) {
+        return EXIT_FAILURE;
+      }
+
+      printf("%-20s update %8.3f s   render %8.3f s   %12.0f samples/s\n",
+             scene.name,
+             run.update_time,
+             run.render_time,
+             run.samples_per_second);
+      fflush(stdout);
+
+      result.runs.push_back(run);
+    }
+
+    results.push_back(result);
+  }
+
+  if (results.empty()) {
+    fprintf(stderr, "No scenes matching \"%s\"\n", options.scenes.c_str());
+    return EXIT_FAILURE;
+  }
+
+  string report = benchmark_report(options, device, results);
+  if (options.output_filepath.empty()) {
+    printf("%s", report.c_str());
+  }
+  else if (!path_write_text(options.output_filepath, report)) {
+    fprintf(stderr, "Failed to write report %s\n", options.output_filepath.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+CCL_NAMESPACE_END
+
+using namespace ccl;
+
+int main(int argc, const char **argv)
+{
+  util_logging_init(argv[0]);
+  path_init();
+  return benchmark_main(argc, argv);
+}
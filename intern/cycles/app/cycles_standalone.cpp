@@ -31,6 +31,10 @@
 #include "app/cycles_xml.h"
 #include "app/oiio_output_driver.h"
 
+#ifdef WITH_REMOTE
+#  include "integrator/remote_worker.h"
+#endif
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
 #  include "opengl/display_driver.h"
 #  include "opengl/window.h"
@@ -384,6 +388,10 @@ static void options_parse(int argc, const char **argv)
   ArgParse ap;
   bool help = false, profile = false, debug = false, version = false;
   int verbosity = 1;
+#ifdef WITH_REMOTE
+  int remote_worker_port = 0;
+  string remote_bind_address = REMOTE_DEFAULT_BIND_ADDRESS;
+#endif
 
   ap.options("Usage: cycles [options] file.xml",
              "%*",
@@ -424,6 +432,15 @@ static void options_parse(int argc, const char **argv)
              "--list-devices",
              &list,
              "List information about all available devices",
+#ifdef WITH_REMOTE
+             "--remote-worker %d",
+             &remote_worker_port,
+             "Run as worker for the REMOTE device of other instances, listening on the given port",
+             "--remote-bind %s",
+             &remote_bind_address,
+             "Address the remote worker listens on, the local machine only by default. Use "
+             "0.0.0.0 for all interfaces, only on trusted networks as there is no authentication",
+#endif
              "--profile",
              &profile,
              "Enable profile logging",
@@ -471,6 +488,13 @@ static void options_parse(int argc, const char **argv)
     printf("%s\n", CYCLES_VERSION_STRING);
     exit(EXIT_SUCCESS);
   }
+#ifdef WITH_REMOTE
+  else if (remote_worker_port > 0) {
+    RemoteWorker worker(options.session_params.threads);
+    worker.listen(remote_bind_address, remote_worker_port);
+    exit(EXIT_FAILURE);
+  }
+#endif
   else if (help || options.filepath == "") {
     ap.usage();
     exit(EXIT_SUCCESS);
@@ -501,6 +525,12 @@ static void options_parse(int argc, const char **argv)
     device_available = true;
   }
 
+  /* Render with all workers listed in CYCLES_REMOTE_WORKERS together. */
+  if (device_type == DEVICE_REMOTE && devices.size() > 1) {
+    options.session_params.device = Device::get_multi_device(
+        devices, options.session_params.threads, options.session_params.background);
+  }
+
   /* handle invalid configurations */
   if (options.session_params.device.type == DEVICE_NONE || !device_available) {
     fprintf(stderr, "Unknown device: %s\n", devicename.c_str());
@@ -14,6 +14,7 @@
 #include "scene/background.h"
 #include "scene/camera.h"
 #include "scene/film.h"
+#include "scene/hair.h"
 #include "scene/integrator.h"
 #include "scene/light.h"
 #include "scene/mesh.h"
@@ -554,6 +555,54 @@ static void xml_read_mesh(const XMLReadState &state, xml_node node)
   }
 }
 
+/* Hair */
+
+static void xml_read_hair(const XMLReadState &state, xml_node node)
+{
+  /* add hair */
+  Hair *hair = new Hair();
+  state.scene->geometry.push_back(hair);
+
+  Object *object = new Object();
+  object->set_geometry(hair);
+  object->set_tfm(state.tfm);
+  state.scene->objects.push_back(object);
+
+  array<Node *> used_shaders = hair->get_used_shaders();
+  used_shaders.push_back_slow(state.shader);
+  hair->set_used_shaders(used_shaders);
+
+  /* read curve keys, with either one radius for all keys or one per key */
+  vector<float3> P;
+  vector<float> radius;
+  vector<int> nkeys;
+
+  xml_read_float3_array(P, node, "P");
+  xml_read_float_array(radius, node, "radius");
+  xml_read_int_array(nkeys, node, "nkeys");
+
+  if (radius.empty()) {
+    radius.push_back(0.01f);
+  }
+
+  hair->reserve_curves(nkeys.size(), P.size());
+
+  int first_key = 0;
+  for (size_t i = 0; i < nkeys.size(); i++) {
+    if (nkeys[i] < 2 || first_key + nkeys[i] > (int)P.size()) {
+      fprintf(stderr, "Invalid number of keys for curve %d.\n", (int)i);
+      break;
+    }
+
+    for (int j = first_key; j < first_key + nkeys[i]; j++) {
+      hair->add_curve_key(P[j], (radius.size() == P.size()) ? radius[j] : radius[0]);
+    }
+    hair->add_curve(first_key, 0);
+
+    first_key += nkeys[i];
+  }
+}
+
 /* Light */
 
 static void xml_read_light(XMLReadState &state, xml_node node)
@@ -653,6 +702,9 @@ static void xml_read_scene(XMLReadState &state, xml_node scene_node)
     else if (string_iequals(node.name(), "mesh")) {
       xml_read_mesh(state, node);
     }
+    else if (string_iequals(node.name(), "hair")) {
+      xml_read_hair(state, node);
+    }
     else if (string_iequals(node.name(), "light")) {
       xml_read_light(state, node);
     }
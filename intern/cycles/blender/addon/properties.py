@@ -978,6 +978,50 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=8, max=8192,
     )
 
+    use_texture_cache: BoolProperty(
+        name="Texture Cache",
+        description="Read image textures on demand while rendering, instead of loading them fully into memory "
+                    "beforehand. Only the parts of images that are used are read, which is most efficient with "
+                    "tiled and mipmapped files such as EXR or TX. Only supported on CPU, and not with OSL",
+        default=False,
+    )
+    texture_cache_size: IntProperty(
+        name="Cache Size",
+        description="Maximum amount of memory used by the texture cache, in megabytes",
+        default=4096,
+        min=64, soft_max=65536,
+    )
+
+    use_compact_attributes: BoolProperty(
+        name="Compact Attributes",
+        description="Store normals, UV maps and colors of meshes with reduced precision, to use less memory "
+                    "for scenes with a lot of geometry. Normals are octahedral encoded, UV maps and colors are "
+                    "stored as half floats, and byte colors are kept as bytes",
+        default=False,
+    )
+
+    use_bvh_cache: BoolProperty(
+        name="BVH Cache",
+        description="Reuse the acceleration structure of objects whose geometry did not change since an earlier "
+                    "render, instead of building it again. Only used when the BVH is built by Cycles itself, "
+                    "not by Embree or GPU ray tracing hardware",
+        default=False,
+    )
+    bvh_cache_memory_limit: IntProperty(
+        name="Memory Limit",
+        description="Maximum amount of memory used to keep cached acceleration structures between renders, "
+                    "in megabytes. They are freed from memory when the last render session ends",
+        default=2048,
+        min=0, soft_max=65536,
+    )
+    bvh_cache_directory: StringProperty(
+        name="Cache Directory",
+        description="Directory to store cached acceleration structures in, so they can be shared between "
+                    "Blender sessions and render farm jobs. Leave empty to only keep them in memory",
+        default="",
+        subtype='DIR_PATH',
+    )
+
     # Various fine-tuning debug flags
 
     def _devices_update_callback(self, context):
@@ -985,6 +1029,7 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         scene = context.scene.as_pointer()
         return _cycles.debug_flags_update(scene)
 
+    debug_use_cpu_avx512: BoolProperty(name="AVX512", default=True)
     debug_use_cpu_avx2: BoolProperty(name="AVX2", default=True)
     debug_use_cpu_sse41: BoolProperty(name="SSE41", default=True)
     debug_use_cpu_sse2: BoolProperty(name="SSE2", default=True)
@@ -993,6 +1038,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_bvh_layouts,
         default='EMBREE',
     )
+    debug_use_cpu_wavefront: BoolProperty(
+        name="Wavefront",
+        description="Trace batches of paths kernel by kernel and sort shading by material, "
+        "for better cache usage in scenes with many materials",
+        default=False,
+    )
 
     debug_use_cuda_adaptive_compile: BoolProperty(name="Adaptive Compile", default=False)
 
@@ -782,6 +782,17 @@ class CYCLES_RENDER_PT_performance_memory(CyclesButtonsPanel, Panel):
         sub.active = cscene.use_auto_tile
         sub.prop(cscene, "tile_size")
 
+        if use_cpu(context):
+            col = layout.column()
+            col.active = not cscene.shading_system
+            col.prop(cscene, "use_texture_cache")
+            sub = col.column()
+            sub.active = cscene.use_texture_cache
+            sub.prop(cscene, "texture_cache_size")
+
+        col = layout.column()
+        col.prop(cscene, "use_compact_attributes")
+
 
 class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Panel):
     bl_label = "Acceleration Structure"
@@ -831,6 +842,13 @@ class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Pa
             if use_multi_device(context) and use_embree:
                 col.prop(cscene, "debug_use_compact_bvh")
 
+        col = layout.column()
+        col.prop(cscene, "use_bvh_cache")
+        sub = col.column()
+        sub.active = cscene.use_bvh_cache
+        sub.prop(cscene, "bvh_cache_memory_limit")
+        sub.prop(cscene, "bvh_cache_directory", text="Directory")
+
 
 class CYCLES_RENDER_PT_performance_final_render(CyclesButtonsPanel, Panel):
     bl_label = "Final Render"
@@ -2206,7 +2224,9 @@ class CYCLES_RENDER_PT_debug(CyclesDebugButtonsPanel, Panel):
         row.prop(cscene, "debug_use_cpu_sse2", toggle=True)
         row.prop(cscene, "debug_use_cpu_sse41", toggle=True)
         row.prop(cscene, "debug_use_cpu_avx2", toggle=True)
+        row.prop(cscene, "debug_use_cpu_avx512", toggle=True)
         col.prop(cscene, "debug_bvh_layout", text="BVH")
+        col.prop(cscene, "debug_use_cpu_wavefront")
 
         col.separator()
 
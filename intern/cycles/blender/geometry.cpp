@@ -183,6 +183,14 @@ Geometry *BlenderSync::sync_geometry(BL::Depsgraph &b_depsgraph,
   return geom;
 }
 
+/* Geometry synced in this update may still be written to by tasks in the geometry task pool, so
+ * its data and modified flags can not be inspected until the pool is done. Use this instead to
+ * test if the geometry may have changed. */
+bool BlenderSync::geometry_is_synced(const Geometry *geom) const
+{
+  return geom && geometry_synced.find(const_cast<Geometry *>(geom)) != geometry_synced.end();
+}
+
 void BlenderSync::sync_geometry_motion(BL::Depsgraph &b_depsgraph,
                                        BObjectInfo &b_ob_info,
                                        Object *object,
@@ -490,6 +490,7 @@ static void attr_create_generic(Scene *scene,
           });
         }
         else {
+          attr->flags |= ATTR_BYTE_COLOR;
           float4 *data = attr->data_float4();
           fill_generic_attribute(b_mesh, data, b_domain, subdivision, [&](int i) {
             return make_float4(color_srgb_to_linear(byte_to_float(src[i][0])),
@@ -63,10 +63,12 @@ static void debug_flags_sync_from_scene(BL::Scene b_scene)
   DebugFlagsRef flags = DebugFlags();
   PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
   /* Synchronize CPU flags. */
+  flags.cpu.avx512 = get_boolean(cscene, "debug_use_cpu_avx512");
   flags.cpu.avx2 = get_boolean(cscene, "debug_use_cpu_avx2");
   flags.cpu.sse41 = get_boolean(cscene, "debug_use_cpu_sse41");
   flags.cpu.sse2 = get_boolean(cscene, "debug_use_cpu_sse2");
   flags.cpu.bvh_layout = (BVHLayout)get_enum(cscene, "debug_bvh_layout");
+  flags.cpu.wavefront = get_boolean(cscene, "debug_use_cpu_wavefront");
   /* Synchronize CUDA flags. */
   flags.cuda.adaptive_compile = get_boolean(cscene, "debug_use_cuda_adaptive_compile");
   /* Synchronize OptiX flags. */
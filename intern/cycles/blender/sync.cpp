@@ -786,7 +786,8 @@ void BlenderSync::free_data_after_sync(BL::Depsgraph &b_depsgraph)
 
 /* Scene Parameters */
 
-SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene,
+SceneParams BlenderSync::get_scene_params(BL::BlendData &b_data,
+                                          BL::Scene &b_scene,
                                           const bool background,
                                           const bool use_developer_ui)
 {
@@ -828,6 +829,18 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene,
     params.texture_limit = 0;
   }
 
+  params.use_texture_cache = RNA_boolean_get(&cscene, "use_texture_cache");
+  params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
+
+  params.use_compact_attributes = RNA_boolean_get(&cscene, "use_compact_attributes");
+
+  params.use_bvh_cache = RNA_boolean_get(&cscene, "use_bvh_cache");
+  if (params.use_bvh_cache) {
+    params.bvh_cache_memory_limit = RNA_int_get(&cscene, "bvh_cache_memory_limit");
+    params.bvh_cache_directory = blender_absolute_path(
+        b_data, b_scene, get_string(cscene, "bvh_cache_directory"));
+  }
+
   params.bvh_layout = DebugFlags().cpu.bvh_layout;
 
   params.background = background;
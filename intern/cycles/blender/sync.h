@@ -85,7 +85,8 @@ class BlenderSync {
   }
 
   /* get parameters */
-  static SceneParams get_scene_params(BL::Scene &b_scene,
+  static SceneParams get_scene_params(BL::BlendData &b_data,
+                                      BL::Scene &b_scene,
                                       const bool background,
                                       const bool use_developer_ui);
   static SessionParams get_session_params(BL::RenderEngine &b_engine,
@@ -187,6 +188,8 @@ class BlenderSync {
                             bool use_particle_hair,
                             TaskPool *task_pool);
 
+  bool geometry_is_synced(const Geometry *geom) const;
+
   /* Light */
   void sync_light(BL::Object &b_parent,
                   int persistent_id[OBJECT_PERSISTENT_ID_SIZE],
@@ -8,6 +8,7 @@
 //#define __KERNEL_SSE__
 
 #include "bvh/binning.h"
+#include "bvh/partition.h"
 
 #include <stdlib.h>
 
@@ -78,9 +79,102 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange &job,
   num_bins = min(size_t(MAX_BINS), size_t(4.0f + 0.05f * size()));
   scale = rcp(cent_bounds_.size()) * make_float3((float)num_bins);
 
+  /* map geometry to bins */
+  Bins bins;
+
+  if (bvh_use_parallel_blocks(size())) {
+    /* Bin blocks of primitives in parallel, and merge their bins. */
+    vector<Bins> block_bins(bvh_num_parallel_blocks(size()));
+    bvh_parallel_for_blocks(start(), size(), [&](int block, int block_start, int block_end) {
+      bin_primitives(prims, block_start, block_end, block_bins[block]);
+    });
+
+    bins = block_bins[0];
+    for (size_t block = 1; block < block_bins.size(); block++) {
+      for (size_t i = 0; i < num_bins; i++) {
+        bins.count[i] = bins.count[i] + block_bins[block].count[i];
+        bins.bounds[i][0].grow(block_bins[block].bounds[i][0]);
+        bins.bounds[i][1].grow(block_bins[block].bounds[i][1]);
+        bins.bounds[i][2].grow(block_bins[block].bounds[i][2]);
+      }
+    }
+  }
+  else {
+    bin_primitives(prims, start(), end(), bins);
+  }
+
+  const int4 *bin_count = bins.count;
+  const BoundBox(*bin_bounds)[4] = bins.bounds;
+
+  /* sweep from right to left and compute parallel prefix of merged bounds */
+  float4 r_area[MAX_BINS];  /* area of bounds of primitives on the right */
+  float4 r_count[MAX_BINS]; /* number of primitives on the right */
+  int4 count = make_int4(0);
+
+  BoundBox bx = BoundBox::empty;
+  BoundBox by = BoundBox::empty;
+  BoundBox bz = BoundBox::empty;
+
+  for (size_t i = num_bins - 1; i > 0; i--) {
+    count = count + bin_count[i];
+    r_count[i] = blocks(count);
+
+    bx = merge(bx, bin_bounds[i][0]);
+    r_area[i][0] = bx.half_area();
+    by = merge(by, bin_bounds[i][1]);
+    r_area[i][1] = by.half_area();
+    bz = merge(bz, bin_bounds[i][2]);
+    r_area[i][2] = bz.half_area();
+    r_area[i][3] = r_area[i][2];
+  }
+
+  /* sweep from left to right and compute SAH */
+  int4 ii = make_int4(1);
+  float4 bestSAH = make_float4(FLT_MAX);
+  int4 bestSplit = make_int4(-1);
+
+  count = make_int4(0);
+
+  bx = BoundBox::empty;
+  by = BoundBox::empty;
+  bz = BoundBox::empty;
+
+  for (size_t i = 1; i < num_bins; i++, ii += make_int4(1)) {
+    count = count + bin_count[i - 1];
+
+    bx = merge(bx, bin_bounds[i - 1][0]);
+    float Ax = bx.half_area();
+    by = merge(by, bin_bounds[i - 1][1]);
+    float Ay = by.half_area();
+    bz = merge(bz, bin_bounds[i - 1][2]);
+    float Az = bz.half_area();
+
+    float4 lCount = blocks(count);
+    float4 lArea = make_float4(Ax, Ay, Az, Az);
+    float4 sah = lArea * lCount + r_area[i] * r_count[i];
+
+    bestSplit = select(sah < bestSAH, ii, bestSplit);
+    bestSAH = min(sah, bestSAH);
+  }
+
+  int4 mask = float3_to_float4(cent_bounds_.size()) <= zero_float4();
+  bestSAH = insert<3>(select(mask, make_float4(FLT_MAX), bestSAH), FLT_MAX);
+
+  /* find best dimension */
+  dim = get_best_dimension(bestSAH);
+  splitSAH = bestSAH[dim];
+  pos = bestSplit[dim];
+  leafSAH = bounds_.half_area() * blocks(size());
+}
+
+void BVHObjectBinning::bin_primitives(const BVHReference *prims,
+                                      int begin,
+                                      int end,
+                                      Bins &bins) const
+{
   /* initialize binning counter and bounds */
-  BoundBox bin_bounds[MAX_BINS][4]; /* bounds for every bin in every dimension */
-  int4 bin_count[MAX_BINS];         /* number of primitives mapped to bin */
+  int4 *bin_count = bins.count;
+  BoundBox(*bin_bounds)[4] = bins.bounds;
 
   for (size_t i = 0; i < num_bins; i++) {
     bin_count[i] = make_int4(0);
@@ -91,12 +185,12 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange &job,
   {
     int64_t i;
 
-    for (i = 0; i < int64_t(size()) - 1; i += 2) {
-      prefetch_L2(&prims[start() + i + 8]);
+    for (i = begin; i < int64_t(end) - 1; i += 2) {
+      prefetch_L2(&prims[i + 8]);
 
       /* map even and odd primitive to bin */
-      const BVHReference &prim0 = prims[start() + i + 0];
-      const BVHReference &prim1 = prims[start() + i + 1];
+      const BVHReference &prim0 = prims[i + 0];
+      const BVHReference &prim1 = prims[i + 1];
 
       BoundBox bounds0 = get_prim_bounds(prim0);
       BoundBox bounds1 = get_prim_bounds(prim1);
@@ -128,9 +222,9 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange &job,
     }
 
     /* for uneven number of primitives */
-    if (i < int64_t(size())) {
+    if (i < int64_t(end)) {
       /* map primitive to bin */
-      const BVHReference &prim0 = prims[start() + i];
+      const BVHReference &prim0 = prims[i];
       BoundBox bounds0 = get_prim_bounds(prim0);
       int4 bin0 = get_bin(bounds0);
 
@@ -146,67 +240,35 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange &job,
       bin_bounds[b02][2].grow(bounds0);
     }
   }
+}
 
-  /* sweep from right to left and compute parallel prefix of merged bounds */
-  float4 r_area[MAX_BINS];  /* area of bounds of primitives on the right */
-  float4 r_count[MAX_BINS]; /* number of primitives on the right */
-  int4 count = make_int4(0);
-
-  BoundBox bx = BoundBox::empty;
-  BoundBox by = BoundBox::empty;
-  BoundBox bz = BoundBox::empty;
-
-  for (size_t i = num_bins - 1; i > 0; i--) {
-    count = count + bin_count[i];
-    r_count[i] = blocks(count);
+/* Bounds of both sides of a split, accumulated while partitioning. */
+struct SplitBounds {
+  BoundBox lgeom_bounds = BoundBox::empty;
+  BoundBox rgeom_bounds = BoundBox::empty;
+  BoundBox lcent_bounds = BoundBox::empty;
+  BoundBox rcent_bounds = BoundBox::empty;
 
-    bx = merge(bx, bin_bounds[i][0]);
-    r_area[i][0] = bx.half_area();
-    by = merge(by, bin_bounds[i][1]);
-    r_area[i][1] = by.half_area();
-    bz = merge(bz, bin_bounds[i][2]);
-    r_area[i][2] = bz.half_area();
-    r_area[i][3] = r_area[i][2];
+  __forceinline void add(const BVHReference &prim, const bool left)
+  {
+    if (left) {
+      lgeom_bounds.grow(prim.bounds());
+      lcent_bounds.grow(prim.bounds().center2());
+    }
+    else {
+      rgeom_bounds.grow(prim.bounds());
+      rcent_bounds.grow(prim.bounds().center2());
+    }
   }
 
-  /* sweep from left to right and compute SAH */
-  int4 ii = make_int4(1);
-  float4 bestSAH = make_float4(FLT_MAX);
-  int4 bestSplit = make_int4(-1);
-
-  count = make_int4(0);
-
-  bx = BoundBox::empty;
-  by = BoundBox::empty;
-  bz = BoundBox::empty;
-
-  for (size_t i = 1; i < num_bins; i++, ii += make_int4(1)) {
-    count = count + bin_count[i - 1];
-
-    bx = merge(bx, bin_bounds[i - 1][0]);
-    float Ax = bx.half_area();
-    by = merge(by, bin_bounds[i - 1][1]);
-    float Ay = by.half_area();
-    bz = merge(bz, bin_bounds[i - 1][2]);
-    float Az = bz.half_area();
-
-    float4 lCount = blocks(count);
-    float4 lArea = make_float4(Ax, Ay, Az, Az);
-    float4 sah = lArea * lCount + r_area[i] * r_count[i];
-
-    bestSplit = select(sah < bestSAH, ii, bestSplit);
-    bestSAH = min(sah, bestSAH);
+  __forceinline void merge(const SplitBounds &other)
+  {
+    lgeom_bounds.grow(other.lgeom_bounds);
+    rgeom_bounds.grow(other.rgeom_bounds);
+    lcent_bounds.grow(other.lcent_bounds);
+    rcent_bounds.grow(other.rcent_bounds);
   }
-
-  int4 mask = float3_to_float4(cent_bounds_.size()) <= zero_float4();
-  bestSAH = insert<3>(select(mask, make_float4(FLT_MAX), bestSAH), FLT_MAX);
-
-  /* find best dimension */
-  dim = get_best_dimension(bestSAH);
-  splitSAH = bestSAH[dim];
-  pos = bestSplit[dim];
-  leafSAH = bounds_.half_area() * blocks(size());
-}
+};
 
 void BVHObjectBinning::split(BVHReference *prims,
                              BVHObjectBinning &left_o,
@@ -221,6 +283,25 @@ void BVHObjectBinning::split(BVHReference *prims,
 
   int64_t l = 0, r = N - 1;
 
+  if (bvh_use_parallel_blocks(N)) {
+    /* Partition blocks of primitives in parallel. */
+    SplitBounds split_bounds;
+    l = bvh_parallel_partition(
+        prims,
+        start(),
+        N,
+        [&](const BVHReference &prim) {
+          return get_bin(get_prim_bounds(prim).center2())[dim] < pos;
+        },
+        split_bounds);
+    r = l - 1;
+
+    lgeom_bounds = split_bounds.lgeom_bounds;
+    rgeom_bounds = split_bounds.rgeom_bounds;
+    lcent_bounds = split_bounds.lcent_bounds;
+    rcent_bounds = split_bounds.rcent_bounds;
+  }
+
   while (l <= r) {
     prefetch_L2(&prims[start() + l + 8]);
     prefetch_L2(&prims[start() + r - 8]);
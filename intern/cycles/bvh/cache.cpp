@@ -0,0 +1,380 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "bvh/cache.h"
+
+#include "scene/attribute.h"
+#include "scene/geometry.h"
+#include "scene/hair.h"
+#include "scene/mesh.h"
+#include "scene/pointcloud.h"
+
+#include "util/log.h"
+#include "util/md5.h"
+#include "util/path.h"
+#include "util/system.h"
+
+#include <cstdio>
+
+CCL_NAMESPACE_BEGIN
+
+/* Increment when the layout of packed BVH2 nodes or of the cache file changes. */
+static const uint BVH_CACHE_VERSION = 1;
+static const char BVH_CACHE_MAGIC[8] = {'C', 'Y', 'C', 'B', 'V', 'H', '2', '\0'};
+
+thread_mutex BVHCache::mutex;
+map<string, BVHCache::Entry> BVHCache::entries;
+list<string> BVHCache::lru;
+size_t BVHCache::memory_used = 0;
+int BVHCache::users = 0;
+
+/* Hashing */
+
+template<typename T> static void hash_value(MD5Hash &md5, const T value)
+{
+  md5.append((const uint8_t *)&value, sizeof(value));
+}
+
+template<typename T> static void hash_array(MD5Hash &md5, const array<T> &data)
+{
+  hash_value(md5, uint64_t(data.size()));
+  if (data.size()) {
+    md5.append((const uint8_t *)data.data(), data.size() * sizeof(T));
+  }
+}
+
+/* Only hash the x, y, z components, the padding of float3 is undefined. */
+static void hash_float3(MD5Hash &md5, const float3 *data, const size_t size)
+{
+  const size_t chunk_size = 4096;
+  float chunk[chunk_size * 3];
+
+  hash_value(md5, uint64_t(size));
+  for (size_t i = 0; i < size; i += chunk_size) {
+    const size_t num = min(chunk_size, size - i);
+    for (size_t j = 0; j < num; j++) {
+      chunk[j * 3 + 0] = data[i + j].x;
+      chunk[j * 3 + 1] = data[i + j].y;
+      chunk[j * 3 + 2] = data[i + j].z;
+    }
+    md5.append((const uint8_t *)chunk, num * 3 * sizeof(float));
+  }
+}
+
+static void hash_motion_attribute(MD5Hash &md5, const Geometry *geom)
+{
+  const Attribute *attr_mP = (geom->has_motion_blur()) ?
+                                 geom->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION) :
+                                 nullptr;
+  if (attr_mP == nullptr) {
+    hash_value(md5, uint64_t(0));
+    return;
+  }
+
+  /* Curve and point motion has the radius in the w component, so hash all of it. */
+  if (geom->is_mesh() || geom->is_volume()) {
+    hash_float3(md5, attr_mP->data_float3(), attr_mP->buffer.size() / sizeof(float3));
+  }
+  else {
+    hash_value(md5, uint64_t(attr_mP->buffer.size()));
+    md5.append((const uint8_t *)attr_mP->data(), attr_mP->buffer.size());
+  }
+}
+
+string BVHCache::key(const BVHParams &params, const Geometry *geom)
+{
+  if (params.bvh_layout != BVH_LAYOUT_BVH2 || params.top_level) {
+    return "";
+  }
+
+  MD5Hash md5;
+
+  hash_value(md5, BVH_CACHE_VERSION);
+
+  /* Build parameters. */
+  hash_value(md5, params.use_spatial_split);
+  hash_value(md5, params.spatial_split_alpha);
+  hash_value(md5, params.unaligned_split_threshold);
+  hash_value(md5, params.sah_node_cost);
+  hash_value(md5, params.sah_primitive_cost);
+  hash_value(md5, params.min_leaf_size);
+  hash_value(md5, params.max_triangle_leaf_size);
+  hash_value(md5, params.max_motion_triangle_leaf_size);
+  hash_value(md5, params.max_curve_leaf_size);
+  hash_value(md5, params.max_motion_curve_leaf_size);
+  hash_value(md5, params.max_point_leaf_size);
+  hash_value(md5, params.max_motion_point_leaf_size);
+  hash_value(md5, params.use_unaligned_nodes);
+  hash_value(md5, params.num_motion_triangle_steps);
+  hash_value(md5, params.num_motion_curve_steps);
+  hash_value(md5, params.num_motion_point_steps);
+  hash_value(md5, params.curve_subdivisions);
+
+  /* Geometry. */
+  hash_value(md5, int(geom->geometry_type));
+  hash_value(md5, int(geom->primitive_type()));
+  hash_value(md5, geom->has_motion_blur());
+  hash_value(md5, geom->get_motion_steps());
+
+  if (geom->is_mesh() || geom->is_volume()) {
+    const Mesh *mesh = static_cast<const Mesh *>(geom);
+    hash_float3(md5, mesh->get_verts().data(), mesh->get_verts().size());
+    hash_array(md5, mesh->get_triangles());
+  }
+  else if (geom->is_hair()) {
+    const Hair *hair = static_cast<const Hair *>(geom);
+    hash_float3(md5, hair->get_curve_keys().data(), hair->get_curve_keys().size());
+    hash_array(md5, hair->get_curve_radius());
+    hash_array(md5, hair->get_curve_first_key());
+  }
+  else if (geom->is_pointcloud()) {
+    const PointCloud *pointcloud = static_cast<const PointCloud *>(geom);
+    hash_float3(md5, pointcloud->get_points().data(), pointcloud->get_points().size());
+    hash_array(md5, pointcloud->get_radius());
+  }
+  else {
+    return "";
+  }
+
+  hash_motion_attribute(md5, geom);
+
+  return md5.get_hex();
+}
+
+/* Memory */
+
+static size_t packed_bvh_size(const PackedBVH &pack)
+{
+  return pack.nodes.size() * sizeof(int4) + pack.leaf_nodes.size() * sizeof(int4) +
+         pack.object_node.size() * sizeof(int) + pack.prim_type.size() * sizeof(int) +
+         pack.prim_visibility.size() * sizeof(uint) + pack.prim_index.size() * sizeof(int) +
+         pack.prim_object.size() * sizeof(int) + pack.prim_time.size() * sizeof(float2);
+}
+
+/* Least recently used BVH are freed when the memory limit is exceeded. */
+void BVHCache::store_memory(const string &key, const size_t memory_limit, const PackedBVH &pack)
+{
+  const size_t size = packed_bvh_size(pack);
+  if (size > memory_limit) {
+    return;
+  }
+
+  map<string, Entry>::iterator it = entries.find(key);
+  if (it != entries.end()) {
+    lru.erase(it->second.lru);
+    memory_used -= it->second.size;
+    entries.erase(it);
+  }
+
+  while (memory_used + size > memory_limit && !lru.empty()) {
+    map<string, Entry>::iterator oldest = entries.find(lru.front());
+    memory_used -= oldest->second.size;
+    entries.erase(oldest);
+    lru.pop_front();
+  }
+
+  Entry &entry = entries[key];
+  entry.pack = pack;
+  entry.size = size;
+  entry.lru = lru.insert(lru.end(), key);
+  memory_used += size;
+}
+
+bool BVHCache::load(const string &key,
+                    const string &directory,
+                    const size_t memory_limit,
+                    PackedBVH &pack)
+{
+  if (key.empty()) {
+    return false;
+  }
+
+  {
+    thread_scoped_lock lock(mutex);
+    map<string, Entry>::iterator it = entries.find(key);
+    if (it != entries.end()) {
+      lru.splice(lru.end(), lru, it->second.lru);
+      pack = it->second.pack;
+      return true;
+    }
+  }
+
+  if (directory.empty()) {
+    return false;
+  }
+
+  const string filepath = path_join(directory, key + ".bvh");
+  if (!path_exists(filepath)) {
+    return false;
+  }
+
+  if (!read_file(filepath, pack)) {
+    VLOG_WARNING << "Failed to read cached BVH " << filepath;
+    pack = PackedBVH();
+    return false;
+  }
+
+  VLOG_WORK << "Loaded cached BVH " << filepath;
+
+  thread_scoped_lock lock(mutex);
+  store_memory(key, memory_limit, pack);
+  return true;
+}
+
+void BVHCache::store(const string &key,
+                     const string &directory,
+                     const size_t memory_limit,
+                     const PackedBVH &pack)
+{
+  if (key.empty()) {
+    return;
+  }
+
+  {
+    thread_scoped_lock lock(mutex);
+    store_memory(key, memory_limit, pack);
+  }
+
+  if (directory.empty()) {
+    return;
+  }
+
+  /* Write to a temporary file first, so other processes sharing the directory never read a
+   * partially written file. */
+  const string filepath = path_join(directory, key + ".bvh");
+  const string filepath_tmp = filepath + string_printf(".%llu.%p.tmp",
+                                                      (unsigned long long)system_self_process_id(),
+                                                      (const void *)&pack);
+
+  if (!write_file(filepath_tmp, pack) || rename(filepath_tmp.c_str(), filepath.c_str()) != 0) {
+    VLOG_WARNING << "Failed to write cached BVH " << filepath;
+    path_remove(filepath_tmp);
+  }
+}
+
+void BVHCache::clear()
+{
+  thread_scoped_lock lock(mutex);
+  entries.clear();
+  lru.clear();
+  memory_used = 0;
+}
+
+void BVHCache::add_user()
+{
+  thread_scoped_lock lock(mutex);
+  users++;
+}
+
+void BVHCache::remove_user()
+{
+  thread_scoped_lock lock(mutex);
+  assert(users > 0);
+  if (--users == 0) {
+    entries.clear();
+    lru.clear();
+    memory_used = 0;
+  }
+}
+
+/* Files
+ *
+ * Arrays are written in a fixed order as their element count followed by the raw data, in
+ * the byte order of the host. Files written on a machine with another byte order are
+ * rejected by the header check. */
+
+template<typename T> static void write_array(vector<uint8_t> &binary, const array<T> &data)
+{
+  const uint64_t size = data.size();
+  const uint8_t *size_bytes = (const uint8_t *)&size;
+  binary.insert(binary.end(), size_bytes, size_bytes + sizeof(size));
+  if (size) {
+    const uint8_t *bytes = (const uint8_t *)data.data();
+    binary.insert(binary.end(), bytes, bytes + size * sizeof(T));
+  }
+}
+
+template<typename T>
+static bool read_array(const vector<uint8_t> &binary, size_t &offset, array<T> &data)
+{
+  uint64_t size;
+  if (offset + sizeof(size) > binary.size()) {
+    return false;
+  }
+  memcpy(&size, &binary[offset], sizeof(size));
+  offset += sizeof(size);
+
+  if (size > (binary.size() - offset) / sizeof(T)) {
+    return false;
+  }
+  data.resize(size);
+  if (size) {
+    memcpy(data.data(), &binary[offset], size * sizeof(T));
+  }
+  offset += size * sizeof(T);
+  return true;
+}
+
+struct BVHCacheHeader {
+  char magic[8];
+  uint version;
+  uint byte_order;
+  int root_index;
+};
+
+bool BVHCache::write_file(const string &filepath, const PackedBVH &pack)
+{
+  vector<uint8_t> binary;
+  binary.reserve(sizeof(BVHCacheHeader) + packed_bvh_size(pack) + 8 * sizeof(uint64_t));
+
+  BVHCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BVH_CACHE_MAGIC, sizeof(header.magic));
+  header.version = BVH_CACHE_VERSION;
+  header.byte_order = 0x01020304;
+  header.root_index = pack.root_index;
+
+  const uint8_t *header_bytes = (const uint8_t *)&header;
+  binary.insert(binary.end(), header_bytes, header_bytes + sizeof(header));
+
+  write_array(binary, pack.nodes);
+  write_array(binary, pack.leaf_nodes);
+  write_array(binary, pack.object_node);
+  write_array(binary, pack.prim_type);
+  write_array(binary, pack.prim_visibility);
+  write_array(binary, pack.prim_index);
+  write_array(binary, pack.prim_object);
+  write_array(binary, pack.prim_time);
+
+  return path_write_binary(filepath, binary);
+}
+
+bool BVHCache::read_file(const string &filepath, PackedBVH &pack)
+{
+  vector<uint8_t> binary;
+  if (!path_read_binary(filepath, binary) || binary.size() < sizeof(BVHCacheHeader)) {
+    return false;
+  }
+
+  BVHCacheHeader header;
+  memcpy(&header, binary.data(), sizeof(header));
+  if (memcmp(header.magic, BVH_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != BVH_CACHE_VERSION || header.byte_order != 0x01020304)
+  {
+    return false;
+  }
+
+  pack.root_index = header.root_index;
+
+  size_t offset = sizeof(header);
+  return read_array(binary, offset, pack.nodes) && read_array(binary, offset, pack.leaf_nodes) &&
+         read_array(binary, offset, pack.object_node) &&
+         read_array(binary, offset, pack.prim_type) &&
+         read_array(binary, offset, pack.prim_visibility) &&
+         read_array(binary, offset, pack.prim_index) &&
+         read_array(binary, offset, pack.prim_object) &&
+         read_array(binary, offset, pack.prim_time) && offset == binary.size();
+}
+
+CCL_NAMESPACE_END
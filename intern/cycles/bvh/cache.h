@@ -0,0 +1,72 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#pragma once
+
+#include "bvh/bvh.h"
+#include "bvh/params.h"
+
+#include "util/list.h"
+#include "util/map.h"
+#include "util/string.h"
+#include "util/thread.h"
+
+CCL_NAMESPACE_BEGIN
+
+class Geometry;
+
+/* BVH Cache
+ *
+ * Packed BVH2 of geometry, keyed by a hash of the geometry data and the build parameters,
+ * so geometry which did not change between renders does not need its BVH to be built again.
+ *
+ * Entries are kept in memory while any scene exists, up to a memory limit, and optionally
+ * written to a directory on disk so they can be shared between processes, for example between
+ * render farm jobs rendering frames of the same shot. Only bottom level BVH2 are cached, the BVH
+ * of other layouts are opaque and owned by their ray tracing library or driver. */
+class BVHCache {
+ public:
+  /* Hash of everything that affects the BVH built for the geometry. Returns an empty string
+   * if the geometry can not be cached. */
+  static string key(const BVHParams &params, const Geometry *geom);
+
+  /* Find BVH in memory, or in the directory when it is not empty. BVH loaded from the directory
+   * are kept in memory when they fit into the memory limit, in bytes. */
+  static bool load(const string &key,
+                   const string &directory,
+                   const size_t memory_limit,
+                   PackedBVH &pack);
+  static void store(const string &key,
+                    const string &directory,
+                    const size_t memory_limit,
+                    const PackedBVH &pack);
+
+  /* Free all BVH cached in memory. Files on disk are left untouched. */
+  static void clear();
+
+  /* Scenes register themselves as users, the memory is freed along with the last scene. */
+  static void add_user();
+  static void remove_user();
+
+ protected:
+  struct Entry {
+    PackedBVH pack;
+    list<string>::iterator lru;
+    size_t size = 0;
+  };
+
+  static bool read_file(const string &filepath, PackedBVH &pack);
+  static bool write_file(const string &filepath, const PackedBVH &pack);
+
+  static void store_memory(const string &key, const size_t memory_limit, const PackedBVH &pack);
+
+  static thread_mutex mutex;
+  static map<string, Entry> entries;
+  /* Least recently used entries first. */
+  static list<string> lru;
+  static size_t memory_used;
+  static int users;
+};
+
+CCL_NAMESPACE_END
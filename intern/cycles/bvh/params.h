@@ -110,6 +110,10 @@ class BVHParams {
   /* fixed parameters */
   enum { MAX_DEPTH = 64, MAX_SPATIAL_DEPTH = 48, NUM_SPATIAL_BINS = 32 };
 
+  /* Number of references handled by one task, when binning and partitioning ranges that are
+   * too large to be processed by a single thread. */
+  enum { PARALLEL_BLOCK_SIZE = 16384 };
+
   BVHParams()
   {
     use_spatial_split = true;
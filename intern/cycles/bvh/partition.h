@@ -0,0 +1,168 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#ifndef __BVH_PARTITION_H__
+#define __BVH_PARTITION_H__
+
+#include "bvh/params.h"
+
+#include "util/algorithm.h"
+#include "util/tbb.h"
+#include "util/vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Parallel Loops Over References
+ *
+ * The top levels of the BVH have to look at all references of the build, before there are
+ * enough subtrees to give every thread some work. These helpers split a range of references
+ * into blocks of fixed size which are processed in parallel. Results are gathered per block
+ * and combined in block order, so the built BVH does not depend on the number of threads. */
+
+__forceinline int bvh_num_parallel_blocks(const int size)
+{
+  return (size + BVHParams::PARALLEL_BLOCK_SIZE - 1) / BVHParams::PARALLEL_BLOCK_SIZE;
+}
+
+__forceinline bool bvh_use_parallel_blocks(const int size)
+{
+  return size >= 2 * BVHParams::PARALLEL_BLOCK_SIZE;
+}
+
+/* Call func(block, block_start, block_end) for every block of the range in parallel.
+ *
+ * Tasks are isolated, so the calling thread does not pick up other BVH build tasks while
+ * waiting. Those could use the same thread local spatial split storage as the caller. */
+template<typename Func>
+void bvh_parallel_for_blocks(const int start, const int size, const Func &func)
+{
+  const int num_blocks = bvh_num_parallel_blocks(size);
+  const int end = start + size;
+
+  tbb::this_task_arena::isolate([&] {
+    parallel_for(blocked_range<int>(0, num_blocks, 1), [&](const blocked_range<int> &r) {
+      for (int block = r.begin(); block != r.end(); block++) {
+        const int block_start = start + block * BVHParams::PARALLEL_BLOCK_SIZE;
+        const int block_end = min(block_start + BVHParams::PARALLEL_BLOCK_SIZE, end);
+        func(block, block_start, block_end);
+      }
+    });
+  });
+}
+
+/* Partition references in [start, start + size[ in place, so that the ones for which the
+ * predicate is true come first. Returns the number of those references.
+ *
+ * Accumulator is called as accum.add(ref, side) for every reference, with a separate copy per
+ * block which are combined with accum.merge(other) in block order.
+ *
+ * Every block is first partitioned on its own. References which then end up on the wrong side
+ * of the final split position are swapped with each other: the n-th misplaced reference on the
+ * left side with the n-th misplaced reference on the right side. */
+template<typename Predicate, typename Accumulator>
+int bvh_parallel_partition(BVHReference *refs,
+                           const int start,
+                           const int size,
+                           const Predicate &predicate,
+                           Accumulator &accum)
+{
+  const int num_blocks = bvh_num_parallel_blocks(size);
+  vector<int> block_num_true(num_blocks);
+  vector<Accumulator> block_accum(num_blocks, accum);
+
+  /* Partition blocks. */
+  bvh_parallel_for_blocks(start, size, [&](int block, int block_start, int block_end) {
+    Accumulator &local_accum = block_accum[block];
+    int l = block_start;
+    int r = block_end - 1;
+    while (l <= r) {
+      if (predicate(refs[l])) {
+        local_accum.add(refs[l], true);
+        l++;
+      }
+      else {
+        local_accum.add(refs[l], false);
+        swap(refs[l], refs[r]);
+        r--;
+      }
+    }
+    block_num_true[block] = l - block_start;
+  });
+
+  int num_true = 0;
+  for (int block = 0; block < num_blocks; block++) {
+    num_true += block_num_true[block];
+    accum.merge(block_accum[block]);
+  }
+
+  /* Gather ranges of misplaced references on both sides, in order. */
+  const int split = start + num_true;
+  const int end = start + size;
+  vector<int2> misplaced_left, misplaced_right;
+  vector<int> misplaced_left_offset, misplaced_right_offset;
+  int num_misplaced = 0, num_misplaced_right = 0;
+
+  for (int block = 0; block < num_blocks; block++) {
+    const int block_start = start + block * BVHParams::PARALLEL_BLOCK_SIZE;
+    const int block_end = min(block_start + BVHParams::PARALLEL_BLOCK_SIZE, end);
+    const int block_split = block_start + block_num_true[block];
+
+    /* False references left of the split. */
+    const int false_start = block_split;
+    const int false_end = min(block_end, split);
+    if (false_start < false_end) {
+      misplaced_left.push_back(make_int2(false_start, false_end));
+      misplaced_left_offset.push_back(num_misplaced);
+      num_misplaced += false_end - false_start;
+    }
+
+    /* True references right of the split. */
+    const int true_start = max(block_start, split);
+    const int true_end = block_split;
+    if (true_start < true_end) {
+      misplaced_right.push_back(make_int2(true_start, true_end));
+      misplaced_right_offset.push_back(num_misplaced_right);
+      num_misplaced_right += true_end - true_start;
+    }
+  }
+
+  assert(num_misplaced == num_misplaced_right);
+  (void)num_misplaced_right;
+
+  if (num_misplaced == 0) {
+    return num_true;
+  }
+
+  /* Swap misplaced references. */
+  bvh_parallel_for_blocks(0, num_misplaced, [&](int /*block*/, int begin, int end) {
+    int li = int(std::upper_bound(misplaced_left_offset.begin(),
+                                  misplaced_left_offset.end(),
+                                  begin) -
+                 misplaced_left_offset.begin()) -
+             1;
+    int ri = int(std::upper_bound(misplaced_right_offset.begin(),
+                                  misplaced_right_offset.end(),
+                                  begin) -
+                 misplaced_right_offset.begin()) -
+             1;
+    int l = misplaced_left[li].x + (begin - misplaced_left_offset[li]);
+    int r = misplaced_right[ri].x + (begin - misplaced_right_offset[ri]);
+
+    for (int i = begin; i < end; i++) {
+      if (l == misplaced_left[li].y) {
+        l = misplaced_left[++li].x;
+      }
+      if (r == misplaced_right[ri].y) {
+        r = misplaced_right[++ri].x;
+      }
+      swap(refs[l++], refs[r++]);
+    }
+  });
+
+  return num_true;
+}
+
+CCL_NAMESPACE_END
+
+#endif /* __BVH_PARTITION_H__ */
@@ -8,6 +8,7 @@
 #include "bvh/split.h"
 
 #include "bvh/build.h"
+#include "bvh/partition.h"
 #include "bvh/sort.h"
 
 #include "scene/hair.h"
@@ -150,9 +151,82 @@ BVHSpatialSplit::BVHSpatialSplit(const BVHBuild &builder,
   float3 binSize = (range_bounds.max - origin) * (1.0f / (float)BVHParams::NUM_SPATIAL_BINS);
   float3 invBinSize = 1.0f / binSize;
 
+  if (bvh_use_parallel_blocks(range.size())) {
+    /* Bin blocks of references in parallel, and merge their bins. */
+    vector<SpatialBins> block_bins(bvh_num_parallel_blocks(range.size()));
+    bvh_parallel_for_blocks(
+        range.start(), range.size(), [&](int block, int block_start, int block_end) {
+          bin_references(builder,
+                         block_start,
+                         block_end,
+                         origin,
+                         binSize,
+                         invBinSize,
+                         block_bins[block].bins);
+        });
+
+    for (int dim = 0; dim < 3; dim++) {
+      for (int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
+        BVHSpatialBin &bin = storage_->bins[dim][i];
+        bin = block_bins[0].bins[dim][i];
+        for (size_t block = 1; block < block_bins.size(); block++) {
+          const BVHSpatialBin &block_bin = block_bins[block].bins[dim][i];
+          bin.bounds.grow(block_bin.bounds);
+          bin.enter += block_bin.enter;
+          bin.exit += block_bin.exit;
+        }
+      }
+    }
+  }
+  else {
+    bin_references(
+        builder, range.start(), range.end(), origin, binSize, invBinSize, storage_->bins);
+  }
+
+  /* select best split plane. */
+  storage_->right_bounds.resize(BVHParams::NUM_SPATIAL_BINS);
+  for (int dim = 0; dim < 3; dim++) {
+    /* sweep right to left and determine bounds. */
+    BoundBox right_bounds = BoundBox::empty;
+    for (int i = BVHParams::NUM_SPATIAL_BINS - 1; i > 0; i--) {
+      right_bounds.grow(storage_->bins[dim][i].bounds);
+      storage_->right_bounds[i - 1] = right_bounds;
+    }
+
+    /* sweep left to right and select lowest SAH. */
+    BoundBox left_bounds = BoundBox::empty;
+    int leftNum = 0;
+    int rightNum = range.size();
+
+    for (int i = 1; i < BVHParams::NUM_SPATIAL_BINS; i++) {
+      left_bounds.grow(storage_->bins[dim][i - 1].bounds);
+      leftNum += storage_->bins[dim][i - 1].enter;
+      rightNum -= storage_->bins[dim][i - 1].exit;
+
+      float sah = nodeSAH + left_bounds.safe_area() * builder.params.primitive_cost(leftNum) +
+                  storage_->right_bounds[i - 1].safe_area() *
+                      builder.params.primitive_cost(rightNum);
+
+      if (sah < this->sah) {
+        this->sah = sah;
+        this->dim = dim;
+        this->pos = origin[dim] + binSize[dim] * (float)i;
+      }
+    }
+  }
+}
+
+void BVHSpatialSplit::bin_references(const BVHBuild &builder,
+                                     const int begin,
+                                     const int end,
+                                     const float3 origin,
+                                     const float3 binSize,
+                                     const float3 invBinSize,
+                                     BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS])
+{
   for (int dim = 0; dim < 3; dim++) {
     for (int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
-      BVHSpatialBin &bin = storage_->bins[dim][i];
+      BVHSpatialBin &bin = bins[dim][i];
 
       bin.bounds = BoundBox::empty;
       bin.enter = 0;
@@ -161,7 +235,7 @@ BVHSpatialSplit::BVHSpatialSplit(const BVHBuild &builder,
   }
 
   /* chop references into bins. */
-  for (unsigned int refIdx = range.start(); refIdx < range.end(); refIdx++) {
+  for (int refIdx = begin; refIdx < end; refIdx++) {
     const BVHReference &ref = references_->at(refIdx);
     BoundBox prim_bounds = get_prim_bounds(ref);
     float3 firstBinf = (prim_bounds.min - origin) * invBinSize;
@@ -181,48 +255,38 @@ BVHSpatialSplit::BVHSpatialSplit(const BVHBuild &builder,
 
         split_reference(
             builder, leftRef, rightRef, currRef, dim, origin[dim] + binSize[dim] * (float)(i + 1));
-        storage_->bins[dim][i].bounds.grow(leftRef.bounds());
+        bins[dim][i].bounds.grow(leftRef.bounds());
         currRef = rightRef;
       }
 
-      storage_->bins[dim][lastBin[dim]].bounds.grow(currRef.bounds());
-      storage_->bins[dim][firstBin[dim]].enter++;
-      storage_->bins[dim][lastBin[dim]].exit++;
+      bins[dim][lastBin[dim]].bounds.grow(currRef.bounds());
+      bins[dim][firstBin[dim]].enter++;
+      bins[dim][lastBin[dim]].exit++;
     }
   }
+}
 
-  /* select best split plane. */
-  storage_->right_bounds.resize(BVHParams::NUM_SPATIAL_BINS);
-  for (int dim = 0; dim < 3; dim++) {
-    /* sweep right to left and determine bounds. */
-    BoundBox right_bounds = BoundBox::empty;
-    for (int i = BVHParams::NUM_SPATIAL_BINS - 1; i > 0; i--) {
-      right_bounds.grow(storage_->bins[dim][i].bounds);
-      storage_->right_bounds[i - 1] = right_bounds;
-    }
-
-    /* sweep left to right and select lowest SAH. */
-    BoundBox left_bounds = BoundBox::empty;
-    int leftNum = 0;
-    int rightNum = range.size();
+/* Bounds of references on either side of a spatial split, accumulated while partitioning. */
+struct BVHSpatialSplit::SideBounds {
+  const BVHSpatialSplit *split;
+  BoundBox bounds[2];
 
-    for (int i = 1; i < BVHParams::NUM_SPATIAL_BINS; i++) {
-      left_bounds.grow(storage_->bins[dim][i - 1].bounds);
-      leftNum += storage_->bins[dim][i - 1].enter;
-      rightNum -= storage_->bins[dim][i - 1].exit;
+  SideBounds(const BVHSpatialSplit *split) : split(split)
+  {
+    bounds[0] = bounds[1] = BoundBox::empty;
+  }
 
-      float sah = nodeSAH + left_bounds.safe_area() * builder.params.primitive_cost(leftNum) +
-                  storage_->right_bounds[i - 1].safe_area() *
-                      builder.params.primitive_cost(rightNum);
+  __forceinline void add(const BVHReference &ref, const bool first)
+  {
+    bounds[first ? 0 : 1].grow(split->get_prim_bounds(ref));
+  }
 
-      if (sah < this->sah) {
-        this->sah = sah;
-        this->dim = dim;
-        this->pos = origin[dim] + binSize[dim] * (float)i;
-      }
-    }
+  __forceinline void merge(const SideBounds &other)
+  {
+    bounds[0].grow(other.bounds[0]);
+    bounds[1].grow(other.bounds[1]);
   }
-}
+};
 
 void BVHSpatialSplit::split(BVHBuild *builder,
                             BVHRange &left,
@@ -243,6 +307,30 @@ void BVHSpatialSplit::split(BVHBuild *builder,
   BoundBox left_bounds = BoundBox::empty;
   BoundBox right_bounds = BoundBox::empty;
 
+  if (bvh_use_parallel_blocks(range.size())) {
+    /* Partition blocks of references in parallel, first moving references entirely on the
+     * left-hand side to the start, then the ones entirely on the right-hand side to the end. */
+    SideBounds side_bounds(this);
+    const int num_left = bvh_parallel_partition(
+        refs.data(),
+        left_start,
+        range.size(),
+        [&](const BVHReference &ref) { return get_prim_bounds(ref).max[this->dim] <= this->pos; },
+        side_bounds);
+    left_end = left_start + num_left;
+    left_bounds = side_bounds.bounds[0];
+
+    side_bounds = SideBounds(this);
+    const int num_unsplit = bvh_parallel_partition(
+        refs.data(),
+        left_end,
+        right_start - left_end,
+        [&](const BVHReference &ref) { return get_prim_bounds(ref).min[this->dim] < this->pos; },
+        side_bounds);
+    right_start = left_end + num_unsplit;
+    right_bounds = side_bounds.bounds[1];
+  }
+
   for (int i = left_end; i < right_start; i++) {
     BoundBox prim_bounds = get_prim_bounds(refs[i]);
     if (prim_bounds.max[this->dim] <= this->pos) {
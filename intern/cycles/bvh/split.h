@@ -89,6 +89,20 @@ class BVHSpatialSplit {
   const BVHUnaligned *unaligned_heuristic_;
   const Transform *aligned_space_;
 
+  struct SpatialBins {
+    BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS];
+  };
+  struct SideBounds;
+
+  /* Chop references in [begin, end[ into bins. */
+  void bin_references(const BVHBuild &builder,
+                      const int begin,
+                      const int end,
+                      const float3 origin,
+                      const float3 binSize,
+                      const float3 invBinSize,
+                      BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS]);
+
   /* Lower-level functions which calculates boundaries of left and right nodes
    * needed for spatial split.
    *
@@ -70,6 +70,7 @@ CPUDevice::CPUDevice(const DeviceInfo &info_, Stats &stats_, Profiler &profiler_
 #ifdef WITH_OSL
   kernel_globals.osl = &osl_globals;
 #endif
+  kernel_globals.image_cache = &image_cache;
 #ifdef WITH_EMBREE
   embree_device = rtcNewDevice("verbose=0");
 #endif
@@ -96,6 +97,29 @@ BVHLayoutMask CPUDevice::get_bvh_layout_mask(uint /*kernel_features*/) const
 
 bool CPUDevice::load_texture_info()
 {
+  /* Images in the texture cache have no pixels in memory. Make sure their slots exist and have
+   * no data, so that the kernel looks them up in the cache. The texture info is only uploaded
+   * again when one of the slots changes. */
+  if (image_cache.is_initialized()) {
+    const int num_cache_slots = image_cache.num_slots();
+    const size_t num_slots = texture_info.size();
+    if (size_t(num_cache_slots) > num_slots) {
+      /* Allocate some slots in advance, and clear them since resizing leaves them
+       * uninitialized. */
+      texture_info.resize(num_cache_slots + 128);
+      for (size_t slot = num_slots; slot < texture_info.size(); slot++) {
+        texture_info[slot] = TextureInfo();
+      }
+      need_texture_info = true;
+    }
+    for (int slot = 0; slot < num_cache_slots; slot++) {
+      if (image_cache.has_image(slot) && texture_info[slot].data != 0) {
+        texture_info[slot] = TextureInfo();
+        need_texture_info = true;
+      }
+    }
+  }
+
   if (!need_texture_info) {
     return false;
   }
@@ -326,6 +350,11 @@ void *CPUDevice::get_cpu_osl_memory()
 #endif
 }
 
+KernelImageCache *CPUDevice::get_cpu_image_cache()
+{
+  return &image_cache;
+}
+
 bool CPUDevice::load_kernels(const uint /*kernel_features*/)
 {
   return true;
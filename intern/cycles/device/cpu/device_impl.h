@@ -27,6 +27,7 @@
 #include "kernel/device/cpu/compat.h"
 #include "kernel/device/cpu/kernel.h"
 #include "kernel/device/cpu/globals.h"
+#include "kernel/device/cpu/image_cache.h"
 
 #include "kernel/osl/globals.h"
 // clang-format on
@@ -43,6 +44,8 @@ class CPUDevice : public Device {
   device_vector<TextureInfo> texture_info;
   bool need_texture_info;
 
+  KernelImageCache image_cache;
+
 #ifdef WITH_OSL
   OSLGlobals osl_globals;
 #endif
@@ -88,6 +91,7 @@ class CPUDevice : public Device {
   virtual void get_cpu_kernel_thread_globals(
       vector<CPUKernelThreadGlobals> &kernel_thread_globals) override;
   virtual void *get_cpu_osl_memory() override;
+  virtual KernelImageCache *get_cpu_image_cache() override;
 
  protected:
   virtual bool load_kernels(uint /*kernel_features*/) override;
@@ -19,9 +19,11 @@ template<typename FunctionType> class CPUKernelFunction {
   CPUKernelFunction(FunctionType kernel_default,
                     FunctionType kernel_sse2,
                     FunctionType kernel_sse41,
-                    FunctionType kernel_avx2)
+                    FunctionType kernel_avx2,
+                    FunctionType kernel_avx512)
   {
-    kernel_info_ = get_best_kernel_info(kernel_default, kernel_sse2, kernel_sse41, kernel_avx2);
+    kernel_info_ = get_best_kernel_info(
+        kernel_default, kernel_sse2, kernel_sse41, kernel_avx2, kernel_avx512);
   }
 
   template<typename... Args> inline auto operator()(Args... args) const
@@ -57,12 +59,20 @@ template<typename FunctionType> class CPUKernelFunction {
   KernelInfo get_best_kernel_info(FunctionType kernel_default,
                                   FunctionType kernel_sse2,
                                   FunctionType kernel_sse41,
-                                  FunctionType kernel_avx2)
+                                  FunctionType kernel_avx2,
+                                  FunctionType kernel_avx512)
   {
     /* Silence warnings about unused variables when compiling without some architectures. */
     (void)kernel_sse2;
     (void)kernel_sse41;
     (void)kernel_avx2;
+    (void)kernel_avx512;
+
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX512
+    if (DebugFlags().cpu.has_avx512() && system_cpu_support_avx512()) {
+      return KernelInfo("AVX512", kernel_avx512);
+    }
+#endif
 
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
     if (DebugFlags().cpu.has_avx2() && system_cpu_support_avx2()) {
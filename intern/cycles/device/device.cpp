@@ -20,6 +20,7 @@
 #include "device/multi/device.h"
 #include "device/oneapi/device.h"
 #include "device/optix/device.h"
+#include "device/remote/device.h"
 
 #include "util/foreach.h"
 #include "util/half.h"
@@ -43,6 +44,7 @@ vector<DeviceInfo> Device::cpu_devices;
 vector<DeviceInfo> Device::hip_devices;
 vector<DeviceInfo> Device::metal_devices;
 vector<DeviceInfo> Device::oneapi_devices;
+vector<DeviceInfo> Device::remote_devices;
 uint Device::devices_initialized_mask = 0;
 
 /* Device */
@@ -110,6 +112,13 @@ Device *Device::create(const DeviceInfo &info, Stats &stats, Profiler &profiler)
       break;
 #endif
 
+#ifdef WITH_REMOTE
+    case DEVICE_REMOTE:
+      if (device_remote_init())
+        device = device_remote_create(info, stats, profiler);
+      break;
+#endif
+
     default:
       break;
   }
@@ -139,6 +148,8 @@ DeviceType Device::type_from_string(const char *name)
     return DEVICE_ONEAPI;
   else if (strcmp(name, "HIPRT") == 0)
     return DEVICE_HIPRT;
+  else if (strcmp(name, "REMOTE") == 0)
+    return DEVICE_REMOTE;
 
   return DEVICE_NONE;
 }
@@ -161,6 +172,8 @@ string Device::string_from_type(DeviceType type)
     return "ONEAPI";
   else if (type == DEVICE_HIPRT)
     return "HIPRT";
+  else if (type == DEVICE_REMOTE)
+    return "REMOTE";
 
   return "";
 }
@@ -187,6 +200,9 @@ vector<DeviceType> Device::available_types()
 #ifdef WITH_HIPRT
   if (hiprtewInit())
     types.push_back(DEVICE_HIPRT);
+#endif
+#ifdef WITH_REMOTE
+  types.push_back(DEVICE_REMOTE);
 #endif
   return types;
 }
@@ -281,6 +297,20 @@ vector<DeviceInfo> Device::available_devices(uint mask)
   }
 #endif
 
+#ifdef WITH_REMOTE
+  if (mask & DEVICE_MASK_REMOTE) {
+    if (!(devices_initialized_mask & DEVICE_MASK_REMOTE)) {
+      if (device_remote_init()) {
+        device_remote_info(remote_devices);
+      }
+      devices_initialized_mask |= DEVICE_MASK_REMOTE;
+    }
+    foreach (DeviceInfo &info, remote_devices) {
+      devices.push_back(info);
+    }
+  }
+#endif
+
   return devices;
 }
 
@@ -350,6 +380,18 @@ string Device::device_capabilities(uint mask)
   }
 #endif
 
+#ifdef WITH_REMOTE
+  if (mask & DEVICE_MASK_REMOTE) {
+    if (device_remote_init()) {
+      const string device_capabilities = device_remote_capabilities();
+      if (!device_capabilities.empty()) {
+        capabilities += "\nRemote device capabilities:\n";
+        capabilities += device_capabilities;
+      }
+    }
+  }
+#endif
+
   return capabilities;
 }
 
@@ -448,6 +490,7 @@ void Device::free_memory()
   oneapi_devices.free_memory();
   cpu_devices.free_memory();
   metal_devices.free_memory();
+  remote_devices.free_memory();
 }
 
 unique_ptr<DeviceQueue> Device::gpu_queue_create()
@@ -474,6 +517,11 @@ void *Device::get_cpu_osl_memory()
   return nullptr;
 }
 
+KernelImageCache *Device::get_cpu_image_cache()
+{
+  return nullptr;
+}
+
 GPUDevice::~GPUDevice() noexcept(false) {}
 
 bool GPUDevice::load_texture_info()
@@ -30,6 +30,7 @@ class DeviceQueue;
 class Progress;
 class CPUKernels;
 class CPUKernelThreadGlobals;
+class KernelImageCache;
 class Scene;
 
 /* Device Types */
@@ -44,6 +45,7 @@ enum DeviceType {
   DEVICE_HIPRT,
   DEVICE_METAL,
   DEVICE_ONEAPI,
+  DEVICE_REMOTE,
   DEVICE_DUMMY,
 };
 
@@ -54,6 +56,7 @@ enum DeviceTypeMask {
   DEVICE_MASK_HIP = (1 << DEVICE_HIP),
   DEVICE_MASK_METAL = (1 << DEVICE_METAL),
   DEVICE_MASK_ONEAPI = (1 << DEVICE_ONEAPI),
+  DEVICE_MASK_REMOTE = (1 << DEVICE_REMOTE),
   DEVICE_MASK_ALL = ~0
 };
 
@@ -206,6 +209,8 @@ class Device {
       vector<CPUKernelThreadGlobals> & /*kernel_thread_globals*/);
   /* Get OpenShadingLanguage memory buffer. */
   virtual void *get_cpu_osl_memory();
+  /* Get on-demand image texture cache, if supported by the device. */
+  virtual KernelImageCache *get_cpu_image_cache();
 
   /* acceleration structure building */
   virtual void build_bvh(BVH *bvh, Progress &progress, bool refit);
@@ -306,6 +311,7 @@ class Device {
   static vector<DeviceInfo> hip_devices;
   static vector<DeviceInfo> metal_devices;
   static vector<DeviceInfo> oneapi_devices;
+  static vector<DeviceInfo> remote_devices;
   static uint devices_initialized_mask;
 };
 
@@ -0,0 +1,123 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "device/remote/device.h"
+
+#include "util/log.h"
+
+#ifdef WITH_REMOTE
+#  include "device/device.h"
+#  include "device/remote/device_impl.h"
+#  include "device/remote/socket.h"
+
+#  include "util/string.h"
+#endif /* WITH_REMOTE */
+
+CCL_NAMESPACE_BEGIN
+
+bool device_remote_init()
+{
+#ifdef WITH_REMOTE
+  return true;
+#else
+  return false;
+#endif
+}
+
+Device *device_remote_create(const DeviceInfo &info, Stats &stats, Profiler &profiler)
+{
+#ifdef WITH_REMOTE
+  return new RemoteDevice(info, stats, profiler);
+#else
+  (void)info;
+  (void)stats;
+  (void)profiler;
+
+  LOG(FATAL) << "Request to create remote device without compiled-in support. Should never "
+                "happen.";
+
+  return nullptr;
+#endif
+}
+
+#ifdef WITH_REMOTE
+static vector<string> remote_worker_addresses()
+{
+  vector<string> addresses;
+
+  const char *workers = getenv("CYCLES_REMOTE_WORKERS");
+  if (workers == nullptr) {
+    return addresses;
+  }
+
+  string_split(addresses, workers, ", ");
+  return addresses;
+}
+#endif
+
+bool device_remote_worker_info(const string &address, const int num, DeviceInfo &info)
+{
+#ifdef WITH_REMOTE
+  string host;
+  int port;
+  if (!remote_parse_address(address, host, port)) {
+    VLOG_WARNING << "Invalid remote worker address " << address;
+    return false;
+  }
+
+  RemoteSocket socket;
+  string description, error;
+  if (!socket.connect(host, port, error) || !RemoteDevice::hello(socket, description, error)) {
+    VLOG_WARNING << "Remote worker " << address << " is not available: " << error;
+    return false;
+  }
+
+  info.type = DEVICE_REMOTE;
+  info.description = description + " (" + address + ")";
+  info.id = RemoteDevice::id_prefix + address;
+  info.num = num;
+  info.has_nanovdb = true;
+  info.has_light_tree = true;
+  info.has_mnee = true;
+  info.has_osl = false;
+  info.has_guiding = false;
+  info.has_profiling = false;
+  info.denoisers = DENOISER_NONE;
+
+  return true;
+#else
+  (void)address;
+  (void)num;
+  (void)info;
+  return false;
+#endif
+}
+
+void device_remote_info(vector<DeviceInfo> &devices)
+{
+#ifdef WITH_REMOTE
+  for (const string &address : remote_worker_addresses()) {
+    DeviceInfo info;
+    if (device_remote_worker_info(address, devices.size(), info)) {
+      VLOG_INFO << "Added device \"" << info.description << "\" with id \"" << info.id << "\".";
+      devices.push_back(info);
+    }
+  }
+#else
+  (void)devices;
+#endif
+}
+
+string device_remote_capabilities()
+{
+  string capabilities;
+#ifdef WITH_REMOTE
+  for (const string &address : remote_worker_addresses()) {
+    capabilities += "\t" + address + "\n";
+  }
+#endif
+  return capabilities;
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,30 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#pragma once
+
+#include "util/string.h"
+#include "util/vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class Device;
+class DeviceInfo;
+class Profiler;
+class Stats;
+
+bool device_remote_init();
+
+Device *device_remote_create(const DeviceInfo &info, Stats &stats, Profiler &profiler);
+
+/* Devices for the workers listed in the CYCLES_REMOTE_WORKERS environment variable, as comma
+ * separated host:port addresses. Workers which can not be reached are skipped. */
+void device_remote_info(vector<DeviceInfo> &devices);
+
+/* Connect to the worker at the given host:port address to fill in the device info. */
+bool device_remote_worker_info(const string &address, const int num, DeviceInfo &info);
+
+string device_remote_capabilities();
+
+CCL_NAMESPACE_END
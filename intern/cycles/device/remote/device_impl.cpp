@@ -0,0 +1,256 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#ifdef WITH_REMOTE
+
+#  include "device/remote/device_impl.h"
+
+#  include "kernel/types.h"
+
+#  include "util/aligned_malloc.h"
+#  include "util/log.h"
+#  include "util/string.h"
+
+CCL_NAMESPACE_BEGIN
+
+RemoteDevice::RemoteDevice(const DeviceInfo &info_, Stats &stats_, Profiler &profiler_)
+    : Device(info_, stats_, profiler_)
+{
+  address_ = info.id.substr(strlen(id_prefix));
+
+  string host, description, error;
+  int port;
+  if (!remote_parse_address(address_, host, port)) {
+    set_error("Invalid remote worker address " + address_);
+    return;
+  }
+
+  if (!socket_.connect(host, port, error) || !hello(socket_, description, error)) {
+    socket_.close();
+    set_error("Remote worker " + address_ + ": " + error);
+    return;
+  }
+
+  VLOG_INFO << "Connected to remote worker " << address_ << ": " << description;
+}
+
+RemoteDevice::~RemoteDevice()
+{
+  /* Closing the connection is enough for the worker to free everything. */
+  socket_.close();
+}
+
+bool RemoteDevice::hello(RemoteSocket &socket, string &description, string &error)
+{
+  RemoteMessage args, reply;
+  args.write(REMOTE_PROTOCOL_VERSION);
+  args.write(uint64_t(sizeof(KernelData)));
+
+  uint reply_type;
+  if (!socket.send_message(REMOTE_REQUEST_HELLO, args) || !socket.recv_message(reply_type, reply))
+  {
+    error = "Failed to communicate with worker";
+    return false;
+  }
+
+  if (reply_type != REMOTE_REPLY_OK) {
+    if (!reply.read_string(error)) {
+      error = "Worker is not compatible";
+    }
+    return false;
+  }
+
+  if (!reply.read_string(description)) {
+    error = "Invalid reply from worker";
+    return false;
+  }
+
+  return true;
+}
+
+bool RemoteDevice::request(const RemoteRequest request,
+                           const RemoteMessage &args,
+                           RemoteMessage &reply)
+{
+  thread_scoped_lock lock(socket_mutex_);
+
+  if (!socket_.is_open()) {
+    return false;
+  }
+
+  uint reply_type;
+  if (!socket_.send_message(request, args) || !socket_.recv_message(reply_type, reply)) {
+    socket_.close();
+    set_error("Lost connection to remote worker " + address_);
+    return false;
+  }
+
+  if (reply_type != REMOTE_REPLY_OK) {
+    string message;
+    reply.read_string(message);
+    set_error("Remote worker " + address_ + ": " + message);
+    return false;
+  }
+
+  return true;
+}
+
+bool RemoteDevice::request(const RemoteRequest request, const RemoteMessage &args)
+{
+  RemoteMessage reply;
+  return this->request(request, args, reply);
+}
+
+BVHLayoutMask RemoteDevice::get_bvh_layout_mask(uint /*kernel_features*/) const
+{
+  /* BVH is built on the host and sent to the worker as global memory, so it can only be a
+   * layout which is fully contained in it. */
+  return BVH_LAYOUT_BVH2;
+}
+
+bool RemoteDevice::load_kernels(const uint kernel_features)
+{
+  RemoteMessage args;
+  args.write(kernel_features);
+  return request(REMOTE_REQUEST_LOAD_KERNELS, args);
+}
+
+void RemoteDevice::const_copy_to(const char *name, void *host, size_t size)
+{
+  RemoteMessage args;
+  args.write_string(name);
+  args.write(uint64_t(size));
+  args.write_data(host, size);
+  request(REMOTE_REQUEST_CONST_COPY_TO, args);
+}
+
+void RemoteDevice::mem_alloc(device_memory &mem)
+{
+  if (mem.type == MEM_TEXTURE) {
+    assert(!"mem_alloc not supported for textures.");
+  }
+  else if (mem.type == MEM_GLOBAL) {
+    assert(!"mem_alloc not supported for global memory.");
+  }
+  else {
+    if (mem.type == MEM_DEVICE_ONLY || !mem.host_pointer) {
+      void *data = util_aligned_malloc(mem.memory_size(), MIN_ALIGNMENT_CPU_DATA_TYPES);
+      mem.device_pointer = (device_ptr)data;
+    }
+    else {
+      mem.device_pointer = (device_ptr)mem.host_pointer;
+    }
+
+    mem.device_size = mem.memory_size();
+    stats.mem_alloc(mem.device_size);
+  }
+}
+
+void RemoteDevice::mem_copy_to(device_memory &mem)
+{
+  if (mem.type == MEM_GLOBAL || mem.type == MEM_TEXTURE) {
+    remote_copy_to(mem);
+  }
+  else if (!mem.device_pointer) {
+    mem_alloc(mem);
+  }
+}
+
+void RemoteDevice::mem_copy_from(
+    device_memory & /*mem*/, size_t /*y*/, size_t /*w*/, size_t /*h*/, size_t /*elem*/)
+{
+  /* Memory which is not sent to the worker lives on the host, copy is no-op. */
+}
+
+void RemoteDevice::mem_zero(device_memory &mem)
+{
+  if (mem.type == MEM_GLOBAL || mem.type == MEM_TEXTURE) {
+    if (mem.host_pointer) {
+      memset(mem.host_pointer, 0, mem.memory_size());
+      remote_copy_to(mem);
+    }
+    return;
+  }
+
+  if (!mem.device_pointer) {
+    mem_alloc(mem);
+  }
+
+  if (mem.device_pointer) {
+    memset((void *)mem.device_pointer, 0, mem.memory_size());
+  }
+}
+
+void RemoteDevice::mem_free(device_memory &mem)
+{
+  if (mem.type == MEM_GLOBAL || mem.type == MEM_TEXTURE) {
+    remote_free(mem);
+  }
+  else if (mem.device_pointer) {
+    if (mem.type == MEM_DEVICE_ONLY || !mem.host_pointer) {
+      util_aligned_free((void *)mem.device_pointer);
+    }
+    mem.device_pointer = 0;
+    stats.mem_free(mem.device_size);
+    mem.device_size = 0;
+  }
+}
+
+void RemoteDevice::remote_copy_to(device_memory &mem)
+{
+  if (mem.name) {
+    VLOG_WORK << "Remote memory copy: " << mem.name << ", "
+              << string_human_readable_number(mem.memory_size()) << " bytes. ("
+              << string_human_readable_size(mem.memory_size()) << ")";
+  }
+
+  if (mem.device_pointer) {
+    stats.mem_free(mem.device_size);
+  }
+  else {
+    mem.device_pointer = next_remote_pointer_++;
+  }
+
+  mem.device_size = mem.memory_size();
+  stats.mem_alloc(mem.device_size);
+
+  RemoteMessage args;
+  args.write(uint64_t(mem.device_pointer));
+  args.write_string(mem.name ? mem.name : "");
+  args.write(int(mem.type));
+  args.write(int(mem.data_type));
+  args.write(int(mem.data_elements));
+  args.write(uint64_t(mem.data_size));
+  args.write(uint64_t(mem.data_width));
+  args.write(uint64_t(mem.data_height));
+  args.write(uint64_t(mem.data_depth));
+  if (mem.type == MEM_TEXTURE) {
+    const device_texture &tex = (const device_texture &)mem;
+    args.write(uint(tex.slot));
+    args.write(tex.info);
+  }
+  args.write(uint64_t(mem.memory_size()));
+  args.write_data(mem.host_pointer, mem.memory_size());
+
+  request(REMOTE_REQUEST_MEM_COPY_TO, args);
+}
+
+void RemoteDevice::remote_free(device_memory &mem)
+{
+  if (!mem.device_pointer) {
+    return;
+  }
+
+  RemoteMessage args;
+  args.write(uint64_t(mem.device_pointer));
+  request(REMOTE_REQUEST_MEM_FREE, args);
+
+  mem.device_pointer = 0;
+  stats.mem_free(mem.device_size);
+  mem.device_size = 0;
+}
+
+CCL_NAMESPACE_END
+
+#endif /* WITH_REMOTE */
@@ -0,0 +1,71 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#pragma once
+
+#ifdef WITH_REMOTE
+
+#  include "device/device.h"
+#  include "device/remote/protocol.h"
+#  include "device/remote/socket.h"
+
+#  include "util/thread.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Device which renders in a worker process, possibly on another machine.
+ *
+ * The scene is kept in host memory like on the CPU device. Kernel data, global arrays and
+ * textures are additionally sent to the worker whenever they are copied to the device, so the
+ * worker has a copy of everything the kernels read. All other memory such as render buffers
+ * stays on the host, and is exchanged with the worker by PathTraceWorkRemote.
+ *
+ * Multiple workers are combined with a MultiDevice, which lets the WorkBalancer distribute the
+ * render buffer between them based on their measured render time. */
+class RemoteDevice : public Device {
+ public:
+  /* Device id of a worker is the prefix followed by its address. */
+  static constexpr const char *id_prefix = "REMOTE_";
+
+  RemoteDevice(const DeviceInfo &info_, Stats &stats_, Profiler &profiler_);
+  ~RemoteDevice();
+
+  virtual BVHLayoutMask get_bvh_layout_mask(uint /*kernel_features*/) const override;
+
+  virtual bool load_kernels(const uint kernel_features) override;
+
+  virtual void const_copy_to(const char *name, void *host, size_t size) override;
+
+  /* Send request to the worker and wait for its reply. On failure the device error is set, the
+   * connection is closed and all further requests fail. */
+  bool request(const RemoteRequest request, const RemoteMessage &args, RemoteMessage &reply);
+  bool request(const RemoteRequest request, const RemoteMessage &args);
+
+  /* Check that the worker on the other side of the socket is compatible with this build, and
+   * get its description. */
+  static bool hello(RemoteSocket &socket, string &description, string &error);
+
+ protected:
+  virtual void mem_alloc(device_memory &mem) override;
+  virtual void mem_copy_to(device_memory &mem) override;
+  virtual void mem_copy_from(device_memory &mem, size_t y, size_t w, size_t h, size_t elem)
+      override;
+  virtual void mem_zero(device_memory &mem) override;
+  virtual void mem_free(device_memory &mem) override;
+
+  /* Send global memory or texture to the worker. */
+  void remote_copy_to(device_memory &mem);
+  void remote_free(device_memory &mem);
+
+  string address_;
+  RemoteSocket socket_;
+  thread_mutex socket_mutex_;
+
+  /* Global memory and textures are identified on the worker by a unique number. */
+  device_ptr next_remote_pointer_ = 1;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* WITH_REMOTE */
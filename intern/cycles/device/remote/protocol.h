@@ -0,0 +1,157 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+#include "util/string.h"
+#include "util/types.h"
+#include "util/vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Remote Device Protocol
+ *
+ * The render host sends requests to a worker process, and waits for the reply of every request
+ * before sending the next one. Every message is a fixed size header followed by the payload.
+ *
+ * Values are sent in the byte order and layout of the host, so the render host and all of its
+ * workers must be the same build of Cycles on the same architecture. This is verified when
+ * connecting, by comparing the protocol version and size of the kernel data. */
+
+/* Increment when any of the messages change. */
+static const uint REMOTE_PROTOCOL_VERSION = 1;
+
+/* Default port workers listen on. */
+static const int REMOTE_DEFAULT_PORT = 5120;
+
+/* Default address workers listen on. Connections are not authenticated, so workers only accept
+ * connections from the local machine unless another address is chosen explicitly. */
+static const char *const REMOTE_DEFAULT_BIND_ADDRESS = "127.0.0.1";
+
+enum RemoteRequest {
+  /* Check compatibility of the worker, and query its description. */
+  REMOTE_REQUEST_HELLO = 0,
+
+  /* Device memory and constants, see RemoteDevice. */
+  REMOTE_REQUEST_MEM_COPY_TO,
+  REMOTE_REQUEST_MEM_FREE,
+  REMOTE_REQUEST_CONST_COPY_TO,
+  REMOTE_REQUEST_LOAD_KERNELS,
+
+  /* Path tracing of the render buffers of the worker, see PathTraceWorkRemote. */
+  REMOTE_REQUEST_WORK_INIT_EXECUTION,
+  REMOTE_REQUEST_WORK_RENDER_SAMPLES,
+  REMOTE_REQUEST_WORK_COPY_FROM_DEVICE,
+  REMOTE_REQUEST_WORK_COPY_TO_DEVICE,
+  REMOTE_REQUEST_WORK_ZERO,
+  REMOTE_REQUEST_WORK_ADAPTIVE_SAMPLING,
+  REMOTE_REQUEST_WORK_CRYPTOMATTE,
+
+  /* Shader evaluation, see ShaderEval. */
+  REMOTE_REQUEST_SHADER_EVAL,
+
+  REMOTE_REQUEST_NUM,
+};
+
+enum RemoteReply {
+  REMOTE_REPLY_OK = 0,
+  /* Payload is the error message. */
+  REMOTE_REPLY_ERROR,
+};
+
+struct RemoteMessageHeader {
+  uint magic;
+  uint type;
+  uint64_t size;
+};
+
+static const uint REMOTE_MESSAGE_MAGIC = 0x52435943; /* CYCR */
+
+/* Largest payload of a message. The size in the header is checked against this before allocating
+ * memory for the payload, so a malformed or hostile message can not exhaust the memory. It is big
+ * enough for the render buffers of a 16k image with a typical number of passes. */
+static const uint64_t REMOTE_MESSAGE_MAX_SIZE = uint64_t(16) << 30;
+
+/* Payload of a message.
+ *
+ * Values are appended with the write functions, and read back in the same order. Reads past the
+ * end of the payload fail, so a malformed message can not cause reads of arbitrary memory. */
+class RemoteMessage {
+ public:
+  void clear()
+  {
+    data.clear();
+    offset = 0;
+  }
+
+  template<typename T> void write(const T &value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be sent");
+    write_data(&value, sizeof(T));
+  }
+
+  void write_data(const void *value, const size_t size)
+  {
+    const uint8_t *bytes = (const uint8_t *)value;
+    data.insert(data.end(), bytes, bytes + size);
+  }
+
+  void write_string(const string &value)
+  {
+    write(uint64_t(value.size()));
+    write_data(value.data(), value.size());
+  }
+
+  template<typename T> bool read(T &value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be received");
+    return read_data(&value, sizeof(T));
+  }
+
+  bool read_data(void *value, const size_t size)
+  {
+    const uint8_t *bytes = read_data(size);
+    if (bytes == nullptr) {
+      return false;
+    }
+    if (size) {
+      memcpy(value, bytes, size);
+    }
+    return true;
+  }
+
+  /* Returns pointer to the next size bytes of the payload, or nullptr when the payload is too
+   * short. The pointer is valid until the message is modified. */
+  const uint8_t *read_data(const size_t size)
+  {
+    if (size > data.size() - offset) {
+      return nullptr;
+    }
+    const uint8_t *bytes = data.data() + offset;
+    offset += size;
+    return bytes;
+  }
+
+  bool read_string(string &value)
+  {
+    uint64_t size;
+    if (!read(size)) {
+      return false;
+    }
+    const uint8_t *bytes = read_data(size);
+    if (bytes == nullptr) {
+      return false;
+    }
+    value.assign((const char *)bytes, size);
+    return true;
+  }
+
+  vector<uint8_t> data;
+  size_t offset = 0;
+};
+
+CCL_NAMESPACE_END
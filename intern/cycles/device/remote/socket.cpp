@@ -0,0 +1,274 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#ifdef WITH_REMOTE
+
+#  include "device/remote/socket.h"
+
+#  include "util/log.h"
+
+#  include <cerrno>
+#  include <cstdlib>
+
+#  include <netdb.h>
+#  include <netinet/in.h>
+#  include <netinet/tcp.h>
+#  include <sys/socket.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+
+CCL_NAMESPACE_BEGIN
+
+#  ifdef MSG_NOSIGNAL
+static const int REMOTE_SEND_FLAGS = MSG_NOSIGNAL;
+#  else
+static const int REMOTE_SEND_FLAGS = 0;
+#  endif
+
+/* Messages are small requests and replies which are waited for, send them right away. */
+static void socket_set_options(const int fd)
+{
+  const int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#  ifdef SO_NOSIGPIPE
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#  endif
+}
+
+RemoteSocket::~RemoteSocket()
+{
+  close();
+}
+
+RemoteSocket::RemoteSocket(RemoteSocket &&other) noexcept : fd_(other.fd_)
+{
+  other.fd_ = -1;
+}
+
+RemoteSocket &RemoteSocket::operator=(RemoteSocket &&other) noexcept
+{
+  if (this != &other) {
+    close();
+    fd_ = other.fd_;
+    other.fd_ = -1;
+  }
+  return *this;
+}
+
+bool RemoteSocket::connect(const string &host, const int port, string &error)
+{
+  close();
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  struct addrinfo *addresses = nullptr;
+  const int result = getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &addresses);
+  if (result != 0) {
+    error = string_printf("Failed to resolve %s: %s", host.c_str(), gai_strerror(result));
+    return false;
+  }
+
+  for (struct addrinfo *address = addresses; address; address = address->ai_next) {
+    const int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd == -1) {
+      continue;
+    }
+    if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+      fd_ = fd;
+      break;
+    }
+    ::close(fd);
+  }
+
+  freeaddrinfo(addresses);
+
+  if (fd_ == -1) {
+    error = string_printf("Failed to connect to %s:%d", host.c_str(), port);
+    return false;
+  }
+
+  socket_set_options(fd_);
+  return true;
+}
+
+bool RemoteSocket::listen(const string &address, const int port, string &error)
+{
+  close();
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST;
+
+  struct addrinfo *addresses = nullptr;
+  const int result = getaddrinfo(address.c_str(), to_string(port).c_str(), &hints, &addresses);
+  if (result != 0) {
+    error = string_printf("Invalid address %s: %s", address.c_str(), gai_strerror(result));
+    return false;
+  }
+
+  for (struct addrinfo *info = addresses; info; info = info->ai_next) {
+    const int fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if (fd == -1) {
+      continue;
+    }
+
+    const int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (bind(fd, info->ai_addr, info->ai_addrlen) == 0 && ::listen(fd, 4) == 0) {
+      fd_ = fd;
+      break;
+    }
+    ::close(fd);
+  }
+
+  freeaddrinfo(addresses);
+
+  if (fd_ == -1) {
+    error = string_printf("Failed to listen on %s:%d", address.c_str(), port);
+    return false;
+  }
+
+  return true;
+}
+
+RemoteSocket RemoteSocket::accept()
+{
+  RemoteSocket connection;
+
+  while (fd_ != -1) {
+    const int fd = ::accept(fd_, nullptr, nullptr);
+    if (fd != -1) {
+      socket_set_options(fd);
+      connection.fd_ = fd;
+      break;
+    }
+    if (errno != EINTR && errno != ECONNABORTED) {
+      break;
+    }
+  }
+
+  return connection;
+}
+
+void RemoteSocket::close()
+{
+  if (fd_ != -1) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+int RemoteSocket::get_port() const
+{
+  struct sockaddr_storage address;
+  socklen_t address_size = sizeof(address);
+  if (fd_ == -1 || getsockname(fd_, (struct sockaddr *)&address, &address_size) != 0) {
+    return 0;
+  }
+  if (address.ss_family == AF_INET6) {
+    return ntohs(((struct sockaddr_in6 *)&address)->sin6_port);
+  }
+  return ntohs(((struct sockaddr_in *)&address)->sin_port);
+}
+
+bool RemoteSocket::send(const void *data, const size_t size)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+  size_t offset = 0;
+
+  while (offset < size) {
+    const ssize_t result = ::send(fd_, bytes + offset, size - offset, REMOTE_SEND_FLAGS);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      return false;
+    }
+    offset += result;
+  }
+
+  return true;
+}
+
+bool RemoteSocket::recv(void *data, const size_t size)
+{
+  uint8_t *bytes = (uint8_t *)data;
+  size_t offset = 0;
+
+  while (offset < size) {
+    const ssize_t result = ::recv(fd_, bytes + offset, size - offset, 0);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      return false;
+    }
+    offset += result;
+  }
+
+  return true;
+}
+
+bool RemoteSocket::send_message(const uint type, const RemoteMessage &message)
+{
+  RemoteMessageHeader header;
+  header.magic = REMOTE_MESSAGE_MAGIC;
+  header.type = type;
+  header.size = message.data.size();
+
+  if (header.size > REMOTE_MESSAGE_MAX_SIZE) {
+    VLOG_WARNING << "Message of " << header.size << " bytes is too big to be sent";
+    return false;
+  }
+
+  return send(&header, sizeof(header)) && send(message.data.data(), message.data.size());
+}
+
+bool RemoteSocket::recv_message(uint &type, RemoteMessage &message)
+{
+  RemoteMessageHeader header;
+  if (!recv(&header, sizeof(header))) {
+    return false;
+  }
+  if (header.magic != REMOTE_MESSAGE_MAGIC) {
+    VLOG_WARNING << "Received invalid message, closing connection";
+    close();
+    return false;
+  }
+  if (header.size > REMOTE_MESSAGE_MAX_SIZE) {
+    VLOG_WARNING << "Received message of " << header.size << " bytes, closing connection";
+    close();
+    return false;
+  }
+
+  type = header.type;
+  message.clear();
+  message.data.resize(header.size);
+  return recv(message.data.data(), header.size);
+}
+
+bool remote_parse_address(const string &address, string &host, int &port)
+{
+  const size_t colon = address.rfind(':');
+  if (colon == string::npos) {
+    host = address;
+    port = REMOTE_DEFAULT_PORT;
+  }
+  else {
+    host = address.substr(0, colon);
+    port = atoi(address.c_str() + colon + 1);
+  }
+
+  return !host.empty() && port > 0 && port < 65536;
+}
+
+CCL_NAMESPACE_END
+
+#endif /* WITH_REMOTE */
@@ -0,0 +1,65 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#pragma once
+
+#ifdef WITH_REMOTE
+
+#  include "device/remote/protocol.h"
+
+#  include "util/string.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Blocking TCP socket, for connections between render host and workers.
+ *
+ * There is no authentication or encryption, workers are only to be run on trusted networks. */
+class RemoteSocket {
+ public:
+  RemoteSocket() = default;
+  ~RemoteSocket();
+
+  RemoteSocket(const RemoteSocket &) = delete;
+  RemoteSocket &operator=(const RemoteSocket &) = delete;
+  RemoteSocket(RemoteSocket &&other) noexcept;
+  RemoteSocket &operator=(RemoteSocket &&other) noexcept;
+
+  /* Connect to a worker at the given host name or address. */
+  bool connect(const string &host, const int port, string &error);
+
+  /* Listen for connections on the interface with the given numeric address, for example
+   * REMOTE_DEFAULT_BIND_ADDRESS for the local machine only, or "0.0.0.0" for all interfaces.
+   * With port 0 a free port is chosen, which can be queried with get_port(). */
+  bool listen(const string &address, const int port, string &error);
+
+  /* Wait for a connection on a listening socket. Returns a closed socket on failure. */
+  RemoteSocket accept();
+
+  bool is_open() const
+  {
+    return fd_ != -1;
+  }
+
+  void close();
+
+  int get_port() const;
+
+  /* Send or receive exactly size bytes. */
+  bool send(const void *data, const size_t size);
+  bool recv(void *data, const size_t size);
+
+  /* Send or receive a message with header and payload. */
+  bool send_message(const uint type, const RemoteMessage &message);
+  bool recv_message(uint &type, RemoteMessage &message);
+
+ protected:
+  int fd_ = -1;
+};
+
+/* Split "host:port" into its parts, the port is optional. */
+bool remote_parse_address(const string &address, string &host, int &port);
+
+CCL_NAMESPACE_END
+
+#endif /* WITH_REMOTE */
@@ -1162,6 +1162,8 @@ static const char *device_type_for_description(const DeviceType type)
       return "Multi";
     case DEVICE_METAL:
       return "Metal";
+    case DEVICE_REMOTE:
+      return "Remote";
   }
 
   return "UNKNOWN";
@@ -8,6 +8,7 @@
 #include "integrator/path_trace_work.h"
 #include "integrator/path_trace_work_cpu.h"
 #include "integrator/path_trace_work_gpu.h"
+#include "integrator/path_trace_work_remote.h"
 #include "scene/film.h"
 #include "scene/scene.h"
 #include "session/buffers.h"
@@ -28,6 +29,11 @@ unique_ptr<PathTraceWork> PathTraceWork::create(Device *device,
     /* Dummy devices can't perform any work. */
     return nullptr;
   }
+#ifdef WITH_REMOTE
+  if (device->info.type == DEVICE_REMOTE) {
+    return make_unique<PathTraceWorkRemote>(device, film, device_scene, cancel_requested_flag);
+  }
+#endif
 
   return make_unique<PathTraceWorkGPU>(device, film, device_scene, cancel_requested_flag);
 }
@@ -16,12 +16,21 @@
 #include "scene/scene.h"
 #include "session/buffers.h"
 
+#include "util/algorithm.h"
+#include "util/aligned_malloc.h"
 #include "util/atomic.h"
+#include "util/debug.h"
 #include "util/log.h"
 #include "util/tbb.h"
 
 CCL_NAMESPACE_BEGIN
 
+/* Number of paths the wavefront routine of one thread keeps in flight, and size of the work tiles
+ * it renders. Path states are allocated without initialization and only touched as far as they
+ * are used, so the large shadow intersection arrays of the CPU states are not much of a concern. */
+static constexpr int WAVEFRONT_PATHS_NUM = 128;
+static constexpr int WAVEFRONT_TILE_SIZE = 16;
+
 /* Create TBB arena for execution of path tracing and rendering tasks. */
 static inline tbb::task_arena local_tbb_arena_create(const Device *device)
 {
@@ -52,6 +61,11 @@ PathTraceWorkCPU::PathTraceWorkCPU(Device *device,
   DCHECK_EQ(device->info.type, DEVICE_CPU);
 }
 
+PathTraceWorkCPU::~PathTraceWorkCPU()
+{
+  free_wavefront_states();
+}
+
 void PathTraceWorkCPU::init_execution()
 {
   /* Cache per-thread kernel globals. */
@@ -74,31 +88,79 @@ void PathTraceWorkCPU::render_samples(RenderStatistics &statistics,
   }
 
   tbb::task_arena local_arena = local_tbb_arena_create(device_);
-  local_arena.execute([&]() {
-    parallel_for(int64_t(0), total_pixels_num, [&](int64_t work_index) {
-      if (is_cancel_requested()) {
-        return;
+
+  if (use_wavefront()) {
+    if (wavefront_states_.size() != kernel_thread_globals_.size()) {
+      free_wavefront_states();
+      for (int i = 0; i < kernel_thread_globals_.size(); i++) {
+        wavefront_states_.push_back(static_cast<IntegratorStateCPU *>(
+            util_aligned_malloc(sizeof(IntegratorStateCPU) * WAVEFRONT_PATHS_NUM * 2,
+                                max(int(alignof(IntegratorStateCPU)), 16))));
       }
+    }
+
+    const int64_t tiles_x = divide_up(image_width, WAVEFRONT_TILE_SIZE);
+    const int64_t tiles_y = divide_up(image_height, WAVEFRONT_TILE_SIZE);
+
+    local_arena.execute([&]() {
+      parallel_for(int64_t(0), tiles_x * tiles_y, [&](int64_t work_index) {
+        if (is_cancel_requested()) {
+          return;
+        }
+
+        const int tile_y = work_index / tiles_x;
+        const int tile_x = work_index - tile_y * tiles_x;
+        const int x = tile_x * WAVEFRONT_TILE_SIZE;
+        const int y = tile_y * WAVEFRONT_TILE_SIZE;
+
+        KernelWorkTile work_tile;
+        work_tile.x = effective_buffer_params_.full_x + x;
+        work_tile.y = effective_buffer_params_.full_y + y;
+        work_tile.w = min(int(image_width) - x, WAVEFRONT_TILE_SIZE);
+        work_tile.h = min(int(image_height) - y, WAVEFRONT_TILE_SIZE);
+        work_tile.start_sample = start_sample;
+        work_tile.sample_offset = sample_offset;
+        work_tile.num_samples = samples_num;
+        work_tile.offset = effective_buffer_params_.offset;
+        work_tile.stride = effective_buffer_params_.stride;
+
+        CPUKernelThreadGlobals *kernel_globals = kernel_thread_globals_get(kernel_thread_globals_);
+        IntegratorStateCPU *states =
+            wavefront_states_[kernel_globals - kernel_thread_globals_.data()];
+
+        render_samples_wavefront(kernel_globals, states, work_tile, samples_num);
+      });
+    });
+  }
+  else {
+    local_arena.execute([&]() {
+      parallel_for(int64_t(0), total_pixels_num, [&](int64_t work_index) {
+        if (is_cancel_requested()) {
+          return;
+        }
 
-      const int y = work_index / image_width;
-      const int x = work_index - y * image_width;
+        const int y = work_index / image_width;
+        const int x = work_index - y * image_width;
 
-      KernelWorkTile work_tile;
-      work_tile.x = effective_buffer_params_.full_x + x;
-      work_tile.y = effective_buffer_params_.full_y + y;
-      work_tile.w = 1;
-      work_tile.h = 1;
-      work_tile.start_sample = start_sample;
-      work_tile.sample_offset = sample_offset;
-      work_tile.num_samples = 1;
-      work_tile.offset = effective_buffer_params_.offset;
-      work_tile.stride = effective_buffer_params_.stride;
+        KernelWorkTile work_tile;
+        work_tile.x = effective_buffer_params_.full_x + x;
+        work_tile.y = effective_buffer_params_.full_y + y;
+        work_tile.w = 1;
+        work_tile.h = 1;
+        work_tile.start_sample = start_sample;
+        work_tile.sample_offset = sample_offset;
+        work_tile.num_samples = 1;
+        work_tile.offset = effective_buffer_params_.offset;
+        work_tile.stride = effective_buffer_params_.stride;
 
-      CPUKernelThreadGlobals *kernel_globals = kernel_thread_globals_get(kernel_thread_globals_);
+        CPUKernelThreadGlobals *kernel_globals = kernel_thread_globals_get(
+            kernel_thread_globals_);
 
-      render_samples_full_pipeline(kernel_globals, work_tile, samples_num);
+        render_samples_full_pipeline(kernel_globals, work_tile, samples_num);
+      });
     });
-  });
+  }
+
   if (device_->profiler.active()) {
     for (CPUKernelThreadGlobals &kernel_globals : kernel_thread_globals_) {
       kernel_globals.stop_profiling();
@@ -162,6 +224,149 @@ void PathTraceWorkCPU::render_samples_full_pipeline(KernelGlobalsCPU *kernel_glo
   }
 }
 
+bool PathTraceWorkCPU::use_wavefront() const
+{
+  if (!DebugFlags().cpu.wavefront) {
+    return false;
+  }
+
+#ifdef WITH_PATH_GUIDING
+  /* Guiding records the segments of one path at a time in per-thread storage. */
+  if (device_scene_->data.integrator.use_guiding) {
+    return false;
+  }
+#endif
+
+  return true;
+}
+
+void PathTraceWorkCPU::free_wavefront_states()
+{
+  for (IntegratorStateCPU *states : wavefront_states_) {
+    util_aligned_free(states);
+  }
+  wavefront_states_.clear();
+}
+
+/* Whether the path and its shadow paths have no more kernels to execute. */
+static inline bool wavefront_state_is_terminated(const IntegratorStateCPU *state)
+{
+  return state->path.queued_kernel == 0 && state->shadow.shadow_path.queued_kernel == 0 &&
+         state->ao.shadow_path.queued_kernel == 0;
+}
+
+/* Sort key of the kernel which #integrator_megakernel_step will execute next for the path,
+ * followed by the shader for shading kernels. The lowest bits are left for the state index. */
+static inline uint64_t wavefront_state_sort_key(const IntegratorStateCPU *state)
+{
+  uint64_t kernel = state->shadow.shadow_path.queued_kernel;
+  if (kernel == 0) {
+    kernel = state->ao.shadow_path.queued_kernel;
+  }
+  if (kernel != 0) {
+    return kernel << 48;
+  }
+
+  kernel = state->path.queued_kernel;
+  switch (kernel) {
+    case DEVICE_KERNEL_INTEGRATOR_SHADE_SURFACE:
+    case DEVICE_KERNEL_INTEGRATOR_SHADE_SURFACE_RAYTRACE:
+    case DEVICE_KERNEL_INTEGRATOR_SHADE_SURFACE_MNEE:
+    case DEVICE_KERNEL_INTEGRATOR_SHADE_VOLUME:
+      return (kernel << 48) | (uint64_t(state->path.shader_sort_key) << 16);
+    default:
+      return kernel << 48;
+  }
+}
+
+void PathTraceWorkCPU::render_samples_wavefront(KernelGlobalsCPU *kernel_globals,
+                                                IntegratorStateCPU *states,
+                                                const KernelWorkTile &work_tile,
+                                                const int samples_num)
+{
+  const bool has_bake = device_scene_->data.bake.use;
+  const int pixels_num = work_tile.w * work_tile.h;
+  const int64_t work_size = int64_t(pixels_num) * samples_num;
+  float *render_buffer = buffers_->buffer.data();
+
+  /* Pixels which need no more samples, due to adaptive sampling. */
+  bool pixel_finished[WAVEFRONT_TILE_SIZE * WAVEFRONT_TILE_SIZE] = {false};
+  int64_t next_work_index = 0;
+
+  for (int i = 0; i < WAVEFRONT_PATHS_NUM * 2; i++) {
+    path_state_init_queues(&states[i]);
+  }
+
+  uint64_t keys[WAVEFRONT_PATHS_NUM * 2];
+
+  while (true) {
+    int keys_num = 0;
+
+    for (int path_index = 0; path_index < WAVEFRONT_PATHS_NUM; path_index++) {
+      IntegratorStateCPU *state = &states[path_index * 2];
+      IntegratorStateCPU *shadow_catcher_state = state + 1;
+
+      /* Start the next sample in place of the finished path. Samples are taken in order of the
+       * pixels, so that neighboring paths start out coherent. Once cancelled, only the paths in
+       * flight are finished. */
+      if (wavefront_state_is_terminated(state) &&
+          wavefront_state_is_terminated(shadow_catcher_state))
+      {
+        while (next_work_index < work_size && !is_cancel_requested()) {
+          const int sample = next_work_index / pixels_num;
+          const int pixel = next_work_index - int64_t(sample) * pixels_num;
+          next_work_index++;
+
+          if (pixel_finished[pixel]) {
+            continue;
+          }
+
+          KernelWorkTile sample_work_tile = work_tile;
+          sample_work_tile.x = work_tile.x + pixel % work_tile.w;
+          sample_work_tile.y = work_tile.y + pixel / work_tile.w;
+          sample_work_tile.w = 1;
+          sample_work_tile.h = 1;
+          sample_work_tile.start_sample = work_tile.start_sample + sample;
+          sample_work_tile.num_samples = 1;
+
+          const bool need_sample =
+              has_bake ? kernels_.integrator_init_from_bake(
+                             kernel_globals, state, &sample_work_tile, render_buffer) :
+                         kernels_.integrator_init_from_camera(
+                             kernel_globals, state, &sample_work_tile, render_buffer);
+          if (!need_sample) {
+            pixel_finished[pixel] = true;
+            continue;
+          }
+
+          if (!wavefront_state_is_terminated(state)) {
+            break;
+          }
+        }
+      }
+
+      for (int i = 0; i < 2; i++) {
+        if (!wavefront_state_is_terminated(state + i)) {
+          keys[keys_num++] = wavefront_state_sort_key(state + i) | (path_index * 2 + i);
+        }
+      }
+    }
+
+    if (keys_num == 0) {
+      break;
+    }
+
+    /* Advance every path by one kernel, paths which need the same kernel and shader after each
+     * other. */
+    sort(keys, keys + keys_num);
+
+    for (int i = 0; i < keys_num; i++) {
+      IntegratorStateCPU *state = &states[keys[i] & 0xffff];
+      kernels_.integrator_megakernel_step(kernel_globals, state, render_buffer);
+    }
+  }
+}
+
 void PathTraceWorkCPU::copy_to_display(PathTraceDisplay *display,
                                        PassMode pass_mode,
                                        int num_samples)
@@ -32,6 +32,7 @@ class PathTraceWorkCPU : public PathTraceWork {
                    Film *film,
                    DeviceScene *device_scene,
                    bool *cancel_requested_flag);
+  ~PathTraceWorkCPU();
 
   virtual void init_execution() override;
 
@@ -74,6 +75,22 @@ class PathTraceWorkCPU : public PathTraceWork {
                                     const KernelWorkTile &work_tile,
                                     const int samples_num);
 
+  /* Wavefront path tracing routine. Keeps a batch of paths of the work tile in flight and
+   * advances them one kernel at a time, ordered by the kernel and shader they need next, so that
+   * consecutive paths run the same code on the same data.
+   *
+   * The states array holds two states for every path, the second one is used for the shadow
+   * catcher. */
+  void render_samples_wavefront(KernelGlobalsCPU *kernel_globals,
+                                IntegratorStateCPU *states,
+                                const KernelWorkTile &work_tile,
+                                const int samples_num);
+
+  /* Whether the wavefront routine is requested and supports the current scene. */
+  bool use_wavefront() const;
+
+  void free_wavefront_states();
+
   /* CPU kernels. */
   const CPUKernels &kernels_;
 
@@ -83,6 +100,9 @@ class PathTraceWorkCPU : public PathTraceWork {
    * accessing it, but some "localization" is required to decouple from kernel globals stored
    * on the device level. */
   vector<CPUKernelThreadGlobals> kernel_thread_globals_;
+
+  /* Path states of every thread for the wavefront routine, allocated on first use. */
+  vector<IntegratorStateCPU *> wavefront_states_;
 };
 
 CCL_NAMESPACE_END
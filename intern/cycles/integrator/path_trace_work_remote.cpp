@@ -0,0 +1,178 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#ifdef WITH_REMOTE
+
+#  include "integrator/path_trace_work_remote.h"
+
+#  include "device/remote/device_impl.h"
+
+#  include "integrator/pass_accessor_cpu.h"
+#  include "integrator/path_trace_display.h"
+
+#  include "scene/scene.h"
+#  include "session/buffers.h"
+
+#  include "util/log.h"
+
+CCL_NAMESPACE_BEGIN
+
+void remote_write_buffer_params(RemoteMessage &message, const BufferParams &params)
+{
+  message.write(params.width);
+  message.write(params.height);
+  message.write(params.window_x);
+  message.write(params.window_y);
+  message.write(params.window_width);
+  message.write(params.window_height);
+  message.write(params.full_x);
+  message.write(params.full_y);
+  message.write(params.full_width);
+  message.write(params.full_height);
+  message.write(params.offset);
+  message.write(params.stride);
+  message.write(params.pass_stride);
+}
+
+bool remote_read_buffer_params(RemoteMessage &message, BufferParams &params)
+{
+  return message.read(params.width) && message.read(params.height) &&
+         message.read(params.window_x) && message.read(params.window_y) &&
+         message.read(params.window_width) && message.read(params.window_height) &&
+         message.read(params.full_x) && message.read(params.full_y) &&
+         message.read(params.full_width) && message.read(params.full_height) &&
+         message.read(params.offset) && message.read(params.stride) &&
+         message.read(params.pass_stride);
+}
+
+PathTraceWorkRemote::PathTraceWorkRemote(Device *device,
+                                         Film *film,
+                                         DeviceScene *device_scene,
+                                         bool *cancel_requested_flag)
+    : PathTraceWork(device, film, device_scene, cancel_requested_flag),
+      remote_device_(static_cast<RemoteDevice *>(device))
+{
+  DCHECK_EQ(device->info.type, DEVICE_REMOTE);
+}
+
+void PathTraceWorkRemote::write_buffer_params(RemoteMessage &args) const
+{
+  remote_write_buffer_params(args, buffers_->params);
+  remote_write_buffer_params(args, effective_full_params_);
+  remote_write_buffer_params(args, effective_big_tile_params_);
+  remote_write_buffer_params(args, effective_buffer_params_);
+}
+
+void PathTraceWorkRemote::init_execution()
+{
+  remote_device_->request(REMOTE_REQUEST_WORK_INIT_EXECUTION, RemoteMessage());
+}
+
+void PathTraceWorkRemote::render_samples(RenderStatistics &statistics,
+                                         int start_sample,
+                                         int samples_num,
+                                         int sample_offset)
+{
+  /* NOTE: The request can not be interrupted, cancel is only checked in between. The render
+   * scheduler keeps the number of samples per request small enough for interactive updates. */
+  RemoteMessage args, reply;
+  write_buffer_params(args);
+  args.write(start_sample);
+  args.write(samples_num);
+  args.write(sample_offset);
+
+  if (!remote_device_->request(REMOTE_REQUEST_WORK_RENDER_SAMPLES, args, reply)) {
+    return;
+  }
+
+  reply.read(statistics.occupancy);
+}
+
+void PathTraceWorkRemote::copy_to_display(PathTraceDisplay *display,
+                                          PassMode pass_mode,
+                                          int num_samples)
+{
+  if (!copy_render_buffers_from_device()) {
+    return;
+  }
+
+  half4 *rgba_half = display->map_texture_buffer();
+  if (!rgba_half) {
+    return;
+  }
+
+  const KernelFilm &kfilm = device_scene_->data.film;
+
+  const PassAccessor::PassAccessInfo pass_access_info = get_display_pass_access_info(pass_mode);
+
+  const PassAccessorCPU pass_accessor(pass_access_info, kfilm.exposure, num_samples);
+
+  PassAccessor::Destination destination = get_display_destination_template(display);
+  destination.pixels_half_rgba = rgba_half;
+
+  pass_accessor.get_render_tile_pixels(buffers_.get(), effective_buffer_params_, destination);
+
+  display->unmap_texture_buffer();
+}
+
+void PathTraceWorkRemote::destroy_gpu_resources(PathTraceDisplay * /*display*/) {}
+
+bool PathTraceWorkRemote::copy_render_buffers_from_device()
+{
+  RemoteMessage args, reply;
+  write_buffer_params(args);
+
+  if (!remote_device_->request(REMOTE_REQUEST_WORK_COPY_FROM_DEVICE, args, reply)) {
+    return false;
+  }
+
+  return reply.read_data(buffers_->buffer.data(), buffers_->buffer.size() * sizeof(float));
+}
+
+bool PathTraceWorkRemote::copy_render_buffers_to_device()
+{
+  RemoteMessage args;
+  write_buffer_params(args);
+  args.write_data(buffers_->buffer.data(), buffers_->buffer.size() * sizeof(float));
+
+  return remote_device_->request(REMOTE_REQUEST_WORK_COPY_TO_DEVICE, args);
+}
+
+bool PathTraceWorkRemote::zero_render_buffers()
+{
+  buffers_->zero();
+
+  RemoteMessage args;
+  write_buffer_params(args);
+
+  return remote_device_->request(REMOTE_REQUEST_WORK_ZERO, args);
+}
+
+int PathTraceWorkRemote::adaptive_sampling_converge_filter_count_active(float threshold,
+                                                                        bool reset)
+{
+  RemoteMessage args, reply;
+  write_buffer_params(args);
+  args.write(threshold);
+  args.write(reset);
+
+  int num_active_pixels = 0;
+  if (remote_device_->request(REMOTE_REQUEST_WORK_ADAPTIVE_SAMPLING, args, reply)) {
+    reply.read(num_active_pixels);
+  }
+
+  return num_active_pixels;
+}
+
+void PathTraceWorkRemote::cryptomatte_postproces()
+{
+  RemoteMessage args;
+  write_buffer_params(args);
+
+  remote_device_->request(REMOTE_REQUEST_WORK_CRYPTOMATTE, args);
+}
+
+CCL_NAMESPACE_END
+
+#endif /* WITH_REMOTE */
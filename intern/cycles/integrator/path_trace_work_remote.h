@@ -0,0 +1,63 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#pragma once
+
+#ifdef WITH_REMOTE
+
+#  include "device/remote/protocol.h"
+
+#  include "integrator/path_trace_work.h"
+
+CCL_NAMESPACE_BEGIN
+
+class RemoteDevice;
+
+/* Implementation of PathTraceWork which forwards the work to a worker process.
+ *
+ * The worker has its own render buffers matching the ones of this work, and samples are
+ * accumulated there. Render buffers of this work are only updated when their pixels are copied
+ * from the device, so that displaying and writing the result works the same as for the CPU. */
+class PathTraceWorkRemote : public PathTraceWork {
+ public:
+  PathTraceWorkRemote(Device *device,
+                      Film *film,
+                      DeviceScene *device_scene,
+                      bool *cancel_requested_flag);
+
+  virtual void init_execution() override;
+
+  virtual void render_samples(RenderStatistics &statistics,
+                              int start_sample,
+                              int samples_num,
+                              int sample_offset) override;
+
+  virtual void copy_to_display(PathTraceDisplay *display,
+                               PassMode pass_mode,
+                               int num_samples) override;
+  virtual void destroy_gpu_resources(PathTraceDisplay *display) override;
+
+  virtual bool copy_render_buffers_from_device() override;
+  virtual bool copy_render_buffers_to_device() override;
+  virtual bool zero_render_buffers() override;
+
+  virtual int adaptive_sampling_converge_filter_count_active(float threshold, bool reset) override;
+  virtual void cryptomatte_postproces() override;
+
+ protected:
+  /* Every request about the render buffers starts with their parameters, so the worker can
+   * match its own render buffers to them. */
+  void write_buffer_params(RemoteMessage &args) const;
+
+  RemoteDevice *remote_device_;
+};
+
+/* Parameters of render buffers as sent to the worker. Only the size and position of the buffers
+ * is included, passes are described by the kernel data. */
+void remote_write_buffer_params(RemoteMessage &message, const BufferParams &params);
+bool remote_read_buffer_params(RemoteMessage &message, BufferParams &params);
+
+CCL_NAMESPACE_END
+
+#endif /* WITH_REMOTE */
@@ -0,0 +1,528 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#ifdef WITH_REMOTE
+
+#  include "integrator/remote_worker.h"
+
+#  include "device/device.h"
+
+#  include "integrator/path_trace_work_cpu.h"
+#  include "integrator/path_trace_work_remote.h"
+#  include "integrator/shader_eval.h"
+
+#  include "scene/devicescene.h"
+#  include "session/buffers.h"
+
+#  include "util/log.h"
+#  include "util/progress.h"
+#  include "util/system.h"
+#  include "util/task.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Global memory with the same type and size as on the host, so that it is passed to the kernel
+ * globals the same way as on a local CPU device. */
+class RemoteWorkerGlobal : public device_memory {
+ public:
+  RemoteWorkerGlobal(Device *device,
+                     const char *name,
+                     const DataType type,
+                     const int elements,
+                     const size_t size)
+      : device_memory(device, name, MEM_GLOBAL)
+  {
+    data_type = type;
+    data_elements = elements;
+    data_size = size;
+    data_width = size;
+    host_pointer = host_alloc(memory_size());
+  }
+
+  ~RemoteWorkerGlobal()
+  {
+    device_free();
+    host_free();
+  }
+
+  void copy_to_device()
+  {
+    device_copy_to();
+  }
+};
+
+static bool is_kernel_data_array(const string &name)
+{
+#  define KERNEL_DATA_ARRAY(type, tname) \
+    if (name == #tname) { \
+      return true; \
+    }
+#  include "kernel/data_arrays.h"
+
+  return false;
+}
+
+/* Check that the dimensions of device memory match the size of the data sent along with it, before
+ * any memory is allocated for them. The size is divided by every dimension in turn, so that large
+ * dimensions can not overflow. */
+static bool memory_dimensions_match(const uint64_t size,
+                                    const uint64_t element_size,
+                                    const uint64_t width,
+                                    const uint64_t height,
+                                    const uint64_t depth)
+{
+  if (element_size == 0) {
+    return false;
+  }
+  if (width == 0) {
+    return size == 0;
+  }
+
+  const uint64_t factors[] = {
+      element_size, width, max(height, uint64_t(1)), max(depth, uint64_t(1))};
+  uint64_t remaining = size;
+  for (const uint64_t factor : factors) {
+    if (remaining % factor != 0) {
+      return false;
+    }
+    remaining /= factor;
+  }
+  return remaining == 1;
+}
+
+RemoteWorker::RemoteWorker(const int threads) : threads_(threads)
+{
+  TaskScheduler::init(threads);
+}
+
+RemoteWorker::~RemoteWorker()
+{
+  reset();
+  TaskScheduler::exit();
+}
+
+void RemoteWorker::reset()
+{
+  /* Free in reverse order of creation, memory needs the device to be freed. */
+  work_.reset();
+  memory_.clear();
+  device_scene_.reset();
+  device_.reset();
+}
+
+bool RemoteWorker::listen(const string &address, const int port)
+{
+  RemoteSocket listener;
+  string error;
+  if (!listener.listen(address, port, error)) {
+    LOG(ERROR) << error;
+    return false;
+  }
+
+  if (address != REMOTE_DEFAULT_BIND_ADDRESS) {
+    LOG(WARNING) << "Remote worker accepts unauthenticated connections on " << address
+                 << ", only use it on trusted networks";
+  }
+  VLOG_INFO << "Remote worker listening on " << address << ":" << listener.get_port();
+
+  while (true) {
+    RemoteSocket socket = listener.accept();
+    if (!socket.is_open()) {
+      LOG(ERROR) << "Failed to accept connection";
+      return false;
+    }
+    serve(socket);
+  }
+
+  return true;
+}
+
+void RemoteWorker::serve(RemoteSocket &socket)
+{
+  reset();
+
+  vector<DeviceInfo> devices = Device::available_devices(DEVICE_MASK_CPU);
+  DeviceInfo device_info = devices.front();
+  device_info.cpu_threads = threads_;
+
+  device_.reset(Device::create(device_info, stats_, profiler_));
+  device_scene_ = make_unique<DeviceScene>(device_.get());
+  work_ = make_unique<PathTraceWorkCPU>(
+      device_.get(), nullptr, device_scene_.get(), &cancel_requested_flag_);
+
+  while (true) {
+    uint request;
+    RemoteMessage args;
+    if (!socket.recv_message(request, args)) {
+      break;
+    }
+
+    RemoteMessage reply;
+    string error;
+    bool success = (request < REMOTE_REQUEST_NUM) &&
+                   handle_request(RemoteRequest(request), args, reply, error);
+
+    if (success && device_->have_error()) {
+      error = device_->error_message();
+      success = false;
+    }
+
+    if (!success) {
+      reply.clear();
+      reply.write_string((error.empty()) ? "Invalid request" : error);
+    }
+
+    if (!socket.send_message((success) ? REMOTE_REPLY_OK : REMOTE_REPLY_ERROR, reply)) {
+      break;
+    }
+  }
+
+  VLOG_INFO << "Render host disconnected";
+
+  reset();
+}
+
+bool RemoteWorker::handle_request(const RemoteRequest request,
+                                  RemoteMessage &args,
+                                  RemoteMessage &reply,
+                                  string &error)
+{
+  switch (request) {
+    case REMOTE_REQUEST_HELLO:
+      return hello(args, reply, error);
+
+    case REMOTE_REQUEST_MEM_COPY_TO:
+      return mem_copy_to(args, error);
+
+    case REMOTE_REQUEST_MEM_FREE:
+      return mem_free(args, error);
+
+    case REMOTE_REQUEST_CONST_COPY_TO:
+      return const_copy_to(args, error);
+
+    case REMOTE_REQUEST_LOAD_KERNELS: {
+      uint kernel_features;
+      if (!args.read(kernel_features)) {
+        return false;
+      }
+      if (!device_->load_kernels(kernel_features)) {
+        error = "Failed to load kernels";
+        return false;
+      }
+      return true;
+    }
+
+    case REMOTE_REQUEST_WORK_INIT_EXECUTION:
+      work_->init_execution();
+      return true;
+
+    case REMOTE_REQUEST_WORK_RENDER_SAMPLES: {
+      int start_sample, samples_num, sample_offset;
+      if (!read_work_params(args, error) || !args.read(start_sample) ||
+          !args.read(samples_num) || !args.read(sample_offset))
+      {
+        return false;
+      }
+
+      PathTraceWork::RenderStatistics statistics;
+      work_->render_samples(statistics, start_sample, samples_num, sample_offset);
+      reply.write(statistics.occupancy);
+      return true;
+    }
+
+    case REMOTE_REQUEST_WORK_COPY_FROM_DEVICE: {
+      if (!read_work_params(args, error)) {
+        return false;
+      }
+      const RenderBuffers *buffers = work_->get_render_buffers();
+      reply.write_data(buffers->buffer.data(), buffers->buffer.size() * sizeof(float));
+      return true;
+    }
+
+    case REMOTE_REQUEST_WORK_COPY_TO_DEVICE: {
+      if (!read_work_params(args, error)) {
+        return false;
+      }
+      RenderBuffers *buffers = work_->get_render_buffers();
+      if (!args.read_data(buffers->buffer.data(), buffers->buffer.size() * sizeof(float))) {
+        error = "Render buffer size mismatch";
+        return false;
+      }
+      return work_->copy_render_buffers_to_device();
+    }
+
+    case REMOTE_REQUEST_WORK_ZERO:
+      return read_work_params(args, error) && work_->zero_render_buffers();
+
+    case REMOTE_REQUEST_WORK_ADAPTIVE_SAMPLING: {
+      float threshold;
+      bool reset;
+      if (!read_work_params(args, error) || !args.read(threshold) || !args.read(reset)) {
+        return false;
+      }
+      reply.write(work_->adaptive_sampling_converge_filter_count_active(threshold, reset));
+      return true;
+    }
+
+    case REMOTE_REQUEST_WORK_CRYPTOMATTE:
+      if (!read_work_params(args, error)) {
+        return false;
+      }
+      work_->cryptomatte_postproces();
+      return true;
+
+    case REMOTE_REQUEST_SHADER_EVAL:
+      return shader_eval(args, reply, error);
+
+    case REMOTE_REQUEST_NUM:
+      break;
+  }
+
+  return false;
+}
+
+bool RemoteWorker::hello(RemoteMessage &args, RemoteMessage &reply, string &error)
+{
+  uint version;
+  uint64_t kernel_data_size;
+  if (!args.read(version) || !args.read(kernel_data_size)) {
+    return false;
+  }
+
+  if (version != REMOTE_PROTOCOL_VERSION || kernel_data_size != sizeof(KernelData)) {
+    error = "Worker runs a different version of Cycles";
+    return false;
+  }
+
+  reply.write_string(string_printf(
+      "%s, %d threads", system_cpu_brand_string().c_str(), device_->info.cpu_threads));
+  return true;
+}
+
+bool RemoteWorker::mem_copy_to(RemoteMessage &args, string &error)
+{
+  uint64_t pointer, data_size, data_width, data_height, data_depth, size;
+  string name;
+  int type, data_type, data_elements;
+  uint slot = 0;
+  TextureInfo info;
+
+  if (!args.read(pointer) || !args.read_string(name) || !args.read(type) ||
+      !args.read(data_type) || !args.read(data_elements) || !args.read(data_size) ||
+      !args.read(data_width) || !args.read(data_height) || !args.read(data_depth))
+  {
+    return false;
+  }
+  if (type == MEM_TEXTURE && (!args.read(slot) || !args.read(info))) {
+    return false;
+  }
+  const uint8_t *data = (args.read(size)) ? args.read_data(size) : nullptr;
+  if (data == nullptr) {
+    return false;
+  }
+
+  if (!(type == MEM_TEXTURE || (type == MEM_GLOBAL && is_kernel_data_array(name)))) {
+    error = "Unknown device memory " + name;
+    return false;
+  }
+  if (type == MEM_TEXTURE && (info.data_type >= IMAGE_DATA_NUM_TYPES)) {
+    error = "Unknown image data type for " + name;
+    return false;
+  }
+  if (type == MEM_GLOBAL && data_elements <= 0) {
+    error = "Invalid number of elements for " + name;
+    return false;
+  }
+
+  /* Replace existing memory, which may have changed size and type. */
+  memory_.erase(pointer);
+  Memory &memory = memory_[pointer];
+  memory.name = name;
+
+  if (type == MEM_TEXTURE) {
+    /* The texture determines the element type from the image data type. */
+    unique_ptr<device_texture> tex = make_unique<device_texture>(device_.get(),
+                                                                 memory.name.c_str(),
+                                                                 slot,
+                                                                 ImageDataType(info.data_type),
+                                                                 InterpolationType(
+                                                                     info.interpolation),
+                                                                 ExtensionType(info.extension));
+    if (!memory_dimensions_match(size,
+                                 tex->data_elements * datatype_size(tex->data_type),
+                                 data_width,
+                                 data_height,
+                                 data_depth))
+    {
+      memory_.erase(pointer);
+      error = "Device memory size mismatch for " + name;
+      return false;
+    }
+    tex->alloc(data_width, data_height, data_depth);
+    tex->info = info;
+    memory.mem = std::move(tex);
+  }
+  else {
+    if (!memory_dimensions_match(
+            size, data_elements * datatype_size(DataType(data_type)), data_size, 0, 0))
+    {
+      memory_.erase(pointer);
+      error = "Device memory size mismatch for " + name;
+      return false;
+    }
+    memory.mem = make_unique<RemoteWorkerGlobal>(
+        device_.get(), memory.name.c_str(), DataType(data_type), data_elements, data_size);
+  }
+
+  if (size) {
+    memcpy(memory.mem->host_pointer, data, size);
+  }
+
+  if (type == MEM_TEXTURE) {
+    static_cast<device_texture *>(memory.mem.get())->copy_to_device();
+  }
+  else {
+    static_cast<RemoteWorkerGlobal *>(memory.mem.get())->copy_to_device();
+  }
+
+  return true;
+}
+
+bool RemoteWorker::mem_free(RemoteMessage &args, string & /*error*/)
+{
+  uint64_t pointer;
+  if (!args.read(pointer)) {
+    return false;
+  }
+
+  memory_.erase(pointer);
+  return true;
+}
+
+bool RemoteWorker::const_copy_to(RemoteMessage &args, string &error)
+{
+  string name;
+  uint64_t size;
+  if (!args.read_string(name) || !args.read(size)) {
+    return false;
+  }
+
+  if (name != "data" || size != sizeof(KernelData)) {
+    error = "Unknown constant memory " + name;
+    return false;
+  }
+
+  /* Keep a copy in the device scene, the integrator reads some of it on the host side. */
+  if (!args.read_data(&device_scene_->data, size)) {
+    return false;
+  }
+
+  device_->const_copy_to("data", &device_scene_->data, size);
+  return true;
+}
+
+bool RemoteWorker::shader_eval(RemoteMessage &args, RemoteMessage &reply, string &error)
+{
+  int type, num_points;
+  uint64_t output_size;
+  if (!args.read(type) || !args.read(num_points) || !args.read(output_size)) {
+    error = "Invalid shader evaluation parameters";
+    return false;
+  }
+
+  /* Shader evaluation writes up to a color per point. */
+  const int max_num_channels = 4;
+  if (type < SHADER_EVAL_DISPLACE || type > SHADER_EVAL_CURVE_SHADOW_TRANSPARENCY ||
+      num_points <= 0 || output_size == 0 || output_size % num_points != 0 ||
+      output_size / num_points > max_num_channels)
+  {
+    error = string_printf("Invalid shader evaluation of type %d with %d points and %llu outputs",
+                          type,
+                          num_points,
+                          (unsigned long long)output_size);
+    return false;
+  }
+
+  const uint8_t *input = args.read_data(num_points * sizeof(KernelShaderEvalInput));
+  if (input == nullptr) {
+    error = "Failed to read shader evaluation input";
+    return false;
+  }
+
+  Progress progress;
+  ShaderEval shader_eval(device_.get(), progress);
+
+  const bool success = shader_eval.eval(
+      ShaderEvalType(type),
+      num_points,
+      output_size / num_points,
+      [&](device_vector<KernelShaderEvalInput> &d_input) {
+        memcpy(d_input.data(), input, num_points * sizeof(KernelShaderEvalInput));
+        return num_points;
+      },
+      [&](device_vector<float> &d_output) {
+        reply.write_data(d_output.data(), d_output.size() * sizeof(float));
+      });
+
+  if (!success) {
+    error = "Shader evaluation failed";
+  }
+
+  return success;
+}
+
+bool RemoteWorker::read_work_params(RemoteMessage &args, string &error)
+{
+  BufferParams buffer_params, full_params, big_tile_params, effective_params;
+  if (!remote_read_buffer_params(args, buffer_params) ||
+      !remote_read_buffer_params(args, full_params) ||
+      !remote_read_buffer_params(args, big_tile_params) ||
+      !remote_read_buffer_params(args, effective_params))
+  {
+    error = "Invalid render buffer parameters";
+    return false;
+  }
+
+  /* The render buffers are sent to and from the host in a single message, so they must fit in one
+   * before they are allocated. */
+  const uint64_t max_buffer_floats = REMOTE_MESSAGE_MAX_SIZE / sizeof(float);
+  if (buffer_params.width < 0 || buffer_params.height < 0 || buffer_params.pass_stride < 0 ||
+      (buffer_params.width > 0 && buffer_params.height > 0 && buffer_params.pass_stride > 0 &&
+       uint64_t(buffer_params.width) * uint64_t(buffer_params.height) >
+           max_buffer_floats / uint64_t(buffer_params.pass_stride)))
+  {
+    error = string_printf("Invalid render buffer of %dx%d pixels with pass stride %d",
+                          buffer_params.width,
+                          buffer_params.height,
+                          buffer_params.pass_stride);
+    return false;
+  }
+
+  RenderBuffers *buffers = work_->get_render_buffers();
+  const BufferParams &params = buffers->params;
+
+  if (buffer_params.width != params.width || buffer_params.height != params.height ||
+      buffer_params.pass_stride != params.pass_stride)
+  {
+    if (buffer_params.pass_stride > 0) {
+      /* Start with zeroed buffers, same as the freshly reset buffers of the host. */
+      buffers->reset(buffer_params);
+      buffers->zero();
+    }
+    else {
+      buffers->params = buffer_params;
+      buffers->buffer.free();
+    }
+  }
+  else {
+    buffers->params = buffer_params;
+  }
+
+  work_->set_effective_buffer_params(full_params, big_tile_params, effective_params);
+  return true;
+}
+
+CCL_NAMESPACE_END
+
+#endif /* WITH_REMOTE */
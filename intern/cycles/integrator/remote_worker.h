@@ -0,0 +1,80 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#pragma once
+
+#ifdef WITH_REMOTE
+
+#  include "device/remote/protocol.h"
+#  include "device/remote/socket.h"
+
+#  include "util/map.h"
+#  include "util/profiling.h"
+#  include "util/stats.h"
+#  include "util/string.h"
+#  include "util/unique_ptr.h"
+
+CCL_NAMESPACE_BEGIN
+
+class Device;
+class DeviceScene;
+class PathTraceWork;
+class device_memory;
+
+/* Worker process of the remote device.
+ *
+ * Renders with a local CPU device on behalf of a RemoteDevice in the render host. The worker
+ * keeps a copy of the kernel data and scene arrays sent by the host, and a single path trace
+ * work with render buffers for the part of the image assigned to it. */
+class RemoteWorker {
+ public:
+  /* Number of threads to render with, 0 for all of them. */
+  explicit RemoteWorker(const int threads = 0);
+  ~RemoteWorker();
+
+  /* Listen for render hosts on the given address and port, serving them one after the other.
+   * Only returns when listening fails. */
+  bool listen(const string &address, const int port);
+
+  /* Serve requests of a connected render host until it disconnects. */
+  void serve(RemoteSocket &socket);
+
+ protected:
+  struct Memory {
+    string name;
+    unique_ptr<device_memory> mem;
+  };
+
+  void reset();
+
+  /* Handle a single request. Returns false with error set when it fails. */
+  bool handle_request(const RemoteRequest request,
+                      RemoteMessage &args,
+                      RemoteMessage &reply,
+                      string &error);
+
+  bool hello(RemoteMessage &args, RemoteMessage &reply, string &error);
+  bool mem_copy_to(RemoteMessage &args, string &error);
+  bool mem_free(RemoteMessage &args, string &error);
+  bool const_copy_to(RemoteMessage &args, string &error);
+  bool shader_eval(RemoteMessage &args, RemoteMessage &reply, string &error);
+
+  /* Match render buffers and effective parameters of the work to the ones of the host. */
+  bool read_work_params(RemoteMessage &args, string &error);
+
+  int threads_;
+  Stats stats_;
+  Profiler profiler_;
+
+  /* State of the connected render host, reset on every connection. */
+  unique_ptr<Device> device_;
+  unique_ptr<DeviceScene> device_scene_;
+  unique_ptr<PathTraceWork> work_;
+  map<uint64_t, Memory> memory_;
+  bool cancel_requested_flag_ = false;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* WITH_REMOTE */
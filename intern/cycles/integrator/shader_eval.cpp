@@ -9,6 +9,7 @@
 
 #include "device/cpu/kernel.h"
 #include "device/cpu/kernel_thread_globals.h"
+#include "device/remote/device_impl.h"
 
 #include "util/log.h"
 #include "util/progress.h"
@@ -56,10 +57,16 @@ bool ShaderEval::eval(const ShaderEvalType type,
     output.alloc(num_points * num_channels);
     output.zero_to_device();
 
-    /* Evaluate on CPU or GPU. */
-    success = (device->info.type == DEVICE_CPU) ?
-                  eval_cpu(device, type, input, output, num_points) :
-                  eval_gpu(device, type, input, output, num_points);
+    /* Evaluate on CPU, GPU or in a worker process. */
+    if (device->info.type == DEVICE_CPU) {
+      success = eval_cpu(device, type, input, output, num_points);
+    }
+    else if (device->info.type == DEVICE_REMOTE) {
+      success = eval_remote(device, type, input, output, num_points);
+    }
+    else {
+      success = eval_gpu(device, type, input, output, num_points);
+    }
 
     /* Copy data back from device if not canceled. */
     if (success) {
@@ -168,4 +175,34 @@ bool ShaderEval::eval_gpu(Device *device,
   return true;
 }
 
+bool ShaderEval::eval_remote(Device *device,
+                             const ShaderEvalType type,
+                             device_vector<KernelShaderEvalInput> &input,
+                             device_vector<float> &output,
+                             const int64_t work_size)
+{
+#ifdef WITH_REMOTE
+  /* Input and output are in host memory, send them along with the request. */
+  RemoteMessage args, reply;
+  args.write(int(type));
+  args.write(int(work_size));
+  args.write(uint64_t(output.size()));
+  args.write_data(input.data(), work_size * sizeof(KernelShaderEvalInput));
+
+  RemoteDevice *remote_device = static_cast<RemoteDevice *>(device);
+  if (!remote_device->request(REMOTE_REQUEST_SHADER_EVAL, args, reply)) {
+    return false;
+  }
+
+  return reply.read_data(output.data(), output.size() * sizeof(float));
+#else
+  (void)device;
+  (void)type;
+  (void)input;
+  (void)output;
+  (void)work_size;
+  return false;
+#endif
+}
+
 CCL_NAMESPACE_END
@@ -45,6 +45,11 @@ class ShaderEval {
                 device_vector<KernelShaderEvalInput> &input,
                 device_vector<float> &output,
                 const int64_t work_size);
+  bool eval_remote(Device *device,
+                   const ShaderEvalType type,
+                   device_vector<KernelShaderEvalInput> &input,
+                   device_vector<float> &output,
+                   const int64_t work_size);
 
   Device *device_;
   Progress &progress_;
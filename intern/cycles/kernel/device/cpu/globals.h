@@ -19,6 +19,8 @@ CCL_NAMESPACE_BEGIN
  * these are really just standard arrays. We can't use actually globals because
  * multiple renders may be running inside the same process. */
 
+class KernelImageCache;
+
 #ifdef __OSL__
 struct OSLGlobals;
 struct OSLThreadData;
@@ -43,6 +45,9 @@ typedef struct KernelGlobalsCPU {
 
   KernelData data;
 
+  /* On-demand texture cache, for images which are not loaded into memory. */
+  const KernelImageCache *image_cache = nullptr;
+
 #ifdef __OSL__
   /* On the CPU, we also have the OSL globals here. Most data structures are shared
    * with SVM, the difference is in the shaders and object/mesh attributes. */
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "kernel/device/cpu/image_cache.h"
+
 #ifdef WITH_NANOVDB
 #  define NANOVDB_USE_INTRINSICS
 #  include <nanovdb/NanoVDB.h>
@@ -800,6 +802,10 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals kg, int id, float x, flo
   const TextureInfo &info = kernel_data_fetch(texture_info, id);
 
   if (UNLIKELY(!info.data)) {
+    /* Image is not in memory, look it up in the on-demand texture cache instead. */
+    if (kg->image_cache && kg->image_cache->has_image(id)) {
+      return kg->image_cache->lookup(id, x, y);
+    }
     return zero_float4();
   }
 
@@ -0,0 +1,177 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "kernel/device/cpu/image_cache.h"
+
+#include "util/log.h"
+#include "util/math.h"
+
+CCL_NAMESPACE_BEGIN
+
+KernelImageCache::KernelImageCache() {}
+
+KernelImageCache::~KernelImageCache()
+{
+  free();
+}
+
+void KernelImageCache::init(const int max_memory_mb)
+{
+  thread_scoped_lock lock(mutex_);
+
+  if (texture_system_ == nullptr) {
+    /* Not shared with OSL, which has its own texture system with different settings. */
+    texture_system_ = OIIO::TextureSystem::create(false);
+
+    /* Split files which are not tiled into tiles as well, so lookups never need to keep a
+     * full image in memory. */
+    texture_system_->attribute("autotile", 64);
+    texture_system_->attribute("gray_to_rgb", 1);
+  }
+
+  texture_system_->attribute("max_memory_MB", float(max_memory_mb));
+}
+
+void KernelImageCache::free()
+{
+  thread_scoped_lock lock(mutex_);
+
+  if (texture_system_ == nullptr) {
+    return;
+  }
+
+  VLOG_INFO << "Texture cache statistics:\n" << texture_system_->getstats(1);
+
+  OIIO::TextureSystem::destroy(texture_system_);
+  texture_system_ = nullptr;
+  images_.clear();
+}
+
+bool KernelImageCache::add_image(const int slot,
+                                 const ustring filepath,
+                                 const bool is_rgba,
+                                 const InterpolationType interpolation,
+                                 const ExtensionType extension,
+                                 const ColorConversion &to_scene_linear)
+{
+  thread_scoped_lock lock(mutex_);
+
+  if (texture_system_ == nullptr || filepath.empty()) {
+    return false;
+  }
+
+  OIIO::TextureSystem::TextureHandle *handle = texture_system_->get_texture_handle(filepath);
+  if (handle == nullptr || !texture_system_->good(handle)) {
+    /* Clear error so it does not leak into other lookups. */
+    texture_system_->geterror();
+    return false;
+  }
+
+  if (slot >= images_.size()) {
+    images_.resize(slot + 1);
+  }
+
+  Image &image = images_[slot];
+  image.handle = handle;
+  image.filepath = filepath;
+  image.is_rgba = is_rgba;
+  image.to_scene_linear = to_scene_linear;
+
+  /* Missing alpha channel is opaque. */
+  image.options.fill = 1.0f;
+
+  switch (interpolation) {
+    case INTERPOLATION_CLOSEST:
+      image.options.interpmode = OIIO::TextureOpt::InterpClosest;
+      break;
+    case INTERPOLATION_CUBIC:
+    case INTERPOLATION_SMART:
+      image.options.interpmode = OIIO::TextureOpt::InterpBicubic;
+      break;
+    default:
+      image.options.interpmode = OIIO::TextureOpt::InterpBilinear;
+      break;
+  }
+
+  switch (extension) {
+    case EXTENSION_REPEAT:
+      image.options.swrap = image.options.twrap = OIIO::TextureOpt::WrapPeriodic;
+      break;
+    case EXTENSION_EXTEND:
+      image.options.swrap = image.options.twrap = OIIO::TextureOpt::WrapClamp;
+      break;
+    case EXTENSION_MIRROR:
+      image.options.swrap = image.options.twrap = OIIO::TextureOpt::WrapMirror;
+      break;
+    default:
+      image.options.swrap = image.options.twrap = OIIO::TextureOpt::WrapBlack;
+      break;
+  }
+
+  return true;
+}
+
+void KernelImageCache::remove_image(const int slot)
+{
+  thread_scoped_lock lock(mutex_);
+
+  if (slot >= images_.size() || images_[slot].handle == nullptr) {
+    return;
+  }
+
+  /* Drop tiles of the file, it may have changed on disk by the time it is used again. */
+  texture_system_->invalidate(images_[slot].filepath);
+  images_[slot] = Image();
+}
+
+float4 KernelImageCache::lookup(const int slot, const float x, const float y) const
+{
+  const Image &image = images_[slot];
+  const int channels = image.is_rgba ? 4 : 1;
+  OIIO::TextureOpt options = image.options;
+
+  /* Image lookups in SVM have no ray differentials, so only the full resolution level is
+   * sampled. Tiles are still only read where the image is actually used.
+   * The vertical axis is flipped compared to OpenImageIO. */
+  float result[4];
+  if (!texture_system_->texture(image.handle,
+                                nullptr,
+                                options,
+                                x,
+                                1.0f - y,
+                                0.0f,
+                                0.0f,
+                                0.0f,
+                                0.0f,
+                                channels,
+                                result))
+  {
+    texture_system_->geterror();
+    return make_float4(
+        TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
+  }
+
+  if (!image.is_rgba) {
+    float f = isfinite_safe(result[0]) ? result[0] : 0.0f;
+    if (image.to_scene_linear) {
+      image.to_scene_linear(&f, 1);
+    }
+    return make_float4(f, f, f, 1.0f);
+  }
+
+  /* Put all channels to zero for non-finite values, same as images loaded into memory. */
+  if (!isfinite_safe(result[0]) || !isfinite_safe(result[1]) || !isfinite_safe(result[2]) ||
+      !isfinite_safe(result[3]))
+  {
+    return zero_float4();
+  }
+
+  if (image.to_scene_linear) {
+    image.to_scene_linear(result, 4);
+  }
+
+  return make_float4(result[0], result[1], result[2], result[3]);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,86 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#pragma once
+
+#include <OpenImageIO/texture.h>
+
+#include "util/function.h"
+#include "util/param.h"
+#include "util/texture.h"
+#include "util/thread.h"
+#include "util/types.h"
+#include "util/vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* On-Demand Image Texture Cache
+ *
+ * Images added to the cache are not loaded into memory before rendering. Their texture slot
+ * has no pixel data, and lookups are done through an OpenImageIO texture system instead. It
+ * reads tiles of tiled and mip-mapped files (EXR, TX) the first time they are accessed, and
+ * evicts the least recently used tiles once the memory budget is exceeded. Files which are not
+ * tiled are split into tiles as they are read.
+ *
+ * Only used by the CPU device, the kernel looks up images through it when the texture info of
+ * a slot has no data. */
+class KernelImageCache {
+ public:
+  /* Converts pixels with the given number of channels to scene linear in place. Color spaces
+   * are managed by the scene, which provides the conversion when adding an image. */
+  using ColorConversion = function<void(float *pixels, int channels)>;
+
+  KernelImageCache();
+  ~KernelImageCache();
+
+  /* Create texture system if needed, and set the memory budget in megabytes. */
+  void init(const int max_memory_mb);
+  void free();
+
+  bool is_initialized() const
+  {
+    return texture_system_ != nullptr;
+  }
+
+  /* Use the cache for the image file in the given texture slot. Returns false if the file can
+   * not be read, in which case the image must be loaded into memory as usual.
+   *
+   * Pixels are returned with associated alpha, colors are converted to scene linear with the
+   * given conversion when it is set. Images which are not RGBA are looked up as a single
+   * channel, like images loaded into memory. */
+  bool add_image(const int slot,
+                 const ustring filepath,
+                 const bool is_rgba,
+                 const InterpolationType interpolation,
+                 const ExtensionType extension,
+                 const ColorConversion &to_scene_linear);
+  void remove_image(const int slot);
+
+  bool has_image(const int slot) const
+  {
+    return slot < images_.size() && images_[slot].handle != nullptr;
+  }
+
+  int num_slots() const
+  {
+    return images_.size();
+  }
+
+  float4 lookup(const int slot, const float x, const float y) const;
+
+ protected:
+  struct Image {
+    OIIO::TextureSystem::TextureHandle *handle = nullptr;
+    ustring filepath;
+    bool is_rgba = true;
+    ColorConversion to_scene_linear;
+    OIIO::TextureOpt options;
+  };
+
+  OIIO::TextureSystem *texture_system_ = nullptr;
+  vector<Image> images_;
+  thread_mutex mutex_;
+};
+
+CCL_NAMESPACE_END
@@ -37,6 +37,7 @@ KERNEL_INTEGRATOR_SHADE_FUNCTION(shade_surface);
 KERNEL_INTEGRATOR_SHADE_FUNCTION(shade_volume);
 KERNEL_INTEGRATOR_SHADE_FUNCTION(shade_dedicated_light);
 KERNEL_INTEGRATOR_SHADE_FUNCTION(megakernel);
+KERNEL_INTEGRATOR_SHADE_FUNCTION(megakernel_step);
 
 #undef KERNEL_INTEGRATOR_FUNCTION
 #undef KERNEL_INTEGRATOR_INIT_FUNCTION
@@ -99,6 +99,53 @@ ccl_device_inline AttributeDescriptor find_attribute(KernelGlobals kg,
   return find_attribute(kg, sd->object, sd->prim, sd->type, id);
 }
 
+/* Compact Attributes
+ *
+ * Scenes can store vertex normals octahedral encoded, and triangle attributes as half floats or
+ * bytes in attributes_uchar4, see ATTR_COMPACT_HALF and ATTR_COMPACT_BYTE. Index is the element
+ * relative to the attribute offset. */
+
+ccl_device_inline float3 triangle_vertex_normal(KernelGlobals kg, const uint vert)
+{
+  if (kernel_data.bvh.use_compact_normals) {
+    return oct16_to_float3(kernel_data_fetch(tri_vnormal_oct, vert));
+  }
+  return kernel_data_fetch(tri_vnormal, vert);
+}
+
+ccl_device_inline uint attribute_data_fetch_uint(KernelGlobals kg, const int offset)
+{
+  const uchar4 c = kernel_data_fetch(attributes_uchar4, offset);
+  return (uint)c.x | ((uint)c.y << 8) | ((uint)c.z << 16) | ((uint)c.w << 24);
+}
+
+ccl_device_inline float2 attribute_data_float2(KernelGlobals kg,
+                                               const AttributeDescriptor desc,
+                                               const int index)
+{
+  if (desc.flags & ATTR_COMPACT_HALF) {
+    return half2_bits_to_float2(attribute_data_fetch_uint(kg, desc.offset + index));
+  }
+  return kernel_data_fetch(attributes_float2, desc.offset + index);
+}
+
+ccl_device_inline float4 attribute_data_float4(KernelGlobals kg,
+                                               const AttributeDescriptor desc,
+                                               const int index)
+{
+  if (desc.flags & ATTR_COMPACT_HALF) {
+    const float2 xy = half2_bits_to_float2(attribute_data_fetch_uint(kg, desc.offset + index * 2));
+    const float2 zw = half2_bits_to_float2(
+        attribute_data_fetch_uint(kg, desc.offset + index * 2 + 1));
+    return make_float4(xy.x, xy.y, zw.x, zw.y);
+  }
+  if (desc.flags & ATTR_COMPACT_BYTE) {
+    return color_srgb_to_linear_v4(
+        color_uchar4_to_float4(kernel_data_fetch(attributes_uchar4, desc.offset + index)));
+  }
+  return kernel_data_fetch(attributes_float4, desc.offset + index);
+}
+
 /* Transform matrix attribute on meshes */
 
 ccl_device Transform primitive_attribute_matrix(KernelGlobals kg, const AttributeDescriptor desc)
@@ -84,9 +84,9 @@ ccl_device_inline void triangle_vertices_and_normals(KernelGlobals kg,
   P[1] = kernel_data_fetch(tri_verts, tri_vindex.y);
   P[2] = kernel_data_fetch(tri_verts, tri_vindex.z);
 
-  N[0] = kernel_data_fetch(tri_vnormal, tri_vindex.x);
-  N[1] = kernel_data_fetch(tri_vnormal, tri_vindex.y);
-  N[2] = kernel_data_fetch(tri_vnormal, tri_vindex.z);
+  N[0] = triangle_vertex_normal(kg, tri_vindex.x);
+  N[1] = triangle_vertex_normal(kg, tri_vindex.y);
+  N[2] = triangle_vertex_normal(kg, tri_vindex.z);
 }
 
 /* Interpolate smooth vertex normal from vertices */
@@ -97,9 +97,9 @@ triangle_smooth_normal(KernelGlobals kg, float3 Ng, int prim, float u, float v)
   /* load triangle vertices */
   const uint3 tri_vindex = kernel_data_fetch(tri_vindex, prim);
 
-  float3 n0 = kernel_data_fetch(tri_vnormal, tri_vindex.x);
-  float3 n1 = kernel_data_fetch(tri_vnormal, tri_vindex.y);
-  float3 n2 = kernel_data_fetch(tri_vnormal, tri_vindex.z);
+  float3 n0 = triangle_vertex_normal(kg, tri_vindex.x);
+  float3 n1 = triangle_vertex_normal(kg, tri_vindex.y);
+  float3 n2 = triangle_vertex_normal(kg, tri_vindex.z);
 
   float3 N = safe_normalize((1.0f - u - v) * n0 + u * n1 + v * n2);
 
@@ -112,9 +112,9 @@ ccl_device_inline float3 triangle_smooth_normal_unnormalized(
   /* load triangle vertices */
   const uint3 tri_vindex = kernel_data_fetch(tri_vindex, prim);
 
-  float3 n0 = kernel_data_fetch(tri_vnormal, tri_vindex.x);
-  float3 n1 = kernel_data_fetch(tri_vnormal, tri_vindex.y);
-  float3 n2 = kernel_data_fetch(tri_vnormal, tri_vindex.z);
+  float3 n0 = triangle_vertex_normal(kg, tri_vindex.x);
+  float3 n1 = triangle_vertex_normal(kg, tri_vindex.y);
+  float3 n2 = triangle_vertex_normal(kg, tri_vindex.z);
 
   /* ensure that the normals are in object space */
   if (sd->object_flag & SD_OBJECT_TRANSFORM_APPLIED) {
@@ -211,15 +211,15 @@ ccl_device float2 triangle_attribute_float2(KernelGlobals kg,
     if (desc.element & (ATTR_ELEMENT_VERTEX | ATTR_ELEMENT_VERTEX_MOTION)) {
       const uint3 tri_vindex = kernel_data_fetch(tri_vindex, sd->prim);
 
-      f0 = kernel_data_fetch(attributes_float2, desc.offset + tri_vindex.x);
-      f1 = kernel_data_fetch(attributes_float2, desc.offset + tri_vindex.y);
-      f2 = kernel_data_fetch(attributes_float2, desc.offset + tri_vindex.z);
+      f0 = attribute_data_float2(kg, desc, tri_vindex.x);
+      f1 = attribute_data_float2(kg, desc, tri_vindex.y);
+      f2 = attribute_data_float2(kg, desc, tri_vindex.z);
     }
     else {
-      const int tri = desc.offset + sd->prim * 3;
-      f0 = kernel_data_fetch(attributes_float2, tri + 0);
-      f1 = kernel_data_fetch(attributes_float2, tri + 1);
-      f2 = kernel_data_fetch(attributes_float2, tri + 2);
+      const int tri = sd->prim * 3;
+      f0 = attribute_data_float2(kg, desc, tri + 0);
+      f1 = attribute_data_float2(kg, desc, tri + 1);
+      f2 = attribute_data_float2(kg, desc, tri + 2);
     }
 
 #ifdef __RAY_DIFFERENTIALS__
@@ -240,9 +240,8 @@ ccl_device float2 triangle_attribute_float2(KernelGlobals kg,
 #endif
 
     if (desc.element & (ATTR_ELEMENT_FACE | ATTR_ELEMENT_OBJECT | ATTR_ELEMENT_MESH)) {
-      const int offset = (desc.element == ATTR_ELEMENT_FACE) ? desc.offset + sd->prim :
-                                                               desc.offset;
-      return kernel_data_fetch(attributes_float2, offset);
+      const int index = (desc.element == ATTR_ELEMENT_FACE) ? sd->prim : 0;
+      return attribute_data_float2(kg, desc, index);
     }
     else {
       return make_float2(0.0f, 0.0f);
@@ -315,25 +314,24 @@ ccl_device float4 triangle_attribute_float4(KernelGlobals kg,
     if (desc.element & (ATTR_ELEMENT_VERTEX | ATTR_ELEMENT_VERTEX_MOTION)) {
       const uint3 tri_vindex = kernel_data_fetch(tri_vindex, sd->prim);
 
-      f0 = kernel_data_fetch(attributes_float4, desc.offset + tri_vindex.x);
-      f1 = kernel_data_fetch(attributes_float4, desc.offset + tri_vindex.y);
-      f2 = kernel_data_fetch(attributes_float4, desc.offset + tri_vindex.z);
+      f0 = attribute_data_float4(kg, desc, tri_vindex.x);
+      f1 = attribute_data_float4(kg, desc, tri_vindex.y);
+      f2 = attribute_data_float4(kg, desc, tri_vindex.z);
+    }
+    else if (desc.element == ATTR_ELEMENT_CORNER) {
+      const int tri = sd->prim * 3;
+      f0 = attribute_data_float4(kg, desc, tri + 0);
+      f1 = attribute_data_float4(kg, desc, tri + 1);
+      f2 = attribute_data_float4(kg, desc, tri + 2);
     }
     else {
       const int tri = desc.offset + sd->prim * 3;
-      if (desc.element == ATTR_ELEMENT_CORNER) {
-        f0 = kernel_data_fetch(attributes_float4, tri + 0);
-        f1 = kernel_data_fetch(attributes_float4, tri + 1);
-        f2 = kernel_data_fetch(attributes_float4, tri + 2);
-      }
-      else {
-        f0 = color_srgb_to_linear_v4(
-            color_uchar4_to_float4(kernel_data_fetch(attributes_uchar4, tri + 0)));
-        f1 = color_srgb_to_linear_v4(
-            color_uchar4_to_float4(kernel_data_fetch(attributes_uchar4, tri + 1)));
-        f2 = color_srgb_to_linear_v4(
-            color_uchar4_to_float4(kernel_data_fetch(attributes_uchar4, tri + 2)));
-      }
+      f0 = color_srgb_to_linear_v4(
+          color_uchar4_to_float4(kernel_data_fetch(attributes_uchar4, tri + 0)));
+      f1 = color_srgb_to_linear_v4(
+          color_uchar4_to_float4(kernel_data_fetch(attributes_uchar4, tri + 1)));
+      f2 = color_srgb_to_linear_v4(
+          color_uchar4_to_float4(kernel_data_fetch(attributes_uchar4, tri + 2)));
     }
 
 #ifdef __RAY_DIFFERENTIALS__
@@ -354,9 +352,8 @@ ccl_device float4 triangle_attribute_float4(KernelGlobals kg,
 #endif
 
     if (desc.element & (ATTR_ELEMENT_FACE | ATTR_ELEMENT_OBJECT | ATTR_ELEMENT_MESH)) {
-      const int offset = (desc.element == ATTR_ELEMENT_FACE) ? desc.offset + sd->prim :
-                                                               desc.offset;
-      return kernel_data_fetch(attributes_float4, offset);
+      const int index = (desc.element == ATTR_ELEMENT_FACE) ? sd->prim : 0;
+      return attribute_data_float4(kg, desc, index);
     }
     else {
       return zero_float4();
@@ -163,7 +163,8 @@ ccl_device_forceinline void integrator_path_init_sorted(KernelGlobals kg,
                                                         const uint32_t key)
 {
   INTEGRATOR_STATE_WRITE(state, path, queued_kernel) = next_kernel;
-  (void)key;
+  /* Used by the wavefront scheduler on the host, for coherent shading. */
+  INTEGRATOR_STATE_WRITE(state, path, shader_sort_key) = key;
 }
 
 ccl_device_forceinline void integrator_path_next(KernelGlobals kg,
@@ -190,7 +191,7 @@ ccl_device_forceinline void integrator_path_next_sorted(KernelGlobals kg,
                                                         const uint32_t key)
 {
   INTEGRATOR_STATE_WRITE(state, path, queued_kernel) = next_kernel;
-  (void)key;
+  INTEGRATOR_STATE_WRITE(state, path, shader_sort_key) = key;
   (void)current_kernel;
 }
 
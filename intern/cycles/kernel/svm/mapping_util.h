@@ -25,4 +25,29 @@ svm_mapping(NodeMappingType type, float3 vector, float3 location, float3 rotatio
   }
 }
 
+/* Affine transform equivalent to svm_mapping() with the given location, rotation and scale.
+ * The normal type is not affine, as it normalizes the result. */
+ccl_device Transform svm_mapping_to_transform(NodeMappingType type,
+                                              float3 location,
+                                              float3 rotation,
+                                              float3 scale)
+{
+  Transform rotationTransform = euler_to_transform(rotation);
+  switch (type) {
+    case NODE_MAPPING_TYPE_POINT:
+      return transform_translate(location) * rotationTransform * transform_scale(scale);
+    case NODE_MAPPING_TYPE_TEXTURE: {
+      const Transform &r = rotationTransform;
+      Transform inverse_rotation = make_transform(
+          r.x.x, r.y.x, r.z.x, 0.0f, r.x.y, r.y.y, r.z.y, 0.0f, r.x.z, r.y.z, r.z.z, 0.0f);
+      return transform_scale(safe_divide(one_float3(), scale)) * inverse_rotation *
+             transform_translate(-location);
+    }
+    case NODE_MAPPING_TYPE_VECTOR:
+      return rotationTransform * transform_scale(scale);
+    default:
+      return transform_identity();
+  }
+}
+
 CCL_NAMESPACE_END
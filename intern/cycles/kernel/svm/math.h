@@ -24,6 +24,34 @@ ccl_device_noinline void svm_node_math(KernelGlobals kg,
   stack_store_float(stack, result_stack_offset, result);
 }
 
+/* Consecutive math nodes, evaluated without going back to the interpreter loop for every node.
+ * All nodes of the chain are NODE_MATH_CHAIN except for the last one, which is NODE_MATH. */
+ccl_device_noinline int svm_node_math_chain(KernelGlobals kg,
+                                            ccl_private ShaderData *sd,
+                                            ccl_private float *stack,
+                                            uint4 node,
+                                            int offset)
+{
+  while (true) {
+    uint a_stack_offset, b_stack_offset, c_stack_offset;
+    svm_unpack_node_uchar3(node.z, &a_stack_offset, &b_stack_offset, &c_stack_offset);
+
+    float a = stack_load_float(stack, a_stack_offset);
+    float b = stack_load_float(stack, b_stack_offset);
+    float c = stack_load_float(stack, c_stack_offset);
+    float result = svm_math((NodeMathType)node.y, a, b, c);
+
+    stack_store_float(stack, node.w, result);
+
+    if (node.x != NODE_MATH_CHAIN) {
+      break;
+    }
+    node = read_node(kg, &offset);
+  }
+
+  return offset;
+}
+
 ccl_device_noinline int svm_node_vector_math(KernelGlobals kg,
                                              ccl_private ShaderData *sd,
                                              ccl_private float *stack,
@@ -52,6 +52,7 @@ SHADER_NODE_TYPE(NODE_LAYER_WEIGHT)
 SHADER_NODE_TYPE(NODE_CLOSURE_VOLUME)
 SHADER_NODE_TYPE(NODE_PRINCIPLED_VOLUME)
 SHADER_NODE_TYPE(NODE_MATH)
+SHADER_NODE_TYPE(NODE_MATH_CHAIN)
 SHADER_NODE_TYPE(NODE_VECTOR_MATH)
 SHADER_NODE_TYPE(NODE_RGB_RAMP)
 SHADER_NODE_TYPE(NODE_GAMMA)
@@ -109,7 +110,4 @@ SHADER_NODE_TYPE(NODE_MIX_FLOAT)
 SHADER_NODE_TYPE(NODE_MIX_VECTOR)
 SHADER_NODE_TYPE(NODE_MIX_VECTOR_NON_UNIFORM)
 
-/* Padding for struct alignment. */
-SHADER_NODE_TYPE(NODE_PAD1)
-
 #undef SHADER_NODE_TYPE
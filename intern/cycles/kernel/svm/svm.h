@@ -419,6 +419,9 @@ ccl_device void svm_eval_nodes(KernelGlobals kg,
       SVM_CASE(NODE_MATH)
       svm_node_math(kg, sd, stack, node.y, node.z, node.w);
       break;
+      SVM_CASE(NODE_MATH_CHAIN)
+      offset = svm_node_math_chain(kg, sd, stack, node, offset);
+      break;
       SVM_CASE(NODE_VECTOR_MATH)
       offset = svm_node_vector_math(kg, sd, stack, node.y, node.z, node.w, offset);
       break;
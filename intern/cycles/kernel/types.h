@@ -722,6 +722,12 @@ typedef enum AttributeStandard {
 typedef enum AttributeFlag {
   ATTR_FINAL_SIZE = (1 << 0),
   ATTR_SUBDIVIDED = (1 << 1),
+  /* Compact storage of triangle attributes in attributes_uchar4: float2 as two half floats in
+   * one element, float4 as four half floats in two elements, or colors as sRGB encoded bytes. */
+  ATTR_COMPACT_HALF = (1 << 2),
+  ATTR_COMPACT_BYTE = (1 << 3),
+  /* Color converted from 8 bit data, stored as bytes again when using compact attributes. */
+  ATTR_BYTE_COLOR = (1 << 4),
 } AttributeFlag;
 
 typedef struct AttributeDescriptor {
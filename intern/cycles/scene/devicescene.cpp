@@ -20,6 +20,7 @@ DeviceScene::DeviceScene(Device *device)
       tri_verts(device, "tri_verts", MEM_GLOBAL),
       tri_shader(device, "tri_shader", MEM_GLOBAL),
       tri_vnormal(device, "tri_vnormal", MEM_GLOBAL),
+      tri_vnormal_oct(device, "tri_vnormal_oct", MEM_GLOBAL),
       tri_vindex(device, "tri_vindex", MEM_GLOBAL),
       tri_patch(device, "tri_patch", MEM_GLOBAL),
       tri_patch_uv(device, "tri_patch_uv", MEM_GLOBAL),
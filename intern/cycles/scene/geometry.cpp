@@ -486,6 +486,16 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
     }
   }
 
+  /* Compact float2 and float4 attributes of meshes are stored in the uchar4 array. */
+  if (scene->params.use_compact_attributes) {
+    if (device_update_flags & (ATTR_FLOAT2_NEEDS_REALLOC | ATTR_FLOAT4_NEEDS_REALLOC)) {
+      device_update_flags |= ATTR_UCHAR4_NEEDS_REALLOC;
+    }
+    if (device_update_flags & (ATTR_FLOAT2_MODIFIED | ATTR_FLOAT4_MODIFIED)) {
+      device_update_flags |= ATTR_UCHAR4_MODIFIED;
+    }
+  }
+
   if (update_flags & (MESH_ADDED | MESH_REMOVED)) {
     device_update_flags |= DEVICE_MESH_DATA_NEEDS_REALLOC;
   }
@@ -519,6 +529,7 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
     if (device_update_flags & DEVICE_MESH_DATA_NEEDS_REALLOC) {
       dscene->tri_verts.tag_realloc();
       dscene->tri_vnormal.tag_realloc();
+      dscene->tri_vnormal_oct.tag_realloc();
       dscene->tri_vindex.tag_realloc();
       dscene->tri_patch.tag_realloc();
       dscene->tri_patch_uv.tag_realloc();
@@ -587,6 +598,7 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
      * these are the only arrays that can be updated */
     dscene->tri_verts.tag_modified();
     dscene->tri_vnormal.tag_modified();
+    dscene->tri_vnormal_oct.tag_modified();
     dscene->tri_shader.tag_modified();
   }
 
@@ -1044,6 +1056,7 @@ void GeometryManager::device_update(Device *device,
   dscene->tri_vindex.clear_modified();
   dscene->tri_patch.clear_modified();
   dscene->tri_vnormal.clear_modified();
+  dscene->tri_vnormal_oct.clear_modified();
   dscene->tri_patch_uv.clear_modified();
   dscene->curves.clear_modified();
   dscene->curve_keys.clear_modified();
@@ -1072,6 +1085,7 @@ void GeometryManager::device_free(Device *device, DeviceScene *dscene, bool forc
   dscene->tri_verts.free_if_need_realloc(force_free);
   dscene->tri_shader.free_if_need_realloc(force_free);
   dscene->tri_vnormal.free_if_need_realloc(force_free);
+  dscene->tri_vnormal_oct.free_if_need_realloc(force_free);
   dscene->tri_vindex.free_if_need_realloc(force_free);
   dscene->tri_patch.free_if_need_realloc(force_free);
   dscene->tri_patch_uv.free_if_need_realloc(force_free);
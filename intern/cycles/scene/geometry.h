@@ -291,6 +291,7 @@ class GeometryManager {
                                               size_t &attr_uchar4_offset,
                                               Attribute *mattr,
                                               AttributePrimitive prim,
+                                              bool use_compact_attributes,
                                               TypeDesc &type,
                                               AttributeDescriptor &desc);
 };
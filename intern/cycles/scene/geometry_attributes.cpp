@@ -26,7 +26,9 @@
 
 #include "kernel/osl/globals.h"
 
+#include "util/color.h"
 #include "util/foreach.h"
+#include "util/half.h"
 #include "util/log.h"
 #include "util/progress.h"
 #include "util/task.h"
@@ -257,6 +259,84 @@ void GeometryManager::update_svm_attributes(Device *,
   dscene->attributes_map.copy_to_device();
 }
 
+/* Compact storage of the attribute in attributes_uchar4, for scenes using compact attributes.
+ * Only done for attributes interpolated over triangles, attributes of subdivision surfaces and
+ * other primitive types are read from the float arrays by many more kernel functions. */
+static uint attribute_compact_flags(const Geometry *geom,
+                                    const Attribute *mattr,
+                                    AttributePrimitive prim,
+                                    const bool use_compact_attributes)
+{
+  if (!use_compact_attributes || prim != ATTR_PRIM_GEOMETRY || !geom->is_mesh()) {
+    return 0;
+  }
+  if (static_cast<const Mesh *>(geom)->get_num_subd_faces()) {
+    return 0;
+  }
+  if (!(mattr->element & (ATTR_ELEMENT_VERTEX | ATTR_ELEMENT_CORNER | ATTR_ELEMENT_FACE))) {
+    return 0;
+  }
+
+  if (mattr->type == TypeFloat2) {
+    return ATTR_COMPACT_HALF;
+  }
+  if (mattr->type == TypeRGBA && (mattr->flags & ATTR_BYTE_COLOR)) {
+    return ATTR_COMPACT_BYTE;
+  }
+  if (mattr->type == TypeFloat4 || mattr->type == TypeRGBA) {
+    return ATTR_COMPACT_HALF;
+  }
+  return 0;
+}
+
+/* Number of attributes_uchar4 elements used per attribute element in compact storage. */
+static size_t attribute_compact_stride(const Attribute *mattr, const uint compact_flags)
+{
+  return (compact_flags & ATTR_COMPACT_HALF && mattr->type != TypeFloat2) ? 2 : 1;
+}
+
+static AttrKernelDataType attribute_storage_type(const Geometry *geom,
+                                                 const Attribute *mattr,
+                                                 AttributePrimitive prim,
+                                                 const bool use_compact_attributes)
+{
+  if (attribute_compact_flags(geom, mattr, prim, use_compact_attributes)) {
+    return AttrKernelDataType::UCHAR4;
+  }
+  return Attribute::kernel_type(*mattr);
+}
+
+static uchar4 uint_to_uchar4(const uint v)
+{
+  return make_uchar4(v & 0xff, (v >> 8) & 0xff, (v >> 16) & 0xff, v >> 24);
+}
+
+static void pack_compact_attribute(const Attribute *mattr,
+                                   const uint compact_flags,
+                                   const size_t size,
+                                   uchar4 *dst)
+{
+  if (mattr->type == TypeFloat2) {
+    const float2 *data = mattr->data_float2();
+    for (size_t k = 0; k < size; k++) {
+      dst[k] = uint_to_uchar4(float2_to_half2_bits(data[k]));
+    }
+  }
+  else if (compact_flags & ATTR_COMPACT_BYTE) {
+    const float4 *data = mattr->data_float4();
+    for (size_t k = 0; k < size; k++) {
+      dst[k] = color_float4_to_uchar4(color_linear_to_srgb_v4(data[k]));
+    }
+  }
+  else {
+    const float4 *data = mattr->data_float4();
+    for (size_t k = 0; k < size; k++) {
+      dst[k * 2 + 0] = uint_to_uchar4(float2_to_half2_bits(make_float2(data[k].x, data[k].y)));
+      dst[k * 2 + 1] = uint_to_uchar4(float2_to_half2_bits(make_float2(data[k].z, data[k].w)));
+    }
+  }
+}
+
 void GeometryManager::update_attribute_element_offset(Geometry *geom,
                                                       device_vector<float> &attr_float,
                                                       size_t &attr_float_offset,
@@ -270,13 +350,18 @@ void GeometryManager::update_attribute_element_offset(Geometry *geom,
                                                       size_t &attr_uchar4_offset,
                                                       Attribute *mattr,
                                                       AttributePrimitive prim,
+                                                      const bool use_compact_attributes,
                                                       TypeDesc &type,
                                                       AttributeDescriptor &desc)
 {
   if (mattr) {
+    const uint compact_flags = attribute_compact_flags(
+        geom, mattr, prim, use_compact_attributes);
+    const size_t stride = attribute_compact_stride(mattr, compact_flags);
+
     /* store element and type */
     desc.element = mattr->element;
-    desc.flags = mattr->flags;
+    desc.flags = mattr->flags | compact_flags;
     type = mattr->type;
 
     /* store attribute data in arrays */
@@ -303,6 +388,16 @@ void GeometryManager::update_attribute_element_offset(Geometry *geom,
       }
       attr_uchar4_offset += size;
     }
+    else if (compact_flags) {
+      offset = attr_uchar4_offset;
+
+      assert(attr_uchar4.size() >= offset + size * stride);
+      if (mattr->modified) {
+        pack_compact_attribute(mattr, compact_flags, size, &attr_uchar4[offset]);
+        attr_uchar4.tag_modified();
+      }
+      attr_uchar4_offset += size * stride;
+    }
     else if (mattr->type == TypeDesc::TypeFloat) {
       float *data = mattr->data_float();
       offset = attr_float_offset;
@@ -379,18 +474,18 @@ void GeometryManager::update_attribute_element_offset(Geometry *geom,
          * from patch table so no need for correction here. */
       }
       else if (element == ATTR_ELEMENT_VERTEX)
-        offset -= mesh->vert_offset;
+        offset -= mesh->vert_offset * stride;
       else if (element == ATTR_ELEMENT_VERTEX_MOTION)
         offset -= mesh->vert_offset;
       else if (element == ATTR_ELEMENT_FACE) {
         if (prim == ATTR_PRIM_GEOMETRY)
-          offset -= mesh->prim_offset;
+          offset -= mesh->prim_offset * stride;
         else
           offset -= mesh->face_offset;
       }
       else if (element == ATTR_ELEMENT_CORNER || element == ATTR_ELEMENT_CORNER_BYTE) {
         if (prim == ATTR_PRIM_GEOMETRY)
-          offset -= 3 * mesh->prim_offset;
+          offset -= 3 * mesh->prim_offset * stride;
         else
           offset -= mesh->corner_offset;
       }
@@ -421,6 +516,7 @@ void GeometryManager::update_attribute_element_offset(Geometry *geom,
 static void update_attribute_element_size(Geometry *geom,
                                           Attribute *mattr,
                                           AttributePrimitive prim,
+                                          const bool use_compact_attributes,
                                           size_t *attr_float_size,
                                           size_t *attr_float2_size,
                                           size_t *attr_float3_size,
@@ -430,12 +526,18 @@ static void update_attribute_element_size(Geometry *geom,
   if (mattr) {
     size_t size = mattr->element_size(geom, prim);
 
+    const uint compact_flags = attribute_compact_flags(
+        geom, mattr, prim, use_compact_attributes);
+
     if (mattr->element == ATTR_ELEMENT_VOXEL) {
       /* pass */
     }
     else if (mattr->element == ATTR_ELEMENT_CORNER_BYTE) {
       *attr_uchar4_size += size;
     }
+    else if (compact_flags) {
+      *attr_uchar4_size += size * attribute_compact_stride(mattr, compact_flags);
+    }
     else if (mattr->type == TypeDesc::TypeFloat) {
       *attr_float_size += size;
     }
@@ -522,6 +624,7 @@ void GeometryManager::device_update_attributes(Device *device,
   /* Pre-allocate attributes to avoid arrays re-allocation which would
    * take 2x of overall attribute memory usage.
    */
+  const bool use_compact_attributes = scene->params.use_compact_attributes;
   size_t attr_float_size = 0;
   size_t attr_float2_size = 0;
   size_t attr_float3_size = 0;
@@ -537,6 +640,7 @@ void GeometryManager::device_update_attributes(Device *device,
       update_attribute_element_size(geom,
                                     attr,
                                     ATTR_PRIM_GEOMETRY,
+                                    use_compact_attributes,
                                     &attr_float_size,
                                     &attr_float2_size,
                                     &attr_float3_size,
@@ -550,6 +654,7 @@ void GeometryManager::device_update_attributes(Device *device,
         update_attribute_element_size(mesh,
                                       subd_attr,
                                       ATTR_PRIM_SUBD,
+                                      use_compact_attributes,
                                       &attr_float_size,
                                       &attr_float2_size,
                                       &attr_float3_size,
@@ -566,6 +671,7 @@ void GeometryManager::device_update_attributes(Device *device,
       update_attribute_element_size(object->geometry,
                                     &attr,
                                     ATTR_PRIM_GEOMETRY,
+                                    use_compact_attributes,
                                     &attr_float_size,
                                     &attr_float2_size,
                                     &attr_float3_size,
@@ -607,7 +713,8 @@ void GeometryManager::device_update_attributes(Device *device,
 
       if (attr) {
         /* force a copy if we need to reallocate all the data */
-        attr->modified |= attributes_need_realloc[Attribute::kernel_type(*attr)];
+        attr->modified |= attributes_need_realloc[attribute_storage_type(
+            geom, attr, ATTR_PRIM_GEOMETRY, use_compact_attributes)];
       }
 
       update_attribute_element_offset(geom,
@@ -623,6 +730,7 @@ void GeometryManager::device_update_attributes(Device *device,
                                       attr_uchar4_offset,
                                       attr,
                                       ATTR_PRIM_GEOMETRY,
+                                      use_compact_attributes,
                                       req.type,
                                       req.desc);
 
@@ -648,6 +756,7 @@ void GeometryManager::device_update_attributes(Device *device,
                                         attr_uchar4_offset,
                                         subd_attr,
                                         ATTR_PRIM_SUBD,
+                                        use_compact_attributes,
                                         req.subd_type,
                                         req.subd_desc);
       }
@@ -666,7 +775,8 @@ void GeometryManager::device_update_attributes(Device *device,
       Attribute *attr = values.find(req);
 
       if (attr) {
-        attr->modified |= attributes_need_realloc[Attribute::kernel_type(*attr)];
+        attr->modified |= attributes_need_realloc[attribute_storage_type(
+            object->geometry, attr, ATTR_PRIM_GEOMETRY, use_compact_attributes)];
       }
 
       update_attribute_element_offset(object->geometry,
@@ -682,6 +792,7 @@ void GeometryManager::device_update_attributes(Device *device,
                                       attr_uchar4_offset,
                                       attr,
                                       ATTR_PRIM_GEOMETRY,
+                                      use_compact_attributes,
                                       req.type,
                                       req.desc);
 
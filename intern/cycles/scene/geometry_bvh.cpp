@@ -4,6 +4,7 @@
 
 #include "bvh/bvh.h"
 #include "bvh/bvh2.h"
+#include "bvh/cache.h"
 
 #include "device/device.h"
 
@@ -92,7 +93,29 @@ void Geometry::compute_bvh(Device *device,
 
       delete bvh;
       bvh = BVH::create(bparams, geometry, objects, device);
-      MEM_GUARDED_CALL(progress, device->build_bvh, bvh, *progress, false);
+
+      /* Reuse BVH2 built for identical geometry in an earlier render. Other layouts are built
+       * by Embree, OptiX or other libraries and are not cached. */
+      BVH2 *bvh2 = (bvh->params.bvh_layout == BVH_LAYOUT_BVH2) ? static_cast<BVH2 *>(bvh) :
+                                                                nullptr;
+      const string cache_key = (params->use_bvh_cache && bvh2) ? BVHCache::key(bparams, this) :
+                                                                 "";
+      const size_t cache_memory_limit = size_t(params->bvh_cache_memory_limit) * 1024 * 1024;
+
+      if (!cache_key.empty() &&
+          BVHCache::load(
+              cache_key, params->bvh_cache_directory, cache_memory_limit, bvh2->pack))
+      {
+        VLOG_WORK << "Using cached BVH for " << name.c_str();
+      }
+      else {
+        MEM_GUARDED_CALL(progress, device->build_bvh, bvh, *progress, false);
+
+        if (!cache_key.empty() && !progress->get_cancel()) {
+          BVHCache::store(
+              cache_key, params->bvh_cache_directory, cache_memory_limit, bvh2->pack);
+        }
+      }
     }
   }
 
@@ -91,7 +91,11 @@ void GeometryManager::device_update_mesh(Device *,
 
     packed_float3 *tri_verts = dscene->tri_verts.alloc(vert_size);
     uint *tri_shader = dscene->tri_shader.alloc(tri_size);
-    packed_float3 *vnormal = dscene->tri_vnormal.alloc(vert_size);
+    /* Only one of the normal arrays is used, the other one is left empty. */
+    const bool use_compact_normals = scene->params.use_compact_attributes;
+    packed_float3 *vnormal = dscene->tri_vnormal.alloc(use_compact_normals ? 0 : vert_size);
+    uint *vnormal_oct = dscene->tri_vnormal_oct.alloc(use_compact_normals ? vert_size : 0);
+    dscene->data.bvh.use_compact_normals = use_compact_normals;
     packed_uint3 *tri_vindex = dscene->tri_vindex.alloc(tri_size);
     uint *tri_patch = dscene->tri_patch.alloc(tri_size);
     float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
@@ -99,6 +103,7 @@ void GeometryManager::device_update_mesh(Device *,
     const bool copy_all_data = dscene->tri_shader.need_realloc() ||
                                dscene->tri_vindex.need_realloc() ||
                                dscene->tri_vnormal.need_realloc() ||
+                               dscene->tri_vnormal_oct.need_realloc() ||
                                dscene->tri_patch.need_realloc() ||
                                dscene->tri_patch_uv.need_realloc();
 
@@ -113,7 +118,12 @@ void GeometryManager::device_update_mesh(Device *,
         }
 
         if (mesh->verts_is_modified() || copy_all_data) {
-          mesh->pack_normals(&vnormal[mesh->vert_offset]);
+          if (use_compact_normals) {
+            mesh->pack_normals(&vnormal_oct[mesh->vert_offset]);
+          }
+          else {
+            mesh->pack_normals(&vnormal[mesh->vert_offset]);
+          }
         }
 
         if (mesh->verts_is_modified() || mesh->triangles_is_modified() ||
@@ -136,6 +146,7 @@ void GeometryManager::device_update_mesh(Device *,
     dscene->tri_verts.copy_to_device_if_modified();
     dscene->tri_shader.copy_to_device_if_modified();
     dscene->tri_vnormal.copy_to_device_if_modified();
+    dscene->tri_vnormal_oct.copy_to_device_if_modified();
     dscene->tri_vindex.copy_to_device_if_modified();
     dscene->tri_patch.copy_to_device_if_modified();
     dscene->tri_patch_uv.copy_to_device_if_modified();
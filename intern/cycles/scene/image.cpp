@@ -4,6 +4,7 @@
 
 #include "scene/image.h"
 #include "device/device.h"
+#include "kernel/device/cpu/image_cache.h"
 #include "scene/colorspace.h"
 #include "scene/image_oiio.h"
 #include "scene/image_vdb.h"
@@ -527,6 +528,75 @@ static bool image_associate_alpha(ImageManager::Image *img)
            img->params.alpha_type == IMAGE_ALPHA_CHANNEL_PACKED);
 }
 
+KernelImageCache *ImageManager::get_image_cache(Device *device, Scene *scene)
+{
+  /* With OSL, images are already read on demand through its own texture system. */
+  if (!scene->params.use_texture_cache || osl_texture_system) {
+    return NULL;
+  }
+
+  KernelImageCache *image_cache = device->get_cpu_image_cache();
+  if (image_cache) {
+    image_cache->init(scene->params.texture_cache_size);
+  }
+  return image_cache;
+}
+
+bool ImageManager::cache_load_image(KernelImageCache *image_cache, Image *img, size_t slot)
+{
+  /* Only image files can be read through the cache, and only with associated alpha since
+   * that is a setting shared by all images in the cache. */
+  if (img->builtin || img->loader->osl_filepath().empty() || !image_associate_alpha(img)) {
+    return false;
+  }
+
+  const ImageMetaData &metadata = img->metadata;
+  if (!(metadata.channels > 0) || metadata.depth > 1) {
+    return false;
+  }
+
+  const bool is_rgba = (metadata.type == IMAGE_DATA_TYPE_FLOAT4 ||
+                        metadata.type == IMAGE_DATA_TYPE_HALF4 ||
+                        metadata.type == IMAGE_DATA_TYPE_BYTE4 ||
+                        metadata.type == IMAGE_DATA_TYPE_USHORT4);
+  if (!is_rgba && !(metadata.type == IMAGE_DATA_TYPE_FLOAT ||
+                    metadata.type == IMAGE_DATA_TYPE_HALF ||
+                    metadata.type == IMAGE_DATA_TYPE_BYTE ||
+                    metadata.type == IMAGE_DATA_TYPE_USHORT))
+  {
+    return false;
+  }
+
+  /* sRGB images stay in sRGB, same as when loaded into memory. */
+  KernelImageCache::ColorConversion to_scene_linear;
+  if (metadata.colorspace != u_colorspace_raw && metadata.colorspace != u_colorspace_srgb) {
+    ColorSpaceProcessor *processor = ColorSpaceManager::get_processor(metadata.colorspace);
+    if (processor) {
+      to_scene_linear = [processor](float *pixels, const int channels) {
+        ColorSpaceManager::to_scene_linear(processor, pixels, channels);
+      };
+    }
+  }
+
+  if (!image_cache->add_image(slot,
+                              img->loader->osl_filepath(),
+                              is_rgba,
+                              img->params.interpolation,
+                              img->params.extension,
+                              to_scene_linear))
+  {
+    return false;
+  }
+
+  VLOG_WORK << "Reading image " << img->loader->name() << " through texture cache.";
+
+  img->mem->info.width = metadata.width;
+  img->mem->info.height = metadata.height;
+  img->mem->info.depth = metadata.depth;
+
+  return true;
+}
+
 template<TypeDesc::BASETYPE FileFormat, typename StorageType>
 bool ImageManager::file_load_image(Image *img, int texture_limit)
 {
@@ -713,6 +783,14 @@ void ImageManager::device_load_image(Device *device, Scene *scene, size_t slot,
   img->mem->info.use_transform_3d = img->metadata.use_transform_3d;
   img->mem->info.transform_3d = img->metadata.transform_3d;
 
+  /* Read pixels on demand instead of loading them into memory, if possible. */
+  KernelImageCache *image_cache = get_image_cache(device, scene);
+  if (image_cache && cache_load_image(image_cache, img, slot)) {
+    img->loader->cleanup();
+    img->need_load = false;
+    return;
+  }
+
   /* Create new texture. */
   if (type == IMAGE_DATA_TYPE_FLOAT4) {
     if (!file_load_image<TypeDesc::FLOAT, float>(img, texture_limit)) {
@@ -821,13 +899,18 @@ void ImageManager::device_load_image(Device *device, Scene *scene, size_t slot,
   img->need_load = false;
 }
 
-void ImageManager::device_free_image(Device *, size_t slot)
+void ImageManager::device_free_image(Device *device, size_t slot)
 {
   Image *img = images[slot];
   if (img == NULL) {
     return;
   }
 
+  KernelImageCache *image_cache = device->get_cpu_image_cache();
+  if (image_cache) {
+    image_cache->remove_image(slot);
+  }
+
   if (osl_texture_system) {
 #ifdef WITH_OSL
     ustring filepath = img->loader->osl_filepath();
@@ -928,6 +1011,11 @@ void ImageManager::device_free(Device *device)
     device_free_image(device, slot);
   }
   images.clear();
+
+  KernelImageCache *image_cache = device->get_cpu_image_cache();
+  if (image_cache) {
+    image_cache->free();
+  }
 }
 
 void ImageManager::collect_statistics(RenderStats *stats)
@@ -19,6 +19,7 @@ CCL_NAMESPACE_BEGIN
 
 class Device;
 class DeviceInfo;
+class KernelImageCache;
 class ImageHandle;
 class ImageKey;
 class ImageMetaData;
@@ -230,6 +231,9 @@ class ImageManager {
 
   void load_image_metadata(Image *img);
 
+  KernelImageCache *get_image_cache(Device *device, Scene *scene);
+  bool cache_load_image(KernelImageCache *image_cache, Image *img, size_t slot);
+
   template<TypeDesc::BASETYPE FileFormat, typename StorageType>
   bool file_load_image(Image *img, int texture_limit);
 
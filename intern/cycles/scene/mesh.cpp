@@ -748,6 +748,31 @@ void Mesh::pack_normals(packed_float3 *vnormal)
   }
 }
 
+void Mesh::pack_normals(uint *vnormal_oct)
+{
+  Attribute *attr_vN = attributes.find(ATTR_STD_VERTEX_NORMAL);
+  if (attr_vN == NULL) {
+    return;
+  }
+
+  bool do_transform = transform_applied;
+  Transform ntfm = transform_normal;
+
+  float3 *vN = attr_vN->data_float3();
+  size_t verts_size = verts.size();
+
+  if (do_transform) {
+    for (size_t i = 0; i < verts_size; i++) {
+      vnormal_oct[i] = float3_to_oct16(safe_normalize(transform_direction(&ntfm, vN[i])));
+    }
+  }
+  else {
+    for (size_t i = 0; i < verts_size; i++) {
+      vnormal_oct[i] = float3_to_oct16(vN[i]);
+    }
+  }
+}
+
 void Mesh::pack_verts(packed_float3 *tri_verts,
                       packed_uint3 *tri_vindex,
                       uint *tri_patch,
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 
 #include "bvh/bvh.h"
+#include "bvh/cache.h"
 #include "device/device.h"
 #include "scene/alembic.h"
 #include "scene/background.h"
@@ -74,11 +75,15 @@ Scene::Scene(const SceneParams &params_, Device *device)
 
   film->add_default(this);
   shader_manager->add_default(this);
+
+  BVHCache::add_user();
 }
 
 Scene::~Scene()
 {
   free_memory(true);
+
+  BVHCache::remove_user();
 }
 
 void Scene::free_memory(bool final)
@@ -72,6 +72,18 @@ class SceneParams {
   int hair_subdivisions;
   CurveShapeType hair_shape;
   int texture_limit;
+  /* Read image textures on demand through a texture cache with the given size in megabytes,
+   * instead of loading them into memory before rendering. CPU only. */
+  bool use_texture_cache;
+  int texture_cache_size;
+  /* Reuse BVH2 of geometry which did not change since an earlier render, kept in memory up to
+   * the given size in megabytes, and in the directory when it is not empty. */
+  bool use_bvh_cache;
+  int bvh_cache_memory_limit;
+  string bvh_cache_directory;
+  /* Store vertex normals octahedral encoded, and UVs and colors of meshes as half floats or
+   * bytes, trading some precision for less memory. */
+  bool use_compact_attributes;
 
   bool background;
 
@@ -87,6 +99,11 @@ class SceneParams {
     hair_subdivisions = 3;
     hair_shape = CURVE_RIBBON;
     texture_limit = 0;
+    use_texture_cache = false;
+    texture_cache_size = 4096;
+    use_bvh_cache = false;
+    bvh_cache_memory_limit = 2048;
+    use_compact_attributes = false;
     background = true;
   }
 
@@ -99,7 +116,13 @@ class SceneParams {
              use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes &&
              num_bvh_time_steps == params.num_bvh_time_steps &&
              hair_subdivisions == params.hair_subdivisions && hair_shape == params.hair_shape &&
-             texture_limit == params.texture_limit);
+             texture_limit == params.texture_limit &&
+             use_texture_cache == params.use_texture_cache &&
+             texture_cache_size == params.texture_cache_size &&
+             use_bvh_cache == params.use_bvh_cache &&
+             bvh_cache_memory_limit == params.bvh_cache_memory_limit &&
+             bvh_cache_directory == params.bvh_cache_directory &&
+             use_compact_attributes == params.use_compact_attributes);
   }
 
   int curve_subdivisions()
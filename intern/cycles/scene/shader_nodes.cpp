@@ -2026,6 +2026,23 @@ void MappingNode::compile(SVMCompiler &compiler)
   ShaderInput *scale_in = input("Scale");
   ShaderOutput *vector_out = output("Vector");
 
+  /* With constant location, rotation and scale the mapping is a single matrix multiplication,
+   * instead of building the rotation matrix again for every shading point. */
+  if (mapping_type != NODE_MAPPING_TYPE_NORMAL && !location_in->link && !rotation_in->link &&
+      !scale_in->link)
+  {
+    Transform tfm = svm_mapping_to_transform(
+        (NodeMappingType)mapping_type, location, rotation, scale);
+
+    compiler.add_node(NODE_TEXTURE_MAPPING,
+                      compiler.stack_assign(vector_in),
+                      compiler.stack_assign(vector_out));
+    compiler.add_node(tfm.x);
+    compiler.add_node(tfm.y);
+    compiler.add_node(tfm.z);
+    return;
+  }
+
   int vector_stack_offset = compiler.stack_assign(vector_in);
   int location_stack_offset = compiler.stack_assign(location_in);
   int rotation_stack_offset = compiler.stack_assign(rotation_in);
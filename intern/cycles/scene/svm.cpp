@@ -162,6 +162,7 @@ SVMCompiler::SVMCompiler(Scene *scene) : scene(scene)
   current_graph = NULL;
   background = false;
   mix_weight_offset = SVM_STACK_INVALID;
+  last_math_node = -1;
   compile_failed = false;
 
   /* This struct has one entry for every node, in order of ShaderNodeType definition. */
@@ -375,6 +376,18 @@ void SVMCompiler::add_node(int a, int b, int c, int d)
 
 void SVMCompiler::add_node(ShaderNodeType type, int a, int b, int c)
 {
+  if (type == NODE_MATH) {
+    /* Fuse with the math node directly before it, so the kernel evaluates both without
+     * dispatching each of them separately. Only the opcode changes, so jump offsets stay
+     * valid and jumping into the middle of the chain works too. */
+    const int index = current_svm_nodes.size();
+    if (index > 0 && last_math_node == index - 1) {
+      current_svm_nodes[index - 1].x = NODE_MATH_CHAIN;
+      svm_node_types_used[NODE_MATH_CHAIN] = true;
+    }
+    last_math_node = index;
+  }
+
   svm_node_types_used[type] = true;
   current_svm_nodes.push_back_slow(make_int4(type, a, b, c));
 }
@@ -751,6 +764,7 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
   /* clear all compiler state */
   memset((void *)&active_stack, 0, sizeof(active_stack));
   current_svm_nodes.clear();
+  last_math_node = -1;
 
   foreach (ShaderNode *node, graph->nodes) {
     foreach (ShaderInput *input, node->inputs)
@@ -827,6 +841,7 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
   /* if compile failed, generate empty shader */
   if (compile_failed) {
     current_svm_nodes.clear();
+    last_math_node = -1;
     compile_failed = false;
   }
 
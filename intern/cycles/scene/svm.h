@@ -219,6 +219,8 @@ class SVMCompiler {
   Stack active_stack;
   int max_stack_use;
   uint mix_weight_offset;
+  /* Index of the last emitted math node in current_svm_nodes, for fusing math nodes. */
+  int last_math_node;
   bool compile_failed;
 };
 
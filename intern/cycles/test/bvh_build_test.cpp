@@ -0,0 +1,210 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "bvh/build.h"
+#include "bvh/node.h"
+#include "bvh/partition.h"
+
+#include "scene/mesh.h"
+#include "scene/object.h"
+
+#include "util/progress.h"
+#include "util/task.h"
+#include "util/time.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Grid of size x size quads, randomly displaced so splits are not trivial. */
+void create_grid_mesh(Mesh &mesh, const int size)
+{
+  mesh.reserve_mesh((size + 1) * (size + 1), size * size * 2);
+
+  uint seed = 1;
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      seed = seed * 1103515245 + 12345;
+      const float z = float((seed >> 16) & 0x7fff) / 32767.0f;
+      mesh.add_vertex(make_float3(float(x), float(y), z));
+    }
+  }
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int v = y * (size + 1) + x;
+      mesh.add_triangle(v, v + 1, v + size + 2, 0, false);
+      mesh.add_triangle(v, v + size + 2, v + size + 1, 0, false);
+    }
+  }
+}
+
+/* Build BVH of the mesh, and check that every triangle is referenced by a leaf. */
+void build_and_verify(Mesh &mesh, const int size, const bool use_spatial_split)
+{
+  Object object;
+  object.set_geometry(&mesh);
+  vector<Object *> objects;
+  objects.push_back(&object);
+
+  BVHParams params;
+  params.use_spatial_split = use_spatial_split;
+
+  array<int> prim_type, prim_index, prim_object;
+  array<float2> prim_time;
+  Progress progress;
+
+  BVHBuild build(objects, prim_type, prim_index, prim_object, prim_time, params, progress);
+  BVHNode *root = build.run();
+  ASSERT_NE(root, nullptr);
+
+  const size_t num_triangles = mesh.num_triangles();
+  if (use_spatial_split) {
+    EXPECT_GE(prim_index.size(), num_triangles);
+  }
+  else {
+    EXPECT_EQ(prim_index.size(), num_triangles);
+  }
+
+  vector<bool> found(num_triangles, false);
+  for (size_t i = 0; i < prim_index.size(); i++) {
+    ASSERT_GE(prim_index[i], 0);
+    ASSERT_LT(prim_index[i], int(num_triangles));
+    found[prim_index[i]] = true;
+  }
+  for (size_t i = 0; i < num_triangles; i++) {
+    EXPECT_TRUE(found[i]) << "Triangle " << i << " is not in the BVH";
+  }
+
+  const BoundBox &bounds = root->bounds;
+  EXPECT_LE(bounds.min.x, 0.0f);
+  EXPECT_LE(bounds.min.y, 0.0f);
+  EXPECT_GE(bounds.max.x, float(size));
+  EXPECT_GE(bounds.max.y, float(size));
+
+  root->deleteSubtree();
+}
+
+struct PartitionCount {
+  int num_true = 0;
+  int num_false = 0;
+
+  void add(const BVHReference & /*ref*/, const bool side)
+  {
+    (side) ? num_true++ : num_false++;
+  }
+
+  void merge(const PartitionCount &other)
+  {
+    num_true += other.num_true;
+    num_false += other.num_false;
+  }
+};
+
+}  // namespace
+
+TEST(bvh_build, parallel_partition)
+{
+  TaskScheduler::init(0);
+
+  const int num_refs = 5 * BVHParams::PARALLEL_BLOCK_SIZE + 123;
+  vector<BVHReference> refs;
+  for (int i = 0; i < num_refs; i++) {
+    const float x = float((i * 7919) % num_refs);
+    refs.push_back(BVHReference(BoundBox(make_float3(x, 0.0f, 0.0f)), i, 0, PRIMITIVE_TRIANGLE));
+  }
+
+  const int start = 5;
+  const int size = num_refs - 10;
+  const float split = 0.3f * num_refs;
+  PartitionCount count;
+  const int num_left = bvh_parallel_partition(
+      refs.data(),
+      start,
+      size,
+      [&](const BVHReference &ref) { return ref.bounds().min.x < split; },
+      count);
+
+  EXPECT_EQ(num_left, count.num_true);
+  EXPECT_EQ(size - num_left, count.num_false);
+
+  /* All references on the correct side, and none lost or duplicated. */
+  vector<bool> found(num_refs, false);
+  for (int i = start; i < start + size; i++) {
+    EXPECT_EQ(refs[i].bounds().min.x < split, i < start + num_left);
+    EXPECT_FALSE(found[refs[i].prim_index()]);
+    found[refs[i].prim_index()] = true;
+  }
+  for (int i = 0; i < start; i++) {
+    EXPECT_EQ(refs[i].prim_index(), i);
+  }
+
+  TaskScheduler::exit();
+}
+
+TEST(bvh_build, binning)
+{
+  TaskScheduler::init(0);
+
+  /* Large enough for the top levels to be binned and partitioned in parallel. */
+  Mesh mesh;
+  create_grid_mesh(mesh, 200);
+  build_and_verify(mesh, 200, false);
+
+  TaskScheduler::exit();
+}
+
+TEST(bvh_build, spatial_split)
+{
+  TaskScheduler::init(0);
+
+  Mesh mesh;
+  create_grid_mesh(mesh, 200);
+  build_and_verify(mesh, 200, true);
+
+  TaskScheduler::exit();
+}
+
+#if 0
+/* Build time of a BVH for a mesh with millions of triangles. */
+TEST(bvh_build, benchmark)
+{
+  TaskScheduler::init(0);
+
+  Mesh mesh;
+  create_grid_mesh(mesh, 2048);
+
+  for (const bool use_spatial_split : {false, true}) {
+    Object object;
+    object.set_geometry(&mesh);
+    vector<Object *> objects;
+    objects.push_back(&object);
+
+    BVHParams params;
+    params.use_spatial_split = use_spatial_split;
+
+    array<int> prim_type, prim_index, prim_object;
+    array<float2> prim_time;
+    Progress progress;
+
+    const double start_time = time_dt();
+    BVHBuild build(objects, prim_type, prim_index, prim_object, prim_time, params, progress);
+    BVHNode *root = build.run();
+    const double build_time = time_dt() - start_time;
+
+    printf("%s build of %d triangles: %.3f s\n",
+           (use_spatial_split) ? "Spatial split" : "Binned",
+           int(mesh.num_triangles()),
+           build_time);
+
+    root->deleteSubtree();
+  }
+
+  TaskScheduler::exit();
+}
+#endif
+
+CCL_NAMESPACE_END
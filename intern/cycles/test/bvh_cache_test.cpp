@@ -0,0 +1,131 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "bvh/cache.h"
+
+#include "util/path.h"
+
+#include <cstring>
+#include <filesystem>
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Fill the arrays with different sizes and contents, so swapped or truncated arrays are
+ * detected. */
+PackedBVH create_packed_bvh(const int seed)
+{
+  PackedBVH pack;
+  pack.root_index = seed;
+  pack.nodes.resize(8);
+  for (size_t i = 0; i < pack.nodes.size(); i++) {
+    pack.nodes[i] = make_int4(seed, int(i), -int(i), 7);
+  }
+  pack.leaf_nodes.resize(3);
+  for (size_t i = 0; i < pack.leaf_nodes.size(); i++) {
+    pack.leaf_nodes[i] = make_int4(int(i), seed, 3, -1);
+  }
+  pack.object_node.resize(1);
+  pack.object_node[0] = seed;
+  pack.prim_type.resize(5);
+  pack.prim_visibility.resize(5);
+  pack.prim_index.resize(5);
+  pack.prim_object.resize(5);
+  pack.prim_time.resize(5);
+  for (int i = 0; i < 5; i++) {
+    pack.prim_type[i] = i % 2;
+    pack.prim_visibility[i] = ~uint(i);
+    pack.prim_index[i] = seed + i;
+    pack.prim_object[i] = -1;
+    pack.prim_time[i] = make_float2(0.0f, float(i) * 0.25f);
+  }
+  return pack;
+}
+
+size_t packed_bvh_size(const PackedBVH &pack)
+{
+  return (pack.nodes.size() + pack.leaf_nodes.size()) * sizeof(int4) +
+         (pack.object_node.size() + pack.prim_type.size() + pack.prim_visibility.size() +
+          pack.prim_index.size() + pack.prim_object.size()) *
+             sizeof(int) +
+         pack.prim_time.size() * sizeof(float2);
+}
+
+template<typename T> void expect_arrays_equal(const array<T> &a, const array<T> &b)
+{
+  ASSERT_EQ(a.size(), b.size());
+  EXPECT_EQ(memcmp(a.data(), b.data(), a.size() * sizeof(T)), 0);
+}
+
+void expect_packed_bvh_equal(const PackedBVH &a, const PackedBVH &b)
+{
+  EXPECT_EQ(a.root_index, b.root_index);
+  expect_arrays_equal(a.nodes, b.nodes);
+  expect_arrays_equal(a.leaf_nodes, b.leaf_nodes);
+  expect_arrays_equal(a.object_node, b.object_node);
+  expect_arrays_equal(a.prim_type, b.prim_type);
+  expect_arrays_equal(a.prim_visibility, b.prim_visibility);
+  expect_arrays_equal(a.prim_index, b.prim_index);
+  expect_arrays_equal(a.prim_object, b.prim_object);
+  expect_arrays_equal(a.prim_time, b.prim_time);
+}
+
+}  // namespace
+
+TEST(BVHCache, file_round_trip)
+{
+  const string directory = path_join(std::filesystem::temp_directory_path().string(),
+                                     "cycles_bvh_cache_test");
+  const string key = "0123456789abcdef0123456789abcdef";
+  const string filepath = path_join(directory, key + ".bvh");
+  const PackedBVH pack = create_packed_bvh(3);
+
+  /* Without memory for it, the BVH is only written to the directory. */
+  BVHCache::store(key, directory, 0, pack);
+  ASSERT_TRUE(path_exists(filepath));
+
+  PackedBVH loaded;
+  ASSERT_TRUE(BVHCache::load(key, directory, 0, loaded));
+  expect_packed_bvh_equal(pack, loaded);
+
+  /* Files that were not completely written are rejected. */
+  vector<uint8_t> binary;
+  ASSERT_TRUE(path_read_binary(filepath, binary));
+  binary.pop_back();
+  ASSERT_TRUE(path_write_binary(filepath, binary));
+  PackedBVH truncated;
+  EXPECT_FALSE(BVHCache::load(key, directory, 0, truncated));
+
+  path_remove(filepath);
+}
+
+TEST(BVHCache, memory_limit)
+{
+  BVHCache::clear();
+
+  const PackedBVH pack_a = create_packed_bvh(1);
+  const PackedBVH pack_b = create_packed_bvh(2);
+  const size_t memory_limit = packed_bvh_size(pack_a) * 3 / 2;
+
+  BVHCache::store("a", "", memory_limit, pack_a);
+  PackedBVH loaded;
+  ASSERT_TRUE(BVHCache::load("a", "", memory_limit, loaded));
+  expect_packed_bvh_equal(pack_a, loaded);
+
+  /* Only one BVH fits, the least recently used one is freed. */
+  BVHCache::store("b", "", memory_limit, pack_b);
+  EXPECT_FALSE(BVHCache::load("a", "", memory_limit, loaded));
+  ASSERT_TRUE(BVHCache::load("b", "", memory_limit, loaded));
+  expect_packed_bvh_equal(pack_b, loaded);
+
+  /* The memory is freed along with the last scene. */
+  BVHCache::add_user();
+  BVHCache::remove_user();
+  EXPECT_FALSE(BVHCache::load("b", "", memory_limit, loaded));
+}
+
+CCL_NAMESPACE_END
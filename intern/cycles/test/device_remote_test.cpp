@@ -0,0 +1,409 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "device/device.h"
+#include "device/remote/device.h"
+#include "device/remote/protocol.h"
+#include "device/remote/socket.h"
+
+#include "integrator/path_trace_work_remote.h"
+#include "integrator/remote_worker.h"
+#include "integrator/shader_eval.h"
+
+#include "kernel/types.h"
+
+#include "scene/background.h"
+#include "scene/camera.h"
+#include "scene/pass.h"
+#include "scene/scene.h"
+#include "scene/shader.h"
+#include "scene/shader_graph.h"
+#include "scene/shader_nodes.h"
+
+#include "session/output_driver.h"
+#include "session/session.h"
+
+#include "util/stats.h"
+#include "util/task.h"
+#include "util/thread.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Keeps the combined pass of the rendered image. */
+class CombinedOutputDriver : public OutputDriver {
+ public:
+  void write_render_tile(const Tile &tile) override
+  {
+    offset = tile.offset;
+    size = tile.size;
+    pixels.resize(size_t(size.x) * size.y * 4);
+    has_pixels = tile.get_pass_pixels("combined", 4, pixels.data());
+  }
+
+  int2 offset = make_int2(0, 0);
+  int2 size = make_int2(0, 0);
+  vector<float> pixels;
+  bool has_pixels = false;
+};
+
+}  // namespace
+
+TEST(device_remote, message)
+{
+  RemoteMessage message;
+  message.write(int(42));
+  message.write_string("bvh_nodes");
+  message.write(1.5f);
+
+  int value_int;
+  string value_string;
+  float value_float;
+  EXPECT_TRUE(message.read(value_int));
+  EXPECT_TRUE(message.read_string(value_string));
+  EXPECT_TRUE(message.read(value_float));
+  EXPECT_EQ(value_int, 42);
+  EXPECT_EQ(value_string, "bvh_nodes");
+  EXPECT_EQ(value_float, 1.5f);
+
+  /* Reading past the end fails. */
+  EXPECT_FALSE(message.read(value_int));
+  EXPECT_EQ(message.read_data(1), nullptr);
+}
+
+TEST(device_remote, socket)
+{
+  RemoteSocket listener;
+  string error;
+  ASSERT_TRUE(listener.listen(REMOTE_DEFAULT_BIND_ADDRESS, 0, error)) << error;
+  const int port = listener.get_port();
+  ASSERT_GT(port, 0);
+
+  /* Echo a single message. */
+  thread echo([&]() {
+    RemoteSocket connection = listener.accept();
+    uint type;
+    RemoteMessage message;
+    if (connection.recv_message(type, message)) {
+      connection.send_message(type + 1, message);
+    }
+  });
+
+  RemoteSocket socket;
+  ASSERT_TRUE(socket.connect("127.0.0.1", port, error)) << error;
+
+  RemoteMessage message;
+  vector<float> data(100000, 2.0f);
+  message.write_data(data.data(), data.size() * sizeof(float));
+  ASSERT_TRUE(socket.send_message(7, message));
+
+  uint type;
+  RemoteMessage reply;
+  ASSERT_TRUE(socket.recv_message(type, reply));
+  EXPECT_EQ(type, 8u);
+  EXPECT_EQ(reply.data, message.data);
+
+  echo.join();
+}
+
+TEST(device_remote, socket_listen_address)
+{
+  RemoteSocket listener;
+  string error;
+
+  /* Only numeric addresses of local interfaces can be listened on. */
+  EXPECT_FALSE(listener.listen("localhost", 0, error));
+  EXPECT_FALSE(error.empty());
+
+  ASSERT_TRUE(listener.listen("0.0.0.0", 0, error)) << error;
+  EXPECT_GT(listener.get_port(), 0);
+}
+
+TEST(device_remote, worker)
+{
+  TaskScheduler::init(0);
+
+  RemoteSocket listener;
+  string error;
+  ASSERT_TRUE(listener.listen(REMOTE_DEFAULT_BIND_ADDRESS, 0, error)) << error;
+  const string address = string_printf("127.0.0.1:%d", listener.get_port());
+
+  /* Serve the connection to query the device info, and the one of the device itself. */
+  RemoteWorker worker;
+  thread serve([&]() {
+    for (int i = 0; i < 2; i++) {
+      RemoteSocket connection = listener.accept();
+      worker.serve(connection);
+    }
+  });
+
+  DeviceInfo info;
+  ASSERT_TRUE(device_remote_worker_info(address, 0, info));
+  EXPECT_EQ(info.type, DEVICE_REMOTE);
+
+  {
+    Stats stats;
+    Profiler profiler;
+    unique_ptr<Device> device(Device::create(info, stats, profiler));
+    ASSERT_EQ(device->info.type, DEVICE_REMOTE);
+    EXPECT_TRUE(device->load_kernels(0));
+
+    KernelData data;
+    memset(&data, 0, sizeof(data));
+    device->const_copy_to("data", &data, sizeof(data));
+
+    device_vector<uint> prim_index(device.get(), "prim_index", MEM_GLOBAL);
+    uint *prim_index_data = prim_index.alloc(1000);
+    for (int i = 0; i < 1000; i++) {
+      prim_index_data[i] = i;
+    }
+    prim_index.copy_to_device();
+    prim_index.free();
+    EXPECT_FALSE(device->have_error()) << device->error_message();
+
+    /* Errors of the worker are reported to the device. */
+    device_vector<uint> unknown(device.get(), "unknown", MEM_GLOBAL);
+    unknown.alloc(1);
+    unknown.copy_to_device();
+    EXPECT_TRUE(device->have_error());
+  }
+
+  serve.join();
+
+  TaskScheduler::exit();
+}
+
+TEST(device_remote, render_multiple_workers)
+{
+  const int num_workers = 2;
+  const int width = 64, height = 48;
+  const float3 background_color = make_float3(0.25f, 0.5f, 0.75f);
+
+  TaskScheduler::init(0);
+
+  /* Every worker serves the connection to query the device info, and the one of the device. */
+  RemoteSocket listeners[num_workers];
+  unique_ptr<RemoteWorker> workers[num_workers];
+  unique_ptr<thread> serve[num_workers];
+  vector<DeviceInfo> infos;
+  for (int i = 0; i < num_workers; i++) {
+    string error;
+    ASSERT_TRUE(listeners[i].listen(REMOTE_DEFAULT_BIND_ADDRESS, 0, error)) << error;
+    const string address = string_printf("127.0.0.1:%d", listeners[i].get_port());
+
+    workers[i] = make_unique<RemoteWorker>();
+    serve[i] = make_unique<thread>([&listeners, &workers, i]() {
+      for (int j = 0; j < 2; j++) {
+        RemoteSocket connection = listeners[i].accept();
+        workers[i]->serve(connection);
+      }
+    });
+
+    DeviceInfo info;
+    ASSERT_TRUE(device_remote_worker_info(address, i, info));
+    infos.push_back(info);
+  }
+
+  {
+    SessionParams session_params;
+    session_params.device = Device::get_multi_device(infos, 0, true);
+    session_params.background = true;
+    session_params.samples = 4;
+
+    SceneParams scene_params;
+    scene_params.shadingsystem = SHADINGSYSTEM_SVM;
+
+    Session session(session_params, scene_params);
+    CombinedOutputDriver *output_driver = new CombinedOutputDriver();
+    session.set_output_driver(unique_ptr<OutputDriver>(output_driver));
+
+    /* An empty scene with a constant background, so every pixel has the same color no matter
+     * which worker rendered it. */
+    Scene *scene = session.scene;
+    {
+      thread_scoped_lock scene_lock(scene->mutex);
+
+      ShaderGraph *graph = new ShaderGraph();
+      BackgroundNode *background = graph->create_node<BackgroundNode>();
+      background->set_color(background_color);
+      background->set_strength(1.0f);
+      graph->add(background);
+      graph->connect(background->output("Background"), graph->output()->input("Surface"));
+
+      Shader *shader = scene->default_background;
+      shader->set_graph(graph);
+      shader->tag_update(scene);
+
+      scene->camera->set_full_width(width);
+      scene->camera->set_full_height(height);
+      scene->camera->compute_auto_viewplane();
+
+      Pass *pass = scene->create_node<Pass>();
+      pass->set_name(ustring("combined"));
+      pass->set_type(PASS_COMBINED);
+    }
+
+    BufferParams buffer_params;
+    buffer_params.width = width;
+    buffer_params.height = height;
+    buffer_params.full_width = width;
+    buffer_params.full_height = height;
+
+    session.reset(session_params, buffer_params);
+    session.start();
+    session.wait();
+
+    ASSERT_FALSE(session.progress.get_error()) << session.progress.get_error_message();
+
+    /* The slices rendered by the workers are merged into the full image. */
+    ASSERT_TRUE(output_driver->has_pixels);
+    EXPECT_EQ(output_driver->offset.x, 0);
+    EXPECT_EQ(output_driver->offset.y, 0);
+    EXPECT_EQ(output_driver->size.x, width);
+    EXPECT_EQ(output_driver->size.y, height);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        const float *pixel = &output_driver->pixels[(size_t(y) * width + x) * 4];
+        EXPECT_NEAR(pixel[0], background_color.x, 1e-5f) << "pixel " << x << ", " << y;
+        EXPECT_NEAR(pixel[1], background_color.y, 1e-5f) << "pixel " << x << ", " << y;
+        EXPECT_NEAR(pixel[2], background_color.z, 1e-5f) << "pixel " << x << ", " << y;
+        EXPECT_NEAR(pixel[3], 1.0f, 1e-5f) << "pixel " << x << ", " << y;
+      }
+    }
+  }
+
+  for (int i = 0; i < num_workers; i++) {
+    serve[i]->join();
+  }
+
+  TaskScheduler::exit();
+}
+
+TEST(device_remote, worker_invalid_memory)
+{
+  TaskScheduler::init(0);
+
+  RemoteSocket listener;
+  string error;
+  ASSERT_TRUE(listener.listen(REMOTE_DEFAULT_BIND_ADDRESS, 0, error)) << error;
+
+  RemoteWorker worker;
+  thread serve([&]() {
+    RemoteSocket connection = listener.accept();
+    worker.serve(connection);
+  });
+
+  RemoteSocket socket;
+  ASSERT_TRUE(socket.connect("127.0.0.1", listener.get_port(), error)) << error;
+
+  /* Texture dimensions that do not match the data, which must be rejected before allocating. */
+  TextureInfo info;
+  memset(&info, 0, sizeof(info));
+  info.data_type = IMAGE_DATA_TYPE_FLOAT4;
+  RemoteMessage args;
+  args.write(uint64_t(1));
+  args.write_string("tex_image_float4_000");
+  args.write(int(MEM_TEXTURE));
+  args.write(int(TYPE_FLOAT));
+  args.write(int(4));
+  args.write(uint64_t(0));
+  args.write(uint64_t(1) << 40);
+  args.write(uint64_t(1) << 40);
+  args.write(uint64_t(0));
+  args.write(uint(0));
+  args.write(info);
+  args.write(uint64_t(sizeof(float4)));
+  args.write(make_float4(1.0f));
+  ASSERT_TRUE(socket.send_message(REMOTE_REQUEST_MEM_COPY_TO, args));
+
+  uint type;
+  RemoteMessage reply;
+  string reply_error;
+  ASSERT_TRUE(socket.recv_message(type, reply));
+  EXPECT_EQ(type, uint(REMOTE_REPLY_ERROR));
+  ASSERT_TRUE(reply.read_string(reply_error));
+  EXPECT_EQ(reply_error, "Device memory size mismatch for tex_image_float4_000");
+
+  /* Render buffers too big to ever be sent in a message. */
+  BufferParams buffer_params;
+  buffer_params.width = 1 << 20;
+  buffer_params.height = 1 << 20;
+  buffer_params.pass_stride = 4;
+  args.clear();
+  for (int i = 0; i < 4; i++) {
+    remote_write_buffer_params(args, buffer_params);
+  }
+  ASSERT_TRUE(socket.send_message(REMOTE_REQUEST_WORK_ZERO, args));
+  ASSERT_TRUE(socket.recv_message(type, reply));
+  EXPECT_EQ(type, uint(REMOTE_REPLY_ERROR));
+  ASSERT_TRUE(reply.read_string(reply_error));
+  EXPECT_NE(reply_error.find("Invalid render buffer"), string::npos) << reply_error;
+
+  /* Message header with a size above the protocol maximum closes the connection. */
+  RemoteMessageHeader header;
+  header.magic = REMOTE_MESSAGE_MAGIC;
+  header.type = REMOTE_REQUEST_HELLO;
+  header.size = REMOTE_MESSAGE_MAX_SIZE + 1;
+  ASSERT_TRUE(socket.send(&header, sizeof(header)));
+  EXPECT_FALSE(socket.recv_message(type, reply));
+
+  socket.close();
+  serve.join();
+
+  TaskScheduler::exit();
+}
+
+TEST(device_remote, worker_invalid_shader_eval)
+{
+  TaskScheduler::init(0);
+
+  RemoteSocket listener;
+  string error;
+  ASSERT_TRUE(listener.listen(REMOTE_DEFAULT_BIND_ADDRESS, 0, error)) << error;
+
+  RemoteWorker worker;
+  thread serve([&]() {
+    RemoteSocket connection = listener.accept();
+    worker.serve(connection);
+  });
+
+  RemoteSocket socket;
+  ASSERT_TRUE(socket.connect("127.0.0.1", listener.get_port(), error)) << error;
+
+  /* Output size that is not a multiple of the number of points. */
+  RemoteMessage args;
+  args.write(int(SHADER_EVAL_BACKGROUND));
+  args.write(int(10));
+  args.write(uint64_t(15));
+  ASSERT_TRUE(socket.send_message(REMOTE_REQUEST_SHADER_EVAL, args));
+
+  uint type;
+  RemoteMessage reply;
+  string reply_error;
+  ASSERT_TRUE(socket.recv_message(type, reply));
+  EXPECT_EQ(type, uint(REMOTE_REPLY_ERROR));
+  ASSERT_TRUE(reply.read_string(reply_error));
+  EXPECT_NE(reply_error.find("Invalid shader evaluation"), string::npos) << reply_error;
+
+  /* Missing input. */
+  args.clear();
+  args.write(int(SHADER_EVAL_BACKGROUND));
+  args.write(int(10));
+  args.write(uint64_t(30));
+  ASSERT_TRUE(socket.send_message(REMOTE_REQUEST_SHADER_EVAL, args));
+  ASSERT_TRUE(socket.recv_message(type, reply));
+  EXPECT_EQ(type, uint(REMOTE_REPLY_ERROR));
+  ASSERT_TRUE(reply.read_string(reply_error));
+  EXPECT_EQ(reply_error, "Failed to read shader evaluation input");
+
+  socket.close();
+  serve.join();
+
+  TaskScheduler::exit();
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,71 @@
+/* SPDX-FileCopyrightText: 2011-2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "kernel/svm/types.h"
+
+#include "util/transform.h"
+
+#include "kernel/svm/mapping_util.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Constant mapping nodes are compiled to a matrix, which must give the same result as evaluating
+ * the node. */
+static void expect_mapping_transform_equal(const NodeMappingType type,
+                                           const float3 location,
+                                           const float3 rotation,
+                                           const float3 scale)
+{
+  const Transform tfm = svm_mapping_to_transform(type, location, rotation, scale);
+
+  const float3 vectors[] = {
+      make_float3(0.0f, 0.0f, 0.0f),
+      make_float3(1.0f, 0.0f, 0.0f),
+      make_float3(0.0f, 1.0f, 0.0f),
+      make_float3(0.0f, 0.0f, 1.0f),
+      make_float3(0.3f, -2.5f, 7.0f),
+      make_float3(-11.0f, 4.25f, -0.125f),
+  };
+  for (const float3 &vector : vectors) {
+    const float3 expected = svm_mapping(type, vector, location, rotation, scale);
+    const float3 result = transform_point(&tfm, vector);
+    EXPECT_NEAR(result.x, expected.x, 1e-4f) << "type " << type;
+    EXPECT_NEAR(result.y, expected.y, 1e-4f) << "type " << type;
+    EXPECT_NEAR(result.z, expected.z, 1e-4f) << "type " << type;
+  }
+}
+
+TEST(svm_mapping, transform_matches_node)
+{
+  const NodeMappingType types[] = {
+      NODE_MAPPING_TYPE_POINT, NODE_MAPPING_TYPE_TEXTURE, NODE_MAPPING_TYPE_VECTOR};
+  const float3 location = make_float3(1.5f, -0.75f, 3.0f);
+  const float3 rotation = make_float3(0.4f, -1.2f, 2.7f);
+  const float3 scale = make_float3(2.0f, 0.5f, -3.0f);
+
+  for (const NodeMappingType type : types) {
+    expect_mapping_transform_equal(type, location, rotation, scale);
+
+    /* Rotation about a single axis at a time. */
+    expect_mapping_transform_equal(type, location, make_float3(0.9f, 0.0f, 0.0f), scale);
+    expect_mapping_transform_equal(type, location, make_float3(0.0f, 0.9f, 0.0f), scale);
+    expect_mapping_transform_equal(type, location, make_float3(0.0f, 0.0f, 0.9f), scale);
+
+    /* Identity. */
+    expect_mapping_transform_equal(type, zero_float3(), zero_float3(), one_float3());
+  }
+}
+
+TEST(svm_mapping, transform_zero_scale)
+{
+  /* The texture type divides by the scale, which is done safely by both. */
+  expect_mapping_transform_equal(NODE_MAPPING_TYPE_TEXTURE,
+                                 make_float3(1.0f, 2.0f, 3.0f),
+                                 make_float3(0.4f, -1.2f, 2.7f),
+                                 make_float3(2.0f, 0.0f, 0.5f));
+}
+
+CCL_NAMESPACE_END
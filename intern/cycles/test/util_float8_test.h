@@ -12,7 +12,9 @@ CCL_NAMESPACE_BEGIN
 static bool validate_cpu_capabilities()
 {
 
-#if defined(__KERNEL_AVX2__)
+#if defined(__KERNEL_AVX512__)
+  return system_cpu_support_avx512();
+#elif defined(__KERNEL_AVX2__)
   return system_cpu_support_avx2();
 #elif defined(__KERNEL_AVX__)
   return system_cpu_support_avx();
@@ -96,6 +98,21 @@ TEST(TEST_CATEGORY_NAME, float8_sqrt)
                         make_vfloat8(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f));
 }
 
+TEST(TEST_CATEGORY_NAME, float8_rcp)
+{
+  INIT_FLOAT8_TEST
+  compare_vector_vector_near(rcp(float8_b()),
+                             make_vfloat8(1.0f / 1.0f,
+                                          1.0f / 2.0f,
+                                          1.0f / 3.0f,
+                                          1.0f / 4.0f,
+                                          1.0f / 5.0f,
+                                          1.0f / 6.0f,
+                                          1.0f / 7.0f,
+                                          1.0f / 8.0f),
+                             1e-3f);
+}
+
 TEST(TEST_CATEGORY_NAME, float8_min_max)
 {
   INIT_FLOAT8_TEST
@@ -4,6 +4,7 @@
 
 #include "testing/testing.h"
 
+#include "util/half.h"
 #include "util/math.h"
 
 CCL_NAMESPACE_BEGIN
@@ -46,4 +47,48 @@ TEST(math, reverse_integer_bits)
   EXPECT_EQ(reverse_integer_bits(0xAAAAAAAA), 0x55555555);
 }
 
+TEST(math, oct16)
+{
+  const float3 axes[6] = {make_float3(1.0f, 0.0f, 0.0f),
+                          make_float3(-1.0f, 0.0f, 0.0f),
+                          make_float3(0.0f, 1.0f, 0.0f),
+                          make_float3(0.0f, -1.0f, 0.0f),
+                          make_float3(0.0f, 0.0f, 1.0f),
+                          make_float3(0.0f, 0.0f, -1.0f)};
+  for (int i = 0; i < 6; i++) {
+    const float3 n = oct16_to_float3(float3_to_oct16(axes[i]));
+    EXPECT_NEAR(n.x, axes[i].x, 1e-4f);
+    EXPECT_NEAR(n.y, axes[i].y, 1e-4f);
+    EXPECT_NEAR(n.z, axes[i].z, 1e-4f);
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    const float phi = i * 0.0628f;
+    const float z = 1.0f - 2.0f * (i + 0.5f) / 1000.0f;
+    const float r = sqrtf(1.0f - z * z);
+    const float3 v = make_float3(r * cosf(phi), r * sinf(phi), z);
+    const float3 n = oct16_to_float3(float3_to_oct16(v));
+    EXPECT_LT(len(n - v), 1e-4f);
+  }
+}
+
+TEST(math, half_bits)
+{
+  EXPECT_EQ(half_bits_to_float(float_to_half_bits(0.0f)), 0.0f);
+  EXPECT_EQ(half_bits_to_float(float_to_half_bits(1.0f)), 1.0f);
+  EXPECT_EQ(half_bits_to_float(float_to_half_bits(-2.5f)), -2.5f);
+  EXPECT_EQ(half_bits_to_float(float_to_half_bits(1e10f)), 65504.0f);
+  EXPECT_EQ(half_bits_to_float(float_to_half_bits(1e-10f)), 0.0f);
+
+  /* Rounded to nearest, with 11 bits of precision. */
+  for (int i = 0; i < 1000; i++) {
+    const float f = i * 0.0137f;
+    EXPECT_NEAR(half_bits_to_float(float_to_half_bits(f)), f, f * (1.0f / 2048.0f));
+  }
+
+  const float2 uv = half2_bits_to_float2(float2_to_half2_bits(make_float2(0.25f, 3.0f)));
+  EXPECT_EQ(uv.x, 0.25f);
+  EXPECT_EQ(uv.y, 3.0f);
+}
+
 CCL_NAMESPACE_END
@@ -26,6 +26,7 @@ class DebugFlags {
     void reset();
 
     /* Flags describing which instructions sets are allowed for use. */
+    bool avx512 = true;
     bool avx2 = true;
     bool sse41 = true;
     bool sse2 = true;
@@ -33,6 +34,10 @@ class DebugFlags {
     /* Check functions to see whether instructions up to the given one
      * are allowed for use.
      */
+    bool has_avx512()
+    {
+      return has_avx2() && avx512;
+    }
     bool has_avx2()
     {
       return has_sse41() && avx2;
@@ -52,6 +57,10 @@ class DebugFlags {
      * CPUs and GPUs can be selected here instead.
      */
     BVHLayout bvh_layout = BVH_LAYOUT_AUTO;
+
+    /* Trace batches of paths kernel by kernel, sorted by shader, instead of following every
+     * path to its end before starting the next one. */
+    bool wavefront = false;
   };
 
   /* Descriptor of CUDA feature-set to be used. */
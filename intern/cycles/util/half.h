@@ -176,6 +176,51 @@ ccl_device_inline half4 float4_to_half4_display(const float4 f)
 #endif
 }
 
+/* Conversion to/from half float bits for compact geometry attributes
+ *
+ * Two half floats are packed into a 32 bit integer, so they can be stored as one element of the
+ * uchar4 attribute array that exists on all devices. Decoding only uses integer operations, it
+ * does not depend on native half float support of the device. Values are rounded to nearest,
+ * clamped to the half float range, and denormals are flushed to zero. */
+
+ccl_device_inline uint float_to_half_bits(const float f)
+{
+  const uint u = __float_as_uint(f);
+  const uint sign_bit = (u >> 16) & 0x8000;
+  const uint absolute = u & 0x7fffffff;
+
+  if (absolute < 0x38800000 || absolute > 0x7f800000) {
+    /* Denormals and NaN become zero. */
+    return sign_bit;
+  }
+  if (absolute >= 0x477ff000) {
+    /* Clamp to the largest half float. */
+    return sign_bit | 0x7bff;
+  }
+
+  /* Adjust exponent bias and round mantissa to nearest. */
+  return sign_bit | ((absolute - 0x38000000 + 0x1000) >> 13);
+}
+
+ccl_device_inline float half_bits_to_float(const uint h)
+{
+  if ((h & 0x7fff) == 0) {
+    return __uint_as_float((h & 0x8000) << 16);
+  }
+  return __uint_as_float(((h & 0x8000) << 16) | (((h & 0x7c00) + 0x1c000) << 13) |
+                         ((h & 0x03ff) << 13));
+}
+
+ccl_device_inline uint float2_to_half2_bits(const float2 f)
+{
+  return float_to_half_bits(f.x) | (float_to_half_bits(f.y) << 16);
+}
+
+ccl_device_inline float2 half2_bits_to_float2(const uint h)
+{
+  return make_float2(half_bits_to_float(h & 0xffff), half_bits_to_float(h >> 16));
+}
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_HALF_H__ */
@@ -492,6 +492,41 @@ ccl_device_inline float3 ensure_finite(float3 v)
   return v;
 }
 
+/* Octahedral encoding of a unit vector into two 16 bit unsigned integers, packed in a single
+ * 32 bit integer. Used for compact storage of normals, with an angular error of about 0.002
+ * degrees. */
+ccl_device_inline uint float3_to_oct16(const float3 n)
+{
+  const float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+  if (!(l1 > 0.0f)) {
+    return 0x7fff7fff;
+  }
+
+  float u = n.x / l1;
+  float v = n.y / l1;
+  if (n.z < 0.0f) {
+    const float tu = (1.0f - fabsf(v)) * ((u >= 0.0f) ? 1.0f : -1.0f);
+    const float tv = (1.0f - fabsf(u)) * ((v >= 0.0f) ? 1.0f : -1.0f);
+    u = tu;
+    v = tv;
+  }
+
+  const uint qu = (uint)(clamp(u * 0.5f + 0.5f, 0.0f, 1.0f) * 65535.0f + 0.5f);
+  const uint qv = (uint)(clamp(v * 0.5f + 0.5f, 0.0f, 1.0f) * 65535.0f + 0.5f);
+  return qu | (qv << 16);
+}
+
+ccl_device_inline float3 oct16_to_float3(const uint oct)
+{
+  const float u = (float)(oct & 0xffff) * (2.0f / 65535.0f) - 1.0f;
+  const float v = (float)(oct >> 16) * (2.0f / 65535.0f) - 1.0f;
+  const float z = 1.0f - fabsf(u) - fabsf(v);
+  const float t = max(-z, 0.0f);
+  const float x = u + ((u >= 0.0f) ? -t : t);
+  const float y = v + ((v >= 0.0f) ? -t : t);
+  return normalize(make_float3(x, y, z));
+}
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_MATH_FLOAT3_H__ */
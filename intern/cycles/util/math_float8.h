@@ -171,7 +171,9 @@ ccl_device_inline const vfloat8 operator^(const vfloat8 a, const vfloat8 b)
 
 ccl_device_inline vfloat8 rcp(const vfloat8 a)
 {
-#ifdef __KERNEL_AVX__
+#ifdef __KERNEL_AVX512__
+  return vfloat8(_mm256_rcp14_ps(a.m256));
+#elif defined(__KERNEL_AVX__)
   return vfloat8(_mm256_rcp_ps(a.m256));
 #else
   return make_vfloat8(1.0f / a.a,
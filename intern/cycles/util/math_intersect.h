@@ -122,9 +122,13 @@ ccl_device_forceinline float ray_triangle_rcp(const float x)
   return reciprocal[0];
 #elif defined(__KERNEL_SSE__)
   const __m128 a = _mm_set_ss(x);
+#  ifdef __KERNEL_AVX512__
+  const __m128 r = _mm_rcp14_ss(_mm_set_ss(0.0f), a);
+#  else
   const __m128 r = _mm_rcp_ss(a);
+#  endif
 
-#  ifdef __KERNEL_AVX2_
+#  ifdef __KERNEL_AVX2__
   return _mm_cvtss_f32(_mm_mul_ss(r, _mm_fnmadd_ss(r, a, _mm_set_ss(2.0f))));
 #  else
   return _mm_cvtss_f32(_mm_mul_ss(r, _mm_sub_ss(_mm_set_ss(2.0f), _mm_mul_ss(r, a))));
@@ -134,6 +134,7 @@ struct CPUCapabilities {
   bool sse41;
   bool avx;
   bool avx2;
+  bool avx512;
 };
 
 static CPUCapabilities &system_cpu_capabilities()
@@ -190,6 +191,17 @@ static CPUCapabilities &system_cpu_capabilities()
         caps.avx = sse && sse2 && sse3 && ssse3 && sse41 && avx;
         caps.avx2 = sse && sse2 && sse3 && ssse3 && sse41 && avx && f16c && avx2 && fma3 && bmi1 &&
                     bmi2;
+
+        /* Check if the OS will also save the opmask and ZMM registers. */
+        const bool os_avx512 = (xcr_feature_mask & 0xe6) == 0xe6;
+        const bool avx512f = (result[1] & ((int)1 << 16)) != 0;
+        const bool avx512dq = (result[1] & ((int)1 << 17)) != 0;
+        const bool avx512cd = (result[1] & ((int)1 << 28)) != 0;
+        const bool avx512bw = (result[1] & ((int)1 << 30)) != 0;
+        const bool avx512vl = (result[1] & ((int)1 << 31)) != 0;
+
+        caps.avx512 = caps.avx2 && os_avx512 && avx512f && avx512dq && avx512cd && avx512bw &&
+                      avx512vl;
       }
     }
 
@@ -216,6 +228,12 @@ bool system_cpu_support_avx2()
   CPUCapabilities &caps = system_cpu_capabilities();
   return caps.avx2;
 }
+
+bool system_cpu_support_avx512()
+{
+  CPUCapabilities &caps = system_cpu_capabilities();
+  return caps.avx512;
+}
 #else
 
 bool system_cpu_support_sse2()
@@ -233,6 +251,11 @@ bool system_cpu_support_avx2()
   return false;
 }
 
+bool system_cpu_support_avx512()
+{
+  return false;
+}
+
 #endif
 
 size_t system_physical_ram()
@@ -42,6 +42,7 @@
  */
 
 #include "MEM_Allocator.h"
+#include <cstdint>
 #include <list>
 #include <queue>
 #include <vector>
@@ -127,7 +128,7 @@ template<class T> class MEM_CacheLimiterHandle {
 template<class T> class MEM_CacheLimiter {
  public:
   typedef size_t (*MEM_CacheLimiter_DataSize_Func)(void *data);
-  typedef int (*MEM_CacheLimiter_ItemPriority_Func)(void *item, int default_priority);
+  typedef int64_t (*MEM_CacheLimiter_ItemPriority_Func)(void *item, int64_t default_priority);
   typedef bool (*MEM_CacheLimiter_ItemDestroyable_Func)(void *item);
 
   MEM_CacheLimiter(MEM_CacheLimiter_DataSize_Func data_size_func) : data_size_func(data_size_func)
@@ -278,7 +279,7 @@ template<class T> class MEM_CacheLimiter {
       }
     }
     else {
-      int best_match_priority = 0;
+      int64_t best_match_priority = 0;
       int i;
 
       for (i = 0; i < queue.size(); i++) {
@@ -288,9 +289,7 @@ template<class T> class MEM_CacheLimiter {
           continue;
 
         /* By default 0 means highest priority element. */
-        /* Casting a size type to int is questionable,
-         * but unlikely to cause problems. */
-        int priority = -((int)(queue.size()) - i - 1);
+        int64_t priority = -((int64_t)(queue.size()) - i - 1);
         priority = item_priority_func(elem->get()->get_data(), priority);
 
         if (priority < best_match_priority || best_match_elem == NULL) {
@@ -28,7 +28,7 @@ typedef void (*MEM_CacheLimiter_Destruct_Func)(void *);
 typedef size_t (*MEM_CacheLimiter_DataSize_Func)(void *);
 
 /* function used to measure priority of item when freeing memory */
-typedef int (*MEM_CacheLimiter_ItemPriority_Func)(void *, int);
+typedef int64_t (*MEM_CacheLimiter_ItemPriority_Func)(void *, int64_t);
 
 /* function to check whether item could be destroyed */
 typedef bool (*MEM_CacheLimiter_ItemDestroyable_Func)(void *);
@@ -2373,6 +2373,9 @@ class SEQUENCER_PT_view(SequencerButtonsPanel_Output, Panel):
         col = layout.column()
         if ed:
             col.prop(ed, "use_prefetch")
+            sub = col.column()
+            sub.active = ed.use_prefetch
+            sub.prop(ed, "prefetch_threads", text="Threads")
 
         col.prop(st, "display_channel", text="Channel")
 
@@ -11,12 +11,27 @@
 
 namespace blender::bke {
 
+/**
+ * How the bytes of a #BDataSlice are encoded in storage.
+ */
+enum class BDataCompression {
+  None,
+  Zstd,
+};
+
 /**
  * Reference to a slice of memory typically stored on disk.
  */
 struct BDataSlice {
   std::string name;
+  /** Range of the stored bytes. For compressed slices, this is the range of compressed data. */
   IndexRange range;
+  BDataCompression compression = BDataCompression::None;
+  /** Size of the data after decompression. Only used for compressed slices. */
+  int64_t uncompressed_size = 0;
+
+  /** Number of bytes that the slice contains once it has been read. */
+  int64_t data_size() const;
 
   std::shared_ptr<io::serialize::DictionaryValue> serialize() const;
   static std::optional<BDataSlice> deserialize(const io::serialize::DictionaryValue &io_slice);
@@ -32,13 +47,50 @@ class BDataReader {
    * \return True on success, otherwise false.
    */
   [[nodiscard]] virtual bool read(const BDataSlice &slice, void *r_data) const = 0;
+
+  /**
+   * Access the data of the slice without copying it, e.g. by mapping the file into memory. The
+   * returned data may be modified by its owner if it is not shared. This is only possible for
+   * uncompressed slices and not supported by every reader.
+   * \return Shared ownership to the data, or none if it has to be read with #read instead.
+   */
+  [[nodiscard]] virtual std::optional<ImplicitSharingInfoAndData> read_mapped(
+      const BDataSlice & /*slice*/) const
+  {
+    return std::nullopt;
+  }
+};
+
+/**
+ * Settings that control how a #BDataWriter stores the data.
+ */
+struct BDataWriteSettings {
+  /** Compress slices with zstd when that makes them noticeably smaller. */
+  bool use_compression = true;
+  int compression_level = 3;
+  /**
+   * When larger than zero, positions and velocities are stored as 16 bit integers relative to
+   * their bounds if that keeps the error below this distance. Otherwise they are stored exactly.
+   */
+  float quantization_max_error = 0.0f;
 };
 
 /**
  * Abstract base class for writing binary data.
  */
 class BDataWriter {
+ protected:
+  BDataWriteSettings settings_;
+
  public:
+  BDataWriter() = default;
+  BDataWriter(const BDataWriteSettings &settings) : settings_(settings) {}
+
+  const BDataWriteSettings &settings() const
+  {
+    return settings_;
+  }
+
   /**
    * Write the provided binary data.
    * \return Slice where the data has been written to.
@@ -73,7 +125,8 @@ class BDataSharing {
   Map<const ImplicitSharingInfo *, StoredByRuntimeValue> stored_by_runtime_;
 
   /**
-   * Use a mutex so that #read_shared can be implemented in a thread-safe way.
+   * Use a mutex so that #read_shared can be implemented in a thread-safe way. It is not locked
+   * while the data is read.
    */
   mutable std::mutex mutex_;
   /**
@@ -82,6 +135,26 @@ class BDataSharing {
    */
   mutable Map<std::string, ImplicitSharingInfoAndData> runtime_by_stored_;
 
+  /**
+   * Identifies written bytes by their content, independent of where they come from.
+   */
+  struct ContentKey {
+    std::array<uint8_t, 16> md5;
+    int64_t size;
+
+    uint64_t hash() const;
+    friend bool operator==(const ContentKey &a, const ContentKey &b)
+    {
+      return a.size == b.size && a.md5 == b.md5;
+    }
+  };
+
+  /**
+   * Map used to detect when the same bytes have been written before, even if they are not shared
+   * at run-time, e.g. because a simulation recomputes arrays that don't change every frame.
+   */
+  Map<ContentKey, BDataSlice> slice_by_content_;
+
  public:
   ~BDataSharing();
 
@@ -95,6 +168,14 @@ class BDataSharing {
       const ImplicitSharingInfo *sharing_info,
       FunctionRef<std::shared_ptr<io::serialize::DictionaryValue>()> write_fn);
 
+  /**
+   * Check if the same bytes have been written before, possibly for an earlier frame. If yes,
+   * return the slice they have been written to. Otherwise, write them now with `bdata_writer`.
+   */
+  [[nodiscard]] BDataSlice write_deduplicated(BDataWriter &bdata_writer,
+                                              const void *data,
+                                              int64_t size);
+
   /**
    * Check if the data identified by `io_data` has been read before or load it now.
    * \return Shared ownership to the read data, or none if there was an error.
@@ -102,6 +183,12 @@ class BDataSharing {
   [[nodiscard]] std::optional<ImplicitSharingInfoAndData> read_shared(
       const io::serialize::DictionaryValue &io_data,
       FunctionRef<std::optional<ImplicitSharingInfoAndData>()> read_fn) const;
+
+  /**
+   * Forget read data that is not used anywhere else anymore, so that it can be freed. It is read
+   * again when it is needed later.
+   */
+  void remove_unused_read_data();
 };
 
 /**
@@ -112,10 +199,23 @@ class DiskBDataReader : public BDataReader {
   const std::string bdata_dir_;
   mutable std::mutex mutex_;
   mutable Map<std::string, std::unique_ptr<fstream>> open_input_streams_;
+  /**
+   * Files that have been mapped into memory, with one user owned by the reader. A null value
+   * means that mapping the file failed.
+   */
+  mutable Map<std::string, const ImplicitSharingInfo *> mapped_files_;
+  /** Total size of the slices that have been read or mapped. */
+  mutable int64_t bytes_read_ = 0;
 
  public:
   DiskBDataReader(std::string bdata_dir);
+  ~DiskBDataReader();
+
+  int64_t bytes_read() const;
+
   [[nodiscard]] bool read(const BDataSlice &slice, void *r_data) const override;
+  [[nodiscard]] std::optional<ImplicitSharingInfoAndData> read_mapped(
+      const BDataSlice &slice) const override;
 };
 
 /**
@@ -131,7 +231,10 @@ class DiskBDataWriter : public BDataWriter {
   int64_t current_offset_;
 
  public:
-  DiskBDataWriter(std::string bdata_name, std::ostream &bdata_file, int64_t current_offset);
+  DiskBDataWriter(std::string bdata_name,
+                  std::ostream &bdata_file,
+                  int64_t current_offset,
+                  const BDataWriteSettings &settings = {});
 
   BDataSlice write(const void *data, int64_t size) override;
 };
@@ -9,12 +9,15 @@
 
 #include "BLI_map.hh"
 #include "BLI_sub_frame.hh"
+#include "BLI_utility_mixins.hh"
 
 struct bNodeTree;
+struct TaskPool;
 
 namespace blender::bke::sim {
 
 class ModifierSimulationCache;
+class ModifierSimulationStateUser;
 
 /**
  * Storage of values for a single simulation input and output node pair.
@@ -49,6 +52,22 @@ struct SimulationZoneID {
 class ModifierSimulationState {
  private:
   mutable bool bake_loaded_;
+  /** Number of bytes that had to be read from disk to load the baked state. */
+  mutable int64_t bake_loaded_bytes_ = 0;
+  /** Loading the bake in the background was not possible, it has to be loaded on demand. */
+  mutable bool bake_prefetch_failed_ = false;
+  /** Number of #ModifierSimulationStateUser that keep the baked state loaded. */
+  mutable int users_num_ = 0;
+
+  bool load_bake(const bNodeTree *ntree) const;
+  /**
+   * Free the loaded baked state unless it is currently being loaded or used.
+   * \return True if there was loaded baked data.
+   */
+  bool try_unload_bake() const;
+
+  friend ModifierSimulationCache;
+  friend ModifierSimulationStateUser;
 
  public:
   ModifierSimulationCache *owner_;
@@ -63,6 +82,28 @@ class ModifierSimulationState {
   const SimulationZoneState *get_zone_state(const SimulationZoneID &zone_id) const;
   SimulationZoneState &get_zone_state_for_write(const SimulationZoneID &zone_id);
   void ensure_bake_loaded(const bNodeTree &ntree) const;
+  /**
+   * Load the baked state without access to the node tree, for use from a background thread.
+   * \return False if the bake can only be loaded with #ensure_bake_loaded.
+   */
+  bool try_prefetch_bake() const;
+};
+
+/**
+ * Keeps the baked data of a simulation state loaded while it is used, e.g. during the evaluation
+ * of a depsgraph. The cache is shared between depsgraphs, and
+ * #ModifierSimulationCache::prefetch_baked_states in one of them frees baked states that are not
+ * used anymore.
+ */
+class ModifierSimulationStateUser : NonCopyable {
+ private:
+  const ModifierSimulationState *state_;
+
+ public:
+  explicit ModifierSimulationStateUser(const ModifierSimulationState &state);
+  ModifierSimulationStateUser(ModifierSimulationStateUser &&other);
+  ModifierSimulationStateUser &operator=(ModifierSimulationStateUser &&other) = delete;
+  ~ModifierSimulationStateUser();
 };
 
 struct ModifierSimulationStateAtFrame {
@@ -112,12 +153,26 @@ class ModifierSimulationCache {
 
   bool failed_finding_bake_ = false;
 
+  /** Loads baked states of upcoming frames in a background thread during playback. */
+  TaskPool *prefetch_pool_ = nullptr;
+  std::mutex prefetch_mutex_;
+  /** Frame after which states are prefetched. Updated while the prefetching is running. */
+  SubFrame prefetch_frame_;
+  bool prefetch_running_ = false;
+
+  const ModifierSimulationState *find_state_to_prefetch(const SubFrame &frame) const;
+  void unload_states_outside_prefetch_window(const SubFrame &frame);
+  void cancel_prefetch();
+  static void prefetch_task(TaskPool *pool, void *taskdata);
+
  public:
   CacheState cache_state = CacheState::Valid;
 
   /** A non-persistent cache used only to pass simulation state data from one frame to the next. */
   ModifierSimulationCacheRealtime realtime_cache;
 
+  ~ModifierSimulationCache();
+
   void try_discover_bake(StringRefNull absolute_bake_dir);
 
   bool has_state_at_frame(const SubFrame &frame) const;
@@ -126,6 +181,15 @@ class ModifierSimulationCache {
   ModifierSimulationState &get_state_at_frame_for_write(const SubFrame &frame);
   StatesAroundFrame get_states_around_frame(const SubFrame &frame) const;
 
+  /**
+   * Start loading the baked states after the given frame in the background, so that they are
+   * ready when playback reaches them. Baked states that are neither around nor shortly after the
+   * frame are freed. Does nothing if the cache is not baked.
+   */
+  void prefetch_baked_states(const SubFrame &frame);
+  /** Wait until the states requested by #prefetch_baked_states are loaded. */
+  void wait_for_prefetch();
+
   void invalidate()
   {
     this->cache_state = CacheState::Invalid;
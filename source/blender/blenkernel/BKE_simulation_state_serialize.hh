@@ -39,8 +39,11 @@ void serialize_modifier_simulation_state(const ModifierSimulationState &state,
 /**
  * Fill the simulation state by parsing the provided #DictionaryValue which also contains
  * references to external binary data that is read using #bdata_reader.
+ * \param ntree: Only needed for bakes from older versions which identify simulation zones by
+ * their node ids.
+ * \return False if the node tree would be needed but is null. The state is unchanged then.
  */
-void deserialize_modifier_simulation_state(const bNodeTree &ntree,
+bool deserialize_modifier_simulation_state(const bNodeTree *ntree,
                                            const DictionaryValue &io_root,
                                            const BDataReader &bdata_reader,
                                            const BDataSharing &bdata_sharing,
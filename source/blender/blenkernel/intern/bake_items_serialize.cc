@@ -10,27 +10,59 @@
 #include "BKE_mesh.hh"
 #include "BKE_pointcloud.h"
 
+#include "BLI_bounds.hh"
 #include "BLI_endian_defines.h"
 #include "BLI_endian_switch.h"
+#include "BLI_fileops.h"
+#include "BLI_hash_md5.h"
 #include "BLI_math_matrix_types.hh"
+#include "BLI_mmap.h"
 #include "BLI_path_util.h"
+#include "BLI_task.hh"
 
 #include "DNA_material_types.h"
 
 #include "RNA_access.h"
 #include "RNA_enum_types.h"
 
+#include <fcntl.h>
+#include <zstd.h>
+
+#ifndef WIN32
+#  include <unistd.h> /* For close. */
+#else
+#  include <io.h> /* For close. */
+#endif
+
 namespace blender::bke {
 
 using namespace io::serialize;
 using DictionaryValuePtr = std::shared_ptr<DictionaryValue>;
 
+/**
+ * Uncompressed slices start at a multiple of this in the file, so that they can be used in place
+ * when the file is mapped into memory.
+ */
+static constexpr int64_t bdata_slice_alignment = 16;
+
+/** Smaller slices are not worth compressing. */
+static constexpr int64_t bdata_min_compressed_size = 256;
+
+int64_t BDataSlice::data_size() const
+{
+  return compression == BDataCompression::None ? range.size() : uncompressed_size;
+}
+
 std::shared_ptr<DictionaryValue> BDataSlice::serialize() const
 {
   auto io_slice = std::make_shared<DictionaryValue>();
   io_slice->append_str("name", this->name);
   io_slice->append_int("start", range.start());
   io_slice->append_int("size", range.size());
+  if (compression == BDataCompression::Zstd) {
+    io_slice->append_str("compression", "zstd");
+    io_slice->append_int("uncompressed_size", uncompressed_size);
+  }
   return io_slice;
 }
 
@@ -43,41 +75,192 @@ std::optional<BDataSlice> BDataSlice::deserialize(const DictionaryValue &io_slic
     return std::nullopt;
   }
 
-  return BDataSlice{*name, {*start, *size}};
+  BDataSlice slice{*name, {*start, *size}};
+  if (const std::optional<StringRefNull> compression = io_slice.lookup_str("compression")) {
+    const std::optional<int64_t> uncompressed_size = io_slice.lookup_int("uncompressed_size");
+    if (*compression != "zstd" || !uncompressed_size) {
+      return std::nullopt;
+    }
+    slice.compression = BDataCompression::Zstd;
+    slice.uncompressed_size = *uncompressed_size;
+  }
+  return slice;
 }
 
+/**
+ * Owns a memory-mapped bdata file. Slices that are read in place share ownership of the whole
+ * file.
+ */
+class MappedBDataFile : public ImplicitSharingInfo {
+ private:
+  BLI_mmap_file *mmap_file_;
+
+ public:
+  MappedBDataFile(BLI_mmap_file *mmap_file) : mmap_file_(mmap_file) {}
+
+  ~MappedBDataFile()
+  {
+    BLI_mmap_free(mmap_file_);
+  }
+
+  static const MappedBDataFile *open(const char *path)
+  {
+    const int file = BLI_open(path, O_BINARY | O_RDONLY, 0);
+    if (file == -1) {
+      return nullptr;
+    }
+    BLI_mmap_file *mmap_file = BLI_mmap_open_copy_on_write(file);
+    /* The mapping stays valid without the file descriptor. Closing it right away avoids running
+     * out of descriptors when many bake files are mapped at the same time. */
+    close(file);
+    if (mmap_file == nullptr) {
+      return nullptr;
+    }
+    return MEM_new<MappedBDataFile>(__func__, mmap_file);
+  }
+
+  int64_t size() const
+  {
+    return int64_t(BLI_mmap_get_length(mmap_file_));
+  }
+
+  char *data() const
+  {
+    return static_cast<char *>(BLI_mmap_get_pointer(mmap_file_));
+  }
+
+ private:
+  void delete_self_with_data() override
+  {
+    MEM_delete(this);
+  }
+};
+
 DiskBDataReader::DiskBDataReader(std::string bdata_dir) : bdata_dir_(std::move(bdata_dir)) {}
 
+DiskBDataReader::~DiskBDataReader()
+{
+  for (const ImplicitSharingInfo *mapped_file : mapped_files_.values()) {
+    if (mapped_file) {
+      mapped_file->remove_user_and_delete_if_last();
+    }
+  }
+}
+
+int64_t DiskBDataReader::bytes_read() const
+{
+  std::lock_guard lock{mutex_};
+  return bytes_read_;
+}
+
 [[nodiscard]] bool DiskBDataReader::read(const BDataSlice &slice, void *r_data) const
 {
   if (slice.range.is_empty()) {
-    return true;
+    return slice.data_size() == 0;
   }
 
   char bdata_path[FILE_MAX];
   BLI_path_join(bdata_path, sizeof(bdata_path), bdata_dir_.c_str(), slice.name.c_str());
 
+  Array<char> compressed_data;
+  {
+    std::lock_guard lock{mutex_};
+    std::unique_ptr<fstream> &bdata_file = open_input_streams_.lookup_or_add_cb_as(
+        bdata_path,
+        [&]() { return std::make_unique<fstream>(bdata_path, std::ios::in | std::ios::binary); });
+    bdata_file->seekg(slice.range.start());
+    bytes_read_ += slice.data_size();
+    if (slice.compression == BDataCompression::None) {
+      bdata_file->read(static_cast<char *>(r_data), slice.range.size());
+      return bdata_file->gcount() == slice.range.size();
+    }
+    compressed_data.reinitialize(slice.range.size());
+    bdata_file->read(compressed_data.data(), slice.range.size());
+    if (bdata_file->gcount() != slice.range.size()) {
+      return false;
+    }
+  }
+
+  /* Decompress outside of the lock, so that multiple slices can be decompressed in parallel. */
+  BLI_assert(slice.compression == BDataCompression::Zstd);
+  const size_t decompressed_size = ZSTD_decompress(
+      r_data, slice.uncompressed_size, compressed_data.data(), compressed_data.size());
+  return !ZSTD_isError(decompressed_size) &&
+         int64_t(decompressed_size) == slice.uncompressed_size;
+}
+
+std::optional<ImplicitSharingInfoAndData> DiskBDataReader::read_mapped(
+    const BDataSlice &slice) const
+{
+#ifdef WIN32
+  /* Files that are mapped into memory can't be deleted on Windows, which would prevent freeing
+   * or re-baking the bake while the data is still used. */
+  UNUSED_VARS(slice);
+  return std::nullopt;
+#else
+  if (slice.compression != BDataCompression::None || slice.range.is_empty()) {
+    return std::nullopt;
+  }
+
   std::lock_guard lock{mutex_};
-  std::unique_ptr<fstream> &bdata_file = open_input_streams_.lookup_or_add_cb_as(
-      bdata_path,
-      [&]() { return std::make_unique<fstream>(bdata_path, std::ios::in | std::ios::binary); });
-  bdata_file->seekg(slice.range.start());
-  bdata_file->read(static_cast<char *>(r_data), slice.range.size());
-  if (bdata_file->gcount() != slice.range.size()) {
-    return false;
+  const ImplicitSharingInfo *sharing_info = mapped_files_.lookup_or_add_cb(slice.name, [&]() {
+    char bdata_path[FILE_MAX];
+    BLI_path_join(bdata_path, sizeof(bdata_path), bdata_dir_.c_str(), slice.name.c_str());
+    return MappedBDataFile::open(bdata_path);
+  });
+  if (sharing_info == nullptr) {
+    return std::nullopt;
   }
-  return true;
+  const MappedBDataFile &mapped_file = static_cast<const MappedBDataFile &>(*sharing_info);
+  if (slice.range.one_after_last() > mapped_file.size()) {
+    return std::nullopt;
+  }
+  mapped_file.add_user();
+  bytes_read_ += slice.range.size();
+  return ImplicitSharingInfoAndData{&mapped_file, mapped_file.data() + slice.range.start()};
+#endif
 }
 
 DiskBDataWriter::DiskBDataWriter(std::string bdata_name,
                                  std::ostream &bdata_file,
-                                 const int64_t current_offset)
-    : bdata_name_(std::move(bdata_name)), bdata_file_(bdata_file), current_offset_(current_offset)
+                                 const int64_t current_offset,
+                                 const BDataWriteSettings &settings)
+    : BDataWriter(settings),
+      bdata_name_(std::move(bdata_name)),
+      bdata_file_(bdata_file),
+      current_offset_(current_offset)
 {
 }
 
 BDataSlice DiskBDataWriter::write(const void *data, const int64_t size)
 {
+  if (settings_.use_compression && size >= bdata_min_compressed_size) {
+    Array<char> compressed_data(int64_t(ZSTD_compressBound(size)), NoInitialization());
+    const size_t compressed_size = ZSTD_compress(compressed_data.data(),
+                                                 compressed_data.size(),
+                                                 data,
+                                                 size,
+                                                 settings_.compression_level);
+    /* Only keep the compressed data if it saves enough space to outweigh losing the ability to
+     * use the data without copying it when reading. */
+    if (!ZSTD_isError(compressed_size) && int64_t(compressed_size) <= size - size / 8) {
+      const int64_t old_offset = current_offset_;
+      bdata_file_.write(compressed_data.data(), compressed_size);
+      current_offset_ += compressed_size;
+      return {bdata_name_,
+              {old_offset, int64_t(compressed_size)},
+              BDataCompression::Zstd,
+              size};
+    }
+  }
+
+  const int64_t padding = -current_offset_ & (bdata_slice_alignment - 1);
+  if (padding > 0) {
+    const char zeros[bdata_slice_alignment] = {0};
+    bdata_file_.write(zeros, padding);
+    current_offset_ += padding;
+  }
+
   const int64_t old_offset = current_offset_;
   bdata_file_.write(static_cast<const char *>(data), size);
   current_offset_ += size;
@@ -96,6 +279,27 @@ BDataSharing::~BDataSharing()
   }
 }
 
+uint64_t BDataSharing::ContentKey::hash() const
+{
+  uint64_t md5_hash;
+  memcpy(&md5_hash, md5.data(), sizeof(md5_hash));
+  return md5_hash;
+}
+
+BDataSlice BDataSharing::write_deduplicated(BDataWriter &bdata_writer,
+                                            const void *data,
+                                            const int64_t size)
+{
+  if (size == 0) {
+    return bdata_writer.write(data, size);
+  }
+  ContentKey key;
+  key.size = size;
+  BLI_hash_md5_buffer(static_cast<const char *>(data), size, key.md5.data());
+  return slice_by_content_.lookup_or_add_cb(key,
+                                            [&]() { return bdata_writer.write(data, size); });
+}
+
 DictionaryValuePtr BDataSharing::write_shared(const ImplicitSharingInfo *sharing_info,
                                               FunctionRef<DictionaryValuePtr()> write_fn)
 {
@@ -128,28 +332,56 @@ std::optional<ImplicitSharingInfoAndData> BDataSharing::read_shared(
     const DictionaryValue &io_data,
     FunctionRef<std::optional<ImplicitSharingInfoAndData>()> read_fn) const
 {
-  std::lock_guard lock{mutex_};
-
   io::serialize::JsonFormatter formatter;
   std::stringstream ss;
   formatter.serialize(ss, io_data);
   const std::string key = ss.str();
 
-  if (const ImplicitSharingInfoAndData *shared_data = runtime_by_stored_.lookup_ptr(key)) {
-    shared_data->sharing_info->add_user();
-    return *shared_data;
+  {
+    std::lock_guard lock{mutex_};
+    if (const ImplicitSharingInfoAndData *shared_data = runtime_by_stored_.lookup_ptr(key)) {
+      shared_data->sharing_info->add_user();
+      return *shared_data;
+    }
   }
+  /* Read without holding the lock, so that other threads can use the cached data meanwhile. */
   std::optional<ImplicitSharingInfoAndData> data = read_fn();
   if (!data) {
     return std::nullopt;
   }
-  if (data->sharing_info != nullptr) {
+  if (data->sharing_info == nullptr) {
+    return data;
+  }
+  std::lock_guard lock{mutex_};
+  bool is_new = false;
+  const ImplicitSharingInfoAndData &shared_data = runtime_by_stored_.lookup_or_add_cb(key, [&]() {
+    is_new = true;
     data->sharing_info->add_user();
-    runtime_by_stored_.add_new(key, *data);
+    return *data;
+  });
+  if (!is_new) {
+    /* Another thread has read the same data in the meantime, use that instead. */
+    data->sharing_info->remove_user_and_delete_if_last();
+    shared_data.sharing_info->add_user();
+    return shared_data;
   }
   return data;
 }
 
+void BDataSharing::remove_unused_read_data()
+{
+  std::lock_guard lock{mutex_};
+  runtime_by_stored_.remove_if([](const auto item) {
+    /* New users can only be added through this map, so the data can't be used again. */
+    const ImplicitSharingInfo *sharing_info = item.value.sharing_info;
+    if (!sharing_info->is_mutable()) {
+      return false;
+    }
+    sharing_info->remove_user_and_delete_if_last();
+    return true;
+  });
+}
+
 static StringRefNull get_endian_io_name(const int endian)
 {
   if (endian == L_ENDIAN) {
@@ -195,9 +427,12 @@ static std::optional<eCustomDataType> get_data_type_from_io_name(const StringRef
  * Write the data and remember which endianness the data had.
  */
 static std::shared_ptr<DictionaryValue> write_bdata_raw_data_with_endian(
-    BDataWriter &bdata_writer, const void *data, const int64_t size_in_bytes)
+    BDataWriter &bdata_writer,
+    BDataSharing &bdata_sharing,
+    const void *data,
+    const int64_t size_in_bytes)
 {
-  auto io_data = bdata_writer.write(data, size_in_bytes).serialize();
+  auto io_data = bdata_sharing.write_deduplicated(bdata_writer, data, size_in_bytes).serialize();
   if (ENDIAN_ORDER == B_ENDIAN) {
     io_data->append_str("endian", get_endian_io_name(ENDIAN_ORDER));
   }
@@ -217,7 +452,7 @@ static std::shared_ptr<DictionaryValue> write_bdata_raw_data_with_endian(
   if (!slice) {
     return false;
   }
-  if (slice->range.size() != element_size * elements_num) {
+  if (slice->data_size() != element_size * elements_num) {
     return false;
   }
   if (!bdata_reader.read(*slice, r_data)) {
@@ -248,10 +483,11 @@ static std::shared_ptr<DictionaryValue> write_bdata_raw_data_with_endian(
 
 /** Write bytes ignoring endianness. */
 static std::shared_ptr<DictionaryValue> write_bdata_raw_bytes(BDataWriter &bdata_writer,
+                                                              BDataSharing &bdata_sharing,
                                                               const void *data,
                                                               const int64_t size_in_bytes)
 {
-  return bdata_writer.write(data, size_in_bytes).serialize();
+  return bdata_sharing.write_deduplicated(bdata_writer, data, size_in_bytes).serialize();
 }
 
 /** Read bytes ignoring endianness. */
@@ -264,21 +500,110 @@ static std::shared_ptr<DictionaryValue> write_bdata_raw_bytes(BDataWriter &bdata
   if (!slice) {
     return false;
   }
-  if (slice->range.size() != bytes_num) {
+  if (slice->data_size() != bytes_num) {
     return false;
   }
   return bdata_reader.read(*slice, r_data);
 }
 
+static bool is_raw_bytes_type(const CPPType &type)
+{
+  return type.size() == 1 || type.is<ColorGeometry4b>();
+}
+
 static std::shared_ptr<DictionaryValue> write_bdata_simple_gspan(BDataWriter &bdata_writer,
+                                                                 BDataSharing &bdata_sharing,
                                                                  const GSpan data)
 {
   const CPPType &type = data.type();
   BLI_assert(type.is_trivial());
-  if (type.size() == 1 || type.is<ColorGeometry4b>()) {
-    return write_bdata_raw_bytes(bdata_writer, data.data(), data.size_in_bytes());
+  if (is_raw_bytes_type(type)) {
+    return write_bdata_raw_bytes(bdata_writer, bdata_sharing, data.data(), data.size_in_bytes());
   }
-  return write_bdata_raw_data_with_endian(bdata_writer, data.data(), data.size_in_bytes());
+  return write_bdata_raw_data_with_endian(
+      bdata_writer, bdata_sharing, data.data(), data.size_in_bytes());
+}
+
+static std::shared_ptr<io::serialize::ArrayValue> serialize_float_array(Span<float> values);
+[[nodiscard]] static bool deserialize_float_array(const io::serialize::Value &io_value,
+                                                  MutableSpan<float> r_values);
+
+/**
+ * Store the vectors as 16 bit integers relative to their bounds, if the error introduced by that
+ * stays below the given maximum.
+ * \return Null if the vectors have to be stored exactly.
+ */
+static std::shared_ptr<DictionaryValue> write_bdata_quantized_float3(BDataWriter &bdata_writer,
+                                                                     BDataSharing &bdata_sharing,
+                                                                     const Span<float3> data,
+                                                                     const float max_error)
+{
+  const std::optional<Bounds<float3>> bounds = bounds::min_max(data);
+  if (!bounds) {
+    return nullptr;
+  }
+  const float3 step = (bounds->max - bounds->min) / float(UINT16_MAX);
+  for (const int i : IndexRange(3)) {
+    /* Also avoids quantizing non-finite values. */
+    if (!(step[i] * 0.5f <= max_error)) {
+      return nullptr;
+    }
+  }
+
+  Array<uint16_t> quantized_data(data.size() * 3, NoInitialization());
+  threading::parallel_for(data.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      for (const int axis : IndexRange(3)) {
+        const float value = step[axis] == 0.0f ?
+                                0.0f :
+                                (data[i][axis] - bounds->min[axis]) / step[axis] + 0.5f;
+        quantized_data[i * 3 + axis] = uint16_t(std::clamp(value, 0.0f, float(UINT16_MAX)));
+      }
+    }
+  });
+
+  auto io_data = write_bdata_raw_data_with_endian(bdata_writer,
+                                                  bdata_sharing,
+                                                  quantized_data.data(),
+                                                  quantized_data.as_span().size_in_bytes());
+  auto io_quantization = io_data->append_dict("quantization");
+  io_quantization->append("min", serialize_float_array({bounds->min, 3}));
+  io_quantization->append("max", serialize_float_array({bounds->max, 3}));
+  return io_data;
+}
+
+[[nodiscard]] static bool read_bdata_quantized_float3(const BDataReader &bdata_reader,
+                                                      const DictionaryValue &io_data,
+                                                      const DictionaryValue &io_quantization,
+                                                      MutableSpan<float3> r_data)
+{
+  const io::serialize::ArrayValue *io_min = io_quantization.lookup_array("min");
+  const io::serialize::ArrayValue *io_max = io_quantization.lookup_array("max");
+  if (!io_min || !io_max) {
+    return false;
+  }
+  float3 min;
+  float3 max;
+  if (!deserialize_float_array(*io_min, {min, 3}) || !deserialize_float_array(*io_max, {max, 3}))
+  {
+    return false;
+  }
+  Array<uint16_t> quantized_data(r_data.size() * 3, NoInitialization());
+  if (!read_bdata_raw_data_with_endian(
+          bdata_reader, io_data, sizeof(uint16_t), quantized_data.size(), quantized_data.data()))
+  {
+    return false;
+  }
+  /* Use the same computation as when writing. */
+  const float3 step = (max - min) / float(UINT16_MAX);
+  threading::parallel_for(r_data.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      for (const int axis : IndexRange(3)) {
+        r_data[i][axis] = min[axis] + float(quantized_data[i * 3 + axis]) * step[axis];
+      }
+    }
+  });
+  return true;
 }
 
 [[nodiscard]] static bool read_bdata_simple_gspan(const BDataReader &bdata_reader,
@@ -287,7 +612,7 @@ static std::shared_ptr<DictionaryValue> write_bdata_simple_gspan(BDataWriter &bd
 {
   const CPPType &type = r_data.type();
   BLI_assert(type.is_trivial());
-  if (type.size() == 1 || type.is<ColorGeometry4b>()) {
+  if (is_raw_bytes_type(type)) {
     return read_bdata_raw_bytes(bdata_reader, io_data, r_data.size_in_bytes(), r_data.data());
   }
   if (type.is_any<int16_t, uint16_t, int32_t, uint32_t, int64_t, uint64_t, float>()) {
@@ -299,6 +624,10 @@ static std::shared_ptr<DictionaryValue> write_bdata_simple_gspan(BDataWriter &bd
         bdata_reader, io_data, sizeof(int32_t), r_data.size() * 2, r_data.data());
   }
   if (type.is<float3>()) {
+    if (const DictionaryValue *io_quantization = io_data.lookup_dict("quantization")) {
+      return read_bdata_quantized_float3(
+          bdata_reader, io_data, *io_quantization, r_data.typed<float3>());
+    }
     return read_bdata_raw_data_with_endian(
         bdata_reader, io_data, sizeof(float), r_data.size() * 3, r_data.data());
   }
@@ -319,8 +648,44 @@ static std::shared_ptr<DictionaryValue> write_bdata_shared_simple_gspan(
     const GSpan data,
     const ImplicitSharingInfo *sharing_info)
 {
-  return bdata_sharing.write_shared(
-      sharing_info, [&]() { return write_bdata_simple_gspan(bdata_writer, data); });
+  return bdata_sharing.write_shared(sharing_info, [&]() {
+    return write_bdata_simple_gspan(bdata_writer, bdata_sharing, data);
+  });
+}
+
+/**
+ * Use the stored data in place if it does not have to be decoded.
+ */
+static std::optional<ImplicitSharingInfoAndData> read_bdata_simple_gspan_mapped(
+    const BDataReader &bdata_reader,
+    const DictionaryValue &io_data,
+    const CPPType &cpp_type,
+    const int size)
+{
+  if (io_data.lookup("quantization")) {
+    return std::nullopt;
+  }
+  if (!is_raw_bytes_type(cpp_type)) {
+    const StringRefNull stored_endian = io_data.lookup_str("endian").value_or("little");
+    if (stored_endian != get_endian_io_name(ENDIAN_ORDER)) {
+      return std::nullopt;
+    }
+  }
+  const std::optional<BDataSlice> slice = BDataSlice::deserialize(io_data);
+  if (!slice || slice->compression != BDataCompression::None ||
+      slice->range.size() != size * cpp_type.size())
+  {
+    return std::nullopt;
+  }
+  std::optional<ImplicitSharingInfoAndData> mapped_data = bdata_reader.read_mapped(*slice);
+  if (!mapped_data) {
+    return std::nullopt;
+  }
+  if (uintptr_t(mapped_data->data) % cpp_type.alignment() != 0) {
+    mapped_data->sharing_info->remove_user_and_delete_if_last();
+    return std::nullopt;
+  }
+  return mapped_data;
 }
 
 [[nodiscard]] static const void *read_bdata_shared_simple_gspan(
@@ -333,6 +698,11 @@ static std::shared_ptr<DictionaryValue> write_bdata_shared_simple_gspan(
 {
   const std::optional<ImplicitSharingInfoAndData> sharing_info_and_data =
       bdata_sharing.read_shared(io_data, [&]() -> std::optional<ImplicitSharingInfoAndData> {
+        if (std::optional<ImplicitSharingInfoAndData> mapped_data =
+                read_bdata_simple_gspan_mapped(bdata_reader, io_data, cpp_type, size))
+        {
+          return mapped_data;
+        }
         void *data_mem = MEM_mallocN_aligned(
             size * cpp_type.size(), cpp_type.alignment(), __func__);
         if (!read_bdata_simple_gspan(bdata_reader, io_data, {cpp_type, data_mem, size})) {
@@ -673,12 +1043,27 @@ static std::shared_ptr<io::serialize::ArrayValue> serialize_attributes(
 
         const bke::GAttributeReader attribute = attributes.lookup(attribute_id);
         const GVArraySpan attribute_span(attribute.varray);
+        const ImplicitSharingInfo *sharing_info = attribute.varray.is_span() ?
+                                                      attribute.sharing_info :
+                                                      nullptr;
+        const float max_error = bdata_writer.settings().quantization_max_error;
+        if (max_error > 0.0f && meta_data.data_type == CD_PROP_FLOAT3 &&
+            ELEM(attribute_id.name(), "position", "velocity"))
+        {
+          auto io_data = bdata_sharing.write_shared(sharing_info, [&]() {
+            auto io_quantized_data = write_bdata_quantized_float3(
+                bdata_writer, bdata_sharing, attribute_span.typed<float3>(), max_error);
+            if (io_quantized_data) {
+              return io_quantized_data;
+            }
+            return write_bdata_simple_gspan(bdata_writer, bdata_sharing, attribute_span);
+          });
+          io_attribute->append("data", io_data);
+          return true;
+        }
         io_attribute->append("data",
                              write_bdata_shared_simple_gspan(
-                                 bdata_writer,
-                                 bdata_sharing,
-                                 attribute_span,
-                                 attribute.varray.is_span() ? attribute.sharing_info : nullptr));
+                                 bdata_writer, bdata_sharing, attribute_span, sharing_info));
         return true;
       });
   return io_attributes;
@@ -764,9 +1149,11 @@ static std::shared_ptr<DictionaryValue> serialize_geometry_set(const GeometrySet
     }
 
     io_instances->append("transforms",
-                         write_bdata_simple_gspan(bdata_writer, instances.transforms()));
+                         write_bdata_simple_gspan(
+                             bdata_writer, bdata_sharing, instances.transforms()));
     io_instances->append("handles",
-                         write_bdata_simple_gspan(bdata_writer, instances.reference_handles()));
+                         write_bdata_simple_gspan(
+                             bdata_writer, bdata_sharing, instances.reference_handles()));
 
     auto io_attributes = serialize_attributes(
         instances.attributes(), bdata_writer, bdata_sharing, {"position"});
@@ -983,7 +1370,8 @@ void serialize_bake_item(const BakeItem &item,
       r_io_item.append_str("data", string_state_item->value());
     }
     else {
-      r_io_item.append("data", write_bdata_raw_bytes(bdata_writer, str.data(), str.size()));
+      r_io_item.append(
+          "data", write_bdata_raw_bytes(bdata_writer, bdata_sharing, str.data(), str.size()));
     }
   }
   else if (const auto *primitive_state_item = dynamic_cast<const PrimitiveBakeItem *>(&item)) {
@@ -0,0 +1,324 @@
+/* SPDX-FileCopyrightText: 2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <cstring>
+
+#include "BKE_appdir.h"
+#include "BKE_bake_items_serialize.hh"
+#include "BKE_idtype.h"
+#include "BKE_pointcloud.h"
+
+#include "BLI_array.hh"
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_rand.hh"
+
+#include "CLG_log.h"
+
+#include "DNA_pointcloud_types.h"
+
+namespace blender::bke::tests {
+
+using namespace io::serialize;
+
+class BakeItemsSerializeTest : public testing::Test {
+ protected:
+  static void SetUpTestSuite()
+  {
+    CLG_init();
+    BKE_idtype_init();
+    BKE_tempdir_init("");
+  }
+
+  static void TearDownTestSuite()
+  {
+    BKE_tempdir_session_purge();
+    CLG_exit();
+  }
+};
+
+static std::string bdata_path(const StringRefNull name)
+{
+  char path[FILE_MAX];
+  BLI_path_join(path, sizeof(path), BKE_tempdir_session(), name.c_str());
+  return path;
+}
+
+static fstream open_for_write(const StringRefNull name)
+{
+  return fstream(bdata_path(name), std::ios::out | std::ios::binary);
+}
+
+/** Data that zstd compresses well. */
+static Array<int> compressible_data()
+{
+  Array<int> data(4096);
+  for (const int i : data.index_range()) {
+    data[i] = i / 16;
+  }
+  return data;
+}
+
+static Array<uint8_t> random_bytes(const int64_t size, const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  Array<uint8_t> data(size);
+  for (uint8_t &value : data) {
+    value = uint8_t(rng.get_int32(256));
+  }
+  return data;
+}
+
+template<typename T> static bool read_matches(const BDataReader &reader,
+                                              const BDataSlice &slice,
+                                              const Span<T> expected)
+{
+  Array<T> data(expected.size());
+  if (!reader.read(slice, data.data())) {
+    return false;
+  }
+  return data.as_span() == expected;
+}
+
+static void expect_slices_equal(const BDataSlice &a, const BDataSlice &b)
+{
+  EXPECT_EQ(a.name, b.name);
+  EXPECT_EQ(a.range, b.range);
+  EXPECT_EQ(a.compression, b.compression);
+  EXPECT_EQ(a.data_size(), b.data_size());
+}
+
+TEST_F(BakeItemsSerializeTest, CompressedAndUncompressedSlices)
+{
+  const Array<int> compressible = compressible_data();
+  /* The odd size makes the next slice start at an unaligned offset without padding. */
+  const Array<uint8_t> incompressible = random_bytes(4099, 0);
+  const Array<uint8_t> small = random_bytes(10, 1);
+
+  BDataSlice small_slice, incompressible_slice, compressible_slice, aligned_slice;
+  BDataSlice uncompressed_slice;
+  {
+    fstream file = open_for_write("slices.bdata");
+    DiskBDataWriter writer{"slices.bdata", file, 0};
+    small_slice = writer.write(small.data(), small.size());
+    incompressible_slice = writer.write(incompressible.data(), incompressible.size());
+    compressible_slice = writer.write(compressible.data(),
+                                      compressible.as_span().size_in_bytes());
+    aligned_slice = writer.write(incompressible.data(), incompressible.size());
+  }
+  {
+    BDataWriteSettings settings;
+    settings.use_compression = false;
+    fstream file = open_for_write("uncompressed.bdata");
+    DiskBDataWriter writer{"uncompressed.bdata", file, 0, settings};
+    uncompressed_slice = writer.write(compressible.data(),
+                                      compressible.as_span().size_in_bytes());
+  }
+
+  EXPECT_EQ(small_slice.compression, BDataCompression::None);
+  EXPECT_EQ(incompressible_slice.compression, BDataCompression::None);
+  EXPECT_EQ(aligned_slice.compression, BDataCompression::None);
+  EXPECT_EQ(uncompressed_slice.compression, BDataCompression::None);
+  EXPECT_EQ(compressible_slice.compression, BDataCompression::Zstd);
+  EXPECT_LT(compressible_slice.range.size(), compressible.as_span().size_in_bytes());
+  EXPECT_EQ(compressible_slice.data_size(), compressible.as_span().size_in_bytes());
+
+  /* Uncompressed slices are aligned so that they can be used in place when mapped. */
+  for (const BDataSlice *slice : {&small_slice, &incompressible_slice, &aligned_slice}) {
+    EXPECT_EQ(slice->range.start() % 16, 0);
+  }
+
+  /* Slices are stored in JSON files. */
+  for (const BDataSlice *slice :
+       {&small_slice, &incompressible_slice, &compressible_slice, &uncompressed_slice})
+  {
+    const std::optional<BDataSlice> loaded_slice = BDataSlice::deserialize(*slice->serialize());
+    ASSERT_TRUE(loaded_slice.has_value());
+    expect_slices_equal(*loaded_slice, *slice);
+  }
+
+  DiskBDataReader reader{BKE_tempdir_session()};
+  EXPECT_TRUE(read_matches(reader, small_slice, small.as_span()));
+  EXPECT_TRUE(read_matches(reader, incompressible_slice, incompressible.as_span()));
+  EXPECT_TRUE(read_matches(reader, compressible_slice, compressible.as_span()));
+  EXPECT_TRUE(read_matches(reader, aligned_slice, incompressible.as_span()));
+  EXPECT_TRUE(read_matches(reader, uncompressed_slice, compressible.as_span()));
+}
+
+TEST_F(BakeItemsSerializeTest, DeduplicateAcrossWriters)
+{
+  const Array<int> data = compressible_data();
+  const Array<uint8_t> other_data = random_bytes(1000, 2);
+  BDataSharing bdata_sharing;
+
+  BDataSlice first_slice, duplicate_slice, other_slice;
+  {
+    fstream file = open_for_write("first.bdata");
+    DiskBDataWriter writer{"first.bdata", file, 0};
+    first_slice = bdata_sharing.write_deduplicated(
+        writer, data.data(), data.as_span().size_in_bytes());
+  }
+  {
+    fstream file = open_for_write("second.bdata");
+    DiskBDataWriter writer{"second.bdata", file, 0};
+    /* Write a copy, which is not shared with the first array at run-time. */
+    const Array<int> data_copy = data;
+    duplicate_slice = bdata_sharing.write_deduplicated(
+        writer, data_copy.data(), data_copy.as_span().size_in_bytes());
+    other_slice = bdata_sharing.write_deduplicated(writer, other_data.data(), other_data.size());
+  }
+
+  /* The duplicate references the data in the first file and is not written again. */
+  expect_slices_equal(duplicate_slice, first_slice);
+  EXPECT_EQ(other_slice.name, "second.bdata");
+  EXPECT_EQ(other_slice.range.start(), 0);
+  EXPECT_EQ(int64_t(BLI_file_size(bdata_path("second.bdata").c_str())), other_data.size());
+
+  DiskBDataReader reader{BKE_tempdir_session()};
+  EXPECT_TRUE(read_matches(reader, duplicate_slice, data.as_span()));
+  EXPECT_TRUE(read_matches(reader, other_slice, other_data.as_span()));
+}
+
+TEST_F(BakeItemsSerializeTest, MappedRead)
+{
+  const Array<uint8_t> small = random_bytes(3, 3);
+  const Array<uint8_t> incompressible = random_bytes(4096, 4);
+  const Array<int> compressible = compressible_data();
+
+  BDataSlice small_slice, incompressible_slice, compressible_slice;
+  {
+    fstream file = open_for_write("mapped.bdata");
+    DiskBDataWriter writer{"mapped.bdata", file, 0};
+    small_slice = writer.write(small.data(), small.size());
+    incompressible_slice = writer.write(incompressible.data(), incompressible.size());
+    compressible_slice = writer.write(compressible.data(),
+                                      compressible.as_span().size_in_bytes());
+  }
+
+  DiskBDataReader reader{BKE_tempdir_session()};
+  std::optional<ImplicitSharingInfoAndData> mapped_data = reader.read_mapped(incompressible_slice);
+#ifdef WIN32
+  /* Files are not mapped on Windows. */
+  EXPECT_FALSE(mapped_data.has_value());
+#else
+  ASSERT_TRUE(mapped_data.has_value());
+  EXPECT_EQ(uintptr_t(mapped_data->data) % 16, 0);
+  EXPECT_EQ(memcmp(mapped_data->data, incompressible.data(), incompressible.size()), 0);
+  mapped_data->sharing_info->remove_user_and_delete_if_last();
+
+  mapped_data = reader.read_mapped(small_slice);
+  ASSERT_TRUE(mapped_data.has_value());
+  EXPECT_EQ(memcmp(mapped_data->data, small.data(), small.size()), 0);
+  mapped_data->sharing_info->remove_user_and_delete_if_last();
+#endif
+
+  /* Compressed data has to be decompressed when it is read. */
+  EXPECT_FALSE(reader.read_mapped(compressible_slice).has_value());
+}
+
+static Array<float3> random_positions(const int size)
+{
+  RandomNumberGenerator rng(5);
+  Array<float3> positions(size);
+  for (float3 &position : positions) {
+    position = float3(rng.get_float(), rng.get_float(), rng.get_float()) * 20.0f - 10.0f;
+  }
+  return positions;
+}
+
+/**
+ * Bake the positions of a point cloud with the given maximum error and load them again.
+ * \return Whether the positions were quantized.
+ */
+static bool bake_positions(const StringRefNull name,
+                           const Span<float3> positions,
+                           const float max_error,
+                           Array<float3> &r_loaded_positions)
+{
+  PointCloud *pointcloud = BKE_pointcloud_new_nomain(positions.size());
+  pointcloud->positions_for_write().copy_from(positions);
+  const GeometryBakeItem item{GeometrySet::from_pointcloud(pointcloud)};
+
+  DictionaryValue io_item;
+  {
+    BDataWriteSettings settings;
+    settings.quantization_max_error = max_error;
+    BDataSharing bdata_sharing;
+    fstream file = open_for_write(name);
+    DiskBDataWriter writer{name, file, 0, settings};
+    serialize_bake_item(item, writer, bdata_sharing, io_item);
+  }
+
+  DiskBDataReader reader{BKE_tempdir_session()};
+  BDataSharing bdata_sharing;
+  const std::unique_ptr<BakeItem> loaded_item = deserialize_bake_item(
+      io_item, reader, bdata_sharing);
+  const auto *geometry_item = dynamic_cast<const GeometryBakeItem *>(loaded_item.get());
+  EXPECT_NE(geometry_item, nullptr);
+  if (geometry_item == nullptr || !geometry_item->geometry.has_pointcloud()) {
+    return false;
+  }
+  r_loaded_positions = Array<float3>(geometry_item->geometry.get_pointcloud()->positions());
+
+  JsonFormatter formatter;
+  std::stringstream stream;
+  formatter.serialize(stream, io_item);
+  return stream.str().find("\"quantization\"") != std::string::npos;
+}
+
+TEST_F(BakeItemsSerializeTest, QuantizedPositions)
+{
+  const Array<float3> positions = random_positions(1000);
+  const float max_error = 0.001f;
+
+  Array<float3> loaded_positions;
+  EXPECT_TRUE(bake_positions("quantized.bdata", positions, max_error, loaded_positions));
+  ASSERT_EQ(loaded_positions.size(), positions.size());
+  for (const int i : positions.index_range()) {
+    for (const int axis : IndexRange(3)) {
+      EXPECT_NEAR(loaded_positions[i][axis], positions[i][axis], max_error);
+    }
+  }
+
+  /* The positions are stored exactly when 16 bits are not precise enough. */
+  EXPECT_FALSE(bake_positions("exact.bdata", positions, 1e-6f, loaded_positions));
+  EXPECT_EQ(loaded_positions.as_span(), positions.as_span());
+
+  /* Quantization is disabled by default. */
+  EXPECT_FALSE(bake_positions("default.bdata", positions, 0.0f, loaded_positions));
+  EXPECT_EQ(loaded_positions.as_span(), positions.as_span());
+}
+
+TEST_F(BakeItemsSerializeTest, SliceWithoutCompression)
+{
+  /* Bakes from before compression was added store slices without padding, and don't have the
+   * "compression" and "uncompressed_size" keys. */
+  const Array<uint8_t> data = random_bytes(1000, 6);
+  {
+    fstream file = open_for_write("old.bdata");
+    file.write("abc", 3);
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+  }
+  DictionaryValue io_slice;
+  io_slice.append_str("name", "old.bdata");
+  io_slice.append_int("start", 3);
+  io_slice.append_int("size", data.size());
+
+  const std::optional<BDataSlice> slice = BDataSlice::deserialize(io_slice);
+  ASSERT_TRUE(slice.has_value());
+  EXPECT_EQ(slice->compression, BDataCompression::None);
+  EXPECT_EQ(slice->data_size(), data.size());
+
+  DiskBDataReader reader{BKE_tempdir_session()};
+  EXPECT_TRUE(read_matches(reader, *slice, data.as_span()));
+
+  /* Unknown compression methods can't be read. */
+  io_slice.append_str("compression", "unknown");
+  io_slice.append_int("uncompressed_size", data.size());
+  EXPECT_FALSE(BDataSlice::deserialize(io_slice).has_value());
+}
+
+}  // namespace blender::bke::tests
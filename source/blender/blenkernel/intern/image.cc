@@ -516,7 +516,7 @@ static void imagecache_keydata(void *userkey, int *framenr, int *proxy, int *ren
   *render_flags = 0;
 }
 
-static void imagecache_put(Image *image, int index, ImBuf *ibuf)
+static void imagecache_put(Image *image, int index, ImBuf *ibuf, float cost)
 {
   ImageCacheKey key;
 
@@ -531,7 +531,7 @@ static void imagecache_put(Image *image, int index, ImBuf *ibuf)
 
   key.index = index;
 
-  IMB_moviecache_put(image->cache, &key, ibuf);
+  IMB_moviecache_put_ex(image->cache, &key, ibuf, cost);
 }
 
 static void imagecache_remove(Image *image, int index)
@@ -706,13 +706,16 @@ static ImBuf *image_get_cached_ibuf_for_index_entry(Image *ima,
   return imagecache_get(ima, index, r_is_cached_empty);
 }
 
-static void image_assign_ibuf(Image *ima, ImBuf *ibuf, int index, int entry)
+/**
+ * \param cost: Time in seconds it took to load the buffer, zero when unknown.
+ */
+static void image_assign_ibuf(Image *ima, ImBuf *ibuf, int index, int entry, float cost)
 {
   if (index != IMA_NO_INDEX) {
     index = IMA_MAKE_INDEX(entry, index);
   }
 
-  imagecache_put(ima, index, ibuf);
+  imagecache_put(ima, index, ibuf, cost);
 }
 
 static void image_remove_ibuf(Image *ima, int index, int entry)
@@ -759,7 +762,7 @@ void BKE_image_merge(Main *bmain, Image *dest, Image *source)
       while (!IMB_moviecacheIter_done(iter)) {
         ImBuf *ibuf = IMB_moviecacheIter_getImBuf(iter);
         ImageCacheKey *key = static_cast<ImageCacheKey *>(IMB_moviecacheIter_getUserKey(iter));
-        imagecache_put(dest, key->index, ibuf);
+        imagecache_put(dest, key->index, ibuf, 0.0f);
         IMB_moviecacheIter_step(iter);
       }
       IMB_moviecacheIter_free(iter);
@@ -1244,7 +1247,7 @@ Image *BKE_image_add_generated(Main *bmain,
     ibuf = add_ibuf_for_tile(ima, tile);
     int index = tiled ? 0 : IMA_NO_INDEX;
     int entry = tiled ? 1001 : 0;
-    image_assign_ibuf(ima, ibuf, stereo3d ? view_id : index, entry);
+    image_assign_ibuf(ima, ibuf, stereo3d ? view_id : index, entry, 0.0f);
 
     /* #image_assign_ibuf puts buffer to the cache, which increments user counter. */
     IMB_freeImBuf(ibuf);
@@ -1314,7 +1317,7 @@ void BKE_image_replace_imbuf(Image *image, ImBuf *ibuf)
 
   BKE_image_free_buffers(image);
 
-  image_assign_ibuf(image, ibuf, IMA_NO_INDEX, 0);
+  image_assign_ibuf(image, ibuf, IMA_NO_INDEX, 0, 0.0f);
   image_colorspace_from_imbuf(image, ibuf);
 
   /* Keep generated image type flags consistent with the image buffer. */
@@ -3430,14 +3433,14 @@ void BKE_image_reassign_tile(Image *ima, ImageTile *tile, int new_tile_number)
     for (int i = 0; i < totviews; i++) {
       ImBuf *ibuf = image_get_cached_ibuf_for_index_entry(ima, i, old_tile_number, nullptr);
       image_remove_ibuf(ima, i, old_tile_number);
-      image_assign_ibuf(ima, ibuf, i, new_tile_number);
+      image_assign_ibuf(ima, ibuf, i, new_tile_number, 0.0f);
       IMB_freeImBuf(ibuf);
     }
   }
   else {
     ImBuf *ibuf = image_get_cached_ibuf_for_index_entry(ima, 0, old_tile_number, nullptr);
     image_remove_ibuf(ima, 0, old_tile_number);
-    image_assign_ibuf(ima, ibuf, 0, new_tile_number);
+    image_assign_ibuf(ima, ibuf, 0, new_tile_number, 0.0f);
     IMB_freeImBuf(ibuf);
   }
 
@@ -3482,7 +3485,7 @@ bool BKE_image_fill_tile(Image *ima, ImageTile *tile)
   ImBuf *tile_ibuf = add_ibuf_for_tile(ima, tile);
 
   if (tile_ibuf != nullptr) {
-    image_assign_ibuf(ima, tile_ibuf, 0, tile->tile_number);
+    image_assign_ibuf(ima, tile_ibuf, 0, tile->tile_number, 0.0f);
     BKE_image_release_ibuf(ima, tile_ibuf, nullptr);
     return true;
   }
@@ -3981,7 +3984,7 @@ static ImBuf *image_load_sequence_multilayer(Image *ima, ImageUser *iuser, int e
       BKE_imbuf_stamp_info(ima->rr, ibuf);
 
       image_init_after_load(ima, iuser, ibuf);
-      image_assign_ibuf(ima, ibuf, iuser ? iuser->multi_index : 0, entry);
+      image_assign_ibuf(ima, ibuf, iuser ? iuser->multi_index : 0, entry, 0.0f);
     }
     // else printf("pass not found\n");
   }
@@ -4058,9 +4061,11 @@ static ImBuf *image_load_movie_file(Image *ima, ImageUser *iuser, int frame)
     }
   }
 
+  const double start_time = PIL_check_seconds_timer();
+
   if (!is_multiview) {
     ibuf = load_movie_single(ima, iuser, frame, 0);
-    image_assign_ibuf(ima, ibuf, 0, frame);
+    image_assign_ibuf(ima, ibuf, 0, frame, float(PIL_check_seconds_timer() - start_time));
   }
   else {
     const int totviews = BLI_listbase_count(&ima->views);
@@ -4074,8 +4079,9 @@ static ImBuf *image_load_movie_file(Image *ima, ImageUser *iuser, int frame)
       IMB_ImBufFromStereo3d(ima->stereo3d_format, ibuf_arr[0], ibuf_arr.data(), &ibuf_arr[1]);
     }
 
+    const float cost = float(PIL_check_seconds_timer() - start_time) / totviews;
     for (int i = 0; i < totviews; i++) {
-      image_assign_ibuf(ima, ibuf_arr[i], i, frame);
+      image_assign_ibuf(ima, ibuf_arr[i], i, frame, cost);
     }
 
     /* return the original requested ImBuf */
@@ -4217,12 +4223,14 @@ static ImBuf *image_load_image_file(
     }
   }
 
+  const double start_time = PIL_check_seconds_timer();
+
   if (!is_multiview) {
     bool put_in_cache;
     ibuf = load_image_single(ima, iuser, cfra, 0, has_packed, is_sequence, &put_in_cache);
     if (put_in_cache) {
       const int index = (is_sequence || is_tiled) ? 0 : IMA_NO_INDEX;
-      image_assign_ibuf(ima, ibuf, index, entry);
+      image_assign_ibuf(ima, ibuf, index, entry, float(PIL_check_seconds_timer() - start_time));
     }
   }
   else {
@@ -4248,9 +4256,10 @@ static ImBuf *image_load_image_file(
     const int ibuf_index = (iuser && iuser->multi_index < totviews) ? iuser->multi_index : 0;
     ibuf = ibuf_arr[ibuf_index];
 
+    const float cost = float(PIL_check_seconds_timer() - start_time) / totviews;
     for (int i = 0; i < totviews; i++) {
       if (cache_ibuf_arr[i]) {
-        image_assign_ibuf(ima, ibuf_arr[i], i, entry);
+        image_assign_ibuf(ima, ibuf_arr[i], i, entry, cost);
       }
     }
 
@@ -4287,7 +4296,7 @@ static ImBuf *image_get_ibuf_multilayer(Image *ima, ImageUser *iuser)
 
       BKE_imbuf_stamp_info(ima->rr, ibuf);
 
-      image_assign_ibuf(ima, ibuf, iuser ? iuser->multi_index : IMA_NO_INDEX, 0);
+      image_assign_ibuf(ima, ibuf, iuser ? iuser->multi_index : IMA_NO_INDEX, 0, 0.0f);
     }
   }
 
@@ -4567,7 +4576,7 @@ static ImBuf *image_acquire_ibuf(Image *ima, ImageUser *iuser, void **r_lock)
       ImageTile *tile = BKE_image_get_tile(ima, entry);
       if ((tile->gen_flag & IMA_GEN_TILE) != 0) {
         ibuf = add_ibuf_for_tile(ima, tile);
-        image_assign_ibuf(ima, ibuf, 0, entry);
+        image_assign_ibuf(ima, ibuf, 0, entry, 0.0f);
       }
       else {
         if (ima->type == IMA_TYPE_IMAGE) {
@@ -4607,7 +4616,7 @@ static ImBuf *image_acquire_ibuf(Image *ima, ImageUser *iuser, void **r_lock)
         base_tile->gen_depth = 24;
       }
       ibuf = add_ibuf_for_tile(ima, base_tile);
-      image_assign_ibuf(ima, ibuf, index, 0);
+      image_assign_ibuf(ima, ibuf, index, 0, 0.0f);
     }
     else if (ima->source == IMA_SRC_VIEWER) {
       if (ima->type == IMA_TYPE_R_RESULT) {
@@ -4630,7 +4639,7 @@ static ImBuf *image_acquire_ibuf(Image *ima, ImageUser *iuser, void **r_lock)
             /* Composite Viewer, all handled in compositor */
             /* fake ibuf, will be filled in compositor */
             ibuf = IMB_allocImBuf(256, 256, 32, IB_rect | IB_rectfloat);
-            image_assign_ibuf(ima, ibuf, index, entry);
+            image_assign_ibuf(ima, ibuf, index, entry, 0.0f);
           }
         }
       }
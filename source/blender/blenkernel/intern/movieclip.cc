@@ -42,6 +42,8 @@
 #include "BLI_math.h"
 #include "BLI_threads.h"
 
+#include "PIL_time.h"
+
 #include "BLT_translation.h"
 
 #include "BKE_anim_data.h"
@@ -858,8 +860,12 @@ static bool has_imbuf_cache(MovieClip *clip, const MovieClipUser *user, int flag
   return false;
 }
 
-static bool put_imbuf_cache(
-    MovieClip *clip, const MovieClipUser *user, ImBuf *ibuf, int flag, bool destructive)
+static bool put_imbuf_cache(MovieClip *clip,
+                            const MovieClipUser *user,
+                            ImBuf *ibuf,
+                            int flag,
+                            bool destructive,
+                            float cost)
 {
   MovieClipImBufCacheKey key;
 
@@ -907,7 +913,7 @@ static bool put_imbuf_cache(
   }
 
   if (destructive) {
-    IMB_moviecache_put(clip->cache->moviecache, &key, ibuf);
+    IMB_moviecache_put_ex(clip->cache->moviecache, &key, ibuf, cost);
     return true;
   }
 
@@ -1279,6 +1285,7 @@ static ImBuf *movieclip_get_postprocessed_ibuf(
 
   if (!ibuf) {
     bool use_sequence = false;
+    const double start_time = PIL_check_seconds_timer();
 
     /* undistorted proxies for movies should be read as image sequence */
     use_sequence = (user->render_flag & MCLIP_PROXY_RENDER_UNDISTORT) &&
@@ -1292,7 +1299,7 @@ static ImBuf *movieclip_get_postprocessed_ibuf(
     }
 
     if (ibuf && (cache_flag & MOVIECLIP_CACHE_SKIP) == 0) {
-      put_imbuf_cache(clip, user, ibuf, flag, true);
+      put_imbuf_cache(clip, user, ibuf, flag, true, float(PIL_check_seconds_timer() - start_time));
     }
   }
 
@@ -1961,7 +1968,7 @@ bool BKE_movieclip_put_frame_if_possible(MovieClip *clip, const MovieClipUser *u
   bool result;
 
   BLI_thread_lock(LOCK_MOVIECLIP);
-  result = put_imbuf_cache(clip, user, ibuf, clip->flag, false);
+  result = put_imbuf_cache(clip, user, ibuf, clip->flag, false, 0.0f);
   BLI_thread_unlock(LOCK_MOVIECLIP);
 
   return result;
@@ -72,6 +72,8 @@
 #include "BKE_node_tree_zones.hh"
 #include "BKE_type_conversions.hh"
 
+#include "FN_field.hh"
+
 #include "RNA_access.h"
 #include "RNA_define.h"
 #include "RNA_enum_types.h"
@@ -321,6 +323,10 @@ static void ntree_free_data(ID *id)
   }
 
   BKE_previewimg_free(&ntree->preview);
+  if (ntree->type == NTREE_GEOMETRY) {
+    /* Cached field procedures may reference multi-functions owned by the runtime data. */
+    fn::field_procedure_cache_clear();
+  }
   MEM_delete(ntree->runtime);
 }
 
@@ -4451,6 +4457,8 @@ void BKE_node_system_init()
 
 void BKE_node_system_exit()
 {
+  blender::fn::field_procedure_cache_clear();
+
   if (blender::bke::nodetypes_alias_hash) {
     BLI_ghash_free(blender::bke::nodetypes_alias_hash, MEM_freeN, MEM_freeN);
     blender::bke::nodetypes_alias_hash = nullptr;
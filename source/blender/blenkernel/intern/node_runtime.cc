@@ -12,6 +12,8 @@
 #include "BLI_task.hh"
 #include "BLI_timeit.hh"
 
+#include "FN_field.hh"
+
 #include "NOD_geometry_nodes_lazy_function.hh"
 
 namespace blender::bke::node_tree_runtime {
@@ -19,7 +21,9 @@ namespace blender::bke::node_tree_runtime {
 void preprocess_geometry_node_tree_for_evaluation(bNodeTree &tree_cow)
 {
   BLI_assert(tree_cow.type == NTREE_GEOMETRY);
-  /* Rebuild geometry nodes lazy function graph. */
+  /* Rebuild geometry nodes lazy function graph. Cached field procedures may reference
+   * multi-functions owned by the old graph. */
+  fn::field_procedure_cache_clear();
   tree_cow.runtime->geometry_nodes_lazy_function_graph_info.reset();
   blender::nodes::ensure_geometry_nodes_lazy_function_graph(tree_cow);
 }
@@ -25,6 +25,8 @@
 #include "BKE_node_tree_anonymous_attributes.hh"
 #include "BKE_node_tree_update.h"
 
+#include "FN_field.hh"
+
 #include "MOD_nodes.hh"
 
 #include "NOD_geometry_nodes_lazy_function.hh"
@@ -370,6 +372,10 @@ class NodeTreeMainUpdater {
       }
 
       if (result.output_changed) {
+        if (ntree->type == NTREE_GEOMETRY) {
+          /* Cached field procedures may reference multi-functions owned by the graph. */
+          fn::field_procedure_cache_clear();
+        }
         ntree->runtime->geometry_nodes_lazy_function_graph_info.reset();
       }
 
@@ -16,6 +16,7 @@
 #include "BLI_hash_md5.h"
 #include "BLI_path_util.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 
 #include "MOD_nodes.hh"
 
@@ -192,37 +193,225 @@ SimulationZoneState &ModifierSimulationState::get_zone_state_for_write(
                                         []() { return std::make_unique<SimulationZoneState>(); });
 }
 
-void ModifierSimulationState::ensure_bake_loaded(const bNodeTree &ntree) const
+bool ModifierSimulationState::load_bake(const bNodeTree *ntree) const
 {
   std::scoped_lock lock{mutex_};
   if (bake_loaded_) {
-    return;
+    return true;
   }
   if (!meta_path_ || !bdata_dir_) {
-    return;
+    return true;
   }
 
   const std::shared_ptr<io::serialize::Value> io_root_value = io::serialize::read_json_file(
       *meta_path_);
   if (!io_root_value) {
-    return;
+    return true;
   }
   const DictionaryValue *io_root = io_root_value->as_dictionary_value();
   if (!io_root) {
-    return;
+    return true;
   }
 
   const DiskBDataReader bdata_reader{*bdata_dir_};
-  deserialize_modifier_simulation_state(ntree,
-                                        *io_root,
-                                        bdata_reader,
-                                        *owner_->bdata_sharing_,
-                                        const_cast<ModifierSimulationState &>(*this));
+  if (!deserialize_modifier_simulation_state(ntree,
+                                             *io_root,
+                                             bdata_reader,
+                                             *owner_->bdata_sharing_,
+                                             const_cast<ModifierSimulationState &>(*this)))
+  {
+    return false;
+  }
+  bake_loaded_bytes_ = bdata_reader.bytes_read();
   bake_loaded_ = true;
+  return true;
+}
+
+void ModifierSimulationState::ensure_bake_loaded(const bNodeTree &ntree) const
+{
+  this->load_bake(&ntree);
+}
+
+bool ModifierSimulationState::try_prefetch_bake() const
+{
+  return this->load_bake(nullptr);
+}
+
+bool ModifierSimulationState::try_unload_bake() const
+{
+  std::unique_lock lock{mutex_, std::try_to_lock};
+  if (!lock.owns_lock()) {
+    return false;
+  }
+  /* States without a meta file are only in memory and can't be loaded again. */
+  if (!bake_loaded_ || !meta_path_ || users_num_ > 0) {
+    return false;
+  }
+  const_cast<ModifierSimulationState &>(*this).zone_states_.clear();
+  bake_loaded_ = false;
+  bake_loaded_bytes_ = 0;
+  return true;
+}
+
+ModifierSimulationStateUser::ModifierSimulationStateUser(const ModifierSimulationState &state)
+    : state_(&state)
+{
+  std::lock_guard lock{state.mutex_};
+  state.users_num_++;
+}
+
+ModifierSimulationStateUser::ModifierSimulationStateUser(ModifierSimulationStateUser &&other)
+    : state_(other.state_)
+{
+  other.state_ = nullptr;
+}
+
+ModifierSimulationStateUser::~ModifierSimulationStateUser()
+{
+  if (state_ == nullptr) {
+    return;
+  }
+  std::lock_guard lock{state_->mutex_};
+  BLI_assert(state_->users_num_ > 0);
+  state_->users_num_--;
+}
+
+/** Maximum number of frames that are loaded ahead of the current frame. */
+static constexpr int prefetch_frames_num = 16;
+/** Stop loading ahead once the states after the current frame use this much memory. */
+static constexpr int64_t prefetch_memory_budget = int64_t(1) << 30;
+
+ModifierSimulationCache::~ModifierSimulationCache()
+{
+  if (prefetch_pool_) {
+    this->cancel_prefetch();
+    BLI_task_pool_free(prefetch_pool_);
+  }
+}
+
+const ModifierSimulationState *ModifierSimulationCache::find_state_to_prefetch(
+    const SubFrame &frame) const
+{
+  std::lock_guard lock(states_at_frames_mutex_);
+  int64_t i = find_state_at_frame(states_at_frames_, frame);
+  if (i == -1) {
+    return nullptr;
+  }
+  if (states_at_frames_[i]->frame == frame) {
+    i++;
+  }
+  int64_t loaded_bytes = 0;
+  const int64_t end = std::min<int64_t>(i + prefetch_frames_num, states_at_frames_.size());
+  for (const int64_t j : IndexRange(i, std::max<int64_t>(end - i, 0))) {
+    const ModifierSimulationState &state = states_at_frames_[j]->state;
+    /* Skip states that are currently loaded by another thread. */
+    std::unique_lock state_lock{state.mutex_, std::try_to_lock};
+    if (!state_lock.owns_lock()) {
+      continue;
+    }
+    if (state.bake_loaded_) {
+      loaded_bytes += state.bake_loaded_bytes_;
+      if (loaded_bytes >= prefetch_memory_budget) {
+        return nullptr;
+      }
+      continue;
+    }
+    if (!state.meta_path_ || state.bake_prefetch_failed_) {
+      continue;
+    }
+    return &state;
+  }
+  return nullptr;
+}
+
+void ModifierSimulationCache::unload_states_outside_prefetch_window(const SubFrame &frame)
+{
+  std::lock_guard lock(states_at_frames_mutex_);
+  int64_t i = find_state_at_frame(states_at_frames_, frame);
+  if (i == -1) {
+    i = states_at_frames_.size();
+  }
+  /* Keep the states around the frame which are used to evaluate it, and the prefetched ones. */
+  const int64_t window_start = std::max<int64_t>(i - 1, 0);
+  const int64_t window_end = std::min<int64_t>(i + 1 + prefetch_frames_num,
+                                               states_at_frames_.size());
+  bool unloaded = false;
+  for (const int64_t j : states_at_frames_.index_range()) {
+    if (j >= window_start && j < window_end) {
+      continue;
+    }
+    unloaded |= states_at_frames_[j]->state.try_unload_bake();
+  }
+  if (unloaded) {
+    bdata_sharing_->remove_unused_read_data();
+  }
+}
+
+void ModifierSimulationCache::prefetch_task(TaskPool *pool, void * /*taskdata*/)
+{
+  ModifierSimulationCache &cache = *static_cast<ModifierSimulationCache *>(
+      BLI_task_pool_user_data(pool));
+  while (!BLI_task_pool_current_canceled(pool)) {
+    const ModifierSimulationState *state;
+    {
+      std::lock_guard lock{cache.prefetch_mutex_};
+      state = cache.find_state_to_prefetch(cache.prefetch_frame_);
+      if (state == nullptr) {
+        cache.prefetch_running_ = false;
+        return;
+      }
+    }
+    if (!state->try_prefetch_bake()) {
+      std::lock_guard lock{state->mutex_};
+      state->bake_prefetch_failed_ = true;
+    }
+  }
+  std::lock_guard lock{cache.prefetch_mutex_};
+  cache.prefetch_running_ = false;
+}
+
+void ModifierSimulationCache::prefetch_baked_states(const SubFrame &frame)
+{
+  if (this->cache_state != CacheState::Baked) {
+    return;
+  }
+  this->unload_states_outside_prefetch_window(frame);
+
+  std::lock_guard lock{prefetch_mutex_};
+  prefetch_frame_ = frame;
+  if (prefetch_running_) {
+    /* The running task picks up the new frame. */
+    return;
+  }
+  if (prefetch_pool_ == nullptr) {
+    prefetch_pool_ = BLI_task_pool_create_background_serial(this, TASK_PRIORITY_LOW);
+  }
+  prefetch_running_ = true;
+  BLI_task_pool_push(prefetch_pool_, prefetch_task, nullptr, false, nullptr);
+}
+
+void ModifierSimulationCache::wait_for_prefetch()
+{
+  if (prefetch_pool_) {
+    BLI_task_pool_work_and_wait(prefetch_pool_);
+  }
+}
+
+void ModifierSimulationCache::cancel_prefetch()
+{
+  if (prefetch_pool_ == nullptr) {
+    return;
+  }
+  /* Wait for the task without holding the lock, because the task uses it too. */
+  BLI_task_pool_cancel(prefetch_pool_);
+  std::lock_guard lock{prefetch_mutex_};
+  prefetch_running_ = false;
 }
 
 void ModifierSimulationCache::reset()
 {
+  /* The prefetching accesses the states that are freed below. */
+  this->cancel_prefetch();
   std::lock_guard lock(states_at_frames_mutex_);
   states_at_frames_.clear();
   bdata_sharing_.reset();
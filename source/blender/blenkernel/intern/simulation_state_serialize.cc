@@ -114,7 +114,7 @@ void serialize_modifier_simulation_state(const ModifierSimulationState &state,
   }
 }
 
-void deserialize_modifier_simulation_state(const bNodeTree &ntree,
+bool deserialize_modifier_simulation_state(const bNodeTree *ntree,
                                            const DictionaryValue &io_root,
                                            const BDataReader &bdata_reader,
                                            const BDataSharing &bdata_sharing,
@@ -123,14 +123,22 @@ void deserialize_modifier_simulation_state(const bNodeTree &ntree,
   io::serialize::JsonFormatter formatter;
   const std::optional<int> version = io_root.lookup_int("version");
   if (!version) {
-    return;
+    return true;
   }
   if (*version > serialize_format_version) {
-    return;
+    return true;
   }
   const io::serialize::ArrayValue *io_zones = io_root.lookup_array("zones");
   if (!io_zones) {
-    return;
+    return true;
+  }
+  if (ntree == nullptr) {
+    for (const auto &io_zone_value : io_zones->elements()) {
+      const DictionaryValue *io_zone = io_zone_value->as_dictionary_value();
+      if (io_zone && !io_zone->lookup_int("state_id")) {
+        return false;
+      }
+    }
   }
   for (const auto &io_zone_value : io_zones->elements()) {
     const DictionaryValue *io_zone = io_zone_value->as_dictionary_value();
@@ -153,7 +161,7 @@ void deserialize_modifier_simulation_state(const bNodeTree &ntree,
         }
         node_ids.append(io_node_id->value());
       }
-      const bNestedNodeRef *nested_node_ref = ntree.nested_node_ref_from_node_id_path(node_ids);
+      const bNestedNodeRef *nested_node_ref = ntree->nested_node_ref_from_node_id_path(node_ids);
       if (!nested_node_ref) {
         continue;
       }
@@ -186,6 +194,7 @@ void deserialize_modifier_simulation_state(const bNodeTree &ntree,
 
     r_state.zone_states_.add_overwrite(zone_id, std::move(zone_state));
   }
+  return true;
 }
 
 }  // namespace blender::bke::sim
@@ -0,0 +1,238 @@
+/* SPDX-FileCopyrightText: 2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <atomic>
+#include <thread>
+
+#include "BKE_appdir.h"
+#include "BKE_idtype.h"
+#include "BKE_pointcloud.h"
+#include "BKE_simulation_state.hh"
+#include "BKE_simulation_state_serialize.hh"
+
+#include "BLI_fileops.hh"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_string_utils.h"
+
+#include "CLG_log.h"
+
+#include "DNA_node_types.h"
+#include "DNA_pointcloud_types.h"
+
+namespace blender::bke::sim::tests {
+
+using namespace io::serialize;
+
+/** Number of frames that the cache loads ahead of the current frame. */
+static constexpr int prefetch_frames_num = 16;
+static constexpr int frames_num = 40;
+static constexpr int zone_id = 1;
+
+class SimulationStateTest : public testing::Test {
+ protected:
+  static void SetUpTestSuite()
+  {
+    CLG_init();
+    BKE_idtype_init();
+    BKE_tempdir_init("");
+  }
+
+  static void TearDownTestSuite()
+  {
+    BKE_tempdir_session_purge();
+    CLG_exit();
+  }
+};
+
+/**
+ * Bake a simulation zone with a point cloud whose positions are the frame number.
+ * \param use_legacy_zone: Add a zone that is identified by its node id path, like in bakes from
+ * older versions.
+ * \return The bake directory.
+ */
+static std::string write_bake(const StringRefNull name, const bool use_legacy_zone)
+{
+  char bake_dir[FILE_MAX];
+  BLI_path_join(bake_dir, sizeof(bake_dir), BKE_tempdir_session(), name.c_str());
+
+  BDataSharing bdata_sharing;
+  for (const int frame : IndexRange(1, frames_num)) {
+    char frame_file_c_str[64];
+    SNPRINTF(frame_file_c_str, "%011.5f", double(frame));
+    BLI_string_replace_char(frame_file_c_str, '.', '_');
+    const std::string bdata_file_name = std::string(frame_file_c_str) + ".bdata";
+    const std::string meta_file_name = std::string(frame_file_c_str) + ".json";
+
+    char bdata_path[FILE_MAX];
+    BLI_path_join(bdata_path, sizeof(bdata_path), bake_dir, "bdata", bdata_file_name.c_str());
+    char meta_path[FILE_MAX];
+    BLI_path_join(meta_path, sizeof(meta_path), bake_dir, "meta", meta_file_name.c_str());
+
+    ModifierSimulationState state;
+    PointCloud *pointcloud = BKE_pointcloud_new_nomain(1000);
+    pointcloud->positions_for_write().fill(float3(float(frame)));
+    state.get_zone_state_for_write({zone_id}).item_by_identifier.add(
+        0, std::make_unique<GeometryBakeItem>(GeometrySet::from_pointcloud(pointcloud)));
+
+    BLI_file_ensure_parent_dir_exists(bdata_path);
+    fstream bdata_file{bdata_path, std::ios::out | std::ios::binary};
+    DiskBDataWriter bdata_writer{bdata_file_name, bdata_file, 0};
+
+    DictionaryValue io_state;
+    serialize_modifier_simulation_state(state, bdata_writer, bdata_sharing, io_state);
+
+    /* The first version wrote node id paths, later versions the nested node ids. */
+    DictionaryValue io_root;
+    io_root.append_int("version", use_legacy_zone ? 1 : *io_state.lookup_int("version"));
+    std::shared_ptr<ArrayValue> io_zones = io_root.append_array("zones");
+    if (use_legacy_zone) {
+      std::shared_ptr<DictionaryValue> io_legacy_zone = io_zones->append_dict();
+      io_legacy_zone->append_array("zone_id")->append_int(5);
+      io_legacy_zone->append_array("state_items");
+    }
+    for (const std::shared_ptr<Value> &io_zone : io_state.lookup_array("zones")->elements()) {
+      io_zones->elements().append(io_zone);
+    }
+
+    BLI_file_ensure_parent_dir_exists(meta_path);
+    write_json_file(meta_path, io_root);
+  }
+  return bake_dir;
+}
+
+static bool is_loaded(const ModifierSimulationCache &cache, const int frame)
+{
+  const ModifierSimulationState *state = cache.get_state_at_exact_frame(frame);
+  std::lock_guard lock{state->mutex_};
+  return !state->zone_states_.is_empty();
+}
+
+static float3 loaded_position(const ModifierSimulationCache &cache, const int frame)
+{
+  const ModifierSimulationState *state = cache.get_state_at_exact_frame(frame);
+  const SimulationZoneState *zone_state = state->get_zone_state({zone_id});
+  const auto &item = dynamic_cast<const GeometryBakeItem &>(
+      *zone_state->item_by_identifier.lookup(0));
+  return item.geometry.get_pointcloud()->positions().first();
+}
+
+/** Check that exactly the frames shortly after the current frame have been prefetched. */
+static void expect_prefetched(const ModifierSimulationCache &cache, const int current_frame)
+{
+  for (const int frame : IndexRange(1, frames_num)) {
+    const bool expected = frame > current_frame && frame <= current_frame + prefetch_frames_num;
+    EXPECT_EQ(is_loaded(cache, frame), expected) << "frame " << frame;
+  }
+}
+
+TEST_F(SimulationStateTest, PrefetchAndUnload)
+{
+  const std::string bake_dir = write_bake("prefetch", false);
+  ModifierSimulationCache cache;
+  cache.try_discover_bake(bake_dir);
+  ASSERT_EQ(cache.cache_state, CacheState::Baked);
+
+  cache.prefetch_baked_states(1);
+  cache.wait_for_prefetch();
+  expect_prefetched(cache, 1);
+  EXPECT_EQ(loaded_position(cache, 5), float3(5.0f));
+
+  /* Jumping ahead frees the states that are not needed anymore. */
+  cache.prefetch_baked_states(20);
+  cache.wait_for_prefetch();
+  expect_prefetched(cache, 20);
+  EXPECT_EQ(loaded_position(cache, 30), float3(30.0f));
+
+  /* Freed states are loaded again when they are needed. */
+  cache.prefetch_baked_states(1);
+  cache.wait_for_prefetch();
+  expect_prefetched(cache, 1);
+  EXPECT_EQ(loaded_position(cache, 5), float3(5.0f));
+}
+
+TEST_F(SimulationStateTest, UnloadKeepsUsedStates)
+{
+  const std::string bake_dir = write_bake("users", false);
+  ModifierSimulationCache cache;
+  cache.try_discover_bake(bake_dir);
+  cache.prefetch_baked_states(1);
+  cache.wait_for_prefetch();
+
+  /* Another depsgraph evaluates frame 5 while playback in the active one moves on. */
+  {
+    const ModifierSimulationStateUser user{*cache.get_state_at_exact_frame(5)};
+    std::atomic<bool> evaluation_done = false;
+    std::thread evaluation{[&]() {
+      while (!evaluation_done) {
+        EXPECT_EQ(loaded_position(cache, 5), float3(5.0f));
+      }
+    }};
+    for (const int frame : IndexRange(20, 10)) {
+      cache.prefetch_baked_states(frame);
+    }
+    cache.wait_for_prefetch();
+    evaluation_done = true;
+    evaluation.join();
+    EXPECT_TRUE(is_loaded(cache, 5));
+    EXPECT_FALSE(is_loaded(cache, 6));
+  }
+
+  /* The state is freed once it is not used anymore. */
+  cache.prefetch_baked_states(29);
+  cache.wait_for_prefetch();
+  EXPECT_FALSE(is_loaded(cache, 5));
+}
+
+TEST_F(SimulationStateTest, CancelPrefetchInReset)
+{
+  const std::string bake_dir = write_bake("reset", false);
+  ModifierSimulationCache cache;
+  cache.try_discover_bake(bake_dir);
+
+  cache.prefetch_baked_states(1);
+  cache.reset();
+  EXPECT_FALSE(cache.has_states());
+
+  /* Prefetching still works after it was canceled. */
+  cache.try_discover_bake(bake_dir);
+  cache.prefetch_baked_states(1);
+  cache.wait_for_prefetch();
+  expect_prefetched(cache, 1);
+}
+
+TEST_F(SimulationStateTest, CancelPrefetchInDestructor)
+{
+  const std::string bake_dir = write_bake("destructor", false);
+  for ([[maybe_unused]] const int i : IndexRange(8)) {
+    auto cache = std::make_unique<ModifierSimulationCache>();
+    cache->try_discover_bake(bake_dir);
+    cache->prefetch_baked_states(1);
+    cache.reset();
+  }
+}
+
+TEST_F(SimulationStateTest, LegacyBakeLoadedOnDemand)
+{
+  const std::string bake_dir = write_bake("legacy", true);
+  ModifierSimulationCache cache;
+  cache.try_discover_bake(bake_dir);
+
+  /* Zones identified by node id paths need the node tree, which the prefetching can't access. */
+  cache.prefetch_baked_states(1);
+  cache.wait_for_prefetch();
+  for (const int frame : IndexRange(1, frames_num)) {
+    EXPECT_FALSE(is_loaded(cache, frame)) << "frame " << frame;
+  }
+
+  /* Without nested node references the legacy zone is skipped, but the others are loaded. */
+  const bNodeTree ntree{};
+  cache.get_state_at_exact_frame(2)->ensure_bake_loaded(ntree);
+  EXPECT_TRUE(is_loaded(cache, 2));
+  EXPECT_EQ(loaded_position(cache, 2), float3(2.0f));
+}
+
+}  // namespace blender::bke::sim::tests
@@ -32,12 +32,24 @@ struct FileReader;
 typedef ssize_t (*FileReaderReadFn)(struct FileReader *reader, void *buffer, size_t size);
 typedef off64_t (*FileReaderSeekFn)(struct FileReader *reader, off64_t offset, int whence);
 typedef void (*FileReaderCloseFn)(struct FileReader *reader);
+/**
+ * Direct access to the file contents, without copying them into a buffer.
+ * Returns a pointer to `size` bytes at `offset`, or NULL if the range can't be accessed.
+ * The memory stays valid until the reader is closed, and must not be modified.
+ *
+ * \note For memory-mapped files, IO errors are only detected while the memory is accessed.
+ * In that case the memory reads as zeroes and any following call returns NULL, so callers
+ * have to call this again for the same range after they're done reading it.
+ */
+typedef const void *(*FileReaderDataFn)(struct FileReader *reader, off64_t offset, size_t size);
 
 /** General structure for all #FileReaders, implementations add custom fields at the end. */
 typedef struct FileReader {
   FileReaderReadFn read;
   FileReaderSeekFn seek;
   FileReaderCloseFn close;
+  /** Optional, only supported by readers that have the whole file in memory. */
+  FileReaderDataFn data;
 
   off64_t offset;
 } FileReader;
@@ -0,0 +1,238 @@
+/* SPDX-FileCopyrightText: 2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Hash tables like #blender::Map, #blender::Set and #blender::VectorSet can use control bytes to
+ * speed up probing, a technique known from "Swiss tables". It is enabled by using
+ * #GroupProbingStrategy as probing strategy.
+ *
+ * In addition to the slots, the hash table then stores one byte per slot. It is either empty,
+ * removed, or contains 7 bits of the hash of the key that is stored in the slot. Slots are
+ * organized in groups of 16 whose control bytes are compared at once using SIMD instructions.
+ * Only slots whose control byte matches the hash of the searched key are accessed, which avoids
+ * most cache misses and key comparisons when there are collisions. The cost is one additional
+ * byte per slot.
+ *
+ * The slots still keep track of their own state, so that all slot types can be used with control
+ * bytes. The control bytes always have to be kept in sync with the slots.
+ */
+
+#include <algorithm>
+
+#include "BLI_array.hh"
+#include "BLI_math_bits.h"
+#include "BLI_probing_strategies.hh"
+#include "BLI_simd.h"
+
+namespace blender {
+
+template<typename ProbingStrategy>
+inline constexpr bool is_group_probing_strategy_v = std::is_same_v<ProbingStrategy,
+                                                                   GroupProbingStrategy>;
+
+namespace hash_table_control_bytes {
+
+inline constexpr int64_t group_size = GroupProbingStrategy::group_size;
+/** The high bit is set for control bytes that don't belong to occupied slots. */
+inline constexpr uint8_t empty = 0x80;
+inline constexpr uint8_t removed = 0xFE;
+
+/** Get the 7 bits of the hash that are stored in the control byte of an occupied slot. */
+inline uint8_t hash_to_control_byte(const uint64_t hash)
+{
+  return uint8_t(GroupProbingStrategy::mix_hash(hash) >> 57);
+}
+
+/**
+ * Control bytes of 16 consecutive slots.
+ */
+class Group {
+ private:
+#if BLI_HAVE_SSE2
+  __m128i bytes_;
+#else
+  const uint8_t *bytes_;
+#endif
+
+ public:
+  explicit Group(const uint8_t *bytes)
+  {
+#if BLI_HAVE_SSE2
+    bytes_ = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes));
+#else
+    bytes_ = bytes;
+#endif
+  }
+
+  /** Get a bit mask of the slots whose control byte is equal to the given byte. */
+  uint32_t match(const uint8_t byte) const
+  {
+#if BLI_HAVE_SSE2
+    return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes_, _mm_set1_epi8(char(byte)))));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < group_size; i++) {
+      mask |= uint32_t(bytes_[i] == byte) << i;
+    }
+    return mask;
+#endif
+  }
+
+  uint32_t match_empty() const
+  {
+    return this->match(empty);
+  }
+};
+
+}  // namespace hash_table_control_bytes
+
+/**
+ * Stores the control bytes of a hash table with a power-of-two number of slots. There are always
+ * at least as many control bytes as slots in a group. Additional control bytes for smaller hash
+ * tables are marked as removed, so that they are never used.
+ */
+template<int64_t InlineSlotsNum, typename Allocator> class HashTableControlBytes {
+ private:
+  using Bytes = Array<uint8_t,
+                      std::max<int64_t>(InlineSlotsNum, hash_table_control_bytes::group_size),
+                      Allocator>;
+  Bytes bytes_;
+
+ public:
+  HashTableControlBytes(Allocator allocator = {}) noexcept
+      : bytes_(hash_table_control_bytes::group_size, allocator)
+  {
+    this->reset(1);
+  }
+
+  /** Make sure that there are control bytes for the given number of slots and mark them empty. */
+  void reinitialize(const int64_t slots_num)
+  {
+    bytes_.reinitialize(std::max<int64_t>(slots_num, hash_table_control_bytes::group_size));
+    this->reset(slots_num);
+  }
+
+  void occupy(const int64_t slot_index, const uint64_t hash)
+  {
+    bytes_[slot_index] = hash_table_control_bytes::hash_to_control_byte(hash);
+  }
+
+  void remove(const int64_t slot_index)
+  {
+    bytes_[slot_index] = hash_table_control_bytes::removed;
+  }
+
+  int64_t size_in_bytes() const
+  {
+    return bytes_.size();
+  }
+
+  /**
+   * Find the first slot in the probing sequence that is empty or for which `is_match(slot_index)`
+   * is true. The predicate is only called for slots that store a key with a similar hash.
+   */
+  template<typename IsMatchF>
+  int64_t find_match_or_empty(const uint64_t hash, const IsMatchF &is_match) const
+  {
+    using namespace hash_table_control_bytes;
+    const uint8_t control_byte = hash_to_control_byte(hash);
+    const uint64_t group_mask = this->group_mask();
+    SLOT_PROBING_BEGIN (GroupProbingStrategy, hash, group_mask, group_index) {
+      const int64_t group_start = group_index * group_size;
+      const Group group(bytes_.data() + group_start);
+      uint32_t matches = group.match(control_byte);
+      while (matches != 0) {
+        const int64_t slot_index = group_start + bitscan_forward_clear_uint(&matches);
+        if (is_match(slot_index)) {
+          return slot_index;
+        }
+      }
+      if (const uint32_t empty_slots = group.match_empty()) {
+        return group_start + bitscan_forward_uint(empty_slots);
+      }
+    }
+    SLOT_PROBING_END();
+  }
+
+  /** Find the slot where a key with the given hash is inserted if it is not in the table. */
+  int64_t find_empty(const uint64_t hash) const
+  {
+    using namespace hash_table_control_bytes;
+    const uint64_t group_mask = this->group_mask();
+    SLOT_PROBING_BEGIN (GroupProbingStrategy, hash, group_mask, group_index) {
+      const int64_t group_start = group_index * group_size;
+      if (const uint32_t empty_slots = Group(bytes_.data() + group_start).match_empty()) {
+        return group_start + bitscan_forward_uint(empty_slots);
+      }
+    }
+    SLOT_PROBING_END();
+  }
+
+  /** Number of groups that have to be checked in addition to the first one. */
+  template<typename IsMatchF>
+  int64_t count_collisions(const uint64_t hash, const IsMatchF &is_match) const
+  {
+    using namespace hash_table_control_bytes;
+    const uint8_t control_byte = hash_to_control_byte(hash);
+    const uint64_t group_mask = this->group_mask();
+    int64_t collisions = 0;
+    SLOT_PROBING_BEGIN (GroupProbingStrategy, hash, group_mask, group_index) {
+      const int64_t group_start = group_index * group_size;
+      const Group group(bytes_.data() + group_start);
+      uint32_t matches = group.match(control_byte);
+      while (matches != 0) {
+        if (is_match(group_start + bitscan_forward_clear_uint(&matches))) {
+          return collisions;
+        }
+      }
+      if (group.match_empty() != 0) {
+        return collisions;
+      }
+      collisions++;
+    }
+    SLOT_PROBING_END();
+  }
+
+ private:
+  uint64_t group_mask() const
+  {
+    return uint64_t(bytes_.size() / hash_table_control_bytes::group_size) - 1;
+  }
+
+  void reset(const int64_t slots_num)
+  {
+    BLI_assert(slots_num <= bytes_.size());
+    MutableSpan<uint8_t> bytes = bytes_;
+    bytes.take_front(slots_num).fill(hash_table_control_bytes::empty);
+    bytes.drop_front(slots_num).fill(hash_table_control_bytes::removed);
+  }
+};
+
+/**
+ * Used by hash tables that don't use group probing. It does not store anything.
+ */
+template<typename Allocator> class NoHashTableControlBytes {
+ public:
+  NoHashTableControlBytes(Allocator /*allocator*/ = {}) noexcept {}
+
+  void reinitialize(const int64_t /*slots_num*/) {}
+  void occupy(const int64_t /*slot_index*/, const uint64_t /*hash*/) {}
+  void remove(const int64_t /*slot_index*/) {}
+  int64_t size_in_bytes() const
+  {
+    return 0;
+  }
+};
+
+template<typename ProbingStrategy, int64_t InlineSlotsNum, typename Allocator>
+using HashTableControlBytesFor =
+    std::conditional_t<is_group_probing_strategy_v<ProbingStrategy>,
+                       HashTableControlBytes<InlineSlotsNum, Allocator>,
+                       NoHashTableControlBytes<Allocator>>;
+
+}  // namespace blender
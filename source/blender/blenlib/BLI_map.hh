@@ -33,6 +33,9 @@
  * - Pointers to keys and values might be invalidated when the map is changed or moved.
  * - The hash function can be customized. See BLI_hash.hh for details.
  * - The probing strategy can be customized. See BLI_probing_strategies.hh for details.
+ * - Using #GroupProbingStrategy stores an additional control byte per slot, which makes lookups
+ *   faster when there are many collisions or comparing keys is expensive. See
+ *   BLI_hash_table_control_bytes.hh for details.
  * - The slot type can be customized. See BLI_map_slots.hh for details.
  * - Small buffer optimization is enabled by default, if Key and Value are not too large.
  * - The methods `add_new` and `remove_contained` should be used instead of `add` and `remove`
@@ -56,6 +59,7 @@
 
 #include "BLI_array.hh"
 #include "BLI_hash.hh"
+#include "BLI_hash_table_control_bytes.hh"
 #include "BLI_hash_tables.hh"
 #include "BLI_map_slots.hh"
 #include "BLI_probing_strategies.hh"
@@ -163,6 +167,10 @@ class Map {
   LoadFactor max_load_factor_ = LoadFactor(LOAD_FACTOR);
   using SlotArray =
       Array<Slot, LoadFactor::compute_total_slots(InlineBufferCapacity, LOAD_FACTOR), Allocator>;
+  using ControlBytes =
+      HashTableControlBytesFor<ProbingStrategy,
+                               LoadFactor::compute_total_slots(InlineBufferCapacity, LOAD_FACTOR),
+                               Allocator>;
 #undef LOAD_FACTOR
 
   /**
@@ -171,6 +179,9 @@ class Map {
    */
   SlotArray slots_;
 
+  /** Only stores data when #GroupProbingStrategy is used. It is kept in sync with the slots. */
+  BLI_NO_UNIQUE_ADDRESS ControlBytes control_bytes_;
+
   /** Iterate over a slot index sequence for a given hash. */
 #define MAP_SLOT_PROBING_BEGIN(HASH, R_SLOT) \
   SLOT_PROBING_BEGIN (ProbingStrategy, HASH, slot_mask_, SLOT_INDEX) \
@@ -190,7 +201,8 @@ class Map {
         slot_mask_(0),
         hash_(),
         is_equal_(),
-        slots_(1, allocator)
+        slots_(1, allocator),
+        control_bytes_(allocator)
   {
   }
 
@@ -205,10 +217,12 @@ class Map {
   {
     if constexpr (std::is_nothrow_move_constructible_v<SlotArray>) {
       slots_ = std::move(other.slots_);
+      control_bytes_ = std::move(other.control_bytes_);
     }
     else {
       try {
         slots_ = std::move(other.slots_);
+        control_bytes_ = std::move(other.control_bytes_);
       }
       catch (...) {
         other.noexcept_reset();
@@ -351,8 +365,7 @@ class Map {
     if (slot == nullptr) {
       return false;
     }
-    slot->remove();
-    removed_slots_++;
+    this->remove_slot(*slot);
     return true;
   }
 
@@ -367,8 +380,7 @@ class Map {
   template<typename ForwardKey> void remove_contained_as(const ForwardKey &key)
   {
     Slot &slot = this->lookup_slot(key, hash_(key));
-    slot.remove();
-    removed_slots_++;
+    this->remove_slot(slot);
   }
 
   /**
@@ -383,8 +395,7 @@ class Map {
   {
     Slot &slot = this->lookup_slot(key, hash_(key));
     Value value = std::move(*slot.value());
-    slot.remove();
-    removed_slots_++;
+    this->remove_slot(slot);
     return value;
   }
 
@@ -403,8 +414,7 @@ class Map {
       return {};
     }
     std::optional<Value> value = std::move(*slot->value());
-    slot->remove();
-    removed_slots_++;
+    this->remove_slot(*slot);
     return value;
   }
 
@@ -428,8 +438,7 @@ class Map {
       return Value(std::forward<ForwardValue>(default_value)...);
     }
     Value value = std::move(*slot->value());
-    slot->remove();
-    removed_slots_++;
+    this->remove_slot(*slot);
     return value;
   }
 
@@ -886,8 +895,7 @@ class Map {
   {
     Slot &slot = iterator.current_slot();
     BLI_assert(slot.is_occupied());
-    slot.remove();
-    removed_slots_++;
+    this->remove_slot(slot);
   }
 
   /**
@@ -904,8 +912,7 @@ class Map {
         const Key &key = *slot.key();
         Value &value = *slot.value();
         if (predicate(MutableItem{key, value})) {
-          slot.remove();
-          removed_slots_++;
+          this->remove_slot(slot);
         }
       }
     }
@@ -969,7 +976,7 @@ class Map {
    */
   int64_t size_in_bytes() const
   {
-    return int64_t(sizeof(Slot) * slots_.size());
+    return int64_t(sizeof(Slot) * slots_.size()) + control_bytes_.size_in_bytes();
   }
 
   /**
@@ -992,6 +999,7 @@ class Map {
       slot.~Slot();
       new (&slot) Slot();
     }
+    control_bytes_.reinitialize(slots_.size());
 
     removed_slots_ = 0;
     occupied_and_removed_slots_ = 0;
@@ -1030,6 +1038,7 @@ class Map {
     if (this->size() == 0) {
       try {
         slots_.reinitialize(total_slots);
+        control_bytes_.reinitialize(total_slots);
       }
       catch (...) {
         this->noexcept_reset();
@@ -1045,13 +1054,16 @@ class Map {
     SlotArray new_slots(total_slots);
 
     try {
+      ControlBytes new_control_bytes(slots_.allocator());
+      new_control_bytes.reinitialize(total_slots);
       for (Slot &slot : slots_) {
         if (slot.is_occupied()) {
-          this->add_after_grow(slot, new_slots, new_slot_mask);
+          this->add_after_grow(slot, new_slots, new_control_bytes, new_slot_mask);
           slot.remove();
         }
       }
       slots_ = std::move(new_slots);
+      control_bytes_ = std::move(new_control_bytes);
     }
     catch (...) {
       this->noexcept_reset();
@@ -1064,17 +1076,16 @@ class Map {
     slot_mask_ = new_slot_mask;
   }
 
-  void add_after_grow(Slot &old_slot, SlotArray &new_slots, uint64_t new_slot_mask)
+  void add_after_grow(Slot &old_slot,
+                      SlotArray &new_slots,
+                      ControlBytes &new_control_bytes,
+                      uint64_t new_slot_mask)
   {
     uint64_t hash = old_slot.get_hash(Hash());
-    SLOT_PROBING_BEGIN (ProbingStrategy, hash, new_slot_mask, slot_index) {
-      Slot &slot = new_slots[slot_index];
-      if (slot.is_empty()) {
-        slot.occupy(std::move(*old_slot.key()), hash, std::move(*old_slot.value()));
-        return;
-      }
-    }
-    SLOT_PROBING_END();
+    const int64_t slot_index = find_empty_slot_index(
+        new_slots, new_control_bytes, new_slot_mask, hash);
+    new_slots[slot_index].occupy(std::move(*old_slot.key()), hash, std::move(*old_slot.value()));
+    new_control_bytes.occupy(slot_index, hash);
   }
 
   void noexcept_reset() noexcept
@@ -1084,6 +1095,60 @@ class Map {
     new (this) Map(NoExceptConstructor(), allocator);
   }
 
+  /**
+   * Find the first slot in the probing sequence of the hash that is empty or for which the
+   * predicate is true. The predicate is only called for occupied slots.
+   */
+  template<typename IsMatchF>
+  int64_t find_slot_index(const uint64_t hash, const IsMatchF &is_match) const
+  {
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      return control_bytes_.find_match_or_empty(
+          hash, [&](const int64_t slot_index) { return is_match(slots_[slot_index]); });
+    }
+    else {
+      MAP_SLOT_PROBING_BEGIN (hash, slot) {
+        if (slot.is_empty() || is_match(slot)) {
+          return SLOT_INDEX;
+        }
+      }
+      MAP_SLOT_PROBING_END();
+    }
+  }
+
+  template<typename ForwardKey>
+  int64_t find_key_slot_index(const ForwardKey &key, const uint64_t hash) const
+  {
+    return this->find_slot_index(
+        hash, [&](const Slot &slot) { return slot.contains(key, is_equal_, hash); });
+  }
+
+  /** Find the slot where a new key with the given hash has to be added. */
+  static int64_t find_empty_slot_index(const SlotArray &slots,
+                                       const ControlBytes &control_bytes,
+                                       const uint64_t slot_mask,
+                                       const uint64_t hash)
+  {
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      return control_bytes.find_empty(hash);
+    }
+    else {
+      SLOT_PROBING_BEGIN (ProbingStrategy, hash, slot_mask, slot_index) {
+        if (slots[slot_index].is_empty()) {
+          return slot_index;
+        }
+      }
+      SLOT_PROBING_END();
+    }
+  }
+
+  void remove_slot(Slot &slot)
+  {
+    slot.remove();
+    control_bytes_.remove(&slot - slots_.data());
+    removed_slots_++;
+  }
+
   template<typename ForwardKey, typename... ForwardValue>
   void add_new__impl(ForwardKey &&key, uint64_t hash, ForwardValue &&...value)
   {
@@ -1091,14 +1156,11 @@ class Map {
 
     this->ensure_can_add();
 
-    MAP_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.is_empty()) {
-        slot.occupy(std::forward<ForwardKey>(key), hash, std::forward<ForwardValue>(value)...);
-        occupied_and_removed_slots_++;
-        return;
-      }
-    }
-    MAP_SLOT_PROBING_END();
+    const int64_t slot_index = find_empty_slot_index(slots_, control_bytes_, slot_mask_, hash);
+    slots_[slot_index].occupy(
+        std::forward<ForwardKey>(key), hash, std::forward<ForwardValue>(value)...);
+    control_bytes_.occupy(slot_index, hash);
+    occupied_and_removed_slots_++;
   }
 
   template<typename ForwardKey, typename... ForwardValue>
@@ -1106,17 +1168,15 @@ class Map {
   {
     this->ensure_can_add();
 
-    MAP_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.is_empty()) {
-        slot.occupy(std::forward<ForwardKey>(key), hash, std::forward<ForwardValue>(value)...);
-        occupied_and_removed_slots_++;
-        return true;
-      }
-      if (slot.contains(key, is_equal_, hash)) {
-        return false;
-      }
+    const int64_t slot_index = this->find_key_slot_index(key, hash);
+    Slot &slot = slots_[slot_index];
+    if (slot.is_empty()) {
+      slot.occupy(std::forward<ForwardKey>(key), hash, std::forward<ForwardValue>(value)...);
+      control_bytes_.occupy(slot_index, hash);
+      occupied_and_removed_slots_++;
+      return true;
     }
-    MAP_SLOT_PROBING_END();
+    return false;
   }
 
   template<typename ForwardKey, typename CreateValueF, typename ModifyValueF>
@@ -1132,28 +1192,27 @@ class Map {
 
     this->ensure_can_add();
 
-    MAP_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.is_empty()) {
-        Value *value_ptr = slot.value();
-        if constexpr (std::is_void_v<CreateReturnT>) {
-          create_value(value_ptr);
-          slot.occupy_no_value(std::forward<ForwardKey>(key), hash);
-          occupied_and_removed_slots_++;
-          return;
-        }
-        else {
-          auto &&return_value = create_value(value_ptr);
-          slot.occupy_no_value(std::forward<ForwardKey>(key), hash);
-          occupied_and_removed_slots_++;
-          return return_value;
-        }
+    const int64_t slot_index = this->find_key_slot_index(key, hash);
+    Slot &slot = slots_[slot_index];
+    if (slot.is_empty()) {
+      Value *value_ptr = slot.value();
+      if constexpr (std::is_void_v<CreateReturnT>) {
+        create_value(value_ptr);
+        slot.occupy_no_value(std::forward<ForwardKey>(key), hash);
+        control_bytes_.occupy(slot_index, hash);
+        occupied_and_removed_slots_++;
+        return;
       }
-      if (slot.contains(key, is_equal_, hash)) {
-        Value *value_ptr = slot.value();
-        return modify_value(value_ptr);
+      else {
+        auto &&return_value = create_value(value_ptr);
+        slot.occupy_no_value(std::forward<ForwardKey>(key), hash);
+        control_bytes_.occupy(slot_index, hash);
+        occupied_and_removed_slots_++;
+        return return_value;
       }
     }
-    MAP_SLOT_PROBING_END();
+    Value *value_ptr = slot.value();
+    return modify_value(value_ptr);
   }
 
   template<typename ForwardKey, typename CreateValueF>
@@ -1161,17 +1220,14 @@ class Map {
   {
     this->ensure_can_add();
 
-    MAP_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.is_empty()) {
-        slot.occupy(std::forward<ForwardKey>(key), hash, create_value());
-        occupied_and_removed_slots_++;
-        return *slot.value();
-      }
-      if (slot.contains(key, is_equal_, hash)) {
-        return *slot.value();
-      }
+    const int64_t slot_index = this->find_key_slot_index(key, hash);
+    Slot &slot = slots_[slot_index];
+    if (slot.is_empty()) {
+      slot.occupy(std::forward<ForwardKey>(key), hash, create_value());
+      control_bytes_.occupy(slot_index, hash);
+      occupied_and_removed_slots_++;
     }
-    MAP_SLOT_PROBING_END();
+    return *slot.value();
   }
 
   template<typename ForwardKey, typename... ForwardValue>
@@ -1179,17 +1235,14 @@ class Map {
   {
     this->ensure_can_add();
 
-    MAP_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.is_empty()) {
-        slot.occupy(std::forward<ForwardKey>(key), hash, std::forward<ForwardValue>(value)...);
-        occupied_and_removed_slots_++;
-        return *slot.value();
-      }
-      if (slot.contains(key, is_equal_, hash)) {
-        return *slot.value();
-      }
+    const int64_t slot_index = this->find_key_slot_index(key, hash);
+    Slot &slot = slots_[slot_index];
+    if (slot.is_empty()) {
+      slot.occupy(std::forward<ForwardKey>(key), hash, std::forward<ForwardValue>(value)...);
+      control_bytes_.occupy(slot_index, hash);
+      occupied_and_removed_slots_++;
     }
-    MAP_SLOT_PROBING_END();
+    return *slot.value();
   }
 
   template<typename ForwardKey, typename... ForwardValue>
@@ -1211,12 +1264,7 @@ class Map {
   const Slot &lookup_slot(const ForwardKey &key, const uint64_t hash) const
   {
     BLI_assert(this->contains_as(key));
-    MAP_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash)) {
-        return slot;
-      }
-    }
-    MAP_SLOT_PROBING_END();
+    return *this->lookup_slot_ptr(key, hash);
   }
 
   template<typename ForwardKey> Slot &lookup_slot(const ForwardKey &key, const uint64_t hash)
@@ -1227,15 +1275,12 @@ class Map {
   template<typename ForwardKey>
   const Slot *lookup_slot_ptr(const ForwardKey &key, const uint64_t hash) const
   {
-    MAP_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash)) {
-        return &slot;
-      }
-      if (slot.is_empty()) {
-        return nullptr;
-      }
+    const int64_t slot_index = this->find_key_slot_index(key, hash);
+    const Slot &slot = slots_[slot_index];
+    if (slot.is_empty()) {
+      return nullptr;
     }
-    MAP_SLOT_PROBING_END();
+    return &slot;
   }
 
   template<typename ForwardKey> Slot *lookup_slot_ptr(const ForwardKey &key, const uint64_t hash)
@@ -1246,18 +1291,25 @@ class Map {
   template<typename ForwardKey>
   int64_t count_collisions__impl(const ForwardKey &key, uint64_t hash) const
   {
-    int64_t collisions = 0;
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      return control_bytes_.count_collisions(hash, [&](const int64_t slot_index) {
+        return slots_[slot_index].contains(key, is_equal_, hash);
+      });
+    }
+    else {
+      int64_t collisions = 0;
 
-    MAP_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash)) {
-        return collisions;
-      }
-      if (slot.is_empty()) {
-        return collisions;
+      MAP_SLOT_PROBING_BEGIN (hash, slot) {
+        if (slot.contains(key, is_equal_, hash)) {
+          return collisions;
+        }
+        if (slot.is_empty()) {
+          return collisions;
+        }
+        collisions++;
       }
-      collisions++;
+      MAP_SLOT_PROBING_END();
     }
-    MAP_SLOT_PROBING_END();
   }
 
   void ensure_can_add()
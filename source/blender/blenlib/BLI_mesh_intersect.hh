@@ -43,12 +43,16 @@ constexpr int NO_INDEX = -1;
  * the algorithm and doesn't match an original Vert.
  * Vertices can be reliably compared for equality,
  * and hashed (on their co_exact field).
+ * Input vertices usually have coordinates that are exactly representable as doubles,
+ * which allows using adaptive precision predicates on the double3 version.
  */
 struct Vert {
   mpq3 co_exact;
   double3 co;
   int id = NO_INDEX;
   int orig = NO_INDEX;
+  /** True if co is exactly the same as co_exact. */
+  bool co_is_exact = false;
 
   Vert() = default;
   Vert(const mpq3 &mco, const double3 &dco, int id, int orig);
@@ -387,6 +391,13 @@ struct BoundingBox {
  */
 bool bbs_might_intersect(const BoundingBox &bb_a, const BoundingBox &bb_b);
 
+/**
+ * Same as the #orient3d of #BLI_math_boolean.hh on the exact coordinates of the vertices.
+ * Double arithmetic is used whenever it gives the exact answer, falling back to multi-precision
+ * arithmetic only when the sign can not be determined otherwise.
+ */
+int orient3d_filtered(const Vert *a, const Vert *b, const Vert *c, const Vert *d);
+
 /**
  * This is the main routine for calculating the self_intersection of a triangle mesh.
  *
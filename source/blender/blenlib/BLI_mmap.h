@@ -26,6 +26,11 @@ typedef struct BLI_mmap_file BLI_mmap_file;
  * Note that this seeks to the end of the file to determine its length. */
 BLI_mmap_file *BLI_mmap_open(int fd) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
 
+/* Same as #BLI_mmap_open, but the mapped memory is also writable. Changes are private to the
+ * process and are never written back to the file, so the memory can be handed to code that
+ * expects to own (and possibly modify) the data. */
+BLI_mmap_file *BLI_mmap_open_copy_on_write(int fd) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+
 /* Reads length bytes from file at the given offset into dest.
  * Returns whether the operation was successful (may fail when reading beyond the file
  * end or when IO errors occur). */
@@ -34,6 +39,14 @@ bool BLI_mmap_read(BLI_mmap_file *file, void *dest, size_t offset, size_t length
 
 void *BLI_mmap_get_pointer(BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT;
 
+/* Returns the length of the mapped region, which is the size of the file. */
+size_t BLI_mmap_get_length(const BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+
+/* Returns whether an IO error happened while accessing the mapped memory. After an error the
+ * whole mapping reads as zeroes, so any data accessed through #BLI_mmap_get_pointer since then
+ * can't be trusted. */
+bool BLI_mmap_any_io_error(const BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+
 void BLI_mmap_free(BLI_mmap_file *file) ATTR_NONNULL(1);
 
 #ifdef __cplusplus
@@ -195,6 +195,48 @@ template<uint64_t LinearSteps = 2, bool PreShuffle = false> class ShuffleProbing
   }
 };
 
+/**
+ * Probing strategy for hash tables that use control bytes to check a group of slots at once,
+ * similar to "Swiss tables". See #HashTableControlBytes for details. When used with #Map, #Set or
+ * #VectorSet, the values produced by this strategy are group indices instead of slot indices.
+ *
+ * The hash is mixed first, because the lower bits are used to find the first group and the upper
+ * bits are stored in the control bytes. The groups are probed with triangular numbers as offsets,
+ * which visits every group when the number of groups is a power of two.
+ */
+class GroupProbingStrategy {
+ private:
+  uint64_t hash_;
+  uint64_t offset_ = 0;
+
+ public:
+  /** Number of slots that are checked at once. */
+  static constexpr int64_t group_size = 16;
+
+  GroupProbingStrategy(const uint64_t hash) : hash_(mix_hash(hash) >> 32) {}
+
+  void next()
+  {
+    offset_++;
+    hash_ += offset_;
+  }
+
+  uint64_t get() const
+  {
+    return hash_;
+  }
+
+  int64_t linear_steps() const
+  {
+    return 1;
+  }
+
+  static uint64_t mix_hash(const uint64_t hash)
+  {
+    return hash * 0x9E3779B97F4A7C15u;
+  }
+};
+
 /**
  * Having a specified default is convenient.
  */
@@ -32,6 +32,9 @@
  * - Pointers to keys might be invalidated when the set is changed or moved.
  * - The hash function can be customized. See BLI_hash.hh for details.
  * - The probing strategy can be customized. See BLI_probing_stragies.hh for details.
+ * - Using #GroupProbingStrategy stores an additional control byte per slot, which makes lookups
+ *   faster when there are many collisions or comparing keys is expensive. See
+ *   BLI_hash_table_control_bytes.hh for details.
  * - The slot type can be customized. See BLI_set_slots.hh for details.
  * - Small buffer optimization is enabled by default, if the key is not too large.
  * - The methods `add_new` and `remove_contained` should be used instead of `add` and `remove`
@@ -57,6 +60,7 @@
 
 #include "BLI_array.hh"
 #include "BLI_hash.hh"
+#include "BLI_hash_table_control_bytes.hh"
 #include "BLI_hash_tables.hh"
 #include "BLI_probing_strategies.hh"
 #include "BLI_set_slots.hh"
@@ -145,6 +149,10 @@ class Set {
   LoadFactor max_load_factor_ = LoadFactor(LOAD_FACTOR);
   using SlotArray =
       Array<Slot, LoadFactor::compute_total_slots(InlineBufferCapacity, LOAD_FACTOR), Allocator>;
+  using ControlBytes =
+      HashTableControlBytesFor<ProbingStrategy,
+                               LoadFactor::compute_total_slots(InlineBufferCapacity, LOAD_FACTOR),
+                               Allocator>;
 #undef LOAD_FACTOR
 
   /**
@@ -153,6 +161,9 @@ class Set {
    */
   SlotArray slots_;
 
+  /** Only stores data when #GroupProbingStrategy is used. It is kept in sync with the slots. */
+  BLI_NO_UNIQUE_ADDRESS ControlBytes control_bytes_;
+
   /** Iterate over a slot index sequence for a given hash. */
 #define SET_SLOT_PROBING_BEGIN(HASH, R_SLOT) \
   SLOT_PROBING_BEGIN (ProbingStrategy, HASH, slot_mask_, SLOT_INDEX) \
@@ -170,7 +181,8 @@ class Set {
         occupied_and_removed_slots_(0),
         usable_slots_(0),
         slot_mask_(0),
-        slots_(1, allocator)
+        slots_(1, allocator),
+        control_bytes_(allocator)
   {
   }
 
@@ -196,10 +208,12 @@ class Set {
   {
     if constexpr (std::is_nothrow_move_constructible_v<SlotArray>) {
       slots_ = std::move(other.slots_);
+      control_bytes_ = std::move(other.control_bytes_);
     }
     else {
       try {
         slots_ = std::move(other.slots_);
+        control_bytes_ = std::move(other.control_bytes_);
       }
       catch (...) {
         other.noexcept_reset();
@@ -483,8 +497,7 @@ class Set {
     /* The const cast is valid because this method itself is not const. */
     Slot &slot = const_cast<Slot &>(it.current_slot());
     BLI_assert(slot.is_occupied());
-    slot.remove();
-    removed_slots_++;
+    this->remove_slot(slot);
   }
 
   /**
@@ -500,8 +513,7 @@ class Set {
       if (slot.is_occupied()) {
         const Key &key = *slot.key();
         if (predicate(key)) {
-          slot.remove();
-          removed_slots_++;
+          this->remove_slot(slot);
         }
       }
     }
@@ -535,6 +547,7 @@ class Set {
       slot.~Slot();
       new (&slot) Slot();
     }
+    control_bytes_.reinitialize(slots_.size());
 
     removed_slots_ = 0;
     occupied_and_removed_slots_ = 0;
@@ -604,7 +617,7 @@ class Set {
    */
   int64_t size_in_bytes() const
   {
-    return sizeof(Slot) * slots_.size();
+    return sizeof(Slot) * slots_.size() + control_bytes_.size_in_bytes();
   }
 
   /**
@@ -677,6 +690,7 @@ class Set {
     if (this->size() == 0) {
       try {
         slots_.reinitialize(total_slots);
+        control_bytes_.reinitialize(total_slots);
       }
       catch (...) {
         this->noexcept_reset();
@@ -693,13 +707,16 @@ class Set {
     SlotArray new_slots(total_slots);
 
     try {
+      ControlBytes new_control_bytes(slots_.allocator());
+      new_control_bytes.reinitialize(total_slots);
       for (Slot &slot : slots_) {
         if (slot.is_occupied()) {
-          this->add_after_grow(slot, new_slots, new_slot_mask);
+          this->add_after_grow(slot, new_slots, new_control_bytes, new_slot_mask);
           slot.remove();
         }
       }
       slots_ = std::move(new_slots);
+      control_bytes_ = std::move(new_control_bytes);
     }
     catch (...) {
       this->noexcept_reset();
@@ -712,18 +729,16 @@ class Set {
     slot_mask_ = new_slot_mask;
   }
 
-  void add_after_grow(Slot &old_slot, SlotArray &new_slots, const uint64_t new_slot_mask)
+  void add_after_grow(Slot &old_slot,
+                      SlotArray &new_slots,
+                      ControlBytes &new_control_bytes,
+                      const uint64_t new_slot_mask)
   {
     const uint64_t hash = old_slot.get_hash(Hash());
-
-    SLOT_PROBING_BEGIN (ProbingStrategy, hash, new_slot_mask, slot_index) {
-      Slot &slot = new_slots[slot_index];
-      if (slot.is_empty()) {
-        slot.occupy(std::move(*old_slot.key()), hash);
-        return;
-      }
-    }
-    SLOT_PROBING_END();
+    const int64_t slot_index = find_empty_slot_index(
+        new_slots, new_control_bytes, new_slot_mask, hash);
+    new_slots[slot_index].occupy(std::move(*old_slot.key()), hash);
+    new_control_bytes.occupy(slot_index, hash);
   }
 
   /**
@@ -737,45 +752,81 @@ class Set {
     new (this) Set(NoExceptConstructor(), allocator);
   }
 
-  template<typename ForwardKey>
-  bool contains__impl(const ForwardKey &key, const uint64_t hash) const
+  /**
+   * Find the first slot in the probing sequence of the hash that is empty or for which the
+   * predicate is true. The predicate is only called for occupied slots.
+   */
+  template<typename IsMatchF>
+  int64_t find_slot_index(const uint64_t hash, const IsMatchF &is_match) const
   {
-    SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.is_empty()) {
-        return false;
-      }
-      if (slot.contains(key, is_equal_, hash)) {
-        return true;
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      return control_bytes_.find_match_or_empty(
+          hash, [&](const int64_t slot_index) { return is_match(slots_[slot_index]); });
+    }
+    else {
+      SET_SLOT_PROBING_BEGIN (hash, slot) {
+        if (slot.is_empty() || is_match(slot)) {
+          return SLOT_INDEX;
+        }
       }
+      SET_SLOT_PROBING_END();
     }
-    SET_SLOT_PROBING_END();
   }
 
   template<typename ForwardKey>
-  const Key &lookup_key__impl(const ForwardKey &key, const uint64_t hash) const
+  int64_t find_key_slot_index(const ForwardKey &key, const uint64_t hash) const
   {
-    BLI_assert(this->contains_as(key));
+    return this->find_slot_index(
+        hash, [&](const Slot &slot) { return slot.contains(key, is_equal_, hash); });
+  }
 
-    SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash)) {
-        return *slot.key();
+  /** Find the slot where a new key with the given hash has to be added. */
+  static int64_t find_empty_slot_index(const SlotArray &slots,
+                                       const ControlBytes &control_bytes,
+                                       const uint64_t slot_mask,
+                                       const uint64_t hash)
+  {
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      return control_bytes.find_empty(hash);
+    }
+    else {
+      SLOT_PROBING_BEGIN (ProbingStrategy, hash, slot_mask, slot_index) {
+        if (slots[slot_index].is_empty()) {
+          return slot_index;
+        }
       }
+      SLOT_PROBING_END();
     }
-    SET_SLOT_PROBING_END();
+  }
+
+  void remove_slot(Slot &slot)
+  {
+    slot.remove();
+    control_bytes_.remove(&slot - slots_.data());
+    removed_slots_++;
+  }
+
+  template<typename ForwardKey>
+  bool contains__impl(const ForwardKey &key, const uint64_t hash) const
+  {
+    return !slots_[this->find_key_slot_index(key, hash)].is_empty();
+  }
+
+  template<typename ForwardKey>
+  const Key &lookup_key__impl(const ForwardKey &key, const uint64_t hash) const
+  {
+    BLI_assert(this->contains_as(key));
+    return *slots_[this->find_key_slot_index(key, hash)].key();
   }
 
   template<typename ForwardKey>
   const Key *lookup_key_ptr__impl(const ForwardKey &key, const uint64_t hash) const
   {
-    SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash)) {
-        return slot.key();
-      }
-      if (slot.is_empty()) {
-        return nullptr;
-      }
+    const Slot &slot = slots_[this->find_key_slot_index(key, hash)];
+    if (slot.is_empty()) {
+      return nullptr;
     }
-    SET_SLOT_PROBING_END();
+    return slot.key();
   }
 
   template<typename ForwardKey> void add_new__impl(ForwardKey &&key, const uint64_t hash)
@@ -784,61 +835,42 @@ class Set {
 
     this->ensure_can_add();
 
-    SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.is_empty()) {
-        slot.occupy(std::forward<ForwardKey>(key), hash);
-        occupied_and_removed_slots_++;
-        return;
-      }
-    }
-    SET_SLOT_PROBING_END();
+    const int64_t slot_index = find_empty_slot_index(slots_, control_bytes_, slot_mask_, hash);
+    slots_[slot_index].occupy(std::forward<ForwardKey>(key), hash);
+    control_bytes_.occupy(slot_index, hash);
+    occupied_and_removed_slots_++;
   }
 
   template<typename ForwardKey> bool add__impl(ForwardKey &&key, const uint64_t hash)
   {
     this->ensure_can_add();
 
-    SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.is_empty()) {
-        slot.occupy(std::forward<ForwardKey>(key), hash);
-        occupied_and_removed_slots_++;
-        return true;
-      }
-      if (slot.contains(key, is_equal_, hash)) {
-        return false;
-      }
+    const int64_t slot_index = this->find_key_slot_index(key, hash);
+    Slot &slot = slots_[slot_index];
+    if (slot.is_empty()) {
+      slot.occupy(std::forward<ForwardKey>(key), hash);
+      control_bytes_.occupy(slot_index, hash);
+      occupied_and_removed_slots_++;
+      return true;
     }
-    SET_SLOT_PROBING_END();
+    return false;
   }
 
   template<typename ForwardKey> bool remove__impl(const ForwardKey &key, const uint64_t hash)
   {
-    SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash)) {
-        slot.remove();
-        removed_slots_++;
-        return true;
-      }
-      if (slot.is_empty()) {
-        return false;
-      }
+    Slot &slot = slots_[this->find_key_slot_index(key, hash)];
+    if (slot.is_empty()) {
+      return false;
     }
-    SET_SLOT_PROBING_END();
+    this->remove_slot(slot);
+    return true;
   }
 
   template<typename ForwardKey>
   void remove_contained__impl(const ForwardKey &key, const uint64_t hash)
   {
     BLI_assert(this->contains_as(key));
-
-    SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash)) {
-        slot.remove();
-        removed_slots_++;
-        return;
-      }
-    }
-    SET_SLOT_PROBING_END();
+    this->remove_slot(slots_[this->find_key_slot_index(key, hash)]);
   }
 
   template<typename ForwardKey>
@@ -846,34 +878,38 @@ class Set {
   {
     this->ensure_can_add();
 
-    SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash)) {
-        return *slot.key();
-      }
-      if (slot.is_empty()) {
-        slot.occupy(std::forward<ForwardKey>(key), hash);
-        occupied_and_removed_slots_++;
-        return *slot.key();
-      }
+    const int64_t slot_index = this->find_key_slot_index(key, hash);
+    Slot &slot = slots_[slot_index];
+    if (slot.is_empty()) {
+      slot.occupy(std::forward<ForwardKey>(key), hash);
+      control_bytes_.occupy(slot_index, hash);
+      occupied_and_removed_slots_++;
     }
-    SET_SLOT_PROBING_END();
+    return *slot.key();
   }
 
   template<typename ForwardKey>
   int64_t count_collisions__impl(const ForwardKey &key, const uint64_t hash) const
   {
-    int64_t collisions = 0;
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      return control_bytes_.count_collisions(hash, [&](const int64_t slot_index) {
+        return slots_[slot_index].contains(key, is_equal_, hash);
+      });
+    }
+    else {
+      int64_t collisions = 0;
 
-    SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash)) {
-        return collisions;
-      }
-      if (slot.is_empty()) {
-        return collisions;
+      SET_SLOT_PROBING_BEGIN (hash, slot) {
+        if (slot.contains(key, is_equal_, hash)) {
+          return collisions;
+        }
+        if (slot.is_empty()) {
+          return collisions;
+        }
+        collisions++;
       }
-      collisions++;
+      SET_SLOT_PROBING_END();
     }
-    SET_SLOT_PROBING_END();
   }
 
   void ensure_can_add()
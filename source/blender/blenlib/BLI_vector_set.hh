@@ -31,6 +31,9 @@
  * - Pointers to keys might be invalidated, when the vector set is changed or moved.
  * - The hash function can be customized. See BLI_hash.hh for details.
  * - The probing strategy can be customized. See BLI_probing_strategies.hh for details.
+ * - Using #GroupProbingStrategy stores an additional control byte per slot, which makes lookups
+ *   faster when there are many collisions or comparing keys is expensive. See
+ *   BLI_hash_table_control_bytes.hh for details.
  * - The slot type can be customized. See BLI_vector_set_slots.hh for details.
  * - The methods `add_new` and `remove_contained` should be used instead of `add` and `remove`
  *   whenever appropriate. Assumptions and intention are described better this way.
@@ -49,6 +52,7 @@
 
 #include "BLI_array.hh"
 #include "BLI_hash.hh"
+#include "BLI_hash_table_control_bytes.hh"
 #include "BLI_hash_tables.hh"
 #include "BLI_probing_strategies.hh"
 #include "BLI_vector_set_slots.hh"
@@ -128,6 +132,9 @@ class VectorSet {
 #define LOAD_FACTOR 1, 2
   LoadFactor max_load_factor_ = LoadFactor(LOAD_FACTOR);
   using SlotArray = Array<Slot, LoadFactor::compute_total_slots(4, LOAD_FACTOR), Allocator>;
+  using ControlBytes = HashTableControlBytesFor<ProbingStrategy,
+                                                LoadFactor::compute_total_slots(4, LOAD_FACTOR),
+                                                Allocator>;
 #undef LOAD_FACTOR
 
   /**
@@ -136,6 +143,9 @@ class VectorSet {
    */
   SlotArray slots_;
 
+  /** Only stores data when #GroupProbingStrategy is used. It is kept in sync with the slots. */
+  BLI_NO_UNIQUE_ADDRESS ControlBytes control_bytes_;
+
   /**
    * Pointer to an array that contains all keys. The keys are sorted by insertion order as long as
    * no keys are removed. The first set->size() elements in this array are initialized. The
@@ -161,6 +171,7 @@ class VectorSet {
         usable_slots_(0),
         slot_mask_(0),
         slots_(1, allocator),
+        control_bytes_(allocator),
         keys_(nullptr)
   {
   }
@@ -188,7 +199,7 @@ class VectorSet {
     }
   }
 
-  VectorSet(const VectorSet &other) : slots_(other.slots_)
+  VectorSet(const VectorSet &other) : slots_(other.slots_), control_bytes_(other.control_bytes_)
   {
     keys_ = this->allocate_keys_array(other.usable_slots_);
     try {
@@ -213,6 +224,7 @@ class VectorSet {
         usable_slots_(other.usable_slots_),
         slot_mask_(other.slot_mask_),
         slots_(std::move(other.slots_)),
+        control_bytes_(std::move(other.control_bytes_)),
         keys_(other.keys_)
   {
     other.removed_slots_ = 0;
@@ -220,6 +232,7 @@ class VectorSet {
     other.usable_slots_ = 0;
     other.slot_mask_ = 0;
     other.slots_ = SlotArray(1);
+    other.control_bytes_.reinitialize(1);
     other.keys_ = nullptr;
   }
 
@@ -534,7 +547,8 @@ class VectorSet {
    */
   int64_t size_in_bytes() const
   {
-    return int64_t(sizeof(Slot) * slots_.size() + sizeof(Key) * usable_slots_);
+    return int64_t(sizeof(Slot) * slots_.size() + sizeof(Key) * usable_slots_) +
+           control_bytes_.size_in_bytes();
   }
 
   /**
@@ -557,6 +571,7 @@ class VectorSet {
       slot.~Slot();
       new (&slot) Slot();
     }
+    control_bytes_.reinitialize(slots_.size());
 
     removed_slots_ = 0;
     occupied_and_removed_slots_ = 0;
@@ -593,6 +608,7 @@ class VectorSet {
     if (this->size() == 0) {
       try {
         slots_.reinitialize(total_slots);
+        control_bytes_.reinitialize(total_slots);
         if (keys_ != nullptr) {
           this->deallocate_keys_array(keys_);
           keys_ = nullptr;
@@ -613,13 +629,16 @@ class VectorSet {
     SlotArray new_slots(total_slots);
 
     try {
+      ControlBytes new_control_bytes(slots_.allocator());
+      new_control_bytes.reinitialize(total_slots);
       for (Slot &slot : slots_) {
         if (slot.is_occupied()) {
-          this->add_after_grow(slot, new_slots, new_slot_mask);
+          this->add_after_grow(slot, new_slots, new_control_bytes, new_slot_mask);
           slot.remove();
         }
       }
       slots_ = std::move(new_slots);
+      control_bytes_ = std::move(new_control_bytes);
     }
     catch (...) {
       this->noexcept_reset();
@@ -644,19 +663,17 @@ class VectorSet {
     slot_mask_ = new_slot_mask;
   }
 
-  void add_after_grow(Slot &old_slot, SlotArray &new_slots, const uint64_t new_slot_mask)
+  void add_after_grow(Slot &old_slot,
+                      SlotArray &new_slots,
+                      ControlBytes &new_control_bytes,
+                      const uint64_t new_slot_mask)
   {
     const Key &key = keys_[old_slot.index()];
     const uint64_t hash = old_slot.get_hash(key, Hash());
-
-    SLOT_PROBING_BEGIN (ProbingStrategy, hash, new_slot_mask, slot_index) {
-      Slot &slot = new_slots[slot_index];
-      if (slot.is_empty()) {
-        slot.occupy(old_slot.index(), hash);
-        return;
-      }
-    }
-    SLOT_PROBING_END();
+    const int64_t slot_index = find_empty_slot_index(
+        new_slots, new_control_bytes, new_slot_mask, hash);
+    new_slots[slot_index].occupy(old_slot.index(), hash);
+    new_control_bytes.occupy(slot_index, hash);
   }
 
   void noexcept_reset() noexcept
@@ -666,18 +683,66 @@ class VectorSet {
     new (this) VectorSet(NoExceptConstructor(), allocator);
   }
 
-  template<typename ForwardKey>
-  bool contains__impl(const ForwardKey &key, const uint64_t hash) const
+  /**
+   * Find the first slot in the probing sequence of the hash that is empty or for which the
+   * predicate is true. The predicate is only called for occupied slots.
+   */
+  template<typename IsMatchF>
+  int64_t find_slot_index(const uint64_t hash, const IsMatchF &is_match) const
   {
-    VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.is_empty()) {
-        return false;
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      return control_bytes_.find_match_or_empty(
+          hash, [&](const int64_t slot_index) { return is_match(slots_[slot_index]); });
+    }
+    else {
+      VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
+        if (slot.is_empty() || is_match(slot)) {
+          return SLOT_INDEX;
+        }
       }
-      if (slot.contains(key, is_equal_, hash, keys_)) {
-        return true;
+      VECTOR_SET_SLOT_PROBING_END();
+    }
+  }
+
+  template<typename ForwardKey>
+  int64_t find_key_slot_index(const ForwardKey &key, const uint64_t hash) const
+  {
+    return this->find_slot_index(
+        hash, [&](const Slot &slot) { return slot.contains(key, is_equal_, hash, keys_); });
+  }
+
+  /** Find the slot that references the key at the given index. The key has the given hash. */
+  int64_t find_index_slot_index(const int64_t index, const uint64_t hash) const
+  {
+    const int64_t slot_index = this->find_slot_index(
+        hash, [&](const Slot &slot) { return slot.has_index(index); });
+    BLI_assert(slots_[slot_index].has_index(index));
+    return slot_index;
+  }
+
+  /** Find the slot where a new key with the given hash has to be added. */
+  static int64_t find_empty_slot_index(const SlotArray &slots,
+                                       const ControlBytes &control_bytes,
+                                       const uint64_t slot_mask,
+                                       const uint64_t hash)
+  {
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      return control_bytes.find_empty(hash);
+    }
+    else {
+      SLOT_PROBING_BEGIN (ProbingStrategy, hash, slot_mask, slot_index) {
+        if (slots[slot_index].is_empty()) {
+          return slot_index;
+        }
       }
+      SLOT_PROBING_END();
     }
-    VECTOR_SET_SLOT_PROBING_END();
+  }
+
+  template<typename ForwardKey>
+  bool contains__impl(const ForwardKey &key, const uint64_t hash) const
+  {
+    return !slots_[this->find_key_slot_index(key, hash)].is_empty();
   }
 
   template<typename ForwardKey> void add_new__impl(ForwardKey &&key, const uint64_t hash)
@@ -686,62 +751,46 @@ class VectorSet {
 
     this->ensure_can_add();
 
-    VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.is_empty()) {
-        int64_t index = this->size();
-        new (keys_ + index) Key(std::forward<ForwardKey>(key));
-        slot.occupy(index, hash);
-        occupied_and_removed_slots_++;
-        return;
-      }
-    }
-    VECTOR_SET_SLOT_PROBING_END();
+    const int64_t slot_index = find_empty_slot_index(slots_, control_bytes_, slot_mask_, hash);
+    int64_t index = this->size();
+    new (keys_ + index) Key(std::forward<ForwardKey>(key));
+    slots_[slot_index].occupy(index, hash);
+    control_bytes_.occupy(slot_index, hash);
+    occupied_and_removed_slots_++;
   }
 
   template<typename ForwardKey> bool add__impl(ForwardKey &&key, const uint64_t hash)
   {
     this->ensure_can_add();
 
-    VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.is_empty()) {
-        int64_t index = this->size();
-        new (keys_ + index) Key(std::forward<ForwardKey>(key));
-        slot.occupy(index, hash);
-        occupied_and_removed_slots_++;
-        return true;
-      }
-      if (slot.contains(key, is_equal_, hash, keys_)) {
-        return false;
-      }
+    const int64_t slot_index = this->find_key_slot_index(key, hash);
+    Slot &slot = slots_[slot_index];
+    if (slot.is_empty()) {
+      int64_t index = this->size();
+      new (keys_ + index) Key(std::forward<ForwardKey>(key));
+      slot.occupy(index, hash);
+      control_bytes_.occupy(slot_index, hash);
+      occupied_and_removed_slots_++;
+      return true;
     }
-    VECTOR_SET_SLOT_PROBING_END();
+    return false;
   }
 
   template<typename ForwardKey>
   int64_t index_of__impl(const ForwardKey &key, const uint64_t hash) const
   {
     BLI_assert(this->contains_as(key));
-
-    VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash, keys_)) {
-        return slot.index();
-      }
-    }
-    VECTOR_SET_SLOT_PROBING_END();
+    return slots_[this->find_key_slot_index(key, hash)].index();
   }
 
   template<typename ForwardKey>
   int64_t index_of_try__impl(const ForwardKey &key, const uint64_t hash) const
   {
-    VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash, keys_)) {
-        return slot.index();
-      }
-      if (slot.is_empty()) {
-        return -1;
-      }
+    const Slot &slot = slots_[this->find_key_slot_index(key, hash)];
+    if (slot.is_empty()) {
+      return -1;
     }
-    VECTOR_SET_SLOT_PROBING_END();
+    return slot.index();
   }
 
   template<typename ForwardKey>
@@ -749,19 +798,17 @@ class VectorSet {
   {
     this->ensure_can_add();
 
-    VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash, keys_)) {
-        return slot.index();
-      }
-      if (slot.is_empty()) {
-        const int64_t index = this->size();
-        new (keys_ + index) Key(std::forward<ForwardKey>(key));
-        slot.occupy(index, hash);
-        occupied_and_removed_slots_++;
-        return index;
-      }
+    const int64_t slot_index = this->find_key_slot_index(key, hash);
+    Slot &slot = slots_[slot_index];
+    if (slot.is_empty()) {
+      const int64_t index = this->size();
+      new (keys_ + index) Key(std::forward<ForwardKey>(key));
+      slot.occupy(index, hash);
+      control_bytes_.occupy(slot_index, hash);
+      occupied_and_removed_slots_++;
+      return index;
     }
-    VECTOR_SET_SLOT_PROBING_END();
+    return slot.index();
   }
 
   Key pop__impl()
@@ -773,43 +820,28 @@ class VectorSet {
     keys_[index_to_pop].~Key();
     const uint64_t hash = hash_(key);
 
+    const int64_t slot_index = this->find_index_slot_index(index_to_pop, hash);
+    slots_[slot_index].remove();
+    control_bytes_.remove(slot_index);
     removed_slots_++;
-
-    VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.has_index(index_to_pop)) {
-        slot.remove();
-        return key;
-      }
-    }
-    VECTOR_SET_SLOT_PROBING_END();
+    return key;
   }
 
   template<typename ForwardKey> bool remove__impl(const ForwardKey &key, const uint64_t hash)
   {
-    VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash, keys_)) {
-        this->remove_key_internal(slot);
-        return true;
-      }
-      if (slot.is_empty()) {
-        return false;
-      }
+    Slot &slot = slots_[this->find_key_slot_index(key, hash)];
+    if (slot.is_empty()) {
+      return false;
     }
-    VECTOR_SET_SLOT_PROBING_END();
+    this->remove_key_internal(slot);
+    return true;
   }
 
   template<typename ForwardKey>
   void remove_contained__impl(const ForwardKey &key, const uint64_t hash)
   {
     BLI_assert(this->contains_as(key));
-
-    VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash, keys_)) {
-        this->remove_key_internal(slot);
-        return;
-      }
-    }
-    VECTOR_SET_SLOT_PROBING_END();
+    this->remove_key_internal(slots_[this->find_key_slot_index(key, hash)]);
   }
 
   void remove_key_internal(Slot &slot)
@@ -825,37 +857,39 @@ class VectorSet {
 
     keys_[last_element_index].~Key();
     slot.remove();
+    control_bytes_.remove(&slot - slots_.data());
     removed_slots_++;
     return;
   }
 
   void update_slot_index(const Key &key, const int64_t old_index, const int64_t new_index)
   {
-    uint64_t hash = hash_(key);
-    VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.has_index(old_index)) {
-        slot.update_index(new_index);
-        return;
-      }
-    }
-    VECTOR_SET_SLOT_PROBING_END();
+    const uint64_t hash = hash_(key);
+    slots_[this->find_index_slot_index(old_index, hash)].update_index(new_index);
   }
 
   template<typename ForwardKey>
   int64_t count_collisions__impl(const ForwardKey &key, const uint64_t hash) const
   {
-    int64_t collisions = 0;
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      return control_bytes_.count_collisions(hash, [&](const int64_t slot_index) {
+        return slots_[slot_index].contains(key, is_equal_, hash, keys_);
+      });
+    }
+    else {
+      int64_t collisions = 0;
 
-    VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
-      if (slot.contains(key, is_equal_, hash, keys_)) {
-        return collisions;
-      }
-      if (slot.is_empty()) {
-        return collisions;
+      VECTOR_SET_SLOT_PROBING_BEGIN (hash, slot) {
+        if (slot.contains(key, is_equal_, hash, keys_)) {
+          return collisions;
+        }
+        if (slot.is_empty()) {
+          return collisions;
+        }
+        collisions++;
       }
-      collisions++;
+      VECTOR_SET_SLOT_PROBING_END();
     }
-    VECTOR_SET_SLOT_PROBING_END();
   }
 
   void ensure_can_add()
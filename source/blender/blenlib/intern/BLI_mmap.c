@@ -33,6 +33,9 @@ struct BLI_mmap_file {
   /* Platform-specific handle for the mapping. */
   void *handle;
 
+  /* Whether the mapped pages may be written to (without affecting the file). */
+  bool copy_on_write;
+
   /* Flag to indicate IO errors. Needs to be volatile since it's being set from
    * within the signal handler, which is not part of the normal execution flow. */
   volatile bool io_error;
@@ -73,8 +76,9 @@ static void sigbus_handler(int sig, siginfo_t *siginfo, void *ptr)
       file->io_error = true;
 
       /* Replace the mapped memory with zeroes. */
+      const int prot = file->copy_on_write ? (PROT_READ | PROT_WRITE) : PROT_READ;
       const void *mapped_memory = mmap(
-          file->memory, file->length, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+          file->memory, file->length, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
       if (mapped_memory == MAP_FAILED) {
         fprintf(stderr, "SIGBUS handler: Error replacing mapped file with zeros\n");
       }
@@ -129,7 +133,7 @@ static void sigbus_handler_remove(BLI_mmap_file *file)
 }
 #endif
 
-BLI_mmap_file *BLI_mmap_open(int fd)
+static BLI_mmap_file *mmap_open_ex(int fd, const bool copy_on_write)
 {
   void *memory, *handle = NULL;
   size_t length = BLI_lseek(fd, 0, SEEK_END);
@@ -141,7 +145,8 @@ BLI_mmap_file *BLI_mmap_open(int fd)
   }
 
   /* Map the given file to memory. */
-  memory = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  const int prot = copy_on_write ? (PROT_READ | PROT_WRITE) : PROT_READ;
+  memory = mmap(NULL, length, prot, MAP_PRIVATE, fd, 0);
   if (memory == MAP_FAILED) {
     return NULL;
   }
@@ -151,11 +156,12 @@ BLI_mmap_file *BLI_mmap_open(int fd)
   /* Memory mapping on Windows is a two-step process - first we create a mapping,
    * then we create a view into that mapping.
    * In our case, one view that spans the entire file is enough. */
-  handle = CreateFileMapping(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  handle = CreateFileMapping(
+      file_handle, NULL, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
   if (handle == NULL) {
     return NULL;
   }
-  memory = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+  memory = MapViewOfFile(handle, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
   if (memory == NULL) {
     CloseHandle(handle);
     return NULL;
@@ -167,6 +173,7 @@ BLI_mmap_file *BLI_mmap_open(int fd)
   file->memory = memory;
   file->handle = handle;
   file->length = length;
+  file->copy_on_write = copy_on_write;
 
 #ifndef WIN32
   /* Register the file with the error handler. */
@@ -176,6 +183,16 @@ BLI_mmap_file *BLI_mmap_open(int fd)
   return file;
 }
 
+BLI_mmap_file *BLI_mmap_open(int fd)
+{
+  return mmap_open_ex(fd, false);
+}
+
+BLI_mmap_file *BLI_mmap_open_copy_on_write(int fd)
+{
+  return mmap_open_ex(fd, true);
+}
+
 bool BLI_mmap_read(BLI_mmap_file *file, void *dest, size_t offset, size_t length)
 {
   /* If a previous read has already failed or we try to read past the end,
@@ -210,6 +227,16 @@ void *BLI_mmap_get_pointer(BLI_mmap_file *file)
   return file->memory;
 }
 
+size_t BLI_mmap_get_length(const BLI_mmap_file *file)
+{
+  return file->length;
+}
+
+bool BLI_mmap_any_io_error(const BLI_mmap_file *file)
+{
+  return file->io_error;
+}
+
 void BLI_mmap_free(BLI_mmap_file *file)
 {
 #ifndef WIN32
@@ -62,6 +62,16 @@ static off64_t memory_seek(FileReader *reader, off64_t offset, int whence)
   return mem->reader.offset;
 }
 
+static const void *memory_data_raw(FileReader *reader, off64_t offset, size_t size)
+{
+  MemoryReader *mem = (MemoryReader *)reader;
+
+  if (offset < 0 || (size_t)offset > mem->length || size > mem->length - (size_t)offset) {
+    return NULL;
+  }
+  return mem->data + offset;
+}
+
 static void memory_close_raw(FileReader *reader)
 {
   MEM_freeN(reader);
@@ -77,6 +87,7 @@ FileReader *BLI_filereader_new_memory(const void *data, size_t len)
   mem->reader.read = memory_read_raw;
   mem->reader.seek = memory_seek;
   mem->reader.close = memory_close_raw;
+  mem->reader.data = memory_data_raw;
 
   return (FileReader *)mem;
 }
@@ -103,6 +114,22 @@ static ssize_t memory_read_mmap(FileReader *reader, void *buffer, size_t size)
   return readsize;
 }
 
+#ifndef WIN32
+static const void *memory_data_mmap(FileReader *reader, off64_t offset, size_t size)
+{
+  MemoryReader *mem = (MemoryReader *)reader;
+
+  if (offset < 0 || (size_t)offset > mem->length || size > mem->length - (size_t)offset) {
+    return NULL;
+  }
+  /* Memory that failed to be read has been replaced by zeroes, don't give access to it. */
+  if (BLI_mmap_any_io_error(mem->mmap)) {
+    return NULL;
+  }
+  return (const char *)BLI_mmap_get_pointer(mem->mmap) + offset;
+}
+#endif
+
 static void memory_close_mmap(FileReader *reader)
 {
   MemoryReader *mem = (MemoryReader *)reader;
@@ -125,6 +152,10 @@ FileReader *BLI_filereader_new_mmap(int filedes)
   mem->reader.read = memory_read_mmap;
   mem->reader.seek = memory_seek;
   mem->reader.close = memory_close_mmap;
+#ifndef WIN32
+  /* On Windows, IO errors can only be handled while copying the data in #BLI_mmap_read. */
+  mem->reader.data = memory_data_mmap;
+#endif
 
   return (FileReader *)mem;
 }
@@ -13,9 +13,19 @@
 #include "BLI_endian_switch.h"
 #include "BLI_filereader.h"
 #include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
+/**
+ * Maximum uncompressed size of the consecutive frames that are read ahead and decompressed on
+ * multiple threads when reading sequentially, see #zstd_ensure_prefetch.
+ */
+#define ZSTD_PREFETCH_SIZE (32 * 1024 * 1024)
+
 typedef struct {
   FileReader reader;
 
@@ -32,6 +42,16 @@ typedef struct {
 
     char *cached_content;
     int cached_frame;
+
+    /**
+     * Consecutive frames that were decompressed together, kept separate from the single
+     * cached frame so that seeking back (e.g. to read data on demand) doesn't discard them.
+     */
+    char *prefetch_content;
+    int prefetch_frame;
+    int prefetch_frames_num;
+    /** Number of frames to read ahead, zero until the first sequential read. */
+    int prefetch_frames_max;
   } seek;
 } ZstdReader;
 
@@ -128,6 +148,7 @@ static bool zstd_read_seek_table(ZstdReader *zstd)
   }
 
   zstd->seek.cached_frame = -1;
+  zstd->seek.prefetch_frame = -1;
 
   return true;
 }
@@ -193,6 +214,139 @@ static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
   return uncompressed_data;
 }
 
+typedef struct ZstdPrefetchData {
+  const ZstdReader *zstd;
+  const char *compressed_data;
+  char *uncompressed_data;
+  uint8_t error;
+} ZstdPrefetchData;
+
+static void zstd_prefetch_frame_fn(void *__restrict userdata,
+                                   const int frame,
+                                   const TaskParallelTLS *__restrict tls)
+{
+  ZstdPrefetchData *data = (ZstdPrefetchData *)userdata;
+  const ZstdReader *zstd = data->zstd;
+  ZSTD_DCtx **ctx = (ZSTD_DCtx **)tls->userdata_chunk;
+  if (*ctx == NULL) {
+    *ctx = ZSTD_createDCtx();
+  }
+
+  const int first_frame = zstd->seek.prefetch_frame;
+  size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] - zstd->seek.compressed_ofs[frame];
+  size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
+                             zstd->seek.uncompressed_ofs[frame];
+  const char *compressed_data = data->compressed_data + (zstd->seek.compressed_ofs[frame] -
+                                                         zstd->seek.compressed_ofs[first_frame]);
+  char *uncompressed_data = data->uncompressed_data + (zstd->seek.uncompressed_ofs[frame] -
+                                                       zstd->seek.uncompressed_ofs[first_frame]);
+
+  size_t res = ZSTD_decompressDCtx(
+      *ctx, uncompressed_data, uncompressed_size, compressed_data, compressed_size);
+  if (ZSTD_isError(res) || res < uncompressed_size) {
+    atomic_fetch_and_or_uint8(&data->error, 1);
+  }
+}
+
+static void zstd_prefetch_free_fn(const void *__restrict UNUSED(userdata), void *__restrict chunk)
+{
+  ZSTD_DCtx **ctx = (ZSTD_DCtx **)chunk;
+  if (*ctx != NULL) {
+    ZSTD_freeDCtx(*ctx);
+  }
+}
+
+/**
+ * Read the compressed data of the frames following \a frame with a single read call, and
+ * decompress them on multiple threads. Used when the file is read sequentially, where each
+ * frame would otherwise be read and decompressed one at a time.
+ */
+static const char *zstd_ensure_prefetch(ZstdReader *zstd, int frame)
+{
+  if (zstd->seek.prefetch_frames_max == 0) {
+    zstd->seek.prefetch_frames_max = max_ii(1, BLI_system_thread_count() * 2);
+  }
+
+  MEM_SAFE_FREE(zstd->seek.prefetch_content);
+  zstd->seek.prefetch_frame = -1;
+  zstd->seek.prefetch_frames_num = 0;
+
+  /* Always decompress at least the requested frame. */
+  int frames_num = 1;
+  while (frames_num < zstd->seek.prefetch_frames_max &&
+         frame + frames_num < zstd->seek.frames_num &&
+         zstd->seek.uncompressed_ofs[frame + frames_num + 1] - zstd->seek.uncompressed_ofs[frame] <=
+             ZSTD_PREFETCH_SIZE)
+  {
+    frames_num++;
+  }
+
+  size_t compressed_size = zstd->seek.compressed_ofs[frame + frames_num] -
+                           zstd->seek.compressed_ofs[frame];
+  size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + frames_num] -
+                             zstd->seek.uncompressed_ofs[frame];
+
+  char *uncompressed_data = MEM_mallocN(uncompressed_size, __func__);
+  char *compressed_data = MEM_mallocN(compressed_size, __func__);
+  if (zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) < 0 ||
+      zstd->base->read(zstd->base, compressed_data, compressed_size) < compressed_size)
+  {
+    MEM_freeN(compressed_data);
+    MEM_freeN(uncompressed_data);
+    return NULL;
+  }
+
+  zstd->seek.prefetch_frame = frame;
+  ZstdPrefetchData data = {zstd, compressed_data, uncompressed_data, 0};
+  ZSTD_DCtx *ctx = NULL;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = frames_num > 1;
+  settings.userdata_chunk = &ctx;
+  settings.userdata_chunk_size = sizeof(ctx);
+  settings.func_free = zstd_prefetch_free_fn;
+  BLI_task_parallel_range(frame, frame + frames_num, &data, zstd_prefetch_frame_fn, &settings);
+
+  MEM_freeN(compressed_data);
+  if (data.error) {
+    MEM_freeN(uncompressed_data);
+    zstd->seek.prefetch_frame = -1;
+    return NULL;
+  }
+
+  zstd->seek.prefetch_content = uncompressed_data;
+  zstd->seek.prefetch_frames_num = frames_num;
+  return uncompressed_data;
+}
+
+/* Get the uncompressed contents of the given frame, from the caches if possible. */
+static const char *zstd_frame_data(ZstdReader *zstd, int frame)
+{
+  const int prefetch_end = zstd->seek.prefetch_frame + zstd->seek.prefetch_frames_num;
+  if (zstd->seek.prefetch_frame != -1 && frame >= zstd->seek.prefetch_frame &&
+      frame < prefetch_end)
+  {
+    return zstd->seek.prefetch_content +
+           (zstd->seek.uncompressed_ofs[frame] -
+            zstd->seek.uncompressed_ofs[zstd->seek.prefetch_frame]);
+  }
+  if (zstd->seek.cached_frame == frame) {
+    return zstd->seek.cached_content;
+  }
+
+  /* Read ahead when reading continues after the previously read ahead frames (or at the start
+   * of the file), otherwise only decompress the requested frame. */
+  const bool is_sequential = (zstd->seek.prefetch_frame == -1) ?
+                                 (frame == 0) :
+                                 (frame >= prefetch_end &&
+                                  frame < prefetch_end + zstd->seek.prefetch_frames_max);
+  if (is_sequential) {
+    return zstd_ensure_prefetch(zstd, frame);
+  }
+  return zstd_ensure_cache(zstd, frame);
+}
+
 static ssize_t zstd_read_seekable(FileReader *reader, void *buffer, size_t size)
 {
   ZstdReader *zstd = (ZstdReader *)reader;
@@ -205,7 +359,7 @@ static ssize_t zstd_read_seekable(FileReader *reader, void *buffer, size_t size)
       break;
     }
 
-    const char *framedata = zstd_ensure_cache(zstd, frame);
+    const char *framedata = zstd_frame_data(zstd, frame);
     if (framedata == NULL) {
       /* Error while reading the frame, so return as much as we can. */
       break;
@@ -287,6 +441,9 @@ static void zstd_close(FileReader *reader)
     if (zstd->seek.cached_content) {
       MEM_freeN(zstd->seek.cached_content);
     }
+    if (zstd->seek.prefetch_content) {
+      MEM_freeN(zstd->seek.prefetch_content);
+    }
   }
   else {
     MEM_freeN((void *)zstd->in_buf.src);
@@ -55,9 +55,28 @@ static void dump_perfdata();
 /** For debugging, can disable threading in intersect code with this static constant. */
 static constexpr bool intersect_use_threading = true;
 
+/**
+ * Return true if the rational can be represented exactly as a normalized double,
+ * i.e. its denominator is a power of two and its numerator fits in the mantissa.
+ */
+static bool mpq_is_double(const mpq_class &value)
+{
+  mpz_srcptr den = value.get_den_mpz_t();
+  const size_t den_bits = mpz_sizeinbase(den, 2);
+  return mpz_sizeinbase(value.get_num_mpz_t(), 2) <= 53 && mpz_scan1(den, 0) == den_bits - 1 &&
+         den_bits <= 1023;
+}
+
 Vert::Vert(const mpq3 &mco, const double3 &dco, int id, int orig)
     : co_exact(mco), co(dco), id(id), orig(orig)
 {
+  co_is_exact = true;
+  for (int i = 0; i < 3; i++) {
+    if (!mpq_is_double(mco[i]) || mco[i].get_d() != dco[i]) {
+      co_is_exact = false;
+      break;
+    }
+  }
 }
 
 bool Vert::operator==(const Vert &other) const
@@ -1123,6 +1142,56 @@ static int filter_plane_side(const double3 &p,
   return 0;
 }
 
+/**
+ * The index of orient3d on input coordinates with index 1:
+ * the differences have index 2, the cross product coordinates index 6,
+ * and the dot product of a difference with the cross product has index 11.
+ */
+constexpr int index_orient3d = 11;
+
+/**
+ * Return the sign of `orient3d(a, b, c, d)`, i.e. of `dot(a - d, cross(b - d, c - d))`,
+ * if it can be determined from the double approximations of the coordinates.
+ * If the answer is 0, we are unsure about the sign (or it is zero).
+ */
+static int filter_orient3d(const double3 &a, const double3 &b, const double3 &c, const double3 &d)
+{
+  const double3 ad = a - d;
+  const double3 bd = b - d;
+  const double3 cd = c - d;
+  const double det = math::dot(ad, math::cross(bd, cd));
+  if (det == 0.0) {
+    return 0;
+  }
+  const double3 abs_d = math::abs(d);
+  const double3 sup_ad = math::abs(a) + abs_d;
+  const double3 sup_bd = math::abs(b) + abs_d;
+  const double3 sup_cd = math::abs(c) + abs_d;
+  const double3 sup_cross(sup_bd[1] * sup_cd[2] + sup_bd[2] * sup_cd[1],
+                          sup_bd[2] * sup_cd[0] + sup_bd[0] * sup_cd[2],
+                          sup_bd[0] * sup_cd[1] + sup_bd[1] * sup_cd[0]);
+  const double supremum = math::dot(sup_ad, sup_cross);
+  const double err_bound = supremum * index_orient3d * DBL_EPSILON;
+  if (fabs(det) > err_bound) {
+    return det > 0 ? 1 : -1;
+  }
+  return 0;
+}
+
+int orient3d_filtered(const Vert *a, const Vert *b, const Vert *c, const Vert *d)
+{
+  if (a->co_is_exact && b->co_is_exact && c->co_is_exact && d->co_is_exact) {
+    /* The adaptive precision predicate gives the exact answer for double inputs, and only
+     * does extra work when the points are (nearly) co-planar. */
+    return orient3d(a->co, b->co, c->co, d->co);
+  }
+  const int filtered = filter_orient3d(a->co, b->co, c->co, d->co);
+  if (filtered != 0) {
+    return filtered;
+  }
+  return orient3d(a->co_exact, b->co_exact, c->co_exact, d->co_exact);
+}
+
 /*
  * #intersect_tri_tri and helper functions.
  * This code uses the algorithm of Guigue and Devillers, as described
@@ -1153,31 +1222,13 @@ static inline mpq3 tti_interp(
 }
 
 /**
- * Return +1, 0, -1 as a + ad is above, on, or below the oriented plane containing a, b, c in CCW
- * order. This is the same as -oriented(a, b, c, a + ad), but uses fewer arithmetic operations.
- * TODO: change arguments to `const Vert *` and use floating filters.
- * The ba, ca, n, and dotbuf arguments are used as temporaries; declaring them
- * in the caller can avoid many allocations and frees of mpq3 and mpq_class structures.
+ * Return +1, 0, -1 as d is above, on, or below the oriented plane containing a, b, c in CCW
+ * order. This is the same as -orient3d(a, b, c, d), which is the sign of
+ * `dot(d - a, cross(b - a, c - a))`.
  */
-static inline int tti_above(const mpq3 &a,
-                            const mpq3 &b,
-                            const mpq3 &c,
-                            const mpq3 &ad,
-                            mpq3 &ba,
-                            mpq3 &ca,
-                            mpq3 &n,
-                            mpq3 &dotbuf)
+static inline int tti_above(const Vert *a, const Vert *b, const Vert *c, const Vert *d)
 {
-  ba = b;
-  ba -= a;
-  ca = c;
-  ca -= a;
-
-  n.x = ba.y * ca.z - ba.z * ca.y;
-  n.y = ba.z * ca.x - ba.x * ca.z;
-  n.z = ba.x * ca.y - ba.y * ca.x;
-
-  return sgn(math::dot_with_buffer(ad, n, dotbuf));
+  return orient3d_filtered(d, b, c, a);
 }
 
 /**
@@ -1193,16 +1244,22 @@ static inline int tti_above(const mpq3 &a,
  *   of the plane and at least one of q1 and r1 are off the plane.
  * Similarly for p2, q2, r2 with respect to the first triangle's plane.
  */
-static ITT_value itt_canon2(const mpq3 &p1,
-                            const mpq3 &q1,
-                            const mpq3 &r1,
-                            const mpq3 &p2,
-                            const mpq3 &q2,
-                            const mpq3 &r2,
+static ITT_value itt_canon2(const Vert *vp1,
+                            const Vert *vq1,
+                            const Vert *vr1,
+                            const Vert *vp2,
+                            const Vert *vq2,
+                            const Vert *vr2,
                             const mpq3 &n1,
                             const mpq3 &n2)
 {
   constexpr int dbg_level = 0;
+  const mpq3 &p1 = vp1->co_exact;
+  const mpq3 &q1 = vq1->co_exact;
+  const mpq3 &r1 = vr1->co_exact;
+  const mpq3 &p2 = vp2->co_exact;
+  const mpq3 &q2 = vq2->co_exact;
+  const mpq3 &r2 = vr2->co_exact;
   if (dbg_level > 0) {
     std::cout << "\ntri_tri_intersect_canon:\n";
     std::cout << "p1=" << p1 << " q1=" << q1 << " r1=" << r1 << "\n";
@@ -1218,17 +1275,16 @@ static ITT_value itt_canon2(const mpq3 &p1,
     std::cout << "n1=(" << n1[0].get_d() << "," << n1[1].get_d() << "," << n1[2].get_d() << ")\n";
     std::cout << "n2=(" << n2[0].get_d() << "," << n2[1].get_d() << "," << n2[2].get_d() << ")\n";
   }
-  mpq3 p1p2 = p2 - p1;
   mpq3 intersect_1;
   mpq3 intersect_2;
-  mpq3 buf[4];
+  mpq3 buf[3];
   bool no_overlap = false;
   /* Top test in classification tree. */
-  if (tti_above(p1, q1, r2, p1p2, buf[0], buf[1], buf[2], buf[3]) > 0) {
+  if (tti_above(vp1, vq1, vr2, vp2) > 0) {
     /* Middle right test in classification tree. */
-    if (tti_above(p1, r1, r2, p1p2, buf[0], buf[1], buf[2], buf[3]) <= 0) {
+    if (tti_above(vp1, vr1, vr2, vp2) <= 0) {
       /* Bottom right test in classification tree. */
-      if (tti_above(p1, r1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) > 0) {
+      if (tti_above(vp1, vr1, vq2, vp2) > 0) {
         /* Overlap is [k [i l] j]. */
         if (dbg_level > 0) {
           std::cout << "overlap [k [i l] j]\n";
@@ -1257,7 +1313,7 @@ static ITT_value itt_canon2(const mpq3 &p1,
   }
   else {
     /* Middle left test in classification tree. */
-    if (tti_above(p1, q1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) < 0) {
+    if (tti_above(vp1, vq1, vq2, vp2) < 0) {
       /* No overlap: [i j] [k l]. */
       if (dbg_level > 0) {
         std::cout << "no overlap: [i j] [k l]\n";
@@ -1266,7 +1322,7 @@ static ITT_value itt_canon2(const mpq3 &p1,
     }
     else {
       /* Bottom left test in classification tree. */
-      if (tti_above(p1, r1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) >= 0) {
+      if (tti_above(vp1, vr1, vq2, vp2) >= 0) {
         /* Overlap is [k [i j] l]. */
         if (dbg_level > 0) {
           std::cout << "overlap [k [i j] l]\n";
@@ -1303,12 +1359,12 @@ static ITT_value itt_canon2(const mpq3 &p1,
 
 /* Helper function for intersect_tri_tri. Arguments have been canonicalized for triangle 1. */
 
-static ITT_value itt_canon1(const mpq3 &p1,
-                            const mpq3 &q1,
-                            const mpq3 &r1,
-                            const mpq3 &p2,
-                            const mpq3 &q2,
-                            const mpq3 &r2,
+static ITT_value itt_canon1(const Vert *p1,
+                            const Vert *q1,
+                            const Vert *r1,
+                            const Vert *p2,
+                            const Vert *q2,
+                            const Vert *r2,
                             const mpq3 &n1,
                             const mpq3 &n2,
                             int sp2,
@@ -1433,29 +1489,17 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
     return ITT_value(INONE);
   }
 
-  mpq3 buf[2];
-  const mpq3 &p1 = vp1->co_exact;
-  const mpq3 &q1 = vq1->co_exact;
-  const mpq3 &r1 = vr1->co_exact;
-  const mpq3 &p2 = vp2->co_exact;
-  const mpq3 &q2 = vq2->co_exact;
-  const mpq3 &r2 = vr2->co_exact;
-
-  const mpq3 &n2 = tri2.plane->norm_exact;
+  /* Decide the remaining signs with exact predicates, which only fall back to multi-precision
+   * arithmetic when double arithmetic can't determine the sign. The plane normals are the cross
+   * products of the triangle edges, so the plane side is the same as the orientation. */
   if (sp1 == 0) {
-    buf[0] = p1;
-    buf[0] -= r2;
-    sp1 = sgn(math::dot_with_buffer(buf[0], n2, buf[1]));
+    sp1 = orient3d_filtered(vp1, vp2, vq2, vr2);
   }
   if (sq1 == 0) {
-    buf[0] = q1;
-    buf[0] -= r2;
-    sq1 = sgn(math::dot_with_buffer(buf[0], n2, buf[1]));
+    sq1 = orient3d_filtered(vq1, vp2, vq2, vr2);
   }
   if (sr1 == 0) {
-    buf[0] = r1;
-    buf[0] -= r2;
-    sr1 = sgn(math::dot_with_buffer(buf[0], n2, buf[1]));
+    sr1 = orient3d_filtered(vr1, vp2, vq2, vr2);
   }
 
   if (dbg_level > 1) {
@@ -1473,21 +1517,14 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
   }
 
   /* Repeat for signs of t2's vertices with respect to plane of t1. */
-  const mpq3 &n1 = tri1.plane->norm_exact;
   if (sp2 == 0) {
-    buf[0] = p2;
-    buf[0] -= r1;
-    sp2 = sgn(math::dot_with_buffer(buf[0], n1, buf[1]));
+    sp2 = orient3d_filtered(vp2, vp1, vq1, vr1);
   }
   if (sq2 == 0) {
-    buf[0] = q2;
-    buf[0] -= r1;
-    sq2 = sgn(math::dot_with_buffer(buf[0], n1, buf[1]));
+    sq2 = orient3d_filtered(vq2, vp1, vq1, vr1);
   }
   if (sr2 == 0) {
-    buf[0] = r2;
-    buf[0] -= r1;
-    sr2 = sgn(math::dot_with_buffer(buf[0], n1, buf[1]));
+    sr2 = orient3d_filtered(vr2, vp1, vq1, vr1);
   }
 
   if (dbg_level > 1) {
@@ -1504,6 +1541,15 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
     return ITT_value(INONE);
   }
 
+  const mpq3 &n1 = tri1.plane->norm_exact;
+  const mpq3 &n2 = tri2.plane->norm_exact;
+  const Vert *p1 = vp1;
+  const Vert *q1 = vq1;
+  const Vert *r1 = vr1;
+  const Vert *p2 = vp2;
+  const Vert *q2 = vq2;
+  const Vert *r2 = vr2;
+
   /* Do rest of the work with vertices in a canonical order, where p1 is on
    * positive side of plane and q1, r1 are not, or p1 is on the plane and
    * q1 and r1 are off the plane on the same side. */
@@ -11,6 +11,7 @@
 #include "PIL_time.h"
 
 #include "BLI_array.hh"
+#include "BLI_math_boolean.hh"
 #include "BLI_math_mpq.hh"
 #include "BLI_math_vector_mpq_types.hh"
 #include "BLI_mesh_intersect.hh"
@@ -810,6 +811,51 @@ TEST(mesh_intersect, RectCross)
     write_obj_mesh(out, "test_rectcross");
   }
 }
+
+TEST(mesh_intersect, Orient3dFiltered)
+{
+  /* Like intersection points, the vertices have rational coordinates that doubles can only
+   * approximate. Points on or very close to the plane must give the same sign as the exact
+   * predicate. */
+  IMeshArena arena;
+  const mpq3 a(mpq_class(1, 3), mpq_class(2, 7), mpq_class(-5, 11));
+  const mpq3 b(mpq_class(17, 5), mpq_class(-1, 9), mpq_class(3, 13));
+  const mpq3 c(mpq_class(-4, 7), mpq_class(29, 3), mpq_class(7, 17));
+  const mpq3 normal = math::cross(b - a, c - a);
+  const Vert *va = arena.add_or_find_vert(a, 0);
+  const Vert *vb = arena.add_or_find_vert(b, 1);
+  const Vert *vc = arena.add_or_find_vert(c, 2);
+  EXPECT_FALSE(va->co_is_exact);
+
+  const mpq_class tiny(mpz_class(1), mpz_class(1) << 80);
+  const mpq_class offsets[] = {mpq_class(0), tiny, -tiny, tiny * 1000, mpq_class(1, 3)};
+  const mpq_class weights[][2] = {{mpq_class(1, 3), mpq_class(1, 5)},
+                                  {mpq_class(2, 3), mpq_class(-1, 9)},
+                                  {mpq_class(7, 5), mpq_class(13, 17)},
+                                  {mpq_class(-1000, 3), mpq_class(1, 1000)}};
+
+  int orig = 3;
+  for (const auto &weight : weights) {
+    for (const mpq_class &offset : offsets) {
+      const mpq3 d = a + weight[0] * (b - a) + weight[1] * (c - a) + offset * normal;
+      const Vert *vd = arena.add_or_find_vert(d, orig++);
+      if (offset == 0) {
+        EXPECT_EQ(orient3d(a, b, c, d), 0);
+      }
+      EXPECT_EQ(orient3d_filtered(va, vb, vc, vd), orient3d(a, b, c, d)) << d;
+      EXPECT_EQ(orient3d_filtered(vd, vb, vc, va), orient3d(d, b, c, a)) << d;
+      EXPECT_EQ(orient3d_filtered(vb, vd, va, vc), orient3d(b, d, a, c)) << d;
+    }
+  }
+
+  /* Vertices with exact double coordinates use the adaptive double predicate. */
+  const Vert *v0 = arena.add_or_find_vert(mpq3(0, 0, 0), orig++);
+  const Vert *v1 = arena.add_or_find_vert(mpq3(1, 0, 0), orig++);
+  const Vert *v2 = arena.add_or_find_vert(mpq3(0, 1, 0), orig++);
+  const Vert *v3 = arena.add_or_find_vert(mpq3(mpq_class(1, 4), mpq_class(1, 8), 0), orig++);
+  EXPECT_TRUE(v3->co_is_exact);
+  EXPECT_EQ(orient3d_filtered(v0, v1, v2, v3), 0);
+}
 #  endif
 
 #  if DO_PERF_TESTS
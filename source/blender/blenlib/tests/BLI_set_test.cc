@@ -624,6 +624,43 @@ TEST(set, Equality)
   EXPECT_NE(f, a);
 }
 
+TEST(set, GroupProbing)
+{
+  Set<int, 4, GroupProbingStrategy> set;
+  EXPECT_FALSE(set.contains(0));
+  for (int i = 0; i < 1000; i++) {
+    set.add_new(i * 5);
+  }
+  EXPECT_EQ(set.size(), 1000);
+  for (int i = 0; i < 5000; i++) {
+    EXPECT_EQ(set.contains(i), i % 5 == 0);
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    set.remove_contained(i * 5);
+  }
+  EXPECT_FALSE(set.remove(0));
+  EXPECT_TRUE(set.remove(5));
+  EXPECT_EQ(set.size(), 499);
+  EXPECT_TRUE(set.add(0));
+  EXPECT_FALSE(set.add(0));
+  EXPECT_EQ(set.lookup_key_or_add(3), 3);
+  EXPECT_EQ(set.lookup_key_ptr(4), nullptr);
+
+  Set<int, 4, GroupProbingStrategy> set_copy = set;
+  EXPECT_EQ(set_copy, set);
+  set.remove_if([](const int key) { return key > 100; });
+  EXPECT_EQ(set.size(), 11);
+  set.rehash();
+  EXPECT_EQ(set.size(), 11);
+  EXPECT_TRUE(set.contains(95));
+  set.clear();
+  EXPECT_TRUE(set.is_empty());
+  EXPECT_FALSE(set.contains(95));
+  set.add_new(95);
+  EXPECT_TRUE(set.contains(95));
+  EXPECT_EQ(set_copy.size(), 501);
+}
+
 /**
  * Set this to 1 to activate the benchmark. It is disabled by default, because it prints a lot.
  */
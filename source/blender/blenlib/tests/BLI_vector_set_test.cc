@@ -296,4 +296,36 @@ TEST(vector_set, GrowWhenEmpty)
   set.reserve(100);
 }
 
+TEST(vector_set, GroupProbing)
+{
+  VectorSet<int, GroupProbingStrategy> set;
+  for (int i = 0; i < 1000; i++) {
+    set.add_new(i * 7);
+  }
+  EXPECT_EQ(set.size(), 1000);
+  for (int i = 0; i < 7000; i++) {
+    EXPECT_EQ(set.index_of_try(i), i % 7 == 0 ? i / 7 : -1);
+  }
+  EXPECT_EQ(set.pop(), 999 * 7);
+  set.remove_contained(0);
+  EXPECT_EQ(set[0], 998 * 7);
+  EXPECT_EQ(set.index_of(998 * 7), 0);
+  EXPECT_FALSE(set.remove(0));
+  EXPECT_TRUE(set.remove(7));
+  EXPECT_EQ(set.index_of_or_add(0), 997);
+  EXPECT_EQ(set.size(), 998);
+
+  VectorSet<int, GroupProbingStrategy> set_copy = set;
+  VectorSet<int, GroupProbingStrategy> set_moved = std::move(set);
+  EXPECT_TRUE(set.is_empty());
+  EXPECT_FALSE(set.contains(0));
+  set.add(0);
+  EXPECT_EQ(set.index_of(0), 0);
+  EXPECT_EQ(set_copy.index_of(0), 997);
+  EXPECT_EQ(set_moved.index_of(0), 997);
+  set_moved.clear();
+  EXPECT_FALSE(set_moved.contains(0));
+  EXPECT_TRUE(set_moved.add(0));
+}
+
 }  // namespace blender::tests
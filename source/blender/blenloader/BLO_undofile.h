@@ -19,8 +19,13 @@ typedef struct {
   const char *buf;
   /** Size in bytes. */
   size_t size;
-  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
+  /** When true, this chunk is identical to the chunk at the same position in the previous step,
+   * and shares its memory (used by undo code to detect unchanged IDs). */
   bool is_identical;
+  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk.
+   * Set for identical chunks, but also for chunks matching the content of any chunk of the
+   * previous step, e.g. when data was inserted before them. */
+  bool is_shared;
   /** When true, this chunk is also identical to the one in the next step (used by undo code to
    * detect unchanged IDs).
    * Defined when writing the next step (i.e. last undo step has those always false). */
@@ -28,6 +33,8 @@ typedef struct {
   /** Session UUID of the ID being currently written (MAIN_ID_SESSION_UUID_UNSET when not writing
    * ID-related data). Used to find matching chunks in previous memundo step. */
   uint id_session_uuid;
+  /** Hash of the chunk contents, used to find chunks with the same contents in the next step. */
+  uint hash;
 } MemFileChunk;
 
 typedef struct MemFile {
@@ -44,6 +51,8 @@ typedef struct MemFileWriteData {
 
   /** Maps an ID session uuid to its first reference MemFileChunk, if existing. */
   struct GHash *id_session_uuid_mapping;
+  /** Maps a content hash to the first reference MemFileChunk with that hash, if existing. */
+  struct GHash *chunk_hash_mapping;
 } MemFileWriteData;
 
 typedef struct MemFileUndoData {
@@ -6,6 +6,7 @@
  * \ingroup blenloader
  */
 
+#include <atomic>
 #include <cctype> /* for isdigit. */
 #include <cerrno>
 #include <climits>
@@ -56,7 +57,9 @@
 #include "BLI_math.h"
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
+#include "BLI_vector.hh"
 
 #include "PIL_time.h"
 
@@ -169,6 +172,19 @@
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
+#ifdef USE_BHEAD_READ_ON_DEMAND
+/**
+ * Read and decode (endian switch, DNA reconstruct) the data blocks of upcoming IDs on multiple
+ * threads, before linking them one at a time, see #read_data_decode_ahead.
+ *
+ * \note Only used for file readers that give direct access to the file contents
+ * (memory-mapped files), since other readers can't be accessed from multiple threads.
+ */
+#  define USE_BHEAD_DECODE_AHEAD
+/** Maximum amount of data decoded ahead at once, to bound the extra memory usage. */
+#  define BHEAD_DECODE_AHEAD_SIZE (64 * 1024 * 1024)
+#endif
+
 /** Use #GHash for #BHead name-based lookups (speeds up linking). */
 #define USE_GHASH_BHEAD
 
@@ -191,6 +207,12 @@ struct BHeadN {
   off64_t file_offset;
   /** When set, the remainder of this allocation is the data, otherwise it needs to be read. */
   bool has_data;
+#endif
+#ifdef USE_BHEAD_DECODE_AHEAD
+  /** Set when the block has been decoded ahead of time, #decoded_data is the result then. */
+  bool is_decoded;
+  /** Owned result of #read_struct, until it's taken over by #read_data_into_datamap. */
+  void *decoded_data;
 #endif
   bool is_memchunk_identical;
   BHead bhead;
@@ -757,6 +779,10 @@ static BHeadN *get_bhead(FileData *fd)
           new_bhead->next = new_bhead->prev = nullptr;
           new_bhead->file_offset = fd->file->offset;
           new_bhead->has_data = false;
+#  ifdef USE_BHEAD_DECODE_AHEAD
+          new_bhead->is_decoded = false;
+          new_bhead->decoded_data = nullptr;
+#  endif
           new_bhead->is_memchunk_identical = false;
           new_bhead->bhead = bhead;
           const off64_t seek_new = fd->file->seek(fd->file, bhead.len, SEEK_CUR);
@@ -782,6 +808,10 @@ static BHeadN *get_bhead(FileData *fd)
 #ifdef USE_BHEAD_READ_ON_DEMAND
           new_bhead->file_offset = 0; /* don't seek. */
           new_bhead->has_data = true;
+#endif
+#ifdef USE_BHEAD_DECODE_AHEAD
+          new_bhead->is_decoded = false;
+          new_bhead->decoded_data = nullptr;
 #endif
           new_bhead->is_memchunk_identical = false;
           new_bhead->bhead = bhead;
@@ -870,11 +900,36 @@ BHead *blo_bhead_next(FileData *fd, BHead *thisblock)
 }
 
 #ifdef USE_BHEAD_READ_ON_DEMAND
+/**
+ * Access the data of a block that was not read yet directly in the file contents, without
+ * copying it, for readers that support it (memory-mapped files and memory buffers).
+ * The memory must not be modified. Returns null when direct access is not available, or
+ * when an IO error happened while accessing the file contents since the previous call.
+ */
+static const void *blo_bhead_data_peek(FileData *fd, BHead *thisblock)
+{
+  BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
+  BLI_assert(new_bhead->has_data == false && new_bhead->file_offset != 0);
+  if (fd->file->data == nullptr) {
+    return nullptr;
+  }
+  return fd->file->data(fd->file, new_bhead->file_offset, size_t(new_bhead->bhead.len));
+}
+
 static bool blo_bhead_read_data(FileData *fd, BHead *thisblock, void *buf)
 {
   bool success = true;
   BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
   BLI_assert(new_bhead->has_data == false && new_bhead->file_offset != 0);
+  if (fd->file->data != nullptr) {
+    /* Copy without changing the reader state, so blocks can be read from multiple threads. */
+    const void *data = blo_bhead_data_peek(fd, thisblock);
+    if (data == nullptr) {
+      return false;
+    }
+    memcpy(buf, data, size_t(new_bhead->bhead.len));
+    return blo_bhead_data_peek(fd, thisblock) != nullptr;
+  }
   off64_t offset_backup = fd->file->offset;
   if (UNLIKELY(fd->file->seek(fd->file, new_bhead->file_offset, SEEK_SET) == -1)) {
     success = false;
@@ -901,6 +956,10 @@ static BHead *blo_bhead_read_full(FileData *fd, BHead *thisblock)
   new_bhead_data->bhead = new_bhead->bhead;
   new_bhead_data->file_offset = new_bhead->file_offset;
   new_bhead_data->has_data = true;
+#  ifdef USE_BHEAD_DECODE_AHEAD
+  new_bhead_data->is_decoded = false;
+  new_bhead_data->decoded_data = nullptr;
+#  endif
   new_bhead_data->is_memchunk_identical = false;
   if (!blo_bhead_read_data(fd, thisblock, new_bhead_data + 1)) {
     MEM_freeN(new_bhead_data);
@@ -1320,6 +1379,15 @@ void blo_filedata_free(FileData *fd)
 {
   if (fd) {
 
+#ifdef USE_BHEAD_DECODE_AHEAD
+    /* Free data that was decoded ahead, but not used (when reading failed for example). */
+    LISTBASE_FOREACH (BHeadN *, new_bhead, &fd->bhead_list) {
+      if (new_bhead->decoded_data) {
+        MEM_freeN(new_bhead->decoded_data);
+      }
+    }
+#endif
+
     /* Free all BHeadN data blocks */
 #ifndef NDEBUG
     BLI_freelistN(&fd->bhead_list);
@@ -1758,12 +1826,12 @@ void blo_cache_storage_end(FileData *fd)
 /** \name DNA Struct Loading
  * \{ */
 
-static void switch_endian_structs(const SDNA *filesdna, BHead *bhead)
+static void switch_endian_structs(const SDNA *filesdna, const BHead *bhead, void *bhead_data)
 {
   int blocksize, nblocks;
   char *data;
 
-  data = (char *)(bhead + 1);
+  data = static_cast<char *>(bhead_data);
   blocksize = filesdna->types_size[filesdna->structs[bhead->SDNAnr]->type];
 
   nblocks = bhead->nr;
@@ -1774,57 +1842,78 @@ static void switch_endian_structs(const SDNA *filesdna, BHead *bhead)
   }
 }
 
-static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
+/**
+ * Like #read_struct, but reports read errors instead of flagging them in #FileData.flags,
+ * so that it can be used from multiple threads (as long as #FileReader.data is available).
+ */
+static void *read_struct_ex(FileData *fd, BHead *bh, const char *blockname, bool *r_read_error)
 {
   void *temp = nullptr;
 
   if (bh->len) {
 #ifdef USE_BHEAD_READ_ON_DEMAND
     BHead *bh_orig = bh;
+    const bool has_data = BHEADN_FROM_BHEAD(bh)->has_data;
+#else
+    const bool has_data = true;
 #endif
 
     /* switch is based on file dna */
-    if (bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN)) {
-#ifdef USE_BHEAD_READ_ON_DEMAND
-      if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
-        bh = blo_bhead_read_full(fd, bh);
-        if (UNLIKELY(bh == nullptr)) {
-          fd->flags &= ~FD_FLAGS_FILE_OK;
-          return nullptr;
-        }
-      }
-#endif
-      switch_endian_structs(fd->filesdna, bh);
+    const bool do_endian_swap = bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN);
+    if (do_endian_swap && has_data) {
+      switch_endian_structs(fd->filesdna, bh, bh + 1);
     }
 
     if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
       if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
+        const void *data = (bh + 1);
 #ifdef USE_BHEAD_READ_ON_DEMAND
-        if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
-          bh = blo_bhead_read_full(fd, bh);
-          if (UNLIKELY(bh == nullptr)) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
-            return nullptr;
+        if (!has_data) {
+          /* Reconstruct straight from the file contents when the reader gives access to them,
+           * instead of reading them into a temporary block first. Switching endianness needs
+           * a copy that can be modified though. */
+          data = do_endian_swap ? nullptr : blo_bhead_data_peek(fd, bh);
+          if (data == nullptr) {
+            bh = blo_bhead_read_full(fd, bh);
+            if (UNLIKELY(bh == nullptr)) {
+              *r_read_error = true;
+              return nullptr;
+            }
+            if (do_endian_swap) {
+              switch_endian_structs(fd->filesdna, bh, bh + 1);
+            }
+            data = (bh + 1);
           }
         }
 #endif
-        temp = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, (bh + 1));
+        temp = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, data);
+#ifdef USE_BHEAD_READ_ON_DEMAND
+        if (!has_data && bh == bh_orig && UNLIKELY(!blo_bhead_data_peek(fd, bh))) {
+          /* Reading the file contents failed while reconstructing. */
+          *r_read_error = true;
+          MEM_freeN(temp);
+          temp = nullptr;
+        }
+#endif
       }
       else {
         /* SDNA_CMP_EQUAL */
         temp = MEM_mallocN(bh->len, blockname);
 #ifdef USE_BHEAD_READ_ON_DEMAND
-        if (BHEADN_FROM_BHEAD(bh)->has_data) {
+        if (has_data) {
           memcpy(temp, (bh + 1), bh->len);
         }
         else {
           /* Instead of allocating the bhead, then copying it,
            * read the data from the file directly into the memory. */
           if (UNLIKELY(!blo_bhead_read_data(fd, bh, temp))) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
+            *r_read_error = true;
             MEM_freeN(temp);
             temp = nullptr;
           }
+          else if (do_endian_swap) {
+            switch_endian_structs(fd->filesdna, bh, temp);
+          }
         }
 #else
         memcpy(temp, (bh + 1), bh->len);
@@ -1842,6 +1931,16 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
   return temp;
 }
 
+static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
+{
+  bool read_error = false;
+  void *temp = read_struct_ex(fd, bh, blockname, &read_error);
+  if (UNLIKELY(read_error)) {
+    fd->flags &= ~FD_FLAGS_FILE_OK;
+  }
+  return temp;
+}
+
 /* Like read_struct, but gets a pointer without allocating. Only works for
  * undo since DNA must match. */
 static const void *peek_struct_undo(FileData *fd, BHead *bhead)
@@ -2529,7 +2628,20 @@ static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *all
     }
 #endif
 
+#ifdef USE_BHEAD_DECODE_AHEAD
+    void *data;
+    BHeadN *new_bhead = BHEADN_FROM_BHEAD(bhead);
+    if (new_bhead->is_decoded) {
+      data = new_bhead->decoded_data;
+      new_bhead->decoded_data = nullptr;
+      new_bhead->is_decoded = false;
+    }
+    else {
+      data = read_struct(fd, bhead, allocname);
+    }
+#else
     void *data = read_struct(fd, bhead, allocname);
+#endif
     if (data) {
       oldnewmap_insert(fd->datamap, bhead->old, data, 0);
     }
@@ -2540,6 +2652,78 @@ static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *all
   return bhead;
 }
 
+#ifdef USE_BHEAD_DECODE_AHEAD
+/**
+ * Decode the data blocks of the IDs starting at \a bhead on multiple threads, up to
+ * #BHEAD_DECODE_AHEAD_SIZE bytes. The results are taken over by #read_data_into_datamap,
+ * which keeps the (order dependent) linking of the IDs single threaded.
+ *
+ * \return The first ID block that was not handled, to decode again once it's reached,
+ * or null when the end of the file was reached.
+ */
+static BHead *read_data_decode_ahead(FileData *fd, BHead *bhead)
+{
+  struct DecodeBlock {
+    BHead *bhead;
+    const char *allocname;
+  };
+  blender::Vector<DecodeBlock> blocks;
+  size_t blocks_size = 0;
+
+  /* Only data directly following an ID is read into the datamap. */
+  const char *allocname = nullptr;
+  for (; bhead; bhead = blo_bhead_next(fd, bhead)) {
+    if (bhead->code == BLO_CODE_ENDB) {
+      bhead = nullptr;
+      break;
+    }
+    if (blo_bhead_is_id(bhead)) {
+      if (blocks_size >= BHEAD_DECODE_AHEAD_SIZE) {
+        break;
+      }
+      /* Link placeholders don't have data. */
+      if (bhead->code == ID_LINK_PLACEHOLDER) {
+        allocname = nullptr;
+      }
+      else {
+        allocname = dataname(bhead->code == ID_SCRN ? short(ID_SCR) : short(bhead->code));
+      }
+      continue;
+    }
+    if (bhead->code != BLO_CODE_DATA) {
+      allocname = nullptr;
+      continue;
+    }
+    BHeadN *new_bhead = BHEADN_FROM_BHEAD(bhead);
+    if (allocname == nullptr || bhead->len == 0 || new_bhead->has_data || new_bhead->is_decoded) {
+      continue;
+    }
+    blocks.append({bhead, allocname});
+    blocks_size += size_t(bhead->len);
+  }
+
+  std::atomic<bool> read_error = false;
+  blender::threading::parallel_for(
+      blocks.index_range(), 64, [&](const blender::IndexRange range) {
+        bool range_read_error = false;
+        for (const DecodeBlock &block : blocks.as_span().slice(range)) {
+          BHeadN *new_bhead = BHEADN_FROM_BHEAD(block.bhead);
+          new_bhead->decoded_data = read_struct_ex(
+              fd, block.bhead, block.allocname, &range_read_error);
+          new_bhead->is_decoded = true;
+        }
+        if (range_read_error) {
+          read_error = true;
+        }
+      });
+  if (read_error) {
+    fd->flags &= ~FD_FLAGS_FILE_OK;
+  }
+
+  return bhead;
+}
+#endif
+
 /* Verify if the datablock and all associated data is identical. */
 static bool read_libblock_is_identical(FileData *fd, BHead *bhead)
 {
@@ -3562,7 +3746,21 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     read_undo_reuse_noundo_local_ids(fd);
   }
 
+#ifdef USE_BHEAD_DECODE_AHEAD
+  /* Decoding from multiple threads needs direct access to the file contents. Undo steps are
+   * left out, their IDs are mostly reused from the old main and their data doesn't need
+   * to be reconstructed. */
+  const bool use_decode_ahead = !is_undo && (fd->skip_flags & BLO_READ_SKIP_DATA) == 0 &&
+                                fd->file->seek != nullptr && fd->file->data != nullptr;
+  BHead *decode_ahead_bhead = use_decode_ahead ? bhead : nullptr;
+#endif
+
   while (bhead) {
+#ifdef USE_BHEAD_DECODE_AHEAD
+    if (bhead == decode_ahead_bhead) {
+      decode_ahead_bhead = read_data_decode_ahead(fd, bhead);
+    }
+#endif
     switch (bhead->code) {
       case BLO_CODE_DATA:
       case BLO_CODE_DNA1:
@@ -26,6 +26,7 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BLO_readfile.h"
 #include "BLO_undofile.h"
@@ -42,7 +43,7 @@
 void BLO_memfile_free(MemFile *memfile)
 {
   while (MemFileChunk *chunk = static_cast<MemFileChunk *>(BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
+    if (chunk->is_shared == false) {
       MEM_freeN((void *)chunk->buf);
     }
     MEM_freeN(chunk);
@@ -57,12 +58,16 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
   GHash *buffer_to_second_memchunk = BLI_ghash_new(
       BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, __func__);
 
-  /* First, detect all memchunks in second memfile that are not owned by it. */
+  /* First, detect all memchunks in second memfile that are not owned by it. Several chunks may
+   * share the same buffer, only the first one takes over the ownership. */
   for (MemFileChunk *sc = static_cast<MemFileChunk *>(second->chunks.first); sc != nullptr;
        sc = static_cast<MemFileChunk *>(sc->next))
   {
-    if (sc->is_identical) {
-      BLI_ghash_insert(buffer_to_second_memchunk, (void *)sc->buf, sc);
+    if (sc->is_shared) {
+      void **entry;
+      if (!BLI_ghash_ensure_p(buffer_to_second_memchunk, (void *)sc->buf, &entry)) {
+        *entry = sc;
+      }
     }
   }
 
@@ -71,13 +76,13 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
   for (MemFileChunk *fc = static_cast<MemFileChunk *>(first->chunks.first); fc != nullptr;
        fc = static_cast<MemFileChunk *>(fc->next))
   {
-    if (!fc->is_identical) {
+    if (!fc->is_shared) {
       MemFileChunk *sc = static_cast<MemFileChunk *>(
           BLI_ghash_lookup(buffer_to_second_memchunk, fc->buf));
       if (sc != nullptr) {
-        BLI_assert(sc->is_identical);
-        sc->is_identical = false;
-        fc->is_identical = true;
+        BLI_assert(sc->is_shared);
+        sc->is_shared = false;
+        fc->is_shared = true;
       }
       /* Note that if the second memfile does not use that chunk, we assume that the first one
        * fully owns it without sharing it with any other memfile, and hence it should be freed with
@@ -131,6 +136,21 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
         }
       }
     }
+
+    /* Also map the contents of the chunks, so that chunks which are not at the same position
+     * anymore (e.g. when some data was inserted or removed in an ID) can still share memory.
+     * Only chunks of the reference memfile are used, so that shared memory is always owned by
+     * the previous step or a step before it, as expected by #BLO_memfile_merge. */
+    mem_data->chunk_hash_mapping = BLI_ghash_new(
+        BLI_ghashutil_inthash_p_simple, BLI_ghashutil_intcmp, __func__);
+    LISTBASE_FOREACH (MemFileChunk *, mem_chunk, &reference_memfile->chunks) {
+      void **entry;
+      if (!BLI_ghash_ensure_p(
+              mem_data->chunk_hash_mapping, POINTER_FROM_UINT(mem_chunk->hash), &entry))
+      {
+        *entry = mem_chunk;
+      }
+    }
   }
 }
 
@@ -139,6 +159,9 @@ void BLO_memfile_write_finalize(MemFileWriteData *mem_data)
   if (mem_data->id_session_uuid_mapping != nullptr) {
     BLI_ghash_free(mem_data->id_session_uuid_mapping, nullptr, nullptr);
   }
+  if (mem_data->chunk_hash_mapping != nullptr) {
+    BLI_ghash_free(mem_data->chunk_hash_mapping, nullptr, nullptr);
+  }
 }
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size)
@@ -151,6 +174,7 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   curchunk->size = size;
   curchunk->buf = nullptr;
   curchunk->is_identical = false;
+  curchunk->is_shared = false;
   /* This is unsafe in the sense that an app handler or other code that does not
    * perform an undo push may make changes after the last undo push that
    * will then not be undo. Though it's not entirely clear that is wrong behavior. */
@@ -165,13 +189,29 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
       if (memcmp(compchunk->buf, buf, size) == 0) {
         curchunk->buf = compchunk->buf;
         curchunk->is_identical = true;
+        curchunk->is_shared = true;
+        curchunk->hash = compchunk->hash;
         compchunk->is_identical_future = true;
       }
     }
     *compchunk_step = static_cast<MemFileChunk *>(compchunk->next);
   }
 
-  /* not equal... */
+  /* Not equal, look for a chunk with the same contents elsewhere in the previous step. */
+  if (curchunk->buf == nullptr) {
+    curchunk->hash = BLI_hash_mm2((const uchar *)buf, size, 0);
+    if (mem_data->chunk_hash_mapping != nullptr) {
+      const MemFileChunk *refchunk = static_cast<const MemFileChunk *>(
+          BLI_ghash_lookup(mem_data->chunk_hash_mapping, POINTER_FROM_UINT(curchunk->hash)));
+      if (refchunk != nullptr && refchunk->size == size && memcmp(refchunk->buf, buf, size) == 0)
+      {
+        curchunk->buf = refchunk->buf;
+        curchunk->is_shared = true;
+      }
+    }
+  }
+
+  /* Not found, store a copy. */
   if (curchunk->buf == nullptr) {
     char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
     memcpy(buf_new, buf, size);
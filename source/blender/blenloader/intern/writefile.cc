@@ -180,6 +180,15 @@ struct WriteWrap {
     int level;
     ListBase frames;
 
+    /** Compressed frames waiting for earlier frames to be written, sorted by frame number. */
+    ListBase pending_frames;
+    /** Limit of frames being compressed or waiting to be written, to bound memory usage. */
+    int max_pending_frames;
+    /** Set while a worker thread writes out pending frames, only one can do so at a time. */
+    bool is_writing;
+    /** Compression contexts (#LinkData) not in use by a worker thread, reused between frames. */
+    ListBase contexts;
+
     bool write_error;
   } zstd;
 };
@@ -217,46 +226,107 @@ struct ZstdWriteBlockTask {
   WriteWrap *ww;
 };
 
+struct ZstdCompressedFrame {
+  ZstdCompressedFrame *next, *prev;
+  /** Null when compression failed. */
+  void *data;
+  size_t size;
+  size_t uncompressed_size;
+  int frame_number;
+};
+
+/**
+ * Write out the compressed frames that are next in order. Must be called with the mutex locked,
+ * which is released while writing so other threads can keep adding compressed frames.
+ */
+static void zstd_write_pending_frames(WriteWrap *ww)
+{
+  while (ww->zstd.pending_frames.first) {
+    ZstdCompressedFrame *frame = static_cast<ZstdCompressedFrame *>(ww->zstd.pending_frames.first);
+    if (frame->frame_number != ww->zstd.next_frame) {
+      break;
+    }
+    BLI_remlink(&ww->zstd.pending_frames, frame);
+    const bool skip = ww->zstd.write_error || frame->data == nullptr;
+
+    BLI_mutex_unlock(&ww->zstd.mutex);
+    const bool success = !skip && ww_write_none(ww,
+                                                static_cast<const char *>(frame->data),
+                                                frame->size) == frame->size;
+    BLI_mutex_lock(&ww->zstd.mutex);
+
+    if (success) {
+      ZstdFrame *frameinfo = static_cast<ZstdFrame *>(
+          MEM_mallocN(sizeof(ZstdFrame), "zstd frameinfo"));
+      frameinfo->uncompressed_size = frame->uncompressed_size;
+      frameinfo->compressed_size = frame->size;
+      BLI_addtail(&ww->zstd.frames, frameinfo);
+    }
+    else {
+      ww->zstd.write_error = true;
+    }
+    MEM_SAFE_FREE(frame->data);
+    MEM_freeN(frame);
+
+    ww->zstd.next_frame++;
+  }
+}
+
 static void *zstd_write_task(void *userdata)
 {
   ZstdWriteBlockTask *task = static_cast<ZstdWriteBlockTask *>(userdata);
   WriteWrap *ww = task->ww;
 
+  BLI_mutex_lock(&ww->zstd.mutex);
+  LinkData *ctx_link = static_cast<LinkData *>(BLI_pophead(&ww->zstd.contexts));
+  BLI_mutex_unlock(&ww->zstd.mutex);
+  ZSTD_CCtx *ctx;
+  if (ctx_link) {
+    ctx = static_cast<ZSTD_CCtx *>(ctx_link->data);
+    MEM_freeN(ctx_link);
+  }
+  else {
+    ctx = ZSTD_createCCtx();
+  }
+
+  ZstdCompressedFrame *frame = static_cast<ZstdCompressedFrame *>(
+      MEM_callocN(sizeof(ZstdCompressedFrame), __func__));
+  frame->uncompressed_size = task->size;
+  frame->frame_number = task->frame_number;
+
   size_t out_buf_len = ZSTD_compressBound(task->size);
-  void *out_buf = MEM_mallocN(out_buf_len, "Zstd out buffer");
-  size_t out_size = ZSTD_compress(
-      out_buf, out_buf_len, task->data, task->size, ZSTD_COMPRESSION_LEVEL);
+  frame->data = MEM_mallocN(out_buf_len, "Zstd out buffer");
+  frame->size = ZSTD_compressCCtx(
+      ctx, frame->data, out_buf_len, task->data, task->size, ZSTD_COMPRESSION_LEVEL);
+  if (ZSTD_isError(frame->size)) {
+    MEM_SAFE_FREE(frame->data);
+  }
 
   MEM_freeN(task->data);
 
   BLI_mutex_lock(&ww->zstd.mutex);
 
-  while (ww->zstd.next_frame != task->frame_number) {
-    BLI_condition_wait(&ww->zstd.condition, &ww->zstd.mutex);
-  }
+  BLI_addtail(&ww->zstd.contexts, BLI_genericNodeN(ctx));
 
-  if (ZSTD_isError(out_size)) {
-    ww->zstd.write_error = true;
-  }
-  else {
-    if (ww_write_none(ww, static_cast<const char *>(out_buf), out_size) == out_size) {
-      ZstdFrame *frameinfo = static_cast<ZstdFrame *>(
-          MEM_mallocN(sizeof(ZstdFrame), "zstd frameinfo"));
-      frameinfo->uncompressed_size = task->size;
-      frameinfo->compressed_size = out_size;
-      BLI_addtail(&ww->zstd.frames, frameinfo);
-    }
-    else {
-      ww->zstd.write_error = true;
-    }
+  /* Frames may finish compressing out of order, keep the pending list sorted. */
+  ZstdCompressedFrame *prev_frame = static_cast<ZstdCompressedFrame *>(
+      ww->zstd.pending_frames.last);
+  while (prev_frame && prev_frame->frame_number > frame->frame_number) {
+    prev_frame = prev_frame->prev;
   }
+  BLI_insertlinkafter(&ww->zstd.pending_frames, prev_frame, frame);
 
-  ww->zstd.next_frame++;
+  /* Instead of waiting for the earlier frames to be written, leave writing this frame to the
+   * thread that is already writing, so this thread is free to compress the next frame. */
+  if (!ww->zstd.is_writing) {
+    ww->zstd.is_writing = true;
+    zstd_write_pending_frames(ww);
+    ww->zstd.is_writing = false;
+  }
 
   BLI_mutex_unlock(&ww->zstd.mutex);
   BLI_condition_notify_all(&ww->zstd.condition);
 
-  MEM_freeN(out_buf);
   return nullptr;
 }
 
@@ -269,6 +339,7 @@ static bool ww_open_zstd(WriteWrap *ww, const char *filepath)
   /* Leave one thread open for the main writing logic, unless we only have one HW thread. */
   int num_threads = max_ii(1, BLI_system_thread_count() - 1);
   BLI_threadpool_init(&ww->zstd.threadpool, zstd_write_task, num_threads);
+  ww->zstd.max_pending_frames = num_threads * 4;
   BLI_mutex_init(&ww->zstd.mutex);
   BLI_condition_init(&ww->zstd.condition);
 
@@ -321,6 +392,13 @@ static bool ww_close_zstd(WriteWrap *ww)
   BLI_threadpool_end(&ww->zstd.threadpool);
   BLI_freelistN(&ww->zstd.tasks);
 
+  /* All frames are written by the worker threads once the earlier frames are done. */
+  BLI_assert(BLI_listbase_is_empty(&ww->zstd.pending_frames));
+  LISTBASE_FOREACH (LinkData *, link, &ww->zstd.contexts) {
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx *>(link->data));
+  }
+  BLI_freelistN(&ww->zstd.contexts);
+
   BLI_mutex_end(&ww->zstd.mutex);
   BLI_condition_end(&ww->zstd.condition);
 
@@ -336,6 +414,16 @@ static size_t ww_write_zstd(WriteWrap *ww, const char *buf, size_t buf_len)
     return 0;
   }
 
+  /* Compressed frames can pile up while an earlier frame is being written (e.g. to slow network
+   * storage), wait until enough of them are written out. */
+  BLI_mutex_lock(&ww->zstd.mutex);
+  while (ww->zstd.num_frames - ww->zstd.next_frame >= ww->zstd.max_pending_frames &&
+         !ww->zstd.write_error)
+  {
+    BLI_condition_wait(&ww->zstd.condition, &ww->zstd.mutex);
+  }
+  BLI_mutex_unlock(&ww->zstd.mutex);
+
   ZstdWriteBlockTask *task = static_cast<ZstdWriteBlockTask *>(
       MEM_mallocN(sizeof(ZstdWriteBlockTask), __func__));
   task->data = MEM_mallocN(buf_len, __func__);
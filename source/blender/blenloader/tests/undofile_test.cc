@@ -0,0 +1,76 @@
+/* SPDX-FileCopyrightText: 2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <cstring>
+
+#include "BLI_listbase.h"
+#include "BLI_span.hh"
+#include "BLI_string_ref.hh"
+
+#include "BLO_undofile.h"
+
+namespace blender::blenloader::tests {
+
+static void memfile_write(MemFile *memfile, MemFile *reference, const Span<const char *> chunks)
+{
+  MemFileWriteData mem_data = {};
+  BLO_memfile_write_init(&mem_data, memfile, reference);
+  for (const char *chunk : chunks) {
+    BLO_memfile_chunk_add(&mem_data, chunk, strlen(chunk));
+  }
+  BLO_memfile_write_finalize(&mem_data);
+}
+
+static MemFileChunk *memfile_chunk(MemFile *memfile, const int index)
+{
+  return static_cast<MemFileChunk *>(BLI_findlink(&memfile->chunks, index));
+}
+
+TEST(undofile, SharePreviousChunks)
+{
+  MemFile first = {};
+  MemFile second = {};
+  memfile_write(&first, nullptr, {"aaaa", "bbbb", "cccc"});
+  EXPECT_EQ(first.size, 12u);
+
+  /* Inserting a chunk moves the following ones, they are not identical anymore but still share
+   * memory with the previous step. */
+  memfile_write(&second, &first, {"aaaa", "xx", "bbbb", "cccc"});
+  EXPECT_EQ(second.size, 2u);
+
+  EXPECT_TRUE(memfile_chunk(&second, 0)->is_identical);
+  EXPECT_TRUE(memfile_chunk(&second, 0)->is_shared);
+  EXPECT_FALSE(memfile_chunk(&second, 1)->is_shared);
+  for (const int i : {2, 3}) {
+    MemFileChunk *chunk = memfile_chunk(&second, i);
+    EXPECT_FALSE(chunk->is_identical);
+    EXPECT_TRUE(chunk->is_shared);
+    EXPECT_EQ(chunk->buf, memfile_chunk(&first, i - 1)->buf);
+  }
+
+  BLO_memfile_merge(&first, &second);
+  EXPECT_FALSE(memfile_chunk(&second, 2)->is_shared);
+  EXPECT_FALSE(memfile_chunk(&second, 3)->is_shared);
+  EXPECT_EQ(StringRef(memfile_chunk(&second, 3)->buf, 4), "cccc");
+  BLO_memfile_free(&second);
+}
+
+TEST(undofile, ShareDuplicateChunks)
+{
+  MemFile first = {};
+  MemFile second = {};
+  memfile_write(&first, nullptr, {"aaaa", "bbbb"});
+  memfile_write(&second, &first, {"bbbb", "bbbb", "aaaa"});
+  EXPECT_EQ(second.size, 0u);
+
+  /* Only one of the chunks sharing the same memory takes over its ownership. */
+  BLO_memfile_merge(&first, &second);
+  EXPECT_NE(memfile_chunk(&second, 0)->is_shared, memfile_chunk(&second, 1)->is_shared);
+  EXPECT_FALSE(memfile_chunk(&second, 2)->is_shared);
+  BLO_memfile_free(&second);
+}
+
+}  // namespace blender::blenloader::tests
@@ -325,7 +325,9 @@ static void bake_simulation_job_startjob(void *customdata,
 
         BLI_file_ensure_parent_dir_exists(bdata_path);
         fstream bdata_file{bdata_path, std::ios::out | std::ios::binary};
-        bke::DiskBDataWriter bdata_writer{bdata_file_name, bdata_file, 0};
+        bke::BDataWriteSettings bdata_write_settings;
+        bdata_write_settings.quantization_max_error = nmd.simulation_bake_max_error;
+        bke::DiskBDataWriter bdata_writer{bdata_file_name, bdata_file, 0, bdata_write_settings};
 
         io::serialize::DictionaryValue io_root;
         bke::sim::serialize_modifier_simulation_state(
@@ -232,11 +232,17 @@ class FieldOperation : public FieldNode {
 
  public:
   FieldOperation(std::shared_ptr<const mf::MultiFunction> function, Vector<GField> inputs = {});
+  /**
+   * The function is referenced by pointer in cached field procedures. It has to be static, or
+   * #field_procedure_cache_clear has to be called when it is freed.
+   */
   FieldOperation(const mf::MultiFunction &function, Vector<GField> inputs = {});
   ~FieldOperation();
 
   Span<GField> inputs() const;
   const mf::MultiFunction &multi_function() const;
+  /** Null when the multi-function is not owned by this node. */
+  const std::shared_ptr<const mf::MultiFunction> &owned_multi_function() const;
 
   const CPPType &output_cpp_type(int output_index) const override;
 
@@ -492,6 +498,29 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
                                 const FieldContext &context,
                                 Span<GVMutableArray> dst_varrays = {});
 
+/**
+ * Same as #evaluate_fields, but the procedures built to compute the fields are cached, so that
+ * evaluating equivalent fields again is cheaper. That is most noticeable when fields are evaluated
+ * many times on small domains. Fields are compared by their structure, multi-functions, field
+ * inputs and constant values, so fields that are built again for every evaluation still use the
+ * cache. Only field inputs and constants are kept alive by the cache.
+ */
+Vector<GVArray> evaluate_fields_cached(ResourceScope &scope,
+                                       Span<GField> fields_to_evaluate,
+                                       const IndexMask &mask,
+                                       const FieldContext &context,
+                                       Span<GVMutableArray> dst_varrays = {});
+
+/**
+ * Free all cached procedures. This has to be called when multi-functions that are not owned by
+ * field operations may be freed, e.g. when the evaluation graph of a node tree is rebuilt or
+ * freed. Evaluations that run while the cache is cleared do not add their procedures to it.
+ */
+void field_procedure_cache_clear();
+
+/** Number of distinct field trees that procedures are cached for, used for testing. */
+int64_t field_procedure_cache_size();
+
 /* -------------------------------------------------------------------- */
 /** \name Utility functions for simple field creation and evaluation
  * \{ */
@@ -652,6 +681,12 @@ inline const mf::MultiFunction &FieldOperation::multi_function() const
   return *function_;
 }
 
+inline const std::shared_ptr<const mf::MultiFunction> &FieldOperation::owned_multi_function()
+    const
+{
+  return owned_function_;
+}
+
 inline const CPPType &FieldOperation::output_cpp_type(int output_index) const
 {
   int output_counter = 0;
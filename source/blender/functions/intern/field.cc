@@ -2,6 +2,11 @@
  *
  * SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <optional>
+
 #include "BLI_array_utils.hh"
 #include "BLI_map.hh"
 #include "BLI_multi_value_map.hh"
@@ -36,50 +41,6 @@ struct FieldTreeInfo {
   VectorSet<std::reference_wrapper<const FieldInput>> deduplicated_field_inputs;
 };
 
-/**
- * Collects some information from the field tree that is required by later steps.
- */
-static FieldTreeInfo preprocess_field_tree(Span<GFieldRef> entry_fields)
-{
-  FieldTreeInfo field_tree_info;
-
-  Stack<GFieldRef> fields_to_check;
-  Set<GFieldRef> handled_fields;
-
-  for (GFieldRef field : entry_fields) {
-    if (handled_fields.add(field)) {
-      fields_to_check.push(field);
-    }
-  }
-
-  while (!fields_to_check.is_empty()) {
-    GFieldRef field = fields_to_check.pop();
-    const FieldNode &field_node = field.node();
-    switch (field_node.node_type()) {
-      case FieldNodeType::Input: {
-        const FieldInput &field_input = static_cast<const FieldInput &>(field_node);
-        field_tree_info.deduplicated_field_inputs.add(field_input);
-        break;
-      }
-      case FieldNodeType::Operation: {
-        const FieldOperation &operation = static_cast<const FieldOperation &>(field_node);
-        for (const GFieldRef operation_input : operation.inputs()) {
-          field_tree_info.field_users.add(operation_input, field);
-          if (handled_fields.add(operation_input)) {
-            fields_to_check.push(operation_input);
-          }
-        }
-        break;
-      }
-      case FieldNodeType::Constant: {
-        /* Nothing to do. */
-        break;
-      }
-    }
-  }
-  return field_tree_info;
-}
-
 /**
  * Retrieves the data from the context that is passed as input into the field.
  */
@@ -142,11 +103,13 @@ static Set<GFieldRef> find_varying_fields(const FieldTreeInfo &field_tree_info,
 
 /**
  * Builds the #procedure so that it computes the fields.
+ * \param copy_constants: Whether the procedure owns copies of the constant values, so that it can
+ *   outlive the fields.
  */
 static void build_multi_function_procedure_for_fields(mf::Procedure &procedure,
-                                                      ResourceScope &scope,
                                                       const FieldTreeInfo &field_tree_info,
-                                                      Span<GFieldRef> output_fields)
+                                                      Span<GFieldRef> output_fields,
+                                                      const bool copy_constants)
 {
   mf::ProcedureBuilder builder{procedure};
   /* Every input, intermediate and output field corresponds to a variable in the procedure. */
@@ -238,7 +201,7 @@ static void build_multi_function_procedure_for_fields(mf::Procedure &procedure,
         case FieldNodeType::Constant: {
           const FieldConstant &constant_node = static_cast<const FieldConstant &>(field_node);
           const mf::MultiFunction &fn = procedure.construct_function<mf::CustomMF_GenericConstant>(
-              constant_node.type(), constant_node.value().get(), false);
+              constant_node.type(), constant_node.value().get(), copy_constants);
           mf::Variable &new_variable = *builder.add_call<1>(fn)[0];
           variable_by_field.add_new(field, &new_variable);
           break;
@@ -254,7 +217,7 @@ static void build_multi_function_procedure_for_fields(mf::Procedure &procedure,
     if (!already_output_variables.add(variable)) {
       /* One variable can be output at most once. To output the same value twice, we have to make
        * a copy first. */
-      const mf::MultiFunction &copy_fn = scope.construct<mf::CustomMF_GenericCopy>(
+      const mf::MultiFunction &copy_fn = procedure.construct_function<mf::CustomMF_GenericCopy>(
           variable->data_type());
       variable = builder.add_call<1>(copy_fn, {variable})[0];
     }
@@ -278,11 +241,428 @@ static void build_multi_function_procedure_for_fields(mf::Procedure &procedure,
   BLI_assert(procedure.validate());
 }
 
-Vector<GVArray> evaluate_fields(ResourceScope &scope,
-                                Span<GFieldRef> fields_to_evaluate,
-                                const IndexMask &mask,
-                                const FieldContext &context,
-                                Span<GVMutableArray> dst_varrays)
+/**
+ * Identifies an output of a node in a #FieldTreeKey.
+ */
+struct FieldTreeKeyOutput {
+  int node_index;
+  int output_index;
+
+  uint64_t hash() const
+  {
+    return get_default_hash_2(node_index, output_index);
+  }
+
+  friend bool operator==(const FieldTreeKeyOutput &a, const FieldTreeKeyOutput &b)
+  {
+    return a.node_index == b.node_index && a.output_index == b.output_index;
+  }
+};
+
+/**
+ * Describes the structure of field trees without referencing their operation nodes, which are
+ * usually built again for every evaluation, e.g. by geometry nodes. The same procedures can be
+ * used to compute field trees with equal keys.
+ */
+struct FieldTreeKey {
+  struct Node {
+    FieldNodeType type;
+    /**
+     * The multi-function of an operation. Its owner is compared as well, because another function
+     * may be allocated at the same address when an owned function is freed.
+     */
+    const mf::MultiFunction *function = nullptr;
+    std::weak_ptr<const mf::MultiFunction> function_owner;
+    bool function_is_owned = false;
+    Vector<FieldTreeKeyOutput, 4> inputs;
+    /** Field inputs and constants are compared by value. */
+    GField leaf;
+  };
+
+  /** Nodes are deduplicated the same way as in the other evaluation steps. */
+  Vector<Node> nodes;
+  /** The evaluated fields. */
+  Vector<FieldTreeKeyOutput> outputs;
+  uint64_t hash_value = 0;
+
+  uint64_t hash() const
+  {
+    return hash_value;
+  }
+
+  /**
+   * True when a multi-function owned by an operation has been freed. Such keys can't be equal to
+   * any key that is built later.
+   */
+  bool is_expired() const
+  {
+    for (const Node &node : nodes) {
+      if (node.function_is_owned && node.function_owner.expired()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  friend bool operator==(const FieldTreeKey &a, const FieldTreeKey &b)
+  {
+    if (a.hash_value != b.hash_value || a.outputs != b.outputs ||
+        a.nodes.size() != b.nodes.size())
+    {
+      return false;
+    }
+    for (const int i : a.nodes.index_range()) {
+      if (!nodes_equal(a.nodes[i], b.nodes[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static bool nodes_equal(const Node &a, const Node &b)
+  {
+    if (a.type != b.type) {
+      return false;
+    }
+    switch (a.type) {
+      case FieldNodeType::Operation: {
+        return a.function == b.function && !a.function_owner.owner_before(b.function_owner) &&
+               !b.function_owner.owner_before(a.function_owner) && a.inputs == b.inputs;
+      }
+      case FieldNodeType::Input: {
+        return a.leaf.node() == b.leaf.node();
+      }
+      case FieldNodeType::Constant: {
+        const FieldConstant &a_constant = static_cast<const FieldConstant &>(a.leaf.node());
+        const FieldConstant &b_constant = static_cast<const FieldConstant &>(b.leaf.node());
+        const CPPType &type = a_constant.type();
+        return type == b_constant.type() &&
+               type.is_equal(a_constant.value().get(), b_constant.value().get());
+      }
+    }
+    BLI_assert_unreachable();
+    return false;
+  }
+
+  static uint64_t node_hash(const Node &node)
+  {
+    switch (node.type) {
+      case FieldNodeType::Operation: {
+        uint64_t hash = get_default_hash(node.function);
+        for (const FieldTreeKeyOutput &input : node.inputs) {
+          hash = get_default_hash_2(hash, input);
+        }
+        return hash;
+      }
+      case FieldNodeType::Input: {
+        return node.leaf.node().hash();
+      }
+      case FieldNodeType::Constant: {
+        const FieldConstant &constant = static_cast<const FieldConstant &>(node.leaf.node());
+        return get_default_hash_2(constant.type().hash(),
+                                  constant.type().hash(constant.value().get()));
+      }
+    }
+    BLI_assert_unreachable();
+    return 0;
+  }
+};
+
+/**
+ * Field inputs that don't implement #FieldNode::hash and #FieldNode::is_equal_to are only equal to
+ * themselves. They are usually built again for every evaluation (e.g. the inputs of the Evaluate
+ * at Index and Evaluate on Domain nodes), so caching procedures for trees containing them would
+ * only fill the cache with entries that are never used again.
+ */
+static bool is_compared_by_identity(const FieldInput &field_input)
+{
+  return field_input.hash() == field_input.FieldNode::hash();
+}
+
+/**
+ * Builds the #FieldTreeKey of the evaluated fields while #preprocess_field_tree traverses them.
+ */
+class FieldTreeKeyBuilder {
+ private:
+  FieldTreeKey key_;
+  /* Nodes are identified like in the rest of the evaluation: equal field inputs are the same node,
+   * other nodes are compared by pointer. */
+  Map<GFieldRef, int> node_indices_;
+  bool is_cacheable_ = true;
+
+ public:
+  void add_output(const GField &field)
+  {
+    key_.outputs.append(this->get_output(field));
+  }
+
+  /**
+   * Add the inputs of an operation whose output has been added to the key before.
+   */
+  void add_operation_inputs(const FieldOperation &operation)
+  {
+    const int node_index = node_indices_.lookup(GFieldRef(operation));
+    if (key_.nodes[node_index].function != nullptr) {
+      /* Already added for another output of the operation. */
+      return;
+    }
+    Vector<FieldTreeKeyOutput, 4> inputs;
+    for (const GField &input : operation.inputs()) {
+      inputs.append(this->get_output(input));
+    }
+    /* Only get the node now, because adding the inputs may reallocate the nodes. */
+    FieldTreeKey::Node &node = key_.nodes[node_index];
+    node.function = &operation.multi_function();
+    node.function_owner = operation.owned_multi_function();
+    node.function_is_owned = bool(operation.owned_multi_function());
+    node.inputs = std::move(inputs);
+  }
+
+  /**
+   * \return The key of the field trees, or none if they can't be compared to other trees, because
+   *   they contain constants that are not hashable or inputs that are only compared by identity.
+   */
+  std::optional<FieldTreeKey> finish()
+  {
+    if (!is_cacheable_) {
+      return std::nullopt;
+    }
+    uint64_t hash = get_default_hash(key_.nodes.size());
+    for (const FieldTreeKey::Node &node : key_.nodes) {
+      hash = get_default_hash_2(hash, FieldTreeKey::node_hash(node));
+    }
+    for (const FieldTreeKeyOutput &output : key_.outputs) {
+      hash = get_default_hash_2(hash, output);
+    }
+    key_.hash_value = hash;
+    return std::move(key_);
+  }
+
+ private:
+  FieldTreeKeyOutput get_output(const GField &field)
+  {
+    const FieldNode &field_node = field.node();
+    const int node_index = node_indices_.lookup_or_add_cb(GFieldRef(field_node), [&]() {
+      FieldTreeKey::Node node;
+      node.type = field_node.node_type();
+      switch (node.type) {
+        case FieldNodeType::Operation: {
+          /* Filled in by #add_operation_inputs. */
+          break;
+        }
+        case FieldNodeType::Input: {
+          if (is_compared_by_identity(static_cast<const FieldInput &>(field_node))) {
+            is_cacheable_ = false;
+          }
+          node.leaf = field;
+          break;
+        }
+        case FieldNodeType::Constant: {
+          const CPPType &type = static_cast<const FieldConstant &>(field_node).type();
+          if (!type.is_hashable() || !type.is_equality_comparable()) {
+            is_cacheable_ = false;
+          }
+          node.leaf = field;
+          break;
+        }
+      }
+      return key_.nodes.append_and_get_index(std::move(node));
+    });
+    return {node_index, field.node_output_index()};
+  }
+};
+
+/**
+ * Collects some information from the field tree that is required by later steps.
+ * \param key_builder: When not null, the key for the procedure cache is built in the same
+ *   traversal. The entry fields have to be passed in as owned fields then.
+ */
+static FieldTreeInfo preprocess_field_tree(Span<GFieldRef> entry_fields,
+                                           Span<GField> owned_entry_fields,
+                                           FieldTreeKeyBuilder *key_builder)
+{
+  FieldTreeInfo field_tree_info;
+
+  Stack<GFieldRef> fields_to_check;
+  Set<GFieldRef> handled_fields;
+
+  if (key_builder) {
+    BLI_assert(owned_entry_fields.size() == entry_fields.size());
+    for (const GField &field : owned_entry_fields) {
+      key_builder->add_output(field);
+    }
+  }
+
+  for (GFieldRef field : entry_fields) {
+    if (handled_fields.add(field)) {
+      fields_to_check.push(field);
+    }
+  }
+
+  while (!fields_to_check.is_empty()) {
+    GFieldRef field = fields_to_check.pop();
+    const FieldNode &field_node = field.node();
+    switch (field_node.node_type()) {
+      case FieldNodeType::Input: {
+        const FieldInput &field_input = static_cast<const FieldInput &>(field_node);
+        field_tree_info.deduplicated_field_inputs.add(field_input);
+        break;
+      }
+      case FieldNodeType::Operation: {
+        const FieldOperation &operation = static_cast<const FieldOperation &>(field_node);
+        for (const GFieldRef operation_input : operation.inputs()) {
+          field_tree_info.field_users.add(operation_input, field);
+          if (handled_fields.add(operation_input)) {
+            fields_to_check.push(operation_input);
+          }
+        }
+        if (key_builder) {
+          key_builder->add_operation_inputs(operation);
+        }
+        break;
+      }
+      case FieldNodeType::Constant: {
+        /* Nothing to do. */
+        break;
+      }
+    }
+  }
+  return field_tree_info;
+}
+
+/**
+ * Procedures that only depend on the structure of the evaluated fields and not on the context
+ * they are evaluated in. They are cached, because the same fields are often built and evaluated
+ * many times, e.g. for every instance or for every iteration of a repeat zone, where building the
+ * procedures can take longer than evaluating them on small domains.
+ */
+struct FieldProcedureCacheEntry {
+  std::mutex mutex;
+  /**
+   * Procedures by the indices of the fields that they compute. Which fields are evaluated together
+   * depends on which field inputs vary in the context.
+   */
+  Map<Vector<int>, std::unique_ptr<mf::Procedure>> procedures;
+};
+
+/**
+ * Entries whose owned multi-functions have been freed are removed when a shard becomes too large,
+ * and if that is not enough, the shard is cleared.
+ */
+static constexpr int field_procedure_cache_max_entries = 1024;
+/**
+ * The cache is split into shards with separate locks, so that fields that are evaluated in
+ * parallel (e.g. for many instances) don't all wait for the same mutex.
+ */
+static constexpr int field_procedure_cache_shards_num = 16;
+
+struct FieldProcedureCacheShard {
+  std::mutex mutex;
+  Map<FieldTreeKey, std::shared_ptr<FieldProcedureCacheEntry>> entries;
+};
+
+struct FieldProcedureCache {
+  /**
+   * Incremented whenever the cache is cleared, because multi-functions that keys reference by
+   * pointer may be freed then. Keys built before that are not added to the cache anymore.
+   */
+  std::atomic<int64_t> generation = 0;
+  std::array<FieldProcedureCacheShard, field_procedure_cache_shards_num> shards;
+};
+
+static FieldProcedureCache &get_field_procedure_cache()
+{
+  static FieldProcedureCache cache;
+  return cache;
+}
+
+/**
+ * \param generation: The generation of the cache before the key was built.
+ * eturn The entry for the given key, or null if it can't be added to the cache anymore.
+ */
+static std::shared_ptr<FieldProcedureCacheEntry> lookup_field_procedure_cache(
+    FieldTreeKey key, const int64_t generation)
+{
+  FieldProcedureCache &cache = get_field_procedure_cache();
+  /* Use the high bits, the maps in the shards use the low bits already. */
+  FieldProcedureCacheShard &shard =
+      cache.shards[(key.hash() >> 32) % field_procedure_cache_shards_num];
+  constexpr int max_shard_entries = field_procedure_cache_max_entries /
+                                    field_procedure_cache_shards_num;
+
+  std::lock_guard lock{shard.mutex};
+  if (cache.generation.load() != generation) {
+    /* The cache was cleared while the key was built, it may reference freed functions. */
+    return nullptr;
+  }
+  if (const std::shared_ptr<FieldProcedureCacheEntry> *entry = shard.entries.lookup_ptr(key)) {
+    return *entry;
+  }
+  if (shard.entries.size() >= max_shard_entries) {
+    shard.entries.remove_if([](const auto item) { return item.key.is_expired(); });
+    if (shard.entries.size() >= max_shard_entries) {
+      shard.entries.clear();
+    }
+  }
+  return shard.entries.lookup_or_add(std::move(key), std::make_shared<FieldProcedureCacheEntry>());
+}
+
+/**
+ * Get the procedure that computes the fields with the given indices, building it if necessary.
+ */
+static const mf::Procedure &lookup_cached_procedure(FieldProcedureCacheEntry &entry,
+                                                    const FieldTreeInfo &field_tree_info,
+                                                    Span<GFieldRef> fields,
+                                                    Span<int> field_indices)
+{
+  std::lock_guard lock{entry.mutex};
+  return *entry.procedures.lookup_or_add_cb(field_indices, [&]() {
+    auto procedure = std::make_unique<mf::Procedure>();
+    /* The procedure is used for other fields later, so it must not reference their nodes. */
+    build_multi_function_procedure_for_fields(*procedure, field_tree_info, fields, true);
+    return procedure;
+  });
+}
+
+void field_procedure_cache_clear()
+{
+  FieldProcedureCache &cache = get_field_procedure_cache();
+  /* Increment the generation before clearing the shards, so that evaluations that started before
+   * can't add entries to shards that have been cleared already. */
+  cache.generation++;
+  for (FieldProcedureCacheShard &shard : cache.shards) {
+    /* Destruct the entries after releasing the lock, because destructing field nodes may be
+     * slow. */
+    Map<FieldTreeKey, std::shared_ptr<FieldProcedureCacheEntry>> entries;
+    {
+      std::lock_guard lock{shard.mutex};
+      entries = std::move(shard.entries);
+      shard.entries.clear();
+    }
+  }
+}
+
+int64_t field_procedure_cache_size()
+{
+  FieldProcedureCache &cache = get_field_procedure_cache();
+  int64_t size = 0;
+  for (FieldProcedureCacheShard &shard : cache.shards) {
+    std::lock_guard lock{shard.mutex};
+    size += shard.entries.size();
+  }
+  return size;
+}
+
+/**
+ * \param cached_fields: When not empty, these are the owned fields that are evaluated, and the
+ *   procedures are cached for them if possible.
+ */
+static Vector<GVArray> evaluate_fields_impl(ResourceScope &scope,
+                                            Span<GFieldRef> fields_to_evaluate,
+                                            Span<GField> cached_fields,
+                                            const IndexMask &mask,
+                                            const FieldContext &context,
+                                            Span<GVMutableArray> dst_varrays)
 {
   Vector<GVArray> r_varrays(fields_to_evaluate.size());
   Array<bool> is_output_written_to_dst(fields_to_evaluate.size(), false);
@@ -310,7 +690,32 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
   };
 
   /* Traverse the field tree and prepare some data that is used in later steps. */
-  FieldTreeInfo field_tree_info = preprocess_field_tree(fields_to_evaluate);
+  std::optional<FieldTreeKeyBuilder> key_builder;
+  int64_t cache_generation = 0;
+  if (!cached_fields.is_empty()) {
+    key_builder.emplace();
+    cache_generation = get_field_procedure_cache().generation.load();
+  }
+  FieldTreeInfo field_tree_info = preprocess_field_tree(
+      fields_to_evaluate, cached_fields, key_builder ? &*key_builder : nullptr);
+  std::shared_ptr<FieldProcedureCacheEntry> cache_entry;
+  if (key_builder) {
+    if (std::optional<FieldTreeKey> key = key_builder->finish()) {
+      cache_entry = lookup_field_procedure_cache(std::move(*key), cache_generation);
+    }
+  }
+
+  /* Utility to get the procedure that computes a subset of the fields. Procedures that are not
+   * cached are owned by the scope. */
+  auto get_procedure = [&](Span<GFieldRef> fields,
+                           Span<int> field_indices) -> const mf::Procedure & {
+    if (cache_entry) {
+      return lookup_cached_procedure(*cache_entry, field_tree_info, fields, field_indices);
+    }
+    mf::Procedure &procedure = scope.construct<mf::Procedure>();
+    build_multi_function_procedure_for_fields(procedure, field_tree_info, fields, false);
+    return procedure;
+  };
 
   /* Get inputs that will be passed into the field when evaluated. */
   Vector<GVArray> field_context_inputs = get_field_context_inputs(
@@ -368,9 +773,8 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
   /* Evaluate varying fields if necessary. */
   if (!varying_fields_to_evaluate.is_empty()) {
     /* Build the procedure for those fields. */
-    mf::Procedure procedure;
-    build_multi_function_procedure_for_fields(
-        procedure, scope, field_tree_info, varying_fields_to_evaluate);
+    const mf::Procedure &procedure = get_procedure(varying_fields_to_evaluate,
+                                                   varying_field_indices);
     mf::ProcedureExecutor procedure_executor{procedure};
 
     mf::ParamsBuilder mf_params{procedure_executor, &mask};
@@ -420,9 +824,8 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
   /* Evaluate constant fields if necessary. */
   if (!constant_fields_to_evaluate.is_empty()) {
     /* Build the procedure for those fields. */
-    mf::Procedure procedure;
-    build_multi_function_procedure_for_fields(
-        procedure, scope, field_tree_info, constant_fields_to_evaluate);
+    const mf::Procedure &procedure = get_procedure(constant_fields_to_evaluate,
+                                                   constant_field_indices);
     mf::ProcedureExecutor procedure_executor{procedure};
     const IndexMask mask(1);
     mf::ParamsBuilder mf_params{procedure_executor, &mask};
@@ -495,6 +898,28 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
   return r_varrays;
 }
 
+Vector<GVArray> evaluate_fields(ResourceScope &scope,
+                                Span<GFieldRef> fields_to_evaluate,
+                                const IndexMask &mask,
+                                const FieldContext &context,
+                                Span<GVMutableArray> dst_varrays)
+{
+  return evaluate_fields_impl(scope, fields_to_evaluate, {}, mask, context, dst_varrays);
+}
+
+Vector<GVArray> evaluate_fields_cached(ResourceScope &scope,
+                                       Span<GField> fields_to_evaluate,
+                                       const IndexMask &mask,
+                                       const FieldContext &context,
+                                       Span<GVMutableArray> dst_varrays)
+{
+  Array<GFieldRef> field_refs(fields_to_evaluate.size());
+  for (const int i : fields_to_evaluate.index_range()) {
+    field_refs[i] = fields_to_evaluate[i];
+  }
+  return evaluate_fields_impl(scope, field_refs, fields_to_evaluate, mask, context, dst_varrays);
+}
+
 void evaluate_constant_field(const GField &field, void *r_value)
 {
   if (field.node().depends_on_input()) {
@@ -779,7 +1204,7 @@ static IndexMask evaluate_selection(const Field<bool> &selection_field,
 {
   if (selection_field) {
     VArray<bool> selection =
-        evaluate_fields(scope, {selection_field}, full_mask, context)[0].typed<bool>();
+        evaluate_fields_cached(scope, {selection_field}, full_mask, context)[0].typed<bool>();
     return index_mask_from_selection(full_mask, selection, scope);
   }
   return full_mask;
@@ -791,11 +1216,8 @@ void FieldEvaluator::evaluate()
 
   selection_mask_ = evaluate_selection(selection_field_, context_, mask_, scope_);
 
-  Array<GFieldRef> fields(fields_to_evaluate_.size());
-  for (const int i : fields_to_evaluate_.index_range()) {
-    fields[i] = fields_to_evaluate_[i];
-  }
-  evaluated_varrays_ = evaluate_fields(scope_, fields, selection_mask_, context_, dst_varrays_);
+  evaluated_varrays_ = evaluate_fields_cached(
+      scope_, fields_to_evaluate_, selection_mask_, context_, dst_varrays_);
   BLI_assert(fields_to_evaluate_.size() == evaluated_varrays_.size());
   for (const int i : fields_to_evaluate_.index_range()) {
     OutputPointerInfo &info = output_pointer_infos_[i];
@@ -5,6 +5,7 @@
 #include "testing/testing.h"
 
 #include "BLI_cpp_type.hh"
+
 #include "FN_field.hh"
 #include "FN_multi_function_builder.hh"
 #include "FN_multi_function_test_common.hh"
@@ -39,6 +40,16 @@ class IndexFieldInput final : public FieldInput {
     auto index_func = [](int i) { return i; };
     return VArray<int>::ForFunc(mask.min_array_size(), index_func);
   }
+
+  uint64_t hash() const final
+  {
+    return 2387462;
+  }
+
+  bool is_equal_to(const FieldNode &other) const final
+  {
+    return dynamic_cast<const IndexFieldInput *>(&other) != nullptr;
+  }
 };
 
 TEST(field, VArrayInput)
@@ -281,4 +292,139 @@ TEST(field, IgnoredOutput)
   EXPECT_EQ(results.get(3), 5);
 }
 
+TEST(field, CachedProcedure)
+{
+  field_procedure_cache_clear();
+  auto add_fn = mf::build::SI2_SO<int, int, int>("add", [](int a, int b) { return a + b; });
+
+  /* Build new nodes for every evaluation, like geometry nodes does. */
+  auto evaluate = [&](const int constant, const int size) {
+    GField index_field{std::make_shared<IndexFieldInput>()};
+    Field<int> constant_field = make_constant_field<int>(constant);
+    Field<int> varying_field{FieldOperation::Create(add_fn, {index_field, constant_field})};
+    Field<int> constant_sum_field{
+        FieldOperation::Create(add_fn, {constant_field, constant_field})};
+
+    Array<int> result_1(size);
+    Array<int> result_2(size);
+    FieldContext context;
+    FieldEvaluator evaluator{context, size};
+    evaluator.add_with_destination(varying_field, result_1.as_mutable_span());
+    evaluator.add_with_destination(constant_sum_field, result_2.as_mutable_span());
+    evaluator.evaluate();
+    for (const int i : IndexRange(size)) {
+      EXPECT_EQ(result_1[i], i + constant);
+      EXPECT_EQ(result_2[i], 2 * constant);
+    }
+  };
+
+  evaluate(10, 1);
+  EXPECT_EQ(field_procedure_cache_size(), 1);
+
+  /* Equivalent fields use the same cache entry, also on domains of different sizes. */
+  evaluate(10, 5);
+  evaluate(10, 3);
+  EXPECT_EQ(field_procedure_cache_size(), 1);
+
+  /* Other constant values are not computed by the same procedures. */
+  evaluate(20, 3);
+  EXPECT_EQ(field_procedure_cache_size(), 2);
+  evaluate(10, 3);
+  EXPECT_EQ(field_procedure_cache_size(), 2);
+
+  field_procedure_cache_clear();
+  EXPECT_EQ(field_procedure_cache_size(), 0);
+}
+
+TEST(field, CachedProcedureOwnedFunction)
+{
+  field_procedure_cache_clear();
+
+  auto evaluate = [](const std::shared_ptr<const mf::MultiFunction> &fn) {
+    Field<int> field{FieldOperation::Create(fn)};
+    Array<int> result(2);
+    FieldContext context;
+    FieldEvaluator evaluator{context, 2};
+    evaluator.add_with_destination(field, result.as_mutable_span());
+    evaluator.evaluate();
+    EXPECT_EQ(result[1], 5);
+  };
+
+  std::shared_ptr<const mf::MultiFunction> fn = std::make_shared<mf::CustomMF_Constant<int>>(5);
+  evaluate(fn);
+  evaluate(fn);
+  EXPECT_EQ(field_procedure_cache_size(), 1);
+
+  /* The cache does not keep the function alive. A new function does not match, even when it is
+   * allocated at the address of the freed one. */
+  fn.reset();
+  fn = std::make_shared<mf::CustomMF_Constant<int>>(5);
+  evaluate(fn);
+  EXPECT_EQ(field_procedure_cache_size(), 2);
+
+  field_procedure_cache_clear();
+}
+
+/** A field input that does not implement hashing, so it is only equal to itself. */
+class UnhashedIndexFieldInput final : public FieldInput {
+ public:
+  UnhashedIndexFieldInput() : FieldInput(CPPType::get<int>(), "Unhashed Index") {}
+
+  GVArray get_varray_for_context(const FieldContext & /*context*/,
+                                 const IndexMask &mask,
+                                 ResourceScope & /*scope*/) const final
+  {
+    auto index_func = [](int i) { return i; };
+    return VArray<int>::ForFunc(mask.min_array_size(), index_func);
+  }
+};
+
+TEST(field, CachedProcedureStructure)
+{
+  field_procedure_cache_clear();
+  auto add_fn = mf::build::SI2_SO<int, int, int>("add", [](int a, int b) { return a + b; });
+  auto mul_fn = mf::build::SI2_SO<int, int, int>("mul", [](int a, int b) { return a * b; });
+
+  /* Compute `(index + 2) * 3` or `(index * 2) + 3` from newly built nodes. */
+  auto evaluate = [&](const GField &index_field, const bool add_first) {
+    const mf::MultiFunction &add = add_fn;
+    const mf::MultiFunction &mul = mul_fn;
+    const mf::MultiFunction &first_fn = add_first ? add : mul;
+    const mf::MultiFunction &second_fn = add_first ? mul : add;
+    Field<int> first_field{
+        FieldOperation::Create(first_fn, {index_field, make_constant_field<int>(2)})};
+    Field<int> second_field{
+        FieldOperation::Create(second_fn, {first_field, make_constant_field<int>(3)})};
+
+    Array<int> result(4);
+    FieldContext context;
+    FieldEvaluator evaluator{context, 4};
+    evaluator.add_with_destination(second_field, result.as_mutable_span());
+    evaluator.evaluate();
+    for (const int i : result.index_range()) {
+      EXPECT_EQ(result[i], add_first ? (i + 2) * 3 : i * 2 + 3);
+    }
+  };
+
+  evaluate(GField{std::make_shared<IndexFieldInput>()}, true);
+  EXPECT_EQ(field_procedure_cache_size(), 1);
+
+  /* Rebuilding the same tree hits the cache entry. */
+  evaluate(GField{std::make_shared<IndexFieldInput>()}, true);
+  EXPECT_EQ(field_procedure_cache_size(), 1);
+
+  /* The same nodes connected differently don't. */
+  evaluate(GField{std::make_shared<IndexFieldInput>()}, false);
+  EXPECT_EQ(field_procedure_cache_size(), 2);
+  evaluate(GField{std::make_shared<IndexFieldInput>()}, false);
+  EXPECT_EQ(field_procedure_cache_size(), 2);
+
+  /* Trees with inputs that are only equal to themselves are never equal to trees built later, so
+   * they are not added to the cache. */
+  evaluate(GField{std::make_shared<UnhashedIndexFieldInput>()}, true);
+  EXPECT_EQ(field_procedure_cache_size(), 2);
+
+  field_procedure_cache_clear();
+}
+
 }  // namespace blender::fn::tests
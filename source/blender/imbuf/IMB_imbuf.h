@@ -511,6 +511,30 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
  */
 void IMB_scaleImBuf_threaded(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+typedef enum eIMBScaleFilter {
+  /** Average of the covered pixels when scaling down, nearest pixel when scaling up. */
+  IMB_SCALE_FILTER_BOX = 0,
+  IMB_SCALE_FILTER_BILINEAR,
+  /** Catmull-Rom spline. */
+  IMB_SCALE_FILTER_BICUBIC,
+  /** Three lobed Lanczos, sharpest and slowest of the filters. */
+  IMB_SCALE_FILTER_LANCZOS,
+} eIMBScaleFilter;
+
+/**
+ * \attention Defined in `scaling.cc`.
+ *
+ * Resample the image with a separable filter: rows and columns are scaled in two passes, each
+ * running multi-threaded. When scaling down, the filter is widened so every source pixel
+ * contributes to the result. Float buffers may have 1 to 4 channels.
+ *
+ * Return true if \a ibuf is modified.
+ */
+bool IMB_scale_filtered(struct ImBuf *ibuf,
+                        unsigned int newx,
+                        unsigned int newy,
+                        eIMBScaleFilter filter);
+
 /**
  * \attention Defined in `writeimage.cc`.
  */
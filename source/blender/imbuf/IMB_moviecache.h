@@ -28,6 +28,26 @@ typedef void *(*MovieCacheGetPriorityDataFP)(void *userkey);
 typedef int (*MovieCacheGetItemPriorityFP)(void *last_userkey, void *priority_data);
 typedef void (*MovieCachePriorityDeleterFP)(void *priority_data);
 
+/**
+ * Statistics of a single cache, see #IMB_moviecache_get_stats.
+ *
+ * Cost is the time in seconds it took to produce a buffer, as passed to #IMB_moviecache_put_ex.
+ */
+typedef struct MovieCacheStats {
+  /** Number of items which currently hold a buffer. */
+  int items_num;
+  /** Memory used by the buffers of this cache, in bytes. */
+  size_t memory_in_use;
+  /** Number of lookups which did and did not find a buffer. */
+  uint64_t hits, misses;
+  /** Number of buffers freed to keep the global cache memory within its limit. */
+  uint64_t evictions;
+  /** Total cost of the buffers which are currently cached. */
+  double cost;
+  /** Total cost of the evicted buffers, which will have to be paid again when they are needed. */
+  double evicted_cost;
+} MovieCacheStats;
+
 void IMB_moviecache_init(void);
 void IMB_moviecache_destruct(void);
 
@@ -43,6 +63,17 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
                                           MovieCachePriorityDeleterFP prioritydeleterfp);
 
 void IMB_moviecache_put(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
+/**
+ * Same as #IMB_moviecache_put, but also records how expensive the buffer was to produce.
+ *
+ * All caches share one global memory limit. When it is exceeded, buffers which are cheap to
+ * produce again for their size are freed before expensive ones. The cost is given in seconds,
+ * zero means it is unknown and the buffer is considered to be of average cost.
+ */
+void IMB_moviecache_put_ex(struct MovieCache *cache,
+                           void *userkey,
+                           struct ImBuf *ibuf,
+                           float cost);
 bool IMB_moviecache_put_if_possible(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
 struct ImBuf *IMB_moviecache_get(struct MovieCache *cache, void *userkey, bool *r_is_cached_empty);
 void IMB_moviecache_remove(struct MovieCache *cache, void *userkey);
@@ -61,6 +92,11 @@ void IMB_moviecache_cleanup(struct MovieCache *cache,
 void IMB_moviecache_get_cache_segments(
     struct MovieCache *cache, int proxy, int render_flags, int *r_totseg, int **r_points);
 
+/**
+ * Get memory, hit rate and cost statistics of the cache.
+ */
+void IMB_moviecache_get_stats(struct MovieCache *cache, MovieCacheStats *r_stats);
+
 struct MovieCacheIter;
 struct MovieCacheIter *IMB_moviecacheIter_new(struct MovieCache *cache);
 void IMB_moviecacheIter_free(struct MovieCacheIter *iter);
@@ -35,6 +35,8 @@
 #include "BLI_task.h"
 #include "BLI_threads.h"
 
+#include "PIL_time.h"
+
 #include "BKE_appdir.h"
 #include "BKE_colortools.h"
 #include "BKE_context.h"
@@ -396,7 +398,8 @@ static void colormanage_cache_put(ImBuf *ibuf,
                                   const ColormanageCacheViewSettings *view_settings,
                                   const ColormanageCacheDisplaySettings *display_settings,
                                   uchar *display_buffer,
-                                  void **cache_handle)
+                                  void **cache_handle,
+                                  float cost)
 {
   ColormanageCacheKey key;
   ImBuf *cache_ibuf;
@@ -430,7 +433,7 @@ static void colormanage_cache_put(ImBuf *ibuf,
 
   *cache_handle = cache_ibuf;
 
-  IMB_moviecache_put(moviecache, &key, cache_ibuf);
+  IMB_moviecache_put_ex(moviecache, &key, cache_ibuf, cost);
 }
 
 static void colormanage_cache_handle_release(void *cache_handle)
@@ -2733,11 +2736,16 @@ uchar *IMB_display_buffer_acquire(ImBuf *ibuf,
   buffer_size = DISPLAY_BUFFER_CHANNELS * size_t(ibuf->x) * ibuf->y * sizeof(char);
   display_buffer = static_cast<uchar *>(MEM_callocN(buffer_size, "imbuf display buffer"));
 
+  const double start_time = PIL_check_seconds_timer();
   colormanage_display_buffer_process(
       ibuf, display_buffer, applied_view_settings, display_settings);
 
-  colormanage_cache_put(
-      ibuf, &cache_view_settings, &cache_display_settings, display_buffer, cache_handle);
+  colormanage_cache_put(ibuf,
+                        &cache_view_settings,
+                        &cache_display_settings,
+                        display_buffer,
+                        cache_handle,
+                        float(PIL_check_seconds_timer() - start_time));
 
   BLI_thread_unlock(LOCK_COLORMANAGE);
 
@@ -8,6 +8,8 @@
 
 #undef DEBUG_MESSAGES
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib> /* for qsort */
 #include <memory.h>
 #include <mutex>
@@ -15,6 +17,8 @@
 #include "MEM_CacheLimiterC-Api.h"
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_ghash.h"
 #include "BLI_mempool.h"
 #include "BLI_string.h"
@@ -44,6 +48,16 @@ static MEM_CacheLimiterC *limitor = nullptr;
  * so regular mutex will not work here, hence the recursive lock. */
 static std::recursive_mutex limitor_lock;
 
+/* Logical clock, advanced on every put and successful get. Used to find the least recently used
+ * items of caches which have no priority callback of their own. */
+static uint64_t access_clock = 0;
+
+/* Sum of cost and size of all cached items with a known cost, to get the average cost per byte
+ * which other items are compared against. Protected by #limitor_lock. */
+static double known_cost_total = 0.0;
+static double known_size_total = 0.0;
+static int known_cost_items_num = 0;
+
 struct MovieCache {
   char name[64];
 
@@ -65,7 +79,12 @@ struct MovieCache {
   void *last_userkey;
 
   int totseg, *points, proxy, render_flags; /* for visual statistics optimization */
-  int pad;
+  int items_num;
+
+  /* Statistics, see #MovieCacheStats. Counters are updated atomically, the rest is protected by
+   * #limitor_lock. */
+  uint64_t hits, misses, evictions;
+  double cost, evicted_cost;
 };
 
 struct MovieCacheKey {
@@ -78,6 +97,12 @@ struct MovieCacheItem {
   ImBuf *ibuf;
   MEM_CacheLimiterHandleC *c_handle;
   void *priority_data;
+  /* Time in seconds it took to produce #ibuf, zero when unknown. */
+  float cost;
+  /* Size of #ibuf when it was added, used to keep the cost statistics balanced. */
+  size_t size;
+  /* Value of #access_clock when the item was last added or used. */
+  uint64_t last_access;
   /* Indicates that #ibuf is null, because there was an error during load. */
   bool added_empty;
 };
@@ -106,6 +131,49 @@ static void moviecache_keyfree(void *val)
   BLI_mempool_free(key->cache_owner->keys_pool, key);
 }
 
+static void moviecache_item_account(MovieCacheItem *item)
+{
+  MovieCache *cache = item->cache_owner;
+
+  if (!item->ibuf) {
+    return;
+  }
+
+  cache->items_num++;
+  cache->cost += item->cost;
+
+  if (item->cost > 0.0f && item->size > 0) {
+    known_cost_total += item->cost;
+    known_size_total += item->size;
+    known_cost_items_num++;
+  }
+}
+
+static void moviecache_item_unaccount(MovieCacheItem *item)
+{
+  MovieCache *cache = item->cache_owner;
+
+  if (!item->ibuf) {
+    return;
+  }
+
+  cache->items_num--;
+  cache->cost = cache->items_num ? std::max(cache->cost - item->cost, 0.0) : 0.0;
+
+  if (item->cost > 0.0f && item->size > 0) {
+    known_cost_items_num--;
+    if (known_cost_items_num == 0) {
+      /* Avoid accumulating floating point error over long sessions. */
+      known_cost_total = 0.0;
+      known_size_total = 0.0;
+    }
+    else {
+      known_cost_total = std::max(known_cost_total - item->cost, 0.0);
+      known_size_total = std::max(known_size_total - item->size, 0.0);
+    }
+  }
+}
+
 static void moviecache_valfree(void *val)
 {
   MovieCacheItem *item = (MovieCacheItem *)val;
@@ -116,6 +184,7 @@ static void moviecache_valfree(void *val)
   if (item->c_handle) {
     limitor_lock.lock();
     MEM_CacheLimiter_unmanage(item->c_handle);
+    moviecache_item_unaccount(item);
     limitor_lock.unlock();
   }
 
@@ -171,15 +240,26 @@ static void moviecache_destructor(void *p)
 {
   MovieCacheItem *item = (MovieCacheItem *)p;
 
-  if (item && item->ibuf) {
+  if (item == nullptr) {
+    return;
+  }
+
+  /* The limiter has released its handle, also for items which were added empty. */
+  item->c_handle = nullptr;
+
+  if (item->ibuf) {
     MovieCache *cache = item->cache_owner;
 
     PRINT("%s: cache '%s' destroy item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
+    /* Only called from #MEM_CacheLimiter_enforce_limits, with #limitor_lock held. */
+    moviecache_item_unaccount(item);
+    cache->evictions++;
+    cache->evicted_cost += item->cost;
+
     IMB_freeImBuf(item->ibuf);
 
     item->ibuf = nullptr;
-    item->c_handle = nullptr;
 
     /* force cached segments to be updated */
     MEM_SAFE_FREE(cache->points);
@@ -207,27 +287,48 @@ static size_t get_item_size(void *p)
   return size;
 }
 
-static int get_item_priority(void *item_v, int default_priority)
+/**
+ * How much more expensive than the average it is to produce the item again, per byte of memory.
+ * Items of unknown cost are considered to be average.
+ */
+static double get_item_relative_cost(const MovieCacheItem *item)
+{
+  if (item->cost <= 0.0f || item->size == 0 || known_cost_total <= 0.0) {
+    return 1.0;
+  }
+
+  const double cost_per_byte = double(item->cost) / double(item->size);
+  const double average_cost_per_byte = known_cost_total / known_size_total;
+
+  /* Keep recency in control, a very expensive frame which is never used again should still go
+   * eventually. */
+  return std::clamp(cost_per_byte / average_cost_per_byte, 1.0 / 64.0, 64.0);
+}
+
+/**
+ * Lower priority items are freed first. The priority is the distance of the item from what is
+ * currently used, scaled down by how expensive the item is to produce again.
+ */
+static int64_t get_item_priority(void *item_v, int64_t /*default_priority*/)
 {
   MovieCacheItem *item = (MovieCacheItem *)item_v;
   MovieCache *cache = item->cache_owner;
-  int priority;
-
-  if (!cache->getitempriorityfp) {
-    PRINT("%s: cache '%s' item %p use default priority %d\n",
-          __func__,
-          cache->name,
-          item,
-          default_priority);
+  double distance;
 
-    return default_priority;
+  if (cache->getitempriorityfp) {
+    /* Callbacks return zero for the most important item and negative values for others. */
+    distance = 1.0 - double(cache->getitempriorityfp(cache->last_userkey, item->priority_data));
+  }
+  else {
+    /* Least recently used items go first. */
+    distance = 1.0 + double(atomic_load_uint64(&access_clock) - item->last_access);
   }
 
-  priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
+  const double priority = -distance * 64.0 / get_item_relative_cost(item);
 
-  PRINT("%s: cache '%s' item %p priority %d\n", __func__, cache->name, item, priority);
+  PRINT("%s: cache '%s' item %p priority %f\n", __func__, cache->name, item, priority);
 
-  return priority;
+  return int64_t(std::max(priority, double(INT64_MIN)));
 }
 
 static bool get_item_destroyable(void *item_v)
@@ -307,7 +408,8 @@ void IMB_moviecache_set_priority_callback(MovieCache *cache,
   cache->prioritydeleterfp = prioritydeleterfp;
 }
 
-static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, bool need_lock)
+static void do_moviecache_put(
+    MovieCache *cache, void *userkey, ImBuf *ibuf, float cost, bool need_lock)
 {
   MovieCacheKey *key;
   MovieCacheItem *item;
@@ -333,6 +435,9 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
   item->cache_owner = cache;
   item->c_handle = nullptr;
   item->priority_data = nullptr;
+  item->cost = std::max(cost, 0.0f);
+  item->size = (ibuf == nullptr) ? 0 : get_size_in_memory(ibuf);
+  item->last_access = atomic_add_and_fetch_uint64(&access_clock, 1);
   item->added_empty = ibuf == nullptr;
 
   if (cache->getprioritydatafp) {
@@ -350,6 +455,7 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
   }
 
   item->c_handle = MEM_CacheLimiter_insert(limitor, item);
+  moviecache_item_account(item);
 
   MEM_CacheLimiter_ref(item->c_handle);
   MEM_CacheLimiter_enforce_limits(limitor);
@@ -367,7 +473,12 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 
 void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
-  do_moviecache_put(cache, userkey, ibuf, true);
+  do_moviecache_put(cache, userkey, ibuf, 0.0f, true);
+}
+
+void IMB_moviecache_put_ex(MovieCache *cache, void *userkey, ImBuf *ibuf, float cost)
+{
+  do_moviecache_put(cache, userkey, ibuf, cost, true);
 }
 
 bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibuf)
@@ -382,7 +493,7 @@ bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibu
   mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
 
   if (mem_in_use + elem_size <= mem_limit) {
-    do_moviecache_put(cache, userkey, ibuf, false);
+    do_moviecache_put(cache, userkey, ibuf, 0.0f, false);
     result = true;
   }
 
@@ -416,17 +527,22 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey, bool *r_is_cached_em
     if (item->ibuf) {
       limitor_lock.lock();
       MEM_CacheLimiter_touch(item->c_handle);
+      item->last_access = atomic_add_and_fetch_uint64(&access_clock, 1);
       limitor_lock.unlock();
 
       IMB_refImBuf(item->ibuf);
 
+      atomic_add_and_fetch_uint64(&cache->hits, 1);
       return item->ibuf;
     }
     if (r_is_cached_empty) {
       *r_is_cached_empty = true;
     }
+    atomic_add_and_fetch_uint64(&cache->hits, 1);
+    return nullptr;
   }
 
+  atomic_add_and_fetch_uint64(&cache->misses, 1);
   return nullptr;
 }
 
@@ -573,6 +689,32 @@ void IMB_moviecache_get_cache_segments(
   }
 }
 
+void IMB_moviecache_get_stats(MovieCache *cache, MovieCacheStats *r_stats)
+{
+  GHashIterator gh_iter;
+
+  memset(r_stats, 0, sizeof(*r_stats));
+
+  limitor_lock.lock();
+
+  GHASH_ITER (gh_iter, cache->hash) {
+    MovieCacheItem *item = (MovieCacheItem *)BLI_ghashIterator_getValue(&gh_iter);
+
+    if (item->ibuf) {
+      r_stats->memory_in_use += get_item_size(item);
+    }
+  }
+
+  r_stats->items_num = cache->items_num;
+  r_stats->hits = atomic_load_uint64(&cache->hits);
+  r_stats->misses = atomic_load_uint64(&cache->misses);
+  r_stats->evictions = cache->evictions;
+  r_stats->cost = cache->cost;
+  r_stats->evicted_cost = cache->evicted_cost;
+
+  limitor_lock.unlock();
+}
+
 MovieCacheIter *IMB_moviecacheIter_new(MovieCache *cache)
 {
   GHashIterator *iter;
@@ -8,8 +8,11 @@
 
 #include <cmath>
 
+#include "BLI_array.hh"
 #include "BLI_math_color.h"
 #include "BLI_math_interp.h"
+#include "BLI_simd.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 #include "MEM_guardedalloc.h"
 
@@ -1816,3 +1819,334 @@ void IMB_scaleImBuf_threaded(ImBuf *ibuf, uint newx, uint newy)
     IMB_assign_float_buffer(ibuf, init_data.float_buffer, IB_TAKE_OWNERSHIP);
   }
 }
+
+/* -------------------------------------------------------------------- */
+/** \name Filtered Scaling
+ * \{ */
+
+static float scale_filter_support(const eIMBScaleFilter filter)
+{
+  switch (filter) {
+    case IMB_SCALE_FILTER_BOX:
+      return 0.5f;
+    case IMB_SCALE_FILTER_BILINEAR:
+      return 1.0f;
+    case IMB_SCALE_FILTER_BICUBIC:
+      return 2.0f;
+    case IMB_SCALE_FILTER_LANCZOS:
+      return 3.0f;
+  }
+  BLI_assert_unreachable();
+  return 1.0f;
+}
+
+static float scale_filter_weight(const eIMBScaleFilter filter, const float x)
+{
+  switch (filter) {
+    case IMB_SCALE_FILTER_BOX:
+      return (x >= -0.5f && x < 0.5f) ? 1.0f : 0.0f;
+    case IMB_SCALE_FILTER_BILINEAR:
+      return max_ff(1.0f - fabsf(x), 0.0f);
+    case IMB_SCALE_FILTER_BICUBIC: {
+      /* Keys cubic with `a = -0.5`, which is the Catmull-Rom spline. */
+      const float a = -0.5f;
+      const float t = fabsf(x);
+      if (t < 1.0f) {
+        return ((a + 2.0f) * t - (a + 3.0f)) * t * t + 1.0f;
+      }
+      if (t < 2.0f) {
+        return ((a * t - 5.0f * a) * t + 8.0f * a) * t - 4.0f * a;
+      }
+      return 0.0f;
+    }
+    case IMB_SCALE_FILTER_LANCZOS: {
+      const float t = fabsf(x);
+      if (t < 1e-6f) {
+        return 1.0f;
+      }
+      if (t >= 3.0f) {
+        return 0.0f;
+      }
+      const float pi_t = float(M_PI) * t;
+      return 3.0f * sinf(pi_t) * sinf(pi_t / 3.0f) / (pi_t * pi_t);
+    }
+  }
+  BLI_assert_unreachable();
+  return 0.0f;
+}
+
+/** Source pixels and their weights for every destination pixel along one axis. */
+struct ScaleAxisWeights {
+  /** First source pixel of the filter window of each destination pixel. */
+  blender::Array<int> start;
+  /** Normalized weights, `window_size` values for each destination pixel. */
+  blender::Array<float> weights;
+  int window_size;
+};
+
+static void scale_axis_weights_init(ScaleAxisWeights &r_weights,
+                                    const int src_size,
+                                    const int dst_size,
+                                    const eIMBScaleFilter filter)
+{
+  const float scale = float(src_size) / float(dst_size);
+  /* Widen the filter when scaling down, to average all source pixels instead of skipping. */
+  const float filter_scale = max_ff(scale, 1.0f);
+  const float support = scale_filter_support(filter) * filter_scale;
+
+  /* The filter footprint never exceeds the source, which allows to clamp the window to it. */
+  r_weights.window_size = min_ii(int(ceilf(support)) * 2 + 1, src_size);
+  r_weights.start.reinitialize(dst_size);
+  r_weights.weights.reinitialize(int64_t(dst_size) * r_weights.window_size);
+  r_weights.weights.fill(0.0f);
+
+  for (int i = 0; i < dst_size; i++) {
+    const float center = (i + 0.5f) * scale;
+    const int start = max_ii(int(floorf(center - support + 0.5f)), 0);
+    const int end = min_ii(int(floorf(center + support + 0.5f)),
+                           min_ii(src_size, start + r_weights.window_size));
+    float *weights = &r_weights.weights[int64_t(i) * r_weights.window_size];
+
+    float weight_sum = 0.0f;
+    for (int j = start; j < end; j++) {
+      const float weight = scale_filter_weight(filter, (j + 0.5f - center) / filter_scale);
+      weights[j - start] = weight;
+      weight_sum += weight;
+    }
+
+    if (weight_sum != 0.0f) {
+      for (int j = start; j < end; j++) {
+        weights[j - start] /= weight_sum;
+      }
+    }
+    else {
+      /* Can only happen for degenerate windows, use the nearest pixel. */
+      weights[clamp_i(int(center) - start, 0, r_weights.window_size - 1)] = 1.0f;
+    }
+
+    /* Keep the window inside of the source, so it can be read without bounds checks. */
+    r_weights.start[i] = min_ii(start, max_ii(src_size - r_weights.window_size, 0));
+    if (r_weights.start[i] != start) {
+      const int shift = start - r_weights.start[i];
+      memmove(weights + shift, weights, sizeof(float) * (r_weights.window_size - shift));
+      memset(weights, 0, sizeof(float) * shift);
+    }
+  }
+}
+
+#if BLI_HAVE_SSE2
+BLI_INLINE __m128 scale_load_pixel(const uchar *pixel)
+{
+  int packed;
+  memcpy(&packed, pixel, sizeof(packed));
+  const __m128i zero = _mm_setzero_si128();
+  return _mm_cvtepi32_ps(
+      _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero));
+}
+
+BLI_INLINE __m128 scale_load_pixel(const float *pixel)
+{
+  return _mm_loadu_ps(pixel);
+}
+#endif
+
+/**
+ * Scale each row of `src` from `src_width` to `dst_width` pixels. Output is float, so the second
+ * pass does not lose precision.
+ */
+template<typename T>
+static void scale_rows(const T *src,
+                       float *dst,
+                       const int src_width,
+                       const int dst_width,
+                       const int height,
+                       const int channels,
+                       const ScaleAxisWeights &weights_x)
+{
+  const int window_size = weights_x.window_size;
+  const int64_t work_per_row = int64_t(dst_width) * window_size * channels;
+
+  blender::threading::parallel_for(
+      blender::IndexRange(height),
+      max_ii(1, int(16384 / max_ii(work_per_row, 1))),
+      [&](const blender::IndexRange rows) {
+        for (const int64_t y : rows) {
+          const T *src_row = src + y * src_width * channels;
+          float *dst_pixel = dst + y * dst_width * channels;
+
+          for (int x = 0; x < dst_width; x++, dst_pixel += channels) {
+            const T *src_pixel = src_row + int64_t(weights_x.start[x]) * channels;
+            const float *weights = &weights_x.weights[int64_t(x) * window_size];
+#if BLI_HAVE_SSE2
+            if (channels == 4) {
+              __m128 sum = _mm_setzero_ps();
+              for (int k = 0; k < window_size; k++, src_pixel += 4) {
+                sum = _mm_add_ps(sum,
+                                 _mm_mul_ps(scale_load_pixel(src_pixel), _mm_set1_ps(weights[k])));
+              }
+              _mm_storeu_ps(dst_pixel, sum);
+              continue;
+            }
+#endif
+            for (int c = 0; c < channels; c++) {
+              dst_pixel[c] = 0.0f;
+            }
+            for (int k = 0; k < window_size; k++, src_pixel += channels) {
+              for (int c = 0; c < channels; c++) {
+                dst_pixel[c] += float(src_pixel[c]) * weights[k];
+              }
+            }
+          }
+        }
+      });
+}
+
+BLI_INLINE void scale_store_value(float *dst, const float value)
+{
+  *dst = value;
+}
+
+BLI_INLINE void scale_store_value(uchar *dst, const float value)
+{
+  *dst = uchar(clamp_f(value + 0.5f, 0.0f, 255.0f));
+}
+
+/**
+ * Scale the columns of `src`, which has rows of `row_len` values, from `src_height` to
+ * `dst_height` rows. All values of a row are processed together, so memory is read linearly.
+ */
+template<typename T>
+static void scale_columns(const float *src,
+                          T *dst,
+                          const int64_t row_len,
+                          const int dst_height,
+                          const ScaleAxisWeights &weights_y)
+{
+  const int window_size = weights_y.window_size;
+
+  blender::threading::parallel_for(
+      blender::IndexRange(dst_height),
+      max_ii(1, int(16384 / max_ii(row_len * window_size, 1))),
+      [&](const blender::IndexRange rows) {
+        blender::Array<float> sum(row_len);
+
+        for (const int64_t y : rows) {
+          const float *weights = &weights_y.weights[y * window_size];
+          sum.fill(0.0f);
+
+          for (int k = 0; k < window_size; k++) {
+            const float weight = weights[k];
+            if (weight == 0.0f) {
+              continue;
+            }
+            const float *src_row = src + (weights_y.start[y] + k) * row_len;
+            int64_t i = 0;
+#if BLI_HAVE_SSE2
+            const __m128 weight_v = _mm_set1_ps(weight);
+            for (; i + 4 <= row_len; i += 4) {
+              _mm_storeu_ps(&sum[i],
+                            _mm_add_ps(_mm_loadu_ps(&sum[i]),
+                                       _mm_mul_ps(_mm_loadu_ps(src_row + i), weight_v)));
+            }
+#endif
+            for (; i < row_len; i++) {
+              sum[i] += src_row[i] * weight;
+            }
+          }
+
+          T *dst_row = dst + y * row_len;
+          for (int64_t i = 0; i < row_len; i++) {
+            scale_store_value(&dst_row[i], sum[i]);
+          }
+        }
+      });
+}
+
+template<typename T>
+static T *scale_buffer_filtered(const T *src,
+                                const int src_width,
+                                const int src_height,
+                                const int dst_width,
+                                const int dst_height,
+                                const int channels,
+                                const ScaleAxisWeights &weights_x,
+                                const ScaleAxisWeights &weights_y)
+{
+  T *dst = static_cast<T *>(
+      MEM_mallocN(sizeof(T) * channels * dst_width * dst_height, "scale_buffer_filtered"));
+  if (dst == nullptr) {
+    return nullptr;
+  }
+
+  float *tmp = static_cast<float *>(MEM_mallocN(
+      sizeof(float) * channels * dst_width * src_height, "scale_buffer_filtered tmp"));
+  if (tmp == nullptr) {
+    MEM_freeN(dst);
+    return nullptr;
+  }
+
+  scale_rows(src, tmp, src_width, dst_width, src_height, channels, weights_x);
+  scale_columns(tmp, dst, int64_t(dst_width) * channels, dst_height, weights_y);
+
+  MEM_freeN(tmp);
+  return dst;
+}
+
+bool IMB_scale_filtered(ImBuf *ibuf, uint newx, uint newy, eIMBScaleFilter filter)
+{
+  BLI_assert_msg(newx > 0 && newy > 0, "Images must be at least 1 on both dimensions!");
+
+  if (ibuf == nullptr) {
+    return false;
+  }
+  if (ibuf->byte_buffer.data == nullptr && ibuf->float_buffer.data == nullptr) {
+    return false;
+  }
+  if (newx == ibuf->x && newy == ibuf->y) {
+    return false;
+  }
+
+  ScaleAxisWeights weights_x, weights_y;
+  scale_axis_weights_init(weights_x, ibuf->x, newx, filter);
+  scale_axis_weights_init(weights_y, ibuf->y, newy, filter);
+
+  uchar *byte_buffer = nullptr;
+  float *float_buffer = nullptr;
+
+  if (ibuf->byte_buffer.data) {
+    byte_buffer = scale_buffer_filtered(
+        ibuf->byte_buffer.data, ibuf->x, ibuf->y, newx, newy, 4, weights_x, weights_y);
+    if (byte_buffer == nullptr) {
+      return false;
+    }
+  }
+  if (ibuf->float_buffer.data) {
+    float_buffer = scale_buffer_filtered(ibuf->float_buffer.data,
+                                         ibuf->x,
+                                         ibuf->y,
+                                         newx,
+                                         newy,
+                                         ibuf->channels,
+                                         weights_x,
+                                         weights_y);
+    if (float_buffer == nullptr) {
+      MEM_SAFE_FREE(byte_buffer);
+      return false;
+    }
+  }
+
+  if (byte_buffer) {
+    imb_freerectImBuf(ibuf);
+    IMB_assign_byte_buffer(ibuf, byte_buffer, IB_TAKE_OWNERSHIP);
+  }
+  if (float_buffer) {
+    imb_freerectfloatImBuf(ibuf);
+    IMB_assign_float_buffer(ibuf, float_buffer, IB_TAKE_OWNERSHIP);
+  }
+
+  ibuf->x = newx;
+  ibuf->y = newy;
+  return true;
+}
+
+/** \} */
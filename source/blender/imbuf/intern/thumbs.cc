@@ -423,7 +423,7 @@ static ImBuf *thumb_create_ex(const char *file_path,
           }
           imb_freerectfloatImBuf(img);
         }
-        IMB_scaleImBuf(img, ex, ey);
+        IMB_scale_filtered(img, ex, ey, IMB_SCALE_FILTER_BOX);
       }
     }
     SNPRINTF(desc, "Thumbnail for %s", uri);
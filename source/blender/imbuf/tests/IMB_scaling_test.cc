@@ -0,0 +1,147 @@
+/* SPDX-FileCopyrightText: 2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+namespace blender::imbuf::tests {
+
+class ImBufScalingTest : public testing::Test {
+ protected:
+  static void SetUpTestSuite()
+  {
+    IMB_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    IMB_exit();
+  }
+};
+
+static const eIMBScaleFilter all_filters[] = {
+    IMB_SCALE_FILTER_BOX,
+    IMB_SCALE_FILTER_BILINEAR,
+    IMB_SCALE_FILTER_BICUBIC,
+    IMB_SCALE_FILTER_LANCZOS,
+};
+
+/** Image with both byte and float pixels of a single color, float pixels have 3 channels. */
+static ImBuf *create_constant_image(const int width, const int height)
+{
+  ImBuf *ibuf = IMB_allocImBuf(width, height, 32, IB_rect);
+  imb_addrectfloatImBuf(ibuf, 3);
+  for (int64_t i = 0; i < int64_t(width) * height; i++) {
+    uchar *byte_pixel = ibuf->byte_buffer.data + i * 4;
+    byte_pixel[0] = 200;
+    byte_pixel[1] = 100;
+    byte_pixel[2] = 7;
+    byte_pixel[3] = 255;
+    float *float_pixel = ibuf->float_buffer.data + i * 3;
+    float_pixel[0] = 0.25f;
+    float_pixel[1] = 2.5f;
+    float_pixel[2] = -1.0f;
+  }
+  return ibuf;
+}
+
+static void expect_constant_image(const ImBuf *ibuf)
+{
+  for (int64_t i = 0; i < int64_t(ibuf->x) * ibuf->y; i++) {
+    const uchar *byte_pixel = ibuf->byte_buffer.data + i * 4;
+    EXPECT_EQ(byte_pixel[0], 200);
+    EXPECT_EQ(byte_pixel[1], 100);
+    EXPECT_EQ(byte_pixel[2], 7);
+    EXPECT_EQ(byte_pixel[3], 255);
+    const float *float_pixel = ibuf->float_buffer.data + i * 3;
+    EXPECT_NEAR(float_pixel[0], 0.25f, 1e-5f);
+    EXPECT_NEAR(float_pixel[1], 2.5f, 1e-5f);
+    EXPECT_NEAR(float_pixel[2], -1.0f, 1e-5f);
+  }
+}
+
+TEST_F(ImBufScalingTest, filtered_output_size)
+{
+  for (const eIMBScaleFilter filter : all_filters) {
+    ImBuf *ibuf = create_constant_image(13, 7);
+
+    EXPECT_TRUE(IMB_scale_filtered(ibuf, 5, 3, filter));
+    EXPECT_EQ(ibuf->x, 5);
+    EXPECT_EQ(ibuf->y, 3);
+    EXPECT_EQ(ibuf->channels, 3);
+    EXPECT_NE(ibuf->byte_buffer.data, nullptr);
+    EXPECT_NE(ibuf->float_buffer.data, nullptr);
+
+    EXPECT_TRUE(IMB_scale_filtered(ibuf, 29, 1, filter));
+    EXPECT_EQ(ibuf->x, 29);
+    EXPECT_EQ(ibuf->y, 1);
+
+    /* Nothing to do for the same size. */
+    EXPECT_FALSE(IMB_scale_filtered(ibuf, 29, 1, filter));
+
+    IMB_freeImBuf(ibuf);
+  }
+}
+
+TEST_F(ImBufScalingTest, filtered_constant_color)
+{
+  /* Weights are normalized, so a constant color stays the same, including at the borders. */
+  for (const eIMBScaleFilter filter : all_filters) {
+    ImBuf *ibuf = create_constant_image(37, 21);
+
+    IMB_scale_filtered(ibuf, 8, 5, filter);
+    expect_constant_image(ibuf);
+
+    IMB_scale_filtered(ibuf, 61, 40, filter);
+    expect_constant_image(ibuf);
+
+    IMB_freeImBuf(ibuf);
+  }
+}
+
+TEST_F(ImBufScalingTest, filtered_box_edge)
+{
+  /* A vertical edge between the third and fourth column. */
+  ImBuf *ibuf = IMB_allocImBuf(6, 2, 32, IB_rect);
+  for (int y = 0; y < 2; y++) {
+    for (int x = 0; x < 6; x++) {
+      uchar *pixel = ibuf->byte_buffer.data + (y * 6 + x) * 4;
+      const uchar value = (x < 3) ? 0 : 255;
+      pixel[0] = pixel[1] = pixel[2] = value;
+      pixel[3] = 255;
+    }
+  }
+
+  /* Every pixel is the average of two columns, only the middle one covers the edge. */
+  IMB_scale_filtered(ibuf, 3, 1, IMB_SCALE_FILTER_BOX);
+  const uchar *pixels = ibuf->byte_buffer.data;
+  EXPECT_EQ(pixels[0], 0);
+  EXPECT_EQ(pixels[4], 128);
+  EXPECT_EQ(pixels[8], 255);
+  EXPECT_EQ(pixels[11], 255);
+
+  IMB_freeImBuf(ibuf);
+}
+
+TEST_F(ImBufScalingTest, filtered_bilinear_edge)
+{
+  /* Two rows, scaled up vertically so the column pass interpolates between them. */
+  ImBuf *ibuf = IMB_allocImBuf(1, 2, 32, IB_rectfloat);
+  ibuf->float_buffer.data[0] = 0.0f;
+  ibuf->float_buffer.data[4] = 1.0f;
+
+  /* Pixels past the centers of the outer rows keep their value instead of fading to black. */
+  IMB_scale_filtered(ibuf, 1, 4, IMB_SCALE_FILTER_BILINEAR);
+  const float *pixels = ibuf->float_buffer.data;
+  EXPECT_NEAR(pixels[0], 0.0f, 1e-6f);
+  EXPECT_NEAR(pixels[4], 0.25f, 1e-6f);
+  EXPECT_NEAR(pixels[8], 0.75f, 1e-6f);
+  EXPECT_NEAR(pixels[12], 1.0f, 1e-6f);
+
+  IMB_freeImBuf(ibuf);
+}
+
+}  // namespace blender::imbuf::tests
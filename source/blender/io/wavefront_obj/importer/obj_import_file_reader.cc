@@ -10,6 +10,7 @@
 #include "BLI_math_color.h"
 #include "BLI_math_vector.h"
 #include "BLI_string_ref.hh"
+#include "BLI_task.hh"
 #include "BLI_vector.hh"
 
 #include "obj_export_mtl.hh"
@@ -23,6 +24,11 @@ namespace blender::io::obj {
 
 using std::string;
 
+/**
+ * Amount of read-buffer sized chunks that are read from the file at once and parsed in parallel.
+ */
+static constexpr size_t OBJ_PARSE_CHUNKS_PER_BATCH = 64;
+
 /**
  * Based on the properties of the given Geometry instance, create a new Geometry instance
  * or return the previous one.
@@ -66,11 +72,73 @@ static Geometry *create_geometry(Geometry *const prev_geometry,
   return new_geometry();
 }
 
-static void geom_add_vertex(const char *p, const char *end, GlobalVertices &r_global_vertices)
+/**
+ * A face corner with indices as they are spelled out in the file: one-based or relative,
+ * and not yet checked against the amount of vertex data read before the face.
+ */
+struct RawCorner {
+  PolyCorner corner;
+  bool has_uv = false;
+  bool has_normal = false;
+};
+
+/**
+ * A line that has to be handled in file order while merging chunks: either a face,
+ * or any other statement that depends on or changes the parser state.
+ */
+struct ChunkStatement {
+  /** Text of the line, empty for faces. */
+  StringRef line;
+  /** Corners of a face in #ObjChunk::face_corners, empty for other statements. */
+  IndexRange corners;
+  bool is_face = false;
+  /** Amount of chunk vertex data that precedes the statement in the file. */
+  int vertex_count = 0;
+  int vertex_color_count = 0;
+  int uv_vertex_count = 0;
+  int vert_normal_count = 0;
+};
+
+/**
+ * Part of the read buffer, split at line boundaries. All the chunks of the buffer are
+ * parsed in parallel: vertex data and face corners get decoded into the chunk itself,
+ * everything else is recorded as a statement. The chunks are then merged in file order.
+ */
+struct ObjChunk {
+  StringRef text;
+  Vector<float3> vertices;
+  /** Colors of `xyzrgb` vertices, along with chunk-local vertex index. */
+  Vector<std::pair<int, float3>> vertex_colors;
+  Vector<float2> uv_vertices;
+  Vector<float3> vert_normals;
+  Vector<RawCorner> face_corners;
+  Vector<ChunkStatement> statements;
+  size_t line_count = 0;
+
+  /* Merge progress, see #merge_chunk_vertices. */
+  int vertex_start = 0;
+  int merged_vertices = 0;
+  int merged_vertex_colors = 0;
+  int merged_uv_vertices = 0;
+  int merged_vert_normals = 0;
+
+  ChunkStatement &add_statement()
+  {
+    statements.append_as();
+    ChunkStatement &statement = statements.last();
+    statement.vertex_count = int(vertices.size());
+    statement.vertex_color_count = int(vertex_colors.size());
+    statement.uv_vertex_count = int(uv_vertices.size());
+    statement.vert_normal_count = int(vert_normals.size());
+    return statement;
+  }
+};
+
+static void geom_add_vertex(const char *p, const char *end, ObjChunk &r_chunk)
 {
   float3 vert;
   p = parse_floats(p, end, 0.0f, vert, 3);
-  r_global_vertices.vertices.append(vert);
+  r_chunk.vertices.append(vert);
   /* OBJ extension: `xyzrgb` vertex colors, when the vertex position
    * is followed by 3 more RGB color components. See
    * http://paulbourke.net/dataformats/obj/colour.html */
@@ -80,19 +148,56 @@ static void geom_add_vertex(const char *p, const char *end, GlobalVertices &r_gl
     if (srgb.x >= 0 && srgb.y >= 0 && srgb.z >= 0) {
       float3 linear;
       srgb_to_linearrgb_v3_v3(linear, srgb);
+      r_chunk.vertex_colors.append({int(r_chunk.vertices.size() - 1), linear});
+    }
+  }
+}
 
-      auto &blocks = r_global_vertices.vertex_colors;
-      /* If we don't have vertex colors yet, or the previous vertex
-       * was without color, we need to start a new vertex colors block. */
-      if (blocks.is_empty() || (blocks.last().start_vertex_index + blocks.last().colors.size() !=
-                                r_global_vertices.vertices.size() - 1))
-      {
-        GlobalVertices::VertexColorsBlock block;
-        block.start_vertex_index = r_global_vertices.vertices.size() - 1;
-        blocks.append(block);
-      }
-      blocks.last().colors.append(linear);
+/**
+ * Append chunk vertex data up to the given statement (or all of it, if there is none) to the
+ * global vertex lists. This way each statement sees the same amount of vertices as it would
+ * when parsing the whole file sequentially.
+ */
+static void merge_chunk_vertices(ObjChunk &chunk,
+                                 const ChunkStatement *statement,
+                                 GlobalVertices &r_global_vertices)
+{
+  const int vertex_count = statement ? statement->vertex_count : int(chunk.vertices.size());
+  const int color_count = statement ? statement->vertex_color_count :
+                                      int(chunk.vertex_colors.size());
+  const int uv_count = statement ? statement->uv_vertex_count : int(chunk.uv_vertices.size());
+  const int normal_count = statement ? statement->vert_normal_count :
+                                       int(chunk.vert_normals.size());
+
+  if (chunk.merged_vertices < vertex_count) {
+    r_global_vertices.vertices.extend(chunk.vertices.as_span().slice(
+        chunk.merged_vertices, vertex_count - chunk.merged_vertices));
+    chunk.merged_vertices = vertex_count;
+  }
+  for (; chunk.merged_vertex_colors < color_count; chunk.merged_vertex_colors++) {
+    const std::pair<int, float3> &color = chunk.vertex_colors[chunk.merged_vertex_colors];
+    const int vertex_index = chunk.vertex_start + color.first;
+    auto &blocks = r_global_vertices.vertex_colors;
+    /* If we don't have vertex colors yet, or the previous vertex
+     * was without color, we need to start a new vertex colors block. */
+    if (blocks.is_empty() ||
+        (blocks.last().start_vertex_index + blocks.last().colors.size() != vertex_index))
+    {
+      GlobalVertices::VertexColorsBlock block;
+      block.start_vertex_index = vertex_index;
+      blocks.append(block);
     }
+    blocks.last().colors.append(color.second);
+  }
+  if (chunk.merged_uv_vertices < uv_count) {
+    r_global_vertices.uv_vertices.extend(chunk.uv_vertices.as_span().slice(
+        chunk.merged_uv_vertices, uv_count - chunk.merged_uv_vertices));
+    chunk.merged_uv_vertices = uv_count;
+  }
+  if (chunk.merged_vert_normals < normal_count) {
+    r_global_vertices.vert_normals.extend(chunk.vert_normals.as_span().slice(
+        chunk.merged_vert_normals, normal_count - chunk.merged_vert_normals));
+    chunk.merged_vert_normals = normal_count;
   }
 }
 
@@ -136,9 +241,7 @@ static void geom_add_mrgb_colors(const char *p, const char *end, GlobalVertices
   }
 }
 
-static void geom_add_vertex_normal(const char *p,
-                                   const char *end,
-                                   GlobalVertices &r_global_vertices)
+static void geom_add_vertex_normal(const char *p, const char *end, Vector<float3> &r_normals)
 {
   float3 normal;
   parse_floats(p, end, 0.0f, normal, 3);
@@ -146,14 +249,14 @@ static void geom_add_vertex_normal(const char *p,
    * making them ever-so-slightly non unit length. Make sure they are
    * normalized. */
   normalize_v3(normal);
-  r_global_vertices.vert_normals.append(normal);
+  r_normals.append(normal);
 }
 
-static void geom_add_uv_vertex(const char *p, const char *end, GlobalVertices &r_global_vertices)
+static void geom_add_uv_vertex(const char *p, const char *end, Vector<float2> &r_uv_vertices)
 {
   float2 uv;
   parse_floats(p, end, 0.0f, uv, 2);
-  r_global_vertices.uv_vertices.append(uv);
+  r_uv_vertices.append(uv);
 }
 
 /**
@@ -219,9 +322,46 @@ static void geom_add_polyline(Geometry *geom,
   }
 }
 
+/**
+ * Parse the corners of a face line without interpreting the indices.
+ * Parsing stops after the first corner with an invalid vertex index.
+ */
+static void parse_polygon_corners(const char *p, const char *end, Vector<RawCorner> &r_corners)
+{
+  p = drop_whitespace(p, end);
+  while (p < end) {
+    RawCorner raw_corner;
+    PolyCorner &corner = raw_corner.corner;
+    /* Parse vertex index. */
+    p = parse_int(p, end, INT32_MAX, corner.vert_index, false);
+    if (p < end && *p == '/') {
+      /* Parse UV index. */
+      ++p;
+      if (p < end && *p != '/') {
+        p = parse_int(p, end, INT32_MAX, corner.uv_vert_index, false);
+        raw_corner.has_uv = corner.uv_vert_index != INT32_MAX;
+      }
+      /* Parse normal index. */
+      if (p < end && *p == '/') {
+        ++p;
+        p = parse_int(p, end, INT32_MAX, corner.vertex_normal_index, false);
+        raw_corner.has_normal = corner.vertex_normal_index != INT32_MAX;
+      }
+    }
+    r_corners.append(raw_corner);
+    if (corner.vert_index == INT32_MAX) {
+      break;
+    }
+
+    /* Some files contain extra stuff per face (e.g. 4 indices); skip any remainder (#103441). */
+    p = drop_non_whitespace(p, end);
+    /* Skip whitespace to get to the next face corner. */
+    p = drop_whitespace(p, end);
+  }
+}
+
 static void geom_add_polygon(Geometry *geom,
-                             const char *p,
-                             const char *end,
+                             const Span<RawCorner> raw_corners,
                              const GlobalVertices &global_vertices,
                              const int material_index,
                              const int group_index,
@@ -239,27 +379,12 @@ static void geom_add_polygon(Geometry *geom,
   curr_face.start_index_ = orig_corners_size;
 
   bool face_valid = true;
-  p = drop_whitespace(p, end);
-  while (p < end && face_valid) {
-    PolyCorner corner;
-    bool got_uv = false, got_normal = false;
-    /* Parse vertex index. */
-    p = parse_int(p, end, INT32_MAX, corner.vert_index, false);
-    face_valid &= corner.vert_index != INT32_MAX;
-    if (p < end && *p == '/') {
-      /* Parse UV index. */
-      ++p;
-      if (p < end && *p != '/') {
-        p = parse_int(p, end, INT32_MAX, corner.uv_vert_index, false);
-        got_uv = corner.uv_vert_index != INT32_MAX;
-      }
-      /* Parse normal index. */
-      if (p < end && *p == '/') {
-        ++p;
-        p = parse_int(p, end, INT32_MAX, corner.vertex_normal_index, false);
-        got_normal = corner.vertex_normal_index != INT32_MAX;
-      }
+  for (const RawCorner &raw_corner : raw_corners) {
+    if (!face_valid) {
+      break;
     }
+    PolyCorner corner = raw_corner.corner;
+    face_valid &= corner.vert_index != INT32_MAX;
     /* Always keep stored indices non-negative and zero-based. */
     corner.vert_index += corner.vert_index < 0 ? global_vertices.vertices.size() : -1;
     if (corner.vert_index < 0 || corner.vert_index >= global_vertices.vertices.size()) {
@@ -273,7 +398,7 @@ static void geom_add_polygon(Geometry *geom,
       geom->track_vertex_index(corner.vert_index);
     }
     /* Ignore UV index, if the geometry does not have any UVs (#103212). */
-    if (got_uv && !global_vertices.uv_vertices.is_empty()) {
+    if (raw_corner.has_uv && !global_vertices.uv_vertices.is_empty()) {
       corner.uv_vert_index += corner.uv_vert_index < 0 ? global_vertices.uv_vertices.size() : -1;
       if (corner.uv_vert_index < 0 || corner.uv_vert_index >= global_vertices.uv_vertices.size()) {
         fprintf(stderr,
@@ -286,7 +411,7 @@ static void geom_add_polygon(Geometry *geom,
     /* Ignore corner normal index, if the geometry does not have any normals.
      * Some obj files out there do have face definitions that refer to normal indices,
      * without any normals being present (#98782). */
-    if (got_normal && !global_vertices.vert_normals.is_empty()) {
+    if (raw_corner.has_normal && !global_vertices.vert_normals.is_empty()) {
       corner.vertex_normal_index += corner.vertex_normal_index < 0 ?
                                         global_vertices.vert_normals.size() :
                                         -1;
@@ -302,11 +427,6 @@ static void geom_add_polygon(Geometry *geom,
     }
     geom->face_corners_.append(corner);
     curr_face.corner_count_++;
-
-    /* Some files contain extra stuff per face (e.g. 4 indices); skip any remainder (#103441). */
-    p = drop_non_whitespace(p, end);
-    /* Skip whitespace to get to the next face corner. */
-    p = drop_whitespace(p, end);
   }
 
   if (face_valid) {
@@ -469,6 +589,52 @@ static bool parse_keyword(const char *&p, const char *end, StringRef keyword)
   return true;
 }
 
+/**
+ * Decode vertex data and face corners of a chunk, and record all the statements that have to be
+ * handled in file order. Does not touch any shared state, so chunks can be parsed in parallel.
+ */
+static void parse_chunk(ObjChunk &chunk)
+{
+  StringRef buffer_str = chunk.text;
+  while (!buffer_str.is_empty()) {
+    StringRef line = read_next_line(buffer_str);
+    const char *p = line.begin(), *end = line.end();
+    p = drop_whitespace(p, end);
+    ++chunk.line_count;
+    if (p == end) {
+      continue;
+    }
+    const char *line_start = p;
+    /* Most common things that start with 'v': vertices, normals, UVs. */
+    if (*p == 'v') {
+      if (parse_keyword(p, end, "v")) {
+        geom_add_vertex(p, end, chunk);
+      }
+      else if (parse_keyword(p, end, "vn")) {
+        geom_add_vertex_normal(p, end, chunk.vert_normals);
+      }
+      else if (parse_keyword(p, end, "vt")) {
+        geom_add_uv_vertex(p, end, chunk.uv_vertices);
+      }
+    }
+    /* Faces. */
+    else if (parse_keyword(p, end, "f")) {
+      const int64_t corners_start = chunk.face_corners.size();
+      parse_polygon_corners(p, end, chunk.face_corners);
+      ChunkStatement &statement = chunk.add_statement();
+      statement.is_face = true;
+      statement.corners = IndexRange(corners_start, chunk.face_corners.size() - corners_start);
+    }
+    /* Comments, except for the MRGB vertex colors extension. */
+    else if (*p == '#' && !parse_keyword(p, end, "#MRGB")) {
+      /* Nothing to do. */
+    }
+    else {
+      chunk.add_statement().line = StringRef(line_start, end);
+    }
+  }
+}
+
 /* Special case: if there were no faces/edges in any geometries,
  * treat all the vertices as a point cloud. */
 static void use_all_vertices_if_no_faces(Geometry *geom,
@@ -507,15 +673,17 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
   string state_material_name;
   int state_material_index = -1;
 
-  /* Read the input file in chunks. We need up to twice the possible chunk size,
-   * to possibly store remainder of the previous input line that got broken mid-chunk. */
-  Array<char> buffer(read_buffer_size_ * 2);
+  /* Read the input file in batches of several chunks, which are parsed in parallel. We need up
+   * to twice the possible batch size, to possibly store remainder of the previous input line
+   * that got broken mid-batch. */
+  const size_t batch_size = read_buffer_size_ * OBJ_PARSE_CHUNKS_PER_BATCH;
+  Array<char> buffer(batch_size * 2);
 
   size_t buffer_offset = 0;
   size_t line_number = 0;
   while (true) {
-    /* Read a chunk of input from the file. */
-    size_t bytes_read = fread(buffer.data() + buffer_offset, 1, read_buffer_size_, obj_file_);
+    /* Read a batch of input from the file. */
+    size_t bytes_read = fread(buffer.data() + buffer_offset, 1, batch_size, obj_file_);
     if (bytes_read == 0 && buffer_offset == 0) {
       break; /* No more data to read. */
     }
@@ -526,7 +694,7 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
                              buffer.data() + buffer_offset + bytes_read);
 
     /* Ensure buffer ends in a newline. */
-    if (bytes_read < read_buffer_size_) {
+    if (bytes_read < batch_size) {
       if (bytes_read == 0 || buffer[buffer_offset + bytes_read - 1] != '\n') {
         buffer[buffer_offset + bytes_read] = '\n';
         bytes_read++;
@@ -551,137 +719,142 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
       fprintf(stderr,
               "OBJ file contains a line #%zu that is too long (max. length %zu)\n",
               line_number,
-              read_buffer_size_);
+              batch_size);
       break;
     }
     ++last_nl;
 
-    /* Parse the buffer (until last newline) that we have so far,
-     * line by line. */
-    StringRef buffer_str{buffer.data(), int64_t(last_nl)};
-    while (!buffer_str.is_empty()) {
-      StringRef line = read_next_line(buffer_str);
-      const char *p = line.begin(), *end = line.end();
-      p = drop_whitespace(p, end);
-      ++line_number;
-      if (p == end) {
-        continue;
+    /* Split the buffer (until last newline) into chunks of whole lines. */
+    Vector<ObjChunk> chunks;
+    const char *chunk_start = buffer.data();
+    const char *const batch_end = buffer.data() + last_nl;
+    while (chunk_start < batch_end) {
+      const char *chunk_end = chunk_start + std::min<size_t>(read_buffer_size_,
+                                                             batch_end - chunk_start);
+      chunk_end = static_cast<const char *>(
+                      memchr(chunk_end - 1, '\n', batch_end - (chunk_end - 1))) +
+                  1;
+      chunks.append_as();
+      chunks.last().text = StringRef(chunk_start, chunk_end);
+      chunk_start = chunk_end;
+    }
+
+    threading::parallel_for(chunks.index_range(), 1, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        parse_chunk(chunks[i]);
       }
-      /* Most common things that start with 'v': vertices, normals, UVs. */
-      if (*p == 'v') {
-        if (parse_keyword(p, end, "v")) {
-          geom_add_vertex(p, end, r_global_vertices);
-        }
-        else if (parse_keyword(p, end, "vn")) {
-          geom_add_vertex_normal(p, end, r_global_vertices);
+    });
+
+    /* Merge the chunks in order, handling the statements that depend on the parser state. */
+    for (ObjChunk &chunk : chunks) {
+      chunk.vertex_start = int(r_global_vertices.vertices.size());
+      for (const ChunkStatement &statement : chunk.statements) {
+        merge_chunk_vertices(chunk, &statement, r_global_vertices);
+
+        if (statement.is_face) {
+          /* If we don't have a material index assigned yet, get one.
+           * It means "usemtl" state came from the previous object. */
+          if (state_material_index == -1 && !state_material_name.empty() &&
+              curr_geom->material_indices_.is_empty())
+          {
+            curr_geom->material_indices_.add_new(state_material_name, 0);
+            curr_geom->material_order_.append(state_material_name);
+            state_material_index = 0;
+          }
+
+          geom_add_polygon(curr_geom,
+                           chunk.face_corners.as_span().slice(statement.corners),
+                           r_global_vertices,
+                           state_material_index,
+                           state_group_index,
+                           state_shaded_smooth);
+          continue;
         }
-        else if (parse_keyword(p, end, "vt")) {
-          geom_add_uv_vertex(p, end, r_global_vertices);
+
+        const char *p = statement.line.begin(), *end = statement.line.end();
+        /* Faces. */
+        if (parse_keyword(p, end, "l")) {
+          geom_add_polyline(curr_geom, p, end, r_global_vertices);
         }
-      }
-      /* Faces. */
-      else if (parse_keyword(p, end, "f")) {
-        /* If we don't have a material index assigned yet, get one.
-         * It means "usemtl" state came from the previous object. */
-        if (state_material_index == -1 && !state_material_name.empty() &&
-            curr_geom->material_indices_.is_empty())
-        {
-          curr_geom->material_indices_.add_new(state_material_name, 0);
-          curr_geom->material_order_.append(state_material_name);
-          state_material_index = 0;
+        /* Objects. */
+        else if (parse_keyword(p, end, "o")) {
+          if (import_params_.use_split_objects) {
+            geom_new_object(p,
+                            end,
+                            state_shaded_smooth,
+                            state_group_name,
+                            state_material_index,
+                            curr_geom,
+                            r_all_geometries);
+          }
         }
-
-        geom_add_polygon(curr_geom,
-                         p,
-                         end,
-                         r_global_vertices,
-                         state_material_index,
-                         state_group_index,
-                         state_shaded_smooth);
-      }
-      /* Faces. */
-      else if (parse_keyword(p, end, "l")) {
-        geom_add_polyline(curr_geom, p, end, r_global_vertices);
-      }
-      /* Objects. */
-      else if (parse_keyword(p, end, "o")) {
-        if (import_params_.use_split_objects) {
-          geom_new_object(p,
-                          end,
-                          state_shaded_smooth,
-                          state_group_name,
-                          state_material_index,
-                          curr_geom,
-                          r_all_geometries);
+        /* Groups. */
+        else if (parse_keyword(p, end, "g")) {
+          if (import_params_.use_split_groups) {
+            geom_new_object(p,
+                            end,
+                            state_shaded_smooth,
+                            state_group_name,
+                            state_material_index,
+                            curr_geom,
+                            r_all_geometries);
+          }
+          else {
+            geom_update_group(StringRef(p, end).trim(), state_group_name);
+            int new_index = curr_geom->group_indices_.size();
+            state_group_index = curr_geom->group_indices_.lookup_or_add(state_group_name,
+                                                                        new_index);
+            if (new_index == state_group_index) {
+              curr_geom->group_order_.append(state_group_name);
+            }
+          }
         }
-      }
-      /* Groups. */
-      else if (parse_keyword(p, end, "g")) {
-        if (import_params_.use_split_groups) {
-          geom_new_object(p,
-                          end,
-                          state_shaded_smooth,
-                          state_group_name,
-                          state_material_index,
-                          curr_geom,
-                          r_all_geometries);
+        /* Smoothing groups. */
+        else if (parse_keyword(p, end, "s")) {
+          geom_update_smooth_group(p, end, state_shaded_smooth);
         }
-        else {
-          geom_update_group(StringRef(p, end).trim(), state_group_name);
-          int new_index = curr_geom->group_indices_.size();
-          state_group_index = curr_geom->group_indices_.lookup_or_add(state_group_name, new_index);
-          if (new_index == state_group_index) {
-            curr_geom->group_order_.append(state_group_name);
+        /* Materials and their libraries. */
+        else if (parse_keyword(p, end, "usemtl")) {
+          state_material_name = StringRef(p, end).trim();
+          int new_mat_index = curr_geom->material_indices_.size();
+          state_material_index = curr_geom->material_indices_.lookup_or_add(state_material_name,
+                                                                            new_mat_index);
+          if (new_mat_index == state_material_index) {
+            curr_geom->material_order_.append(state_material_name);
           }
         }
-      }
-      /* Smoothing groups. */
-      else if (parse_keyword(p, end, "s")) {
-        geom_update_smooth_group(p, end, state_shaded_smooth);
-      }
-      /* Materials and their libraries. */
-      else if (parse_keyword(p, end, "usemtl")) {
-        state_material_name = StringRef(p, end).trim();
-        int new_mat_index = curr_geom->material_indices_.size();
-        state_material_index = curr_geom->material_indices_.lookup_or_add(state_material_name,
-                                                                          new_mat_index);
-        if (new_mat_index == state_material_index) {
-          curr_geom->material_order_.append(state_material_name);
+        else if (parse_keyword(p, end, "mtllib")) {
+          add_mtl_library(StringRef(p, end).trim());
+        }
+        else if (parse_keyword(p, end, "#MRGB")) {
+          geom_add_mrgb_colors(p, end, r_global_vertices);
+        }
+        /* Curve related things. */
+        else if (parse_keyword(p, end, "cstype")) {
+          curr_geom = geom_set_curve_type(curr_geom, p, end, state_group_name, r_all_geometries);
+        }
+        else if (parse_keyword(p, end, "deg")) {
+          geom_set_curve_degree(curr_geom, p, end);
+        }
+        else if (parse_keyword(p, end, "curv")) {
+          geom_add_curve_vertex_indices(curr_geom, p, end, r_global_vertices);
+        }
+        else if (parse_keyword(p, end, "parm")) {
+          geom_add_curve_parameters(curr_geom, p, end);
+        }
+        else if (StringRef(p, end).startswith("end")) {
+          /* End of curve definition, nothing else to do. */
+        }
+        else {
+          std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'" << std::endl;
         }
       }
-      else if (parse_keyword(p, end, "mtllib")) {
-        add_mtl_library(StringRef(p, end).trim());
-      }
-      else if (parse_keyword(p, end, "#MRGB")) {
-        geom_add_mrgb_colors(p, end, r_global_vertices);
-      }
-      /* Comments. */
-      else if (*p == '#') {
-        /* Nothing to do. */
-      }
-      /* Curve related things. */
-      else if (parse_keyword(p, end, "cstype")) {
-        curr_geom = geom_set_curve_type(curr_geom, p, end, state_group_name, r_all_geometries);
-      }
-      else if (parse_keyword(p, end, "deg")) {
-        geom_set_curve_degree(curr_geom, p, end);
-      }
-      else if (parse_keyword(p, end, "curv")) {
-        geom_add_curve_vertex_indices(curr_geom, p, end, r_global_vertices);
-      }
-      else if (parse_keyword(p, end, "parm")) {
-        geom_add_curve_parameters(curr_geom, p, end);
-      }
-      else if (StringRef(p, end).startswith("end")) {
-        /* End of curve definition, nothing else to do. */
-      }
-      else {
-        std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'" << std::endl;
-      }
+      merge_chunk_vertices(chunk, nullptr, r_global_vertices);
+      line_number += chunk.line_count;
     }
 
     /* We might have a line that was cut in the middle by the previous buffer;
-     * copy it over for next chunk reading. */
+     * copy it over for next batch reading. */
     size_t left_size = buffer_end - last_nl;
     memmove(buffer.data(), buffer.data() + last_nl, left_size);
     buffer_offset = left_size;
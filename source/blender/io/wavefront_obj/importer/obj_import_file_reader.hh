@@ -34,6 +34,9 @@ class OBJParser {
   /**
    * Read the OBJ file line by line and create OBJ Geometry instances. Also store all the vertex
    * and UV vertex coordinates in a struct accessible by all objects.
+   *
+   * The file is read in batches of several `read_buffer_size` chunks; vertex data and faces
+   * of the chunks are parsed in parallel, then merged in file order.
    */
   void parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
              GlobalVertices &r_global_vertices);
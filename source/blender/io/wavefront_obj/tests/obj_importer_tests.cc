@@ -7,6 +7,7 @@
 #include "testing/testing.h"
 #include "tests/blendfile_loading_base_test.h"
 
+#include "BKE_appdir.h"
 #include "BKE_curve.h"
 #include "BKE_customdata.h"
 #include "BKE_main.h"
@@ -15,10 +16,12 @@
 #include "BKE_object.h"
 #include "BKE_scene.h"
 
+#include "BLI_fileops.h"
 #include "BLI_listbase.h"
 #include "BLI_math_base.hh"
 #include "BLI_math_vector_types.hh"
 #include "BLI_string.h"
+#include "BLI_timeit.hh"
 
 #include "BLO_readfile.h"
 
@@ -33,6 +36,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "obj_import_file_reader.hh"
 #include "obj_importer.hh"
 
 namespace blender::io::obj {
@@ -892,4 +896,76 @@ TEST_F(obj_importer_test, import_polylines)
   import_and_check("polylines.obj", expect, std::size(expect), 0);
 }
 
+/**
+ * Set this to 1 to activate the benchmark. It is disabled by default, because it writes
+ * a large (about 1 GB) temporary file and takes a while to run.
+ */
+#if 0
+TEST(obj_import_file_reader, benchmark_large_file)
+{
+  BKE_tempdir_init(nullptr);
+  const std::string obj_path = std::string(BKE_tempdir_session()) + SEP_STR "benchmark_large.obj";
+
+  /* A few grid objects with positions, UVs, normals and quad faces. */
+  const int object_count = 4;
+  const int grid_size = 1500;
+  {
+    SCOPED_TIMER("Write OBJ");
+    FILE *file = BLI_fopen(obj_path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    for (int object = 0; object < object_count; object++) {
+      fprintf(file, "o Grid%d\n", object);
+      for (int y = 0; y < grid_size; y++) {
+        for (int x = 0; x < grid_size; x++) {
+          const float u = float(x) / grid_size, v = float(y) / grid_size;
+          fprintf(file, "v %f %f %f\n", u * 10.0f, v * 10.0f, float(object));
+          fprintf(file, "vt %f %f\n", u, v);
+          fprintf(file, "vn %f %f %f\n", 0.0f, 0.0f, 1.0f);
+        }
+      }
+      fprintf(file, "usemtl Material%d\ns 1\n", object);
+      for (int y = 0; y < grid_size - 1; y++) {
+        for (int x = 0; x < grid_size - 1; x++) {
+          const int i = object * grid_size * grid_size + y * grid_size + x + 1;
+          fprintf(file,
+                  "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                  i,
+                  i,
+                  i,
+                  i + 1,
+                  i + 1,
+                  i + 1,
+                  i + grid_size + 1,
+                  i + grid_size + 1,
+                  i + grid_size + 1,
+                  i + grid_size,
+                  i + grid_size,
+                  i + grid_size);
+        }
+      }
+    }
+    fclose(file);
+  }
+
+  OBJImportParams params{};
+  STRNCPY(params.filepath, obj_path.c_str());
+  params.use_split_objects = true;
+  for (const size_t read_buffer_size : {size_t(8 * 1024), size_t(64 * 1024), size_t(1024 * 1024)}) {
+    Vector<std::unique_ptr<Geometry>> all_geometries;
+    GlobalVertices global_vertices;
+    {
+      SCOPED_TIMER("Parse OBJ, read buffer size " + std::to_string(read_buffer_size));
+      OBJParser parser{params, read_buffer_size};
+      parser.parse(all_geometries, global_vertices);
+    }
+    EXPECT_EQ(global_vertices.vertices.size(), object_count * grid_size * grid_size);
+    EXPECT_EQ(all_geometries.size(), object_count);
+    EXPECT_EQ(all_geometries.last()->face_elements_.size(), (grid_size - 1) * (grid_size - 1));
+  }
+
+  BLI_delete(obj_path.c_str(), false, false);
+  BKE_tempdir_session_purge();
+}
+#endif
+
 }  // namespace blender::io::obj
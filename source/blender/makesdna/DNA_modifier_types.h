@@ -2337,6 +2337,12 @@ typedef struct NodesModifierData {
    * Directory where baked simulation states are stored. This may be relative to the .blend file.
    */
   char *simulation_bake_directory;
+  /**
+   * Maximum distance that baked positions and velocities may be off, which allows storing them
+   * in less space. Zero stores them exactly.
+   */
+  float simulation_bake_max_error;
+  char _pad[4];
   NodesModifierRuntimeHandle *runtime;
 } NodesModifierData;
 
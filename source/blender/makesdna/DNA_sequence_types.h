@@ -335,7 +335,10 @@ typedef struct Editing {
   int64_t disk_cache_timestamp;
 
   EditingRuntime runtime;
-  void *_pad1;
+
+  /** Number of frames rendered in parallel by prefetching, 0 to pick based on CPU cores. */
+  int prefetch_threads;
+  char _pad1[4];
 } Editing;
 
 /** \} */
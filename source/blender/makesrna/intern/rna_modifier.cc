@@ -7077,6 +7077,16 @@ static void rna_def_modifier_nodes(BlenderRNA *brna)
       prop, "Simulation Bake Directory", "Location on disk where the bake data is stored");
   RNA_def_property_update(prop, 0, nullptr);
 
+  prop = RNA_def_property(srna, "simulation_bake_max_error", PROP_FLOAT, PROP_DISTANCE);
+  RNA_def_property_range(prop, 0.0f, FLT_MAX);
+  RNA_def_property_ui_range(prop, 0.0f, 1.0f, 0.01, 4);
+  RNA_def_property_ui_text(prop,
+                           "Bake Max Error",
+                           "Maximum distance that baked positions and velocities may differ from "
+                           "the simulated ones, which allows storing them in less space. Zero "
+                           "stores them exactly");
+  RNA_def_property_update(prop, 0, nullptr);
+
   RNA_define_lib_overridable(false);
 }
 
@@ -6,6 +6,7 @@
  * \ingroup RNA
  */
 
+#include <algorithm>
 #include <climits>
 #include <cstdlib>
 
@@ -264,6 +265,14 @@ static void rna_SequenceEditor_update_cache(Main * /*bmain*/, Scene *scene, Poin
   SEQ_cache_cleanup(scene);
 }
 
+static void rna_SequenceEditor_prefetch_threads_update(Main * /*bmain*/,
+                                                       Scene *scene,
+                                                       PointerRNA * /*ptr*/)
+{
+  /* The running job keeps the previous number of workers, it is started again on redraw. */
+  SEQ_prefetch_stop(scene);
+}
+
 /* internal use */
 static int rna_SequenceEditor_elements_length(PointerRNA *ptr)
 {
@@ -1222,6 +1231,32 @@ static void rna_SequenceEditor_overlay_frame_set(PointerRNA *ptr, int value)
   }
 }
 
+static int rna_SequenceEditor_cache_stat_clamp(const uint64_t value)
+{
+  return int(std::min<uint64_t>(value, INT_MAX));
+}
+
+static int rna_SequenceEditor_cache_hits_get(PointerRNA *ptr)
+{
+  SeqCacheStats stats;
+  SEQ_cache_stats_get((Scene *)ptr->owner_id, &stats);
+  return rna_SequenceEditor_cache_stat_clamp(stats.hits);
+}
+
+static int rna_SequenceEditor_cache_misses_get(PointerRNA *ptr)
+{
+  SeqCacheStats stats;
+  SEQ_cache_stats_get((Scene *)ptr->owner_id, &stats);
+  return rna_SequenceEditor_cache_stat_clamp(stats.misses);
+}
+
+static int rna_SequenceEditor_cache_evictions_get(PointerRNA *ptr)
+{
+  SeqCacheStats stats;
+  SEQ_cache_stats_get((Scene *)ptr->owner_id, &stats);
+  return rna_SequenceEditor_cache_stat_clamp(stats.evictions);
+}
+
 static void rna_SequenceEditor_display_stack(ID *id,
                                              Editing *ed,
                                              ReportList *reports,
@@ -2474,6 +2509,35 @@ static void rna_def_editor(BlenderRNA *brna)
       "Render frames ahead of current frame in the background for faster playback");
   RNA_def_property_update(prop, NC_SCENE | ND_SEQUENCER, nullptr);
 
+  prop = RNA_def_property(srna, "prefetch_threads", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, nullptr, "prefetch_threads");
+  RNA_def_property_range(prop, 0, SEQ_PREFETCH_THREADS_MAX);
+  RNA_def_property_ui_text(prop,
+                           "Prefetch Threads",
+                           "Number of frames rendered in parallel when prefetching, 0 to pick "
+                           "based on the number of processor cores");
+  RNA_def_property_update(
+      prop, NC_SCENE | ND_SEQUENCER, "rna_SequenceEditor_prefetch_threads_update");
+
+  prop = RNA_def_property(srna, "cache_hits", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_hits_get", nullptr, nullptr);
+  RNA_def_property_ui_text(
+      prop, "Cache Hits", "Number of images found in the RAM cache since it was created");
+
+  prop = RNA_def_property(srna, "cache_misses", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_misses_get", nullptr, nullptr);
+  RNA_def_property_ui_text(
+      prop, "Cache Misses", "Number of images not found in the RAM cache since it was created");
+
+  prop = RNA_def_property(srna, "cache_evictions", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_evictions_get", nullptr, nullptr);
+  RNA_def_property_ui_text(prop,
+                           "Cache Evictions",
+                           "Number of images removed from the RAM cache to free memory");
+
   /* functions */
 
   func = RNA_def_function(srna, "display_stack", "rna_SequenceEditor_display_stack");
@@ -654,9 +654,14 @@ static void check_property_socket_sync(const Object *ob, ModifierData *md)
   }
 }
 
-static void prepare_simulation_states_for_evaluation(const NodesModifierData &nmd,
-                                                     const ModifierEvalContext &ctx,
-                                                     nodes::GeoNodesModifierData &exec_data)
+/**
+ * \param r_state_users: Keeps the read-only states loaded until the evaluation is done.
+ */
+static void prepare_simulation_states_for_evaluation(
+    const NodesModifierData &nmd,
+    const ModifierEvalContext &ctx,
+    nodes::GeoNodesModifierData &exec_data,
+    Vector<bke::sim::ModifierSimulationStateUser> &r_state_users)
 {
   if (!nmd.runtime->simulation_cache) {
     return;
@@ -746,13 +751,16 @@ static void prepare_simulation_states_for_evaluation(const NodesModifierData &nm
     const bke::sim::StatesAroundFrame sim_states = simulation_cache.get_states_around_frame(
         current_frame);
     if (sim_states.current) {
+      r_state_users.append_as(sim_states.current->state);
       sim_states.current->state.ensure_bake_loaded(*nmd.node_group);
       exec_data.current_simulation_state = &sim_states.current->state;
     }
     if (sim_states.prev) {
+      r_state_users.append_as(sim_states.prev->state);
       sim_states.prev->state.ensure_bake_loaded(*nmd.node_group);
       exec_data.prev_simulation_state = &sim_states.prev->state;
       if (sim_states.next) {
+        r_state_users.append_as(sim_states.next->state);
         sim_states.next->state.ensure_bake_loaded(*nmd.node_group);
         exec_data.next_simulation_state = &sim_states.next->state;
         exec_data.simulation_state_mix_factor =
@@ -760,6 +768,13 @@ static void prepare_simulation_states_for_evaluation(const NodesModifierData &nm
             (float(sim_states.next->frame) - float(sim_states.prev->frame));
       }
     }
+    /* Load the upcoming baked frames in the background, so that playback does not have to wait
+     * for them to be read from disk. The cache is shared with other depsgraphs, only the active
+     * one decides which states are kept in memory. The states used by other depsgraphs are kept
+     * loaded by their users. */
+    if (DEG_is_active(ctx.depsgraph)) {
+      simulation_cache.prefetch_baked_states(current_frame);
+    }
   }
   else {
     if (DEG_is_active(ctx.depsgraph)) {
@@ -862,7 +877,9 @@ static void modifyGeometry(ModifierData *md,
   modifier_eval_data.self_object = ctx->object;
   auto eval_log = std::make_unique<geo_log::GeoModifierLog>();
 
-  prepare_simulation_states_for_evaluation(*nmd, *ctx, modifier_eval_data);
+  Vector<bke::sim::ModifierSimulationStateUser> simulation_state_users;
+  prepare_simulation_states_for_evaluation(
+      *nmd, *ctx, modifier_eval_data, simulation_state_users);
 
   Set<ComputeContextHash> socket_log_contexts;
   if (logging_enabled(ctx)) {
@@ -1342,6 +1359,7 @@ static void internal_dependencies_panel_draw(const bContext * /*C*/, Panel *pane
   uiLayoutSetPropSep(col, true);
   uiLayoutSetPropDecorate(col, false);
   uiItemR(col, ptr, "simulation_bake_directory", UI_ITEM_NONE, "Bake", ICON_NONE);
+  uiItemR(col, ptr, "simulation_bake_max_error", UI_ITEM_NONE, "Max Error", ICON_NONE);
 
   geo_log::GeoTreeLog *tree_log = get_root_tree_log(*nmd);
   if (tree_log == nullptr) {
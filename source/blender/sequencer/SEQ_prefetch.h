@@ -15,6 +15,9 @@ extern "C" {
 struct Main;
 struct Scene;
 
+/** Upper limit of frames a prefetch job renders in parallel. */
+#define SEQ_PREFETCH_THREADS_MAX 16
+
 void SEQ_prefetch_stop_all(void);
 /**
  * Use also to update scene and context changes
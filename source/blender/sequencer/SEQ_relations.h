@@ -8,6 +8,8 @@
  * \ingroup sequencer
  */
 
+#include "BLI_sys_types.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -57,7 +59,22 @@ void SEQ_relations_check_uuids_unique_and_report(const struct Scene *scene);
  */
 void SEQ_relations_session_uuid_generate(struct Sequence *sequence);
 
+typedef struct SeqCacheStats {
+  /** Number of images found in the RAM cache. */
+  uint64_t hits;
+  /** Number of images looked up but not found in the RAM cache. */
+  uint64_t misses;
+  /** Number of images removed to free memory for new images. */
+  uint64_t evictions;
+  /** Number of images currently in the RAM cache. */
+  uint items_num;
+} SeqCacheStats;
+
 void SEQ_cache_cleanup(struct Scene *scene);
+/**
+ * Get statistics about the RAM cache usage, since the cache was created.
+ */
+void SEQ_cache_stats_get(struct Scene *scene, SeqCacheStats *r_stats);
 void SEQ_cache_iterate(
     struct Scene *scene,
     void *userdata,
@@ -22,6 +22,7 @@ struct rctf;
 
 typedef enum eSeqTaskId {
   SEQ_TASK_MAIN_RENDER,
+  /* Each prefetch worker uses its own ID, counting up from this one. */
   SEQ_TASK_PREFETCH_RENDER,
 } eSeqTaskId;
 
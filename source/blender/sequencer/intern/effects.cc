@@ -18,6 +18,7 @@
 #include "BLI_math.h" /* windows needs for M_PI */
 #include "BLI_path_util.h"
 #include "BLI_rect.h"
+#include "BLI_simd.h"
 #include "BLI_string.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
@@ -193,6 +194,90 @@ static ImBuf *prepare_effect_imbufs(const SeqRenderData *context,
 
 /** \} */
 
+/**
+ * Blend functions take the use of SIMD as template parameter, so that tests can compare the
+ * results and performance of both code paths, see #seq_effect_blend_functions_get.
+ */
+static constexpr bool use_simd_default = BLI_HAVE_SSE2;
+
+#if BLI_HAVE_SSE2
+
+/* -------------------------------------------------------------------- */
+/** \name SIMD Utilities
+ *
+ * Float pixels are processed as one vector of RGBA channels, byte pixels four at a time as
+ * 16-bit integers. Operations match the scalar code exactly, so results do not depend on
+ * whether SIMD is available.
+ * \{ */
+
+/* Mask of the color channels of a single RGBA pixel. */
+BLI_INLINE __m128 simd_rgb_mask()
+{
+  return _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+}
+
+/* Mask of the color channels of two RGBA pixels unpacked to 16-bit. */
+BLI_INLINE __m128i simd_rgb_mask_epi16()
+{
+  return _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+}
+
+BLI_INLINE __m128 simd_select(const __m128 mask, const __m128 a, const __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+BLI_INLINE __m128 simd_broadcast_alpha(const __m128 color)
+{
+  return _mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* Broadcast alpha of two RGBA pixels unpacked to 16-bit. */
+BLI_INLINE __m128i simd_broadcast_alpha_epi16(const __m128i color)
+{
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(color, _MM_SHUFFLE(3, 3, 3, 3)),
+                             _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* Same as #straight_uchar_to_premul_float. */
+BLI_INLINE __m128 simd_load_straight_uchar_to_premul_float(const uchar *cp)
+{
+  int packed;
+  memcpy(&packed, cp, sizeof(packed));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i color_i = _mm_unpacklo_epi16(
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+  const __m128 color = _mm_cvtepi32_ps(color_i);
+
+  const __m128 alpha = _mm_mul_ps(simd_broadcast_alpha(color), _mm_set1_ps(1.0f / 255.0f));
+  const __m128 fac = _mm_mul_ps(alpha, _mm_set1_ps(1.0f / 255.0f));
+  return simd_select(simd_rgb_mask(), _mm_mul_ps(color, fac), alpha);
+}
+
+/* Same as #premul_float_to_straight_uchar. */
+BLI_INLINE void simd_store_premul_float_to_straight_uchar(uchar *rt, __m128 color)
+{
+  const float alpha = _mm_cvtss_f32(simd_broadcast_alpha(color));
+  if (alpha != 0.0f && alpha != 1.0f) {
+    const float alpha_inv = 1.0f / alpha;
+    color = simd_select(simd_rgb_mask(), _mm_mul_ps(color, _mm_set1_ps(alpha_inv)), color);
+  }
+
+  /* Same as #unit_float_to_uchar_clamp: round by truncation, clamp to the byte range. */
+  __m128 value = _mm_add_ps(_mm_mul_ps(color, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+  value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+  __m128i value_i = _mm_cvttps_epi32(value);
+  value_i = _mm_packs_epi32(value_i, value_i);
+  value_i = _mm_packus_epi16(value_i, value_i);
+
+  const int packed = _mm_cvtsi128_si32(value_i);
+  memcpy(rt, &packed, sizeof(packed));
+}
+
+/** \} */
+
+#endif /* BLI_HAVE_SSE2 */
+
 /* -------------------------------------------------------------------- */
 /** \name Alpha Over Effect
  * \{ */
@@ -206,30 +291,44 @@ static void init_alpha_over_or_under(Sequence *seq)
   seq->seq1 = seq2;
 }
 
+template<bool use_simd = use_simd_default>
 static void do_alphaover_effect_byte(
     float fac, int x, int y, uchar *rect1, uchar *rect2, uchar *out)
 {
+  const int64_t pixels_num = int64_t(x) * y;
+
+  if (fac <= 0.0f) {
+    memcpy(out, rect2, sizeof(uchar[4]) * pixels_num);
+    return;
+  }
+
   uchar *cp1 = rect1;
   uchar *cp2 = rect2;
   uchar *rt = out;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      /* rt = rt1 over rt2  (alpha from rt1) */
-
-      float tempc[4], rt1[4], rt2[4];
-      straight_uchar_to_premul_float(rt1, cp1);
-      straight_uchar_to_premul_float(rt2, cp2);
-
-      float mfac = 1.0f - fac * rt1[3];
+  for (int64_t i = 0; i < pixels_num; i++) {
+    /* rt = rt1 over rt2  (alpha from rt1) */
+    const float mfac = 1.0f - fac * (cp1[3] * (1.0f / 255.0f));
 
-      if (fac <= 0.0f) {
-        *((uint *)rt) = *((uint *)cp2);
-      }
-      else if (mfac <= 0.0f) {
-        *((uint *)rt) = *((uint *)cp1);
+    if (mfac <= 0.0f) {
+      *((uint *)rt) = *((uint *)cp1);
+    }
+    else {
+#if BLI_HAVE_SSE2
+      if constexpr (use_simd) {
+        const __m128 rt1 = simd_load_straight_uchar_to_premul_float(cp1);
+        const __m128 rt2 = simd_load_straight_uchar_to_premul_float(cp2);
+        const __m128 tempc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac), rt1),
+                                        _mm_mul_ps(_mm_set1_ps(mfac), rt2));
+        simd_store_premul_float_to_straight_uchar(rt, tempc);
       }
-      else {
+      else
+#endif
+      {
+        float tempc[4], rt1[4], rt2[4];
+        straight_uchar_to_premul_float(rt1, cp1);
+        straight_uchar_to_premul_float(rt2, cp2);
+
         tempc[0] = fac * rt1[0] + mfac * rt2[0];
         tempc[1] = fac * rt1[1] + mfac * rt2[1];
         tempc[2] = fac * rt1[2] + mfac * rt2[2];
@@ -237,42 +336,55 @@ static void do_alphaover_effect_byte(
 
         premul_float_to_straight_uchar(rt, tempc);
       }
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
     }
+    cp1 += 4;
+    cp2 += 4;
+    rt += 4;
   }
 }
 
+template<bool use_simd = use_simd_default>
 static void do_alphaover_effect_float(
     float fac, int x, int y, float *rect1, float *rect2, float *out)
 {
+  const int64_t pixels_num = int64_t(x) * y;
+
+  if (fac <= 0.0f) {
+    memcpy(out, rect2, sizeof(float[4]) * pixels_num);
+    return;
+  }
+
   float *rt1 = rect1;
   float *rt2 = rect2;
   float *rt = out;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      /* rt = rt1 over rt2  (alpha from rt1) */
+  for (int64_t i = 0; i < pixels_num; i++) {
+    /* rt = rt1 over rt2  (alpha from rt1) */
 
-      float mfac = 1.0f - (fac * rt1[3]);
+    float mfac = 1.0f - (fac * rt1[3]);
 
-      if (fac <= 0.0f) {
-        memcpy(rt, rt2, sizeof(float[4]));
-      }
-      else if (mfac <= 0) {
-        memcpy(rt, rt1, sizeof(float[4]));
+    if (mfac <= 0) {
+      memcpy(rt, rt1, sizeof(float[4]));
+    }
+    else {
+#if BLI_HAVE_SSE2
+      if constexpr (use_simd) {
+        _mm_storeu_ps(rt,
+                      _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac), _mm_loadu_ps(rt1)),
+                                 _mm_mul_ps(_mm_set1_ps(mfac), _mm_loadu_ps(rt2))));
       }
-      else {
+      else
+#endif
+      {
         rt[0] = fac * rt1[0] + mfac * rt2[0];
         rt[1] = fac * rt1[1] + mfac * rt2[1];
         rt[2] = fac * rt1[2] + mfac * rt2[2];
         rt[3] = fac * rt1[3] + mfac * rt2[3];
       }
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
     }
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
   }
 }
 
@@ -432,6 +544,7 @@ static void do_alphaunder_effect(const SeqRenderData *context,
 /** \name Cross Effect
  * \{ */
 
+template<bool use_simd = use_simd_default>
 static void do_cross_effect_byte(float fac, int x, int y, uchar *rect1, uchar *rect2, uchar *out)
 {
   uchar *rt1 = rect1;
@@ -441,20 +554,49 @@ static void do_cross_effect_byte(float fac, int x, int y, uchar *rect1, uchar *r
   int temp_fac = int(256.0f * fac);
   int temp_mfac = 256 - temp_fac;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      rt[0] = (temp_mfac * rt1[0] + temp_fac * rt2[0]) >> 8;
-      rt[1] = (temp_mfac * rt1[1] + temp_fac * rt2[1]) >> 8;
-      rt[2] = (temp_mfac * rt1[2] + temp_fac * rt2[2]) >> 8;
-      rt[3] = (temp_mfac * rt1[3] + temp_fac * rt2[3]) >> 8;
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
+  const int64_t pixels_num = int64_t(x) * y;
+  int64_t i = 0;
+
+#if BLI_HAVE_SSE2
+  /* Weighted sum of both inputs fits 16-bit as long as factor is in the unit range. */
+  if (use_simd && temp_fac >= 0 && temp_fac <= 256) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fac_v = _mm_set1_epi16(short(temp_fac));
+    const __m128i mfac_v = _mm_set1_epi16(short(temp_mfac));
+
+    for (; i + 4 <= pixels_num; i += 4) {
+      const __m128i a = _mm_loadu_si128((const __m128i *)rt1);
+      const __m128i b = _mm_loadu_si128((const __m128i *)rt2);
+      const __m128i lo = _mm_srli_epi16(
+          _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), mfac_v),
+                        _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), fac_v)),
+          8);
+      const __m128i hi = _mm_srli_epi16(
+          _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), mfac_v),
+                        _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), fac_v)),
+          8);
+      _mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(lo, hi));
+
+      rt1 += 16;
+      rt2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    rt[0] = (temp_mfac * rt1[0] + temp_fac * rt2[0]) >> 8;
+    rt[1] = (temp_mfac * rt1[1] + temp_fac * rt2[1]) >> 8;
+    rt[2] = (temp_mfac * rt1[2] + temp_fac * rt2[2]) >> 8;
+    rt[3] = (temp_mfac * rt1[3] + temp_fac * rt2[3]) >> 8;
+
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
+  }
 }
 
+template<bool use_simd = use_simd_default>
 static void do_cross_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
 {
   float *rt1 = rect1;
@@ -463,17 +605,26 @@ static void do_cross_effect_float(float fac, int x, int y, float *rect1, float *
 
   float mfac = 1.0f - fac;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
+  const int64_t pixels_num = int64_t(x) * y;
+  for (int64_t i = 0; i < pixels_num; i++) {
+#if BLI_HAVE_SSE2
+    if constexpr (use_simd) {
+      _mm_storeu_ps(rt,
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mfac), _mm_loadu_ps(rt1)),
+                               _mm_mul_ps(_mm_set1_ps(fac), _mm_loadu_ps(rt2))));
+    }
+    else
+#endif
+    {
       rt[0] = mfac * rt1[0] + fac * rt2[0];
       rt[1] = mfac * rt1[1] + fac * rt2[1];
       rt[2] = mfac * rt1[2] + fac * rt2[2];
       rt[3] = mfac * rt1[3] + fac * rt2[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
     }
+
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
   }
 }
 
@@ -610,6 +761,63 @@ static float invGammaCorrect(float c)
   return res;
 }
 
+#if BLI_HAVE_SSE2
+/**
+ * Vector version of #gammaCorrect and #invGammaCorrect, interpolating the given tables. Channels
+ * outside of the table range fall back to the scalar function.
+ */
+BLI_INLINE __m128 simd_gamma_table_lookup(const __m128 c,
+                                          const float *range_table,
+                                          const float *factor_table,
+                                          float (*fallback_fn)(float))
+{
+  const __m128 f = _mm_mul_ps(c, _mm_set1_ps(inv_color_step));
+  const __m128 f_clamped = _mm_min_ps(_mm_max_ps(f, _mm_setzero_ps()),
+                                      _mm_set1_ps(float(RE_GAMMA_TABLE_SIZE - 1)));
+  int index[4];
+  _mm_storeu_si128((__m128i *)index, _mm_cvttps_epi32(f_clamped));
+
+  const __m128 domain = _mm_setr_ps(color_domain_table[index[0]],
+                                    color_domain_table[index[1]],
+                                    color_domain_table[index[2]],
+                                    color_domain_table[index[3]]);
+  const __m128 range = _mm_setr_ps(
+      range_table[index[0]], range_table[index[1]], range_table[index[2]], range_table[index[3]]);
+  const __m128 factor = _mm_setr_ps(factor_table[index[0]],
+                                    factor_table[index[1]],
+                                    factor_table[index[2]],
+                                    factor_table[index[3]]);
+  __m128 result = _mm_add_ps(range, _mm_mul_ps(_mm_sub_ps(c, domain), factor));
+
+  const int in_range = _mm_movemask_ps(
+      _mm_and_ps(_mm_cmpge_ps(f, _mm_setzero_ps()),
+                 _mm_cmplt_ps(f, _mm_set1_ps(float(RE_GAMMA_TABLE_SIZE)))));
+  if (in_range != 0xF) {
+    float c_arr[4], result_arr[4];
+    _mm_storeu_ps(c_arr, c);
+    _mm_storeu_ps(result_arr, result);
+    for (int i = 0; i < 4; i++) {
+      if ((in_range & (1 << i)) == 0) {
+        result_arr[i] = fallback_fn(c_arr[i]);
+      }
+    }
+    result = _mm_loadu_ps(result_arr);
+  }
+  return result;
+}
+
+BLI_INLINE __m128 simd_gamma_cross(const __m128 rt1, const __m128 rt2, float fac, float mfac)
+{
+  const __m128 inv1 = simd_gamma_table_lookup(
+      rt1, inv_gamma_range_table, inv_gamfactor_table, invGammaCorrect);
+  const __m128 inv2 = simd_gamma_table_lookup(
+      rt2, inv_gamma_range_table, inv_gamfactor_table, invGammaCorrect);
+  const __m128 mix = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mfac), inv1),
+                                _mm_mul_ps(_mm_set1_ps(fac), inv2));
+  return simd_gamma_table_lookup(mix, gamma_range_table, gamfactor_table, gammaCorrect);
+}
+#endif
+
 static void gamtabs(float gamma)
 {
   float val, igamma = 1.0f / gamma;
@@ -659,6 +867,7 @@ static void load_gammacross(Sequence * /*seq*/) {}
 
 static void free_gammacross(Sequence * /*seq*/, const bool /*do_id_user*/) {}
 
+template<bool use_simd = use_simd_default>
 static void do_gammacross_effect_byte(
     float fac, int x, int y, uchar *rect1, uchar *rect2, uchar *out)
 {
@@ -668,8 +877,17 @@ static void do_gammacross_effect_byte(
 
   float mfac = 1.0f - fac;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
+  const int64_t pixels_num = int64_t(x) * y;
+  for (int64_t i = 0; i < pixels_num; i++) {
+#if BLI_HAVE_SSE2
+    if constexpr (use_simd) {
+      const __m128 rt1 = simd_load_straight_uchar_to_premul_float(cp1);
+      const __m128 rt2 = simd_load_straight_uchar_to_premul_float(cp2);
+      simd_store_premul_float_to_straight_uchar(rt, simd_gamma_cross(rt1, rt2, fac, mfac));
+    }
+    else
+#endif
+    {
       float rt1[4], rt2[4], tempc[4];
 
       straight_uchar_to_premul_float(rt1, cp1);
@@ -681,13 +899,14 @@ static void do_gammacross_effect_byte(
       tempc[3] = gammaCorrect(mfac * invGammaCorrect(rt1[3]) + fac * invGammaCorrect(rt2[3]));
 
       premul_float_to_straight_uchar(rt, tempc);
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
     }
+    cp1 += 4;
+    cp2 += 4;
+    rt += 4;
   }
 }
 
+template<bool use_simd = use_simd_default>
 static void do_gammacross_effect_float(
     float fac, int x, int y, float *rect1, float *rect2, float *out)
 {
@@ -697,16 +916,23 @@ static void do_gammacross_effect_float(
 
   float mfac = 1.0f - fac;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
+  const int64_t pixels_num = int64_t(x) * y;
+  for (int64_t i = 0; i < pixels_num; i++) {
+#if BLI_HAVE_SSE2
+    if constexpr (use_simd) {
+      _mm_storeu_ps(rt, simd_gamma_cross(_mm_loadu_ps(rt1), _mm_loadu_ps(rt2), fac, mfac));
+    }
+    else
+#endif
+    {
       rt[0] = gammaCorrect(mfac * invGammaCorrect(rt1[0]) + fac * invGammaCorrect(rt2[0]));
       rt[1] = gammaCorrect(mfac * invGammaCorrect(rt1[1]) + fac * invGammaCorrect(rt2[1]));
       rt[2] = gammaCorrect(mfac * invGammaCorrect(rt1[2]) + fac * invGammaCorrect(rt2[2]));
       rt[3] = gammaCorrect(mfac * invGammaCorrect(rt1[3]) + fac * invGammaCorrect(rt2[3]));
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
     }
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
   }
 }
 
@@ -756,6 +982,7 @@ static void do_gammacross_effect(const SeqRenderData *context,
 /** \name Color Add Effect
  * \{ */
 
+template<bool use_simd = use_simd_default>
 static void do_add_effect_byte(float fac, int x, int y, uchar *rect1, uchar *rect2, uchar *out)
 {
   uchar *cp1 = rect1;
@@ -764,39 +991,80 @@ static void do_add_effect_byte(float fac, int x, int y, uchar *rect1, uchar *rec
 
   int temp_fac = int(256.0f * fac);
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      const int temp_fac2 = temp_fac * int(cp2[3]);
-      rt[0] = min_ii(cp1[0] + ((temp_fac2 * cp2[0]) >> 16), 255);
-      rt[1] = min_ii(cp1[1] + ((temp_fac2 * cp2[1]) >> 16), 255);
-      rt[2] = min_ii(cp1[2] + ((temp_fac2 * cp2[2]) >> 16), 255);
-      rt[3] = cp1[3];
-
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
+  const int64_t pixels_num = int64_t(x) * y;
+  int64_t i = 0;
+
+#if BLI_HAVE_SSE2
+  /* Factor multiplied by alpha fits 16-bit as long as factor is in the unit range. */
+  if (use_simd && temp_fac >= 0 && temp_fac <= 256) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fac_v = _mm_set1_epi16(short(temp_fac));
+    const __m128i rgb_mask = simd_rgb_mask_epi16();
+
+    for (; i + 4 <= pixels_num; i += 4) {
+      const __m128i a = _mm_loadu_si128((const __m128i *)cp1);
+      const __m128i b = _mm_loadu_si128((const __m128i *)cp2);
+      const __m128i b_lo = _mm_unpacklo_epi8(b, zero);
+      const __m128i b_hi = _mm_unpackhi_epi8(b, zero);
+      /* `(temp_fac2 * cp2) >> 16` for color channels, zero for alpha. */
+      const __m128i d_lo = _mm_and_si128(
+          _mm_mulhi_epu16(_mm_mullo_epi16(simd_broadcast_alpha_epi16(b_lo), fac_v), b_lo),
+          rgb_mask);
+      const __m128i d_hi = _mm_and_si128(
+          _mm_mulhi_epu16(_mm_mullo_epi16(simd_broadcast_alpha_epi16(b_hi), fac_v), b_hi),
+          rgb_mask);
+      const __m128i lo = _mm_adds_epu16(_mm_unpacklo_epi8(a, zero), d_lo);
+      const __m128i hi = _mm_adds_epu16(_mm_unpackhi_epi8(a, zero), d_hi);
+      _mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(lo, hi));
+
+      cp1 += 16;
+      cp2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    const int temp_fac2 = temp_fac * int(cp2[3]);
+    rt[0] = min_ii(cp1[0] + ((temp_fac2 * cp2[0]) >> 16), 255);
+    rt[1] = min_ii(cp1[1] + ((temp_fac2 * cp2[1]) >> 16), 255);
+    rt[2] = min_ii(cp1[2] + ((temp_fac2 * cp2[2]) >> 16), 255);
+    rt[3] = cp1[3];
+
+    cp1 += 4;
+    cp2 += 4;
+    rt += 4;
+  }
 }
 
+template<bool use_simd = use_simd_default>
 static void do_add_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
 {
   float *rt1 = rect1;
   float *rt2 = rect2;
   float *rt = out;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      const float temp_fac = (1.0f - (rt1[3] * (1.0f - fac))) * rt2[3];
+  const int64_t pixels_num = int64_t(x) * y;
+  for (int64_t i = 0; i < pixels_num; i++) {
+    const float temp_fac = (1.0f - (rt1[3] * (1.0f - fac))) * rt2[3];
+#if BLI_HAVE_SSE2
+    if constexpr (use_simd) {
+      const __m128 a = _mm_loadu_ps(rt1);
+      const __m128 sum = _mm_add_ps(a, _mm_mul_ps(_mm_set1_ps(temp_fac), _mm_loadu_ps(rt2)));
+      _mm_storeu_ps(rt, simd_select(simd_rgb_mask(), sum, a));
+    }
+    else
+#endif
+    {
       rt[0] = rt1[0] + temp_fac * rt2[0];
       rt[1] = rt1[1] + temp_fac * rt2[1];
       rt[2] = rt1[2] + temp_fac * rt2[2];
       rt[3] = rt1[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
     }
+
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
   }
 }
 
@@ -835,6 +1103,7 @@ static void do_add_effect(const SeqRenderData *context,
 /** \name Color Subtract Effect
  * \{ */
 
+template<bool use_simd = use_simd_default>
 static void do_sub_effect_byte(float fac, int x, int y, uchar *rect1, uchar *rect2, uchar *out)
 {
   uchar *cp1 = rect1;
@@ -843,21 +1112,53 @@ static void do_sub_effect_byte(float fac, int x, int y, uchar *rect1, uchar *rec
 
   int temp_fac = int(256.0f * fac);
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      const int temp_fac2 = temp_fac * int(cp2[3]);
-      rt[0] = max_ii(cp1[0] - ((temp_fac2 * cp2[0]) >> 16), 0);
-      rt[1] = max_ii(cp1[1] - ((temp_fac2 * cp2[1]) >> 16), 0);
-      rt[2] = max_ii(cp1[2] - ((temp_fac2 * cp2[2]) >> 16), 0);
-      rt[3] = cp1[3];
-
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
+  const int64_t pixels_num = int64_t(x) * y;
+  int64_t i = 0;
+
+#if BLI_HAVE_SSE2
+  /* Factor multiplied by alpha fits 16-bit as long as factor is in the unit range. */
+  if (use_simd && temp_fac >= 0 && temp_fac <= 256) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fac_v = _mm_set1_epi16(short(temp_fac));
+    const __m128i rgb_mask = simd_rgb_mask_epi16();
+
+    for (; i + 4 <= pixels_num; i += 4) {
+      const __m128i a = _mm_loadu_si128((const __m128i *)cp1);
+      const __m128i b = _mm_loadu_si128((const __m128i *)cp2);
+      const __m128i b_lo = _mm_unpacklo_epi8(b, zero);
+      const __m128i b_hi = _mm_unpackhi_epi8(b, zero);
+      /* `(temp_fac2 * cp2) >> 16` for color channels, zero for alpha. */
+      const __m128i d_lo = _mm_and_si128(
+          _mm_mulhi_epu16(_mm_mullo_epi16(simd_broadcast_alpha_epi16(b_lo), fac_v), b_lo),
+          rgb_mask);
+      const __m128i d_hi = _mm_and_si128(
+          _mm_mulhi_epu16(_mm_mullo_epi16(simd_broadcast_alpha_epi16(b_hi), fac_v), b_hi),
+          rgb_mask);
+      const __m128i lo = _mm_subs_epu16(_mm_unpacklo_epi8(a, zero), d_lo);
+      const __m128i hi = _mm_subs_epu16(_mm_unpackhi_epi8(a, zero), d_hi);
+      _mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(lo, hi));
+
+      cp1 += 16;
+      cp2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    const int temp_fac2 = temp_fac * int(cp2[3]);
+    rt[0] = max_ii(cp1[0] - ((temp_fac2 * cp2[0]) >> 16), 0);
+    rt[1] = max_ii(cp1[1] - ((temp_fac2 * cp2[1]) >> 16), 0);
+    rt[2] = max_ii(cp1[2] - ((temp_fac2 * cp2[2]) >> 16), 0);
+    rt[3] = cp1[3];
+
+    cp1 += 4;
+    cp2 += 4;
+    rt += 4;
+  }
 }
 
+template<bool use_simd = use_simd_default>
 static void do_sub_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
 {
   float *rt1 = rect1;
@@ -866,18 +1167,28 @@ static void do_sub_effect_float(float fac, int x, int y, float *rect1, float *re
 
   float mfac = 1.0f - fac;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      const float temp_fac = (1.0f - (rt1[3] * mfac)) * rt2[3];
+  const int64_t pixels_num = int64_t(x) * y;
+  for (int64_t i = 0; i < pixels_num; i++) {
+    const float temp_fac = (1.0f - (rt1[3] * mfac)) * rt2[3];
+#if BLI_HAVE_SSE2
+    if constexpr (use_simd) {
+      const __m128 a = _mm_loadu_ps(rt1);
+      const __m128 diff = _mm_max_ps(
+          _mm_sub_ps(a, _mm_mul_ps(_mm_set1_ps(temp_fac), _mm_loadu_ps(rt2))), _mm_setzero_ps());
+      _mm_storeu_ps(rt, simd_select(simd_rgb_mask(), diff, a));
+    }
+    else
+#endif
+    {
       rt[0] = max_ff(rt1[0] - temp_fac * rt2[0], 0.0f);
       rt[1] = max_ff(rt1[1] - temp_fac * rt2[1], 0.0f);
       rt[2] = max_ff(rt1[2] - temp_fac * rt2[2], 0.0f);
       rt[3] = rt1[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
     }
+
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
   }
 }
 
@@ -993,6 +1304,7 @@ static void do_drop_effect_float(
 /** \name Multiply Effect
  * \{ */
 
+template<bool use_simd = use_simd_default>
 static void do_mul_effect_byte(float fac, int x, int y, uchar *rect1, uchar *rect2, uchar *out)
 {
   uchar *rt1 = rect1;
@@ -1005,20 +1317,55 @@ static void do_mul_effect_byte(float fac, int x, int y, uchar *rect1, uchar *rec
    * `fac * (a * b) + (1 - fac) * a => fac * a * (b - 1) + axaux = c * px + py * s;` // + centx
    * `yaux = -s * px + c * py;` // + centy */
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      rt[0] = rt1[0] + ((temp_fac * rt1[0] * (rt2[0] - 255)) >> 16);
-      rt[1] = rt1[1] + ((temp_fac * rt1[1] * (rt2[1] - 255)) >> 16);
-      rt[2] = rt1[2] + ((temp_fac * rt1[2] * (rt2[2] - 255)) >> 16);
-      rt[3] = rt1[3] + ((temp_fac * rt1[3] * (rt2[3] - 255)) >> 16);
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
+  const int64_t pixels_num = int64_t(x) * y;
+  int64_t i = 0;
+
+#if BLI_HAVE_SSE2
+  /* Factor multiplied by color fits 16-bit as long as factor is in the unit range. */
+  if (use_simd && temp_fac >= 0 && temp_fac <= 256) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i max_value = _mm_set1_epi16(255);
+    const __m128i fac_v = _mm_set1_epi16(short(temp_fac));
+
+    /* The product is negative, so arithmetic shift rounds towards negative infinity:
+     * `(p * -q) >> 16 == -ceil(p * q / 65536)`, computed from the unsigned 32-bit product. */
+    auto mul_epi16 = [&](const __m128i a, const __m128i b) {
+      const __m128i p = _mm_mullo_epi16(a, fac_v);
+      const __m128i q = _mm_sub_epi16(max_value, b);
+      const __m128i product_hi = _mm_mulhi_epu16(p, q);
+      const __m128i product_lo_is_zero = _mm_cmpeq_epi16(_mm_mullo_epi16(p, q), zero);
+      const __m128i ceil = _mm_add_epi16(_mm_add_epi16(product_hi, one), product_lo_is_zero);
+      return _mm_sub_epi16(a, ceil);
+    };
+
+    for (; i + 4 <= pixels_num; i += 4) {
+      const __m128i a = _mm_loadu_si128((const __m128i *)rt1);
+      const __m128i b = _mm_loadu_si128((const __m128i *)rt2);
+      const __m128i lo = mul_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+      const __m128i hi = mul_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+      _mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(lo, hi));
+
+      rt1 += 16;
+      rt2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    rt[0] = rt1[0] + ((temp_fac * rt1[0] * (rt2[0] - 255)) >> 16);
+    rt[1] = rt1[1] + ((temp_fac * rt1[1] * (rt2[1] - 255)) >> 16);
+    rt[2] = rt1[2] + ((temp_fac * rt1[2] * (rt2[2] - 255)) >> 16);
+    rt[3] = rt1[3] + ((temp_fac * rt1[3] * (rt2[3] - 255)) >> 16);
+
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
+  }
 }
 
+template<bool use_simd = use_simd_default>
 static void do_mul_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
 {
   float *rt1 = rect1;
@@ -1028,17 +1375,29 @@ static void do_mul_effect_float(float fac, int x, int y, float *rect1, float *re
   /* Formula:
    * `fac * (a * b) + (1 - fac) * a => fac * a * (b - 1) + a`. */
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
+  const int64_t pixels_num = int64_t(x) * y;
+  for (int64_t i = 0; i < pixels_num; i++) {
+#if BLI_HAVE_SSE2
+    if constexpr (use_simd) {
+      const __m128 a = _mm_loadu_ps(rt1);
+      const __m128 b = _mm_loadu_ps(rt2);
+      _mm_storeu_ps(rt,
+                    _mm_add_ps(a,
+                               _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(fac), a),
+                                          _mm_sub_ps(b, _mm_set1_ps(1.0f)))));
+    }
+    else
+#endif
+    {
       rt[0] = rt1[0] + fac * rt1[0] * (rt2[0] - 1.0f);
       rt[1] = rt1[1] + fac * rt1[1] * (rt2[1] - 1.0f);
       rt[2] = rt1[2] + fac * rt1[2] * (rt2[2] - 1.0f);
       rt[3] = rt1[3] + fac * rt1[3] * (rt2[3] - 1.0f);
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
     }
+
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
   }
 }
 
@@ -3295,6 +3654,9 @@ static int early_out_text(Sequence *seq, float /*fac*/)
   return EARLY_NO_INPUT;
 }
 
+/* Font state is global, serialize drawing of text strips rendered by prefetch workers. */
+static ThreadMutex text_render_mutex = BLI_MUTEX_INITIALIZER;
+
 static ImBuf *do_text_effect(const SeqRenderData *context,
                              Sequence *seq,
                              float /*timeline_frame*/,
@@ -3314,6 +3676,8 @@ static ImBuf *do_text_effect(const SeqRenderData *context,
   int y_ofs, x, y;
   double proxy_size_comp;
 
+  BLI_mutex_lock(&text_render_mutex);
+
   if (data->text_blf_id == SEQ_FONT_NOT_LOADED) {
     data->text_blf_id = -1;
 
@@ -3412,6 +3776,8 @@ static ImBuf *do_text_effect(const SeqRenderData *context,
 
   BLF_disable(font, font_flags);
 
+  BLI_mutex_unlock(&text_render_mutex);
+
   return out;
 }
 
@@ -3725,3 +4091,55 @@ int SEQ_effect_get_num_inputs(int seq_type)
 }
 
 /** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Blend Functions for Testing
+ * \{ */
+
+template<bool use_simd>
+static bool blend_functions_get(const int blend_type,
+                                SeqBlendByteFn *r_byte_fn,
+                                SeqBlendFloatFn *r_float_fn)
+{
+  switch (blend_type) {
+    case SEQ_TYPE_ALPHAOVER:
+      *r_byte_fn = do_alphaover_effect_byte<use_simd>;
+      *r_float_fn = do_alphaover_effect_float<use_simd>;
+      return true;
+    case SEQ_TYPE_CROSS:
+      *r_byte_fn = do_cross_effect_byte<use_simd>;
+      *r_float_fn = do_cross_effect_float<use_simd>;
+      return true;
+    case SEQ_TYPE_GAMCROSS:
+      build_gammatabs();
+      *r_byte_fn = do_gammacross_effect_byte<use_simd>;
+      *r_float_fn = do_gammacross_effect_float<use_simd>;
+      return true;
+    case SEQ_TYPE_ADD:
+      *r_byte_fn = do_add_effect_byte<use_simd>;
+      *r_float_fn = do_add_effect_float<use_simd>;
+      return true;
+    case SEQ_TYPE_SUB:
+      *r_byte_fn = do_sub_effect_byte<use_simd>;
+      *r_float_fn = do_sub_effect_float<use_simd>;
+      return true;
+    case SEQ_TYPE_MUL:
+      *r_byte_fn = do_mul_effect_byte<use_simd>;
+      *r_float_fn = do_mul_effect_float<use_simd>;
+      return true;
+  }
+  return false;
+}
+
+bool seq_effect_blend_functions_get(const int blend_type,
+                                    const bool use_simd,
+                                    SeqBlendByteFn *r_byte_fn,
+                                    SeqBlendFloatFn *r_float_fn)
+{
+  if (use_simd) {
+    return blend_functions_get<true>(blend_type, r_byte_fn, r_float_fn);
+  }
+  return blend_functions_get<false>(blend_type, r_byte_fn, r_float_fn);
+}
+
+/** \} */
@@ -31,6 +31,20 @@ float seq_speed_effect_target_frame_get(struct Scene *scene,
                                         float timeline_frame,
                                         int input);
 
+typedef void (*SeqBlendByteFn)(
+    float fac, int x, int y, unsigned char *rect1, unsigned char *rect2, unsigned char *out);
+typedef void (*SeqBlendFloatFn)(
+    float fac, int x, int y, float *rect1, float *rect2, float *out);
+/**
+ * Get the functions blending byte and float images for blend types that have a SIMD code path
+ * (#SEQ_TYPE_CROSS etc.), either with or without SIMD. SIMD is only used when available.
+ * Used to compare both code paths in tests.
+ */
+bool seq_effect_blend_functions_get(int blend_type,
+                                    bool use_simd,
+                                    SeqBlendByteFn *r_byte_fn,
+                                    SeqBlendFloatFn *r_float_fn);
+
 #ifdef __cplusplus
 }
 #endif
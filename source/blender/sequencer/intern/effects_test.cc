@@ -0,0 +1,141 @@
+/* SPDX-FileCopyrightText: 2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <cmath>
+#include <cstdlib>
+
+#include "BLI_array.hh"
+#include "BLI_rand.hh"
+#include "BLI_timeit.hh"
+
+#include "DNA_sequence_types.h"
+
+#include "effects.h"
+
+namespace blender::seq::tests {
+
+struct BlendType {
+  int type;
+  const char *name;
+};
+
+static const BlendType blend_types[] = {
+    {SEQ_TYPE_ALPHAOVER, "Alpha Over"},
+    {SEQ_TYPE_CROSS, "Cross"},
+    {SEQ_TYPE_GAMCROSS, "Gamma Cross"},
+    {SEQ_TYPE_ADD, "Add"},
+    {SEQ_TYPE_SUB, "Subtract"},
+    {SEQ_TYPE_MUL, "Multiply"},
+};
+
+static Array<uchar> random_byte_image(const int64_t pixels_num, const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  Array<uchar> image(pixels_num * 4);
+  for (uchar &value : image) {
+    value = uchar(rng.get_int32(256));
+  }
+  return image;
+}
+
+static Array<float> random_float_image(const int64_t pixels_num,
+                                       const uint32_t seed,
+                                       const float min,
+                                       const float max)
+{
+  RandomNumberGenerator rng(seed);
+  Array<float> image(pixels_num * 4);
+  for (float &value : image) {
+    value = min + rng.get_float() * (max - min);
+  }
+  return image;
+}
+
+TEST(sequencer_effects, BlendSIMDMatchesScalar)
+{
+  /* Not a multiple of the number of pixels that are processed at once. */
+  const int x = 67;
+  const int y = 5;
+  const int64_t pixels_num = int64_t(x) * y;
+
+  Array<uchar> byte1 = random_byte_image(pixels_num, 1);
+  Array<uchar> byte2 = random_byte_image(pixels_num, 2);
+  /* Include negative and over-exposed colors. */
+  Array<float> float1 = random_float_image(pixels_num, 3, -0.25f, 1.25f);
+  Array<float> float2 = random_float_image(pixels_num, 4, -0.25f, 1.25f);
+
+  /* Factors outside of the unit range use the scalar code in some byte functions. */
+  for (const float fac : {0.0f, 0.25f, 0.5f, 1.0f, -0.5f, 1.5f}) {
+    for (const BlendType &blend_type : blend_types) {
+      SCOPED_TRACE(blend_type.name);
+      SCOPED_TRACE(fac);
+      SeqBlendByteFn byte_fn, byte_simd_fn;
+      SeqBlendFloatFn float_fn, float_simd_fn;
+      ASSERT_TRUE(seq_effect_blend_functions_get(blend_type.type, false, &byte_fn, &float_fn));
+      ASSERT_TRUE(
+          seq_effect_blend_functions_get(blend_type.type, true, &byte_simd_fn, &float_simd_fn));
+
+      /* Results may differ slightly where the compiler contracts the scalar code to fused
+       * multiply-add instructions. */
+      Array<uchar> byte_result(pixels_num * 4), byte_simd_result(pixels_num * 4);
+      byte_fn(fac, x, y, byte1.data(), byte2.data(), byte_result.data());
+      byte_simd_fn(fac, x, y, byte1.data(), byte2.data(), byte_simd_result.data());
+      for (const int64_t i : byte_result.index_range()) {
+        EXPECT_LE(std::abs(byte_result[i] - byte_simd_result[i]), 1) << "index " << i;
+      }
+
+      Array<float> float_result(pixels_num * 4), float_simd_result(pixels_num * 4);
+      float_fn(fac, x, y, float1.data(), float2.data(), float_result.data());
+      float_simd_fn(fac, x, y, float1.data(), float2.data(), float_simd_result.data());
+      for (const int64_t i : float_result.index_range()) {
+        EXPECT_NEAR(float_result[i], float_simd_result[i], 1e-5f) << "index " << i;
+      }
+    }
+  }
+}
+
+/**
+ * Compare the performance of the scalar and SIMD code of the blend functions on full HD images.
+ * Run it with `--gtest_also_run_disabled_tests --gtest_filter=*BlendBenchmark*`.
+ */
+TEST(sequencer_effects, DISABLED_BlendBenchmark)
+{
+  const int x = 1920;
+  const int y = 1080;
+  const int64_t pixels_num = int64_t(x) * y;
+  const int iterations = 20;
+
+  Array<uchar> byte1 = random_byte_image(pixels_num, 1);
+  Array<uchar> byte2 = random_byte_image(pixels_num, 2);
+  Array<uchar> byte_result(pixels_num * 4);
+  Array<float> float1 = random_float_image(pixels_num, 3, 0.0f, 1.0f);
+  Array<float> float2 = random_float_image(pixels_num, 4, 0.0f, 1.0f);
+  Array<float> float_result(pixels_num * 4);
+  const float fac = 0.5f;
+
+  for (const BlendType &blend_type : blend_types) {
+    for (const bool use_simd : {false, true}) {
+      SeqBlendByteFn byte_fn;
+      SeqBlendFloatFn float_fn;
+      ASSERT_TRUE(seq_effect_blend_functions_get(blend_type.type, use_simd, &byte_fn, &float_fn));
+      const std::string name = std::string(blend_type.name) + (use_simd ? " SIMD" : " scalar");
+      {
+        SCOPED_TIMER(name + " byte");
+        for (int i = 0; i < iterations; i++) {
+          byte_fn(fac, x, y, byte1.data(), byte2.data(), byte_result.data());
+        }
+      }
+      {
+        SCOPED_TIMER(name + " float");
+        for (int i = 0; i < iterations; i++) {
+          float_fn(fac, x, y, float1.data(), float2.data(), float_result.data());
+        }
+      }
+    }
+  }
+}
+
+}  // namespace blender::seq::tests
@@ -31,9 +31,13 @@
 #include "BLI_path_util.h"
 #include "BLI_threads.h"
 
+#include "PIL_time.h"
+
 #include "BKE_main.h"
 #include "BKE_scene.h"
 
+#include "atomic_ops.h"
+
 #include "SEQ_prefetch.h"
 #include "SEQ_relations.h"
 #include "SEQ_sequencer.h"
@@ -68,23 +72,62 @@
  * entries one by one in reverse order to their creation.
  *
  * User can exclude caching of some images. Such entries will have is_temp_cache set.
+ *
+ * Locking: Entries are distributed over multiple shards, each with its own hash and mutex, so
+ * that looking up images (#seq_cache_get) only locks one shard, and the prefetch job and the UI
+ * don't wait for each other. Changes to the cache (adding, removing or linking entries) are done
+ * with #SeqCache.iterator_mutex locked in addition to the shard mutex. As a result, holding
+ * #SeqCache.iterator_mutex is enough to read any shard.
+ *
+ * Recycling: Permanent entries are also kept in a list ordered by when they were last used, and
+ * every entry stores how long it took to render its frame up to that image. Of the least recently
+ * used frames, the one that is the cheapest to render again is recycled first, see
+ * #seq_cache_get_item_for_removal.
  */
 
 #define THUMB_CACHE_LIMIT 5000
 
+/** Number of shards, must be a power of two. */
+#define SEQ_CACHE_SHARDS_NUM 16
+
+/**
+ * Number of least recently used frames that are compared by their render cost when choosing the
+ * frame to recycle.
+ */
+#define SEQ_CACHE_RECYCLE_CANDIDATES_NUM 8
+
+struct SeqCacheShard {
+  ThreadMutex mutex;
+  GHash *hash;
+};
+
 struct SeqCache {
   Main *bmain;
-  GHash *hash;
+  SeqCacheShard shards[SEQ_CACHE_SHARDS_NUM];
   ThreadMutex iterator_mutex;
   BLI_mempool *keys_pool;
   BLI_mempool *items_pool;
-  SeqCacheKey *last_key;
+  /**
+   * Last key stored by each render task, indexed by #SeqRenderData.task_id. Prefetch workers
+   * render concurrently, so every task builds its own chain of linked keys.
+   */
+  SeqCacheKey *last_key[SEQ_TASK_PREFETCH_RENDER + SEQ_PREFETCH_THREADS_MAX];
   SeqDiskCache *disk_cache;
   int thumbnail_count;
+  /**
+   * Permanent keys (#SeqCacheKey.is_temp_cache unset), from the least to the most recently used.
+   * It has its own mutex, so that #seq_cache_get can update it without locking the whole cache.
+   */
+  SeqCacheKey *lru_first = nullptr;
+  SeqCacheKey *lru_last = nullptr;
+  ThreadMutex lru_mutex;
+  SeqCacheStats stats;
 };
 
 struct SeqCacheItem {
   SeqCache *cache_owner;
+  /** The key that is stored in the cache, lookups use temporary keys. */
+  SeqCacheKey *key;
   ImBuf *ibuf;
 };
 
@@ -134,6 +177,23 @@ static bool seq_cache_hashcmp(const void *a_, const void *b_)
           seq_cmp_render_data(&a->context, &b->context));
 }
 
+static SeqCacheShard *seq_cache_shard_get(SeqCache *cache, const SeqCacheKey *key)
+{
+  /* Use the high bits of a multiplicative hash, the low bits of the key hash are used to find
+   * the bucket in the shard's hash. */
+  const uint hash = seq_cache_hashhash(key) * 2654435761u;
+  return &cache->shards[hash >> (32 - 4)];
+}
+
+static uint seq_cache_len(SeqCache *cache)
+{
+  uint len = 0;
+  for (SeqCacheShard &shard : cache->shards) {
+    len += BLI_ghash_len(shard.hash);
+  }
+  return len;
+}
+
 static float seq_cache_timeline_frame_to_frame_index(Scene *scene,
                                                      Sequence *seq,
                                                      float timeline_frame,
@@ -186,6 +246,32 @@ static size_t seq_cache_get_mem_total()
   return size_t(U.memcachelimit) * 1024 * 1024;
 }
 
+/* Must be called with #SeqCache.iterator_mutex locked. */
+static void seq_cache_links_reset(SeqCache *cache)
+{
+  for (SeqCacheKey *&last_key : cache->last_key) {
+    last_key = nullptr;
+  }
+}
+
+#ifndef NDEBUG
+static bool seq_cache_is_last_key(const SeqCache *cache, const SeqCacheKey *key)
+{
+  for (const SeqCacheKey *last_key : cache->last_key) {
+    if (last_key == key) {
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+static SeqCacheKey *&seq_cache_last_key_get(SeqCache *cache, const eSeqTaskId task_id)
+{
+  BLI_assert(uint(task_id) < ARRAY_SIZE(cache->last_key));
+  return cache->last_key[task_id];
+}
+
 static void seq_cache_keyfree(void *val)
 {
   SeqCacheKey *key = static_cast<SeqCacheKey *>(val);
@@ -203,6 +289,83 @@ static void seq_cache_valfree(void *val)
   BLI_mempool_free(item->cache_owner->items_pool, item);
 }
 
+/* Must be called with #SeqCache.lru_mutex locked. */
+static bool seq_cache_lru_contains(const SeqCache *cache, const SeqCacheKey *key)
+{
+  return key->lru_prev != nullptr || cache->lru_first == key;
+}
+
+/* Must be called with #SeqCache.lru_mutex locked. */
+static void seq_cache_lru_unlink(SeqCache *cache, SeqCacheKey *key)
+{
+  if (key->lru_prev) {
+    key->lru_prev->lru_next = key->lru_next;
+  }
+  else {
+    cache->lru_first = key->lru_next;
+  }
+  if (key->lru_next) {
+    key->lru_next->lru_prev = key->lru_prev;
+  }
+  else {
+    cache->lru_last = key->lru_prev;
+  }
+  key->lru_prev = nullptr;
+  key->lru_next = nullptr;
+}
+
+/* Must be called with #SeqCache.lru_mutex locked. */
+static void seq_cache_lru_append(SeqCache *cache, SeqCacheKey *key)
+{
+  key->lru_prev = cache->lru_last;
+  key->lru_next = nullptr;
+  if (cache->lru_last) {
+    cache->lru_last->lru_next = key;
+  }
+  else {
+    cache->lru_first = key;
+  }
+  cache->lru_last = key;
+}
+
+static void seq_cache_lru_remove(SeqCache *cache, SeqCacheKey *key)
+{
+  BLI_mutex_lock(&cache->lru_mutex);
+  if (seq_cache_lru_contains(cache, key)) {
+    seq_cache_lru_unlink(cache, key);
+  }
+  BLI_mutex_unlock(&cache->lru_mutex);
+}
+
+/* Must be called with #SeqCache.iterator_mutex locked. */
+static bool seq_cache_haskey(SeqCache *cache, SeqCacheKey *key)
+{
+  return BLI_ghash_haskey(seq_cache_shard_get(cache, key)->hash, key);
+}
+
+/**
+ * Remove the key and its item from the cache.
+ * Must be called with #SeqCache.iterator_mutex locked.
+ */
+static void seq_cache_remove(SeqCache *cache, SeqCacheKey *key)
+{
+  SeqCacheShard *shard = seq_cache_shard_get(cache, key);
+
+  /* Free the image after unlocking, to keep the shard locked as short as possible. */
+  BLI_mutex_lock(&shard->mutex);
+  void *item = BLI_ghash_popkey(shard->hash, key, nullptr);
+  BLI_mutex_unlock(&shard->mutex);
+
+  /* Only unlink the key once it can't be found anymore, #seq_cache_get_ex moves found keys to the
+   * end of the list. */
+  seq_cache_lru_remove(cache, key);
+
+  seq_cache_keyfree(key);
+  if (item) {
+    seq_cache_valfree(item);
+  }
+}
+
 static int get_stored_types_flag(Scene *scene, SeqCacheKey *key)
 {
   int flag;
@@ -219,57 +382,101 @@ static int get_stored_types_flag(Scene *scene, SeqCacheKey *key)
   return flag;
 }
 
-static void seq_cache_put_ex(Scene *scene, SeqCacheKey *key, ImBuf *ibuf)
+/**
+ * Add the image to the cache, unless another thread has added an image for the same key already.
+ * Must be called with #SeqCache.iterator_mutex locked.
+ * \return False if the image was not added, the key is freed then.
+ */
+static bool seq_cache_put_ex(Scene *scene, SeqCacheKey *key, ImBuf *ibuf)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
+
+  /* Prevent reinserting, it breaks cache key linking. */
+  if (seq_cache_haskey(cache, key)) {
+    seq_cache_keyfree(key);
+    return false;
+  }
+
   SeqCacheItem *item;
   item = static_cast<SeqCacheItem *>(BLI_mempool_alloc(cache->items_pool));
   item->cache_owner = cache;
+  item->key = key;
   item->ibuf = ibuf;
 
   const int stored_types_flag = get_stored_types_flag(scene, key);
+  /* Only link keys stored by the same task, other tasks render different frames. */
+  SeqCacheKey *&last_key = seq_cache_last_key_get(cache, key->task_id);
 
   /* Item stored for later use. */
   if (stored_types_flag & key->type) {
     key->is_temp_cache = false;
-    key->link_prev = cache->last_key;
+    key->link_prev = last_key;
   }
 
-  BLI_assert(!BLI_ghash_haskey(cache->hash, key));
-  BLI_ghash_insert(cache->hash, key, item);
+  /* Accumulate the time spent rendering the frame up to this image, in frame durations. */
+  key->creation_time = PIL_check_seconds_timer();
+  if (last_key) {
+    key->cost = last_key->cost + float((key->creation_time - last_key->creation_time) * FPS);
+  }
+
+  SeqCacheShard *shard = seq_cache_shard_get(cache, key);
   IMB_refImBuf(ibuf);
+  BLI_mutex_lock(&shard->mutex);
+  BLI_assert(!BLI_ghash_haskey(shard->hash, key));
+  BLI_ghash_insert(shard->hash, key, item);
+  BLI_mutex_unlock(&shard->mutex);
+
+  if (!key->is_temp_cache) {
+    BLI_mutex_lock(&cache->lru_mutex);
+    seq_cache_lru_append(cache, key);
+    BLI_mutex_unlock(&cache->lru_mutex);
+  }
 
   /* Store pointer to last cached key. */
-  SeqCacheKey *temp_last_key = cache->last_key;
+  SeqCacheKey *temp_last_key = last_key;
 
   if (!key->is_temp_cache || key->type != SEQ_CACHE_STORE_THUMBNAIL) {
-    cache->last_key = key;
+    last_key = key;
   }
 
   /* Set last_key's reference to this key so we can look up chain backwards.
-   * Item is already put in cache, so cache->last_key points to current key.
+   * Item is already put in cache, so last_key points to current key.
    */
   if (!key->is_temp_cache && temp_last_key) {
-    temp_last_key->link_next = cache->last_key;
+    temp_last_key->link_next = last_key;
   }
 
   /* Reset linking. */
   if (key->type == SEQ_CACHE_STORE_FINAL_OUT) {
-    cache->last_key = nullptr;
+    last_key = nullptr;
   }
+  return true;
 }
 
 static ImBuf *seq_cache_get_ex(SeqCache *cache, SeqCacheKey *key)
 {
-  SeqCacheItem *item = static_cast<SeqCacheItem *>(BLI_ghash_lookup(cache->hash, key));
+  SeqCacheShard *shard = seq_cache_shard_get(cache, key);
+  ImBuf *ibuf = nullptr;
 
+  BLI_mutex_lock(&shard->mutex);
+  SeqCacheItem *item = static_cast<SeqCacheItem *>(BLI_ghash_lookup(shard->hash, key));
   if (item && item->ibuf) {
-    IMB_refImBuf(item->ibuf);
-
-    return item->ibuf;
+    ibuf = item->ibuf;
+    IMB_refImBuf(ibuf);
+
+    /* Mark the image as most recently used. The shard stays locked, so that the key can't be
+     * removed in the meantime. */
+    BLI_mutex_lock(&cache->lru_mutex);
+    if (seq_cache_lru_contains(cache, item->key)) {
+      seq_cache_lru_unlink(cache, item->key);
+      seq_cache_lru_append(cache, item->key);
+    }
+    BLI_mutex_unlock(&cache->lru_mutex);
   }
+  BLI_mutex_unlock(&shard->mutex);
 
-  return nullptr;
+  atomic_add_and_fetch_uint64(ibuf ? &cache->stats.hits : &cache->stats.misses, 1);
+  return ibuf;
 }
 
 static void seq_cache_key_unlink(SeqCacheKey *key)
@@ -284,69 +491,6 @@ static void seq_cache_key_unlink(SeqCacheKey *key)
   }
 }
 
-/* Choose a key out of 2 candidates(leftmost and rightmost items)
- * to recycle based on currently used strategy */
-static SeqCacheKey *seq_cache_choose_key(Scene *scene, SeqCacheKey *lkey, SeqCacheKey *rkey)
-{
-  SeqCacheKey *finalkey = nullptr;
-
-  /* Ideally, cache would not need to check the state of prefetching task
-   * that is tricky to do however, because prefetch would need to know,
-   * if a key, that is about to be created would be removed by itself.
-   *
-   * This can happen because only FINAL_OUT item insertion will trigger recycling
-   * but that is also the point, where prefetch can be suspended.
-   *
-   * We could use temp cache as a shield and later make it a non-temporary entry,
-   * but it is not worth of increasing system complexity.
-   */
-  if (scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE && seq_prefetch_job_is_running(scene)) {
-    int pfjob_start, pfjob_end;
-    seq_prefetch_get_time_range(scene, &pfjob_start, &pfjob_end);
-
-    if (lkey) {
-      if (lkey->timeline_frame < pfjob_start || lkey->timeline_frame > pfjob_end) {
-        return lkey;
-      }
-    }
-
-    if (rkey) {
-      if (rkey->timeline_frame < pfjob_start || rkey->timeline_frame > pfjob_end) {
-        return rkey;
-      }
-    }
-
-    return nullptr;
-  }
-
-  if (rkey && lkey) {
-    if (lkey->timeline_frame > rkey->timeline_frame) {
-      SeqCacheKey *swapkey = lkey;
-      lkey = rkey;
-      rkey = swapkey;
-    }
-
-    int l_diff = scene->r.cfra - lkey->timeline_frame;
-    int r_diff = rkey->timeline_frame - scene->r.cfra;
-
-    if (l_diff > r_diff) {
-      finalkey = lkey;
-    }
-    else {
-      finalkey = rkey;
-    }
-  }
-  else {
-    if (lkey) {
-      finalkey = lkey;
-    }
-    else {
-      finalkey = rkey;
-    }
-  }
-  return finalkey;
-}
-
 static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
@@ -357,7 +501,7 @@ static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
   SeqCacheKey *next = base->link_next;
 
   while (base) {
-    if (!BLI_ghash_haskey(cache->hash, base)) {
+    if (!seq_cache_haskey(cache, base)) {
       break; /* Key has already been removed from cache. */
     }
 
@@ -369,14 +513,15 @@ static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
     }
 
     seq_cache_key_unlink(base);
-    BLI_ghash_remove(cache->hash, base, seq_cache_keyfree, seq_cache_valfree);
-    BLI_assert(base != cache->last_key);
+    BLI_assert(!seq_cache_is_last_key(cache, base));
+    seq_cache_remove(cache, base);
+    cache->stats.evictions++;
     base = prev;
   }
 
   base = next;
   while (base) {
-    if (!BLI_ghash_haskey(cache->hash, base)) {
+    if (!seq_cache_haskey(cache, base)) {
       break; /* Key has already been removed from cache. */
     }
 
@@ -388,66 +533,59 @@ static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
     }
 
     seq_cache_key_unlink(base);
-    BLI_ghash_remove(cache->hash, base, seq_cache_keyfree, seq_cache_valfree);
-    BLI_assert(base != cache->last_key);
+    BLI_assert(!seq_cache_is_last_key(cache, base));
+    seq_cache_remove(cache, base);
+    cache->stats.evictions++;
     base = next;
   }
 }
 
+/**
+ * Choose the frame to recycle. Only keys at the end of a chain of linked keys are considered,
+ * recycling them frees the whole chain. Of the least recently used frames, the one that was the
+ * fastest to render is chosen, so that frames which are slow to render again are kept longer.
+ * Must be called with #SeqCache.iterator_mutex locked.
+ */
 static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
+
+  /* Ideally, cache would not need to check the state of prefetching task
+   * that is tricky to do however, because prefetch would need to know,
+   * if a key, that is about to be created would be removed by itself.
+   *
+   * This can happen because only FINAL_OUT item insertion will trigger recycling
+   * but that is also the point, where prefetch can be suspended.
+   *
+   * We could use temp cache as a shield and later make it a non-temporary entry,
+   * but it is not worth of increasing system complexity.
+   */
+  int pfjob_start = 0;
+  int pfjob_end = -1;
+  if (scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE && seq_prefetch_job_is_running(scene)) {
+    seq_prefetch_get_time_range(scene, &pfjob_start, &pfjob_end);
+  }
+
   SeqCacheKey *finalkey = nullptr;
-  /* Leftmost key. */
-  SeqCacheKey *lkey = nullptr;
-  /* Rightmost key. */
-  SeqCacheKey *rkey = nullptr;
-  SeqCacheKey *key = nullptr;
-
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  int total_count = 0;
-
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
-    SeqCacheItem *item = static_cast<SeqCacheItem *>(BLI_ghashIterator_getValue(&gh_iter));
-    BLI_ghashIterator_step(&gh_iter);
-    BLI_assert(key->cache_owner == cache);
-
-    /* This shouldn't happen, but better be safe than sorry. */
-    if (!item->ibuf) {
-      seq_cache_recycle_linked(scene, key);
-      /* Can not continue iterating after linked remove. */
-      BLI_ghashIterator_init(&gh_iter, cache->hash);
+  int candidates_num = 0;
+  BLI_mutex_lock(&cache->lru_mutex);
+  for (SeqCacheKey *key = cache->lru_first;
+       key != nullptr && candidates_num < SEQ_CACHE_RECYCLE_CANDIDATES_NUM;
+       key = key->lru_next)
+  {
+    if (key->link_next != nullptr) {
       continue;
     }
-
-    if (key->is_temp_cache || key->link_next != nullptr) {
+    if (key->timeline_frame >= pfjob_start && key->timeline_frame <= pfjob_end) {
       continue;
     }
-
-    total_count++;
-
-    if (lkey) {
-      if (key->timeline_frame < lkey->timeline_frame) {
-        lkey = key;
-      }
-    }
-    else {
-      lkey = key;
-    }
-    if (rkey) {
-      if (key->timeline_frame > rkey->timeline_frame) {
-        rkey = key;
-      }
-    }
-    else {
-      rkey = key;
+    candidates_num++;
+    /* On equal cost, the least recently used frame is recycled. */
+    if (finalkey == nullptr || key->cost < finalkey->cost) {
+      finalkey = key;
     }
   }
-  (void)total_count; /* Quiet set-but-unused warning (may be removed). */
-
-  finalkey = seq_cache_choose_key(scene, lkey, rkey);
+  BLI_mutex_unlock(&cache->lru_mutex);
 
   return finalkey;
 }
@@ -489,6 +627,7 @@ static void seq_cache_set_temp_cache_linked(Scene *scene, SeqCacheKey *base)
   while (base) {
     SeqCacheKey *prev = base->link_prev;
     base->is_temp_cache = true;
+    seq_cache_lru_remove(cache, base);
     base = prev;
   }
 
@@ -496,6 +635,7 @@ static void seq_cache_set_temp_cache_linked(Scene *scene, SeqCacheKey *base)
   while (base) {
     next = base->link_next;
     base->is_temp_cache = true;
+    seq_cache_lru_remove(cache, base);
     base = next;
   }
 }
@@ -504,14 +644,20 @@ static void seq_cache_create(Main *bmain, Scene *scene)
 {
   BLI_mutex_lock(&cache_create_lock);
   if (scene->ed->cache == nullptr) {
-    SeqCache *cache = static_cast<SeqCache *>(MEM_callocN(sizeof(SeqCache), "SeqCache"));
+    SeqCache *cache = MEM_new<SeqCache>("SeqCache");
     cache->keys_pool = BLI_mempool_create(sizeof(SeqCacheKey), 0, 64, BLI_MEMPOOL_NOP);
     cache->items_pool = BLI_mempool_create(sizeof(SeqCacheItem), 0, 64, BLI_MEMPOOL_NOP);
-    cache->hash = BLI_ghash_new(seq_cache_hashhash, seq_cache_hashcmp, "SeqCache hash");
-    cache->last_key = nullptr;
+    for (SeqCacheShard &shard : cache->shards) {
+      shard.hash = BLI_ghash_new(seq_cache_hashhash, seq_cache_hashcmp, "SeqCache hash");
+      BLI_mutex_init(&shard.mutex);
+    }
+    seq_cache_links_reset(cache);
+    cache->disk_cache = nullptr;
+    cache->stats = {};
     cache->bmain = bmain;
     cache->thumbnail_count = 0;
     BLI_mutex_init(&cache->iterator_mutex);
+    BLI_mutex_init(&cache->lru_mutex);
     scene->ed->cache = cache;
 
     if (scene->ed->disk_cache_timestamp == 0) {
@@ -536,6 +682,10 @@ static void seq_cache_populate_key(SeqCacheKey *key,
   key->type = type;
   key->link_prev = nullptr;
   key->link_next = nullptr;
+  key->lru_prev = nullptr;
+  key->lru_next = nullptr;
+  key->creation_time = 0.0;
+  key->cost = 0.0f;
   key->is_temp_cache = true;
   key->task_id = context->task_id;
 }
@@ -562,24 +712,27 @@ void seq_cache_free_temp_cache(Scene *scene, short id, int timeline_frame)
 
   seq_cache_lock(scene);
 
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    SeqCacheKey *key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
-    BLI_ghashIterator_step(&gh_iter);
-    BLI_assert(key->cache_owner == cache);
-
-    if (key->is_temp_cache && key->task_id == id && key->type != SEQ_CACHE_STORE_THUMBNAIL) {
-      /* Use frame_index here to avoid freeing raw images if they are used for multiple frames. */
-      float frame_index = seq_cache_timeline_frame_to_frame_index(
-          scene, key->seq, timeline_frame, key->type);
-      if (frame_index != key->frame_index ||
-          timeline_frame > SEQ_time_right_handle_frame_get(scene, key->seq) ||
-          timeline_frame < SEQ_time_left_handle_frame_get(scene, key->seq))
-      {
-        seq_cache_key_unlink(key);
-        BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
-        BLI_assert(key != cache->last_key);
+  for (SeqCacheShard &shard : cache->shards) {
+    GHashIterator gh_iter;
+    BLI_ghashIterator_init(&gh_iter, shard.hash);
+    while (!BLI_ghashIterator_done(&gh_iter)) {
+      SeqCacheKey *key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
+      BLI_ghashIterator_step(&gh_iter);
+      BLI_assert(key->cache_owner == cache);
+
+      if (key->is_temp_cache && key->task_id == id && key->type != SEQ_CACHE_STORE_THUMBNAIL) {
+        /* Use frame_index here to avoid freeing raw images if they are used for multiple
+         * frames. */
+        float frame_index = seq_cache_timeline_frame_to_frame_index(
+            scene, key->seq, timeline_frame, key->type);
+        if (frame_index != key->frame_index ||
+            timeline_frame > SEQ_time_right_handle_frame_get(scene, key->seq) ||
+            timeline_frame < SEQ_time_left_handle_frame_get(scene, key->seq))
+        {
+          seq_cache_key_unlink(key);
+          BLI_assert(!seq_cache_is_last_key(cache, key));
+          seq_cache_remove(cache, key);
+        }
       }
     }
   }
@@ -593,16 +746,20 @@ void seq_cache_destruct(Scene *scene)
     return;
   }
 
-  BLI_ghash_free(cache->hash, seq_cache_keyfree, seq_cache_valfree);
+  for (SeqCacheShard &shard : cache->shards) {
+    BLI_ghash_free(shard.hash, seq_cache_keyfree, seq_cache_valfree);
+    BLI_mutex_end(&shard.mutex);
+  }
   BLI_mempool_destroy(cache->keys_pool);
   BLI_mempool_destroy(cache->items_pool);
   BLI_mutex_end(&cache->iterator_mutex);
+  BLI_mutex_end(&cache->lru_mutex);
 
   if (cache->disk_cache != nullptr) {
     seq_disk_cache_free(cache->disk_cache);
   }
 
-  MEM_freeN(cache);
+  MEM_delete(cache);
   scene->ed->cache = nullptr;
 }
 
@@ -625,18 +782,21 @@ void SEQ_cache_cleanup(Scene *scene)
 
   seq_cache_lock(scene);
 
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    SeqCacheKey *key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
-    BLI_assert(key->cache_owner == cache);
+  for (SeqCacheShard &shard : cache->shards) {
+    GHashIterator gh_iter;
+    BLI_ghashIterator_init(&gh_iter, shard.hash);
+    while (!BLI_ghashIterator_done(&gh_iter)) {
+      SeqCacheKey *key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
+      BLI_assert(key->cache_owner == cache);
 
-    BLI_ghashIterator_step(&gh_iter);
+      BLI_ghashIterator_step(&gh_iter);
 
-    /* NOTE: no need to call #seq_cache_key_unlink as all keys are removed. */
-    BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
+      /* NOTE: no need to call #seq_cache_key_unlink as all keys are removed. */
+      seq_cache_remove(cache, key);
+    }
   }
-  cache->last_key = nullptr;
+  BLI_assert(cache->lru_first == nullptr);
+  seq_cache_links_reset(cache);
   cache->thumbnail_count = 0;
   seq_cache_unlock(scene);
 }
@@ -670,29 +830,31 @@ void seq_cache_cleanup_sequence(Scene *scene,
   int invalidate_source = invalidate_types & (SEQ_CACHE_STORE_RAW | SEQ_CACHE_STORE_PREPROCESSED |
                                               SEQ_CACHE_STORE_COMPOSITE);
 
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    SeqCacheKey *key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
-    BLI_ghashIterator_step(&gh_iter);
-    BLI_assert(key->cache_owner == cache);
-
-    /* Clean all final and composite in intersection of seq and seq_changed. */
-    if (key->type & invalidate_composite && key->timeline_frame >= range_start &&
-        key->timeline_frame <= range_end)
-    {
-      seq_cache_key_unlink(key);
-      BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
-    }
-    else if (key->type & invalidate_source && key->seq == seq &&
-             key->timeline_frame >= SEQ_time_left_handle_frame_get(scene, seq_changed) &&
-             key->timeline_frame <= SEQ_time_right_handle_frame_get(scene, seq_changed))
-    {
-      seq_cache_key_unlink(key);
-      BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
+  for (SeqCacheShard &shard : cache->shards) {
+    GHashIterator gh_iter;
+    BLI_ghashIterator_init(&gh_iter, shard.hash);
+    while (!BLI_ghashIterator_done(&gh_iter)) {
+      SeqCacheKey *key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
+      BLI_ghashIterator_step(&gh_iter);
+      BLI_assert(key->cache_owner == cache);
+
+      /* Clean all final and composite in intersection of seq and seq_changed. */
+      if (key->type & invalidate_composite && key->timeline_frame >= range_start &&
+          key->timeline_frame <= range_end)
+      {
+        seq_cache_key_unlink(key);
+        seq_cache_remove(cache, key);
+      }
+      else if (key->type & invalidate_source && key->seq == seq &&
+               key->timeline_frame >= SEQ_time_left_handle_frame_get(scene, seq_changed) &&
+               key->timeline_frame <= SEQ_time_right_handle_frame_get(scene, seq_changed))
+      {
+        seq_cache_key_unlink(key);
+        seq_cache_remove(cache, key);
+      }
     }
   }
-  cache->last_key = nullptr;
+  seq_cache_links_reset(cache);
   seq_cache_unlock(scene);
 }
 
@@ -709,34 +871,37 @@ void seq_cache_thumbnail_cleanup(Scene *scene, rctf *view_area_safe)
     return;
   }
 
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    SeqCacheKey *key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
-    BLI_ghashIterator_step(&gh_iter);
-    BLI_assert(key->cache_owner == cache);
-
-    const int frame_index = key->timeline_frame - SEQ_time_left_handle_frame_get(scene, key->seq);
-    const int frame_step = SEQ_render_thumbnails_guaranteed_set_frame_step_get(scene, key->seq);
-    const int relative_base_frame = round_fl_to_int(frame_index / float(frame_step)) * frame_step;
-    const int nearest_guaranted_absolute_frame = relative_base_frame +
-                                                 SEQ_time_left_handle_frame_get(scene, key->seq);
-
-    if (nearest_guaranted_absolute_frame == key->timeline_frame) {
-      continue;
-    }
+  for (SeqCacheShard &shard : cache->shards) {
+    GHashIterator gh_iter;
+    BLI_ghashIterator_init(&gh_iter, shard.hash);
+    while (!BLI_ghashIterator_done(&gh_iter)) {
+      SeqCacheKey *key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
+      BLI_ghashIterator_step(&gh_iter);
+      BLI_assert(key->cache_owner == cache);
+
+      const int left_handle_frame = SEQ_time_left_handle_frame_get(scene, key->seq);
+      const int frame_index = key->timeline_frame - left_handle_frame;
+      const int frame_step = SEQ_render_thumbnails_guaranteed_set_frame_step_get(scene, key->seq);
+      const int relative_base_frame = round_fl_to_int(frame_index / float(frame_step)) *
+                                      frame_step;
+      const int nearest_guaranted_absolute_frame = relative_base_frame + left_handle_frame;
+
+      if (nearest_guaranted_absolute_frame == key->timeline_frame) {
+        continue;
+      }
 
-    if ((key->type & SEQ_CACHE_STORE_THUMBNAIL) &&
-        (key->timeline_frame > view_area_safe->xmax ||
-         key->timeline_frame < view_area_safe->xmin || key->seq->machine > view_area_safe->ymax ||
-         key->seq->machine < view_area_safe->ymin))
-    {
-      seq_cache_key_unlink(key);
-      BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
-      cache->thumbnail_count--;
+      if ((key->type & SEQ_CACHE_STORE_THUMBNAIL) &&
+          (key->timeline_frame > view_area_safe->xmax ||
+           key->timeline_frame < view_area_safe->xmin ||
+           key->seq->machine > view_area_safe->ymax || key->seq->machine < view_area_safe->ymin))
+      {
+        seq_cache_key_unlink(key);
+        seq_cache_remove(cache, key);
+        cache->thumbnail_count--;
+      }
     }
   }
-  cache->last_key = nullptr;
+  seq_cache_links_reset(cache);
 }
 
 ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline_frame, int type)
@@ -762,17 +927,15 @@ ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline
     seq_cache_create(context->bmain, scene);
   }
 
-  seq_cache_lock(scene);
   SeqCache *cache = seq_cache_get_from_scene(scene);
   ImBuf *ibuf = nullptr;
   SeqCacheKey key;
 
-  /* Try RAM cache: */
+  /* Try RAM cache, this only locks the shard containing the key. */
   if (cache && seq) {
     seq_cache_populate_key(&key, context, seq, timeline_frame, type);
     ibuf = seq_cache_get_ex(cache, &key);
   }
-  seq_cache_unlock(scene);
 
   if (ibuf) {
     return ibuf;
@@ -780,9 +943,11 @@ ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline
 
   /* Try disk cache: */
   if (seq_disk_cache_is_enabled(context->bmain)) {
+    seq_cache_lock(scene);
     if (cache->disk_cache == nullptr) {
       cache->disk_cache = seq_disk_cache_create(context->bmain, context->scene);
     }
+    seq_cache_unlock(scene);
 
     ibuf = seq_disk_cache_read_file(cache->disk_cache, &key);
 
@@ -792,8 +957,10 @@ ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline
 
     /* Store read image in RAM. Only recycle item for final type. */
     if (key.type != SEQ_CACHE_STORE_FINAL_OUT || seq_cache_recycle_item(scene)) {
+      seq_cache_lock(scene);
       SeqCacheKey *new_key = seq_cache_allocate_key(cache, context, seq, timeline_frame, type);
       seq_cache_put_ex(scene, new_key, ibuf);
+      seq_cache_unlock(scene);
     }
   }
 
@@ -820,8 +987,11 @@ bool seq_cache_put_if_possible(
     return true;
   }
 
-  seq_cache_set_temp_cache_linked(scene, scene->ed->cache->last_key);
-  scene->ed->cache->last_key = nullptr;
+  seq_cache_lock(scene);
+  SeqCacheKey *&last_key = seq_cache_last_key_get(scene->ed->cache, context->task_id);
+  seq_cache_set_temp_cache_linked(scene, last_key);
+  last_key = nullptr;
+  seq_cache_unlock(scene);
   return false;
 }
 
@@ -843,7 +1013,7 @@ void seq_cache_thumbnail_put(const SeqRenderData *context,
       cache, context, seq, timeline_frame, SEQ_CACHE_STORE_THUMBNAIL);
 
   /* Prevent reinserting, it breaks cache key linking. */
-  if (BLI_ghash_haskey(cache->hash, key)) {
+  if (seq_cache_haskey(cache, key)) {
     seq_cache_unlock(scene);
     return;
   }
@@ -875,13 +1045,6 @@ void seq_cache_put(
     BLI_assert(seq != nullptr);
   }
 
-  /* Prevent reinserting, it breaks cache key linking. */
-  ImBuf *test = seq_cache_get(context, seq, timeline_frame, type);
-  if (test) {
-    IMB_freeImBuf(test);
-    return;
-  }
-
   if (!scene->ed->cache) {
     seq_cache_create(context->bmain, scene);
   }
@@ -889,18 +1052,22 @@ void seq_cache_put(
   seq_cache_lock(scene);
   SeqCache *cache = seq_cache_get_from_scene(scene);
   SeqCacheKey *key = seq_cache_allocate_key(cache, context, seq, timeline_frame, type);
-  seq_cache_put_ex(scene, key, i);
+  if (!seq_cache_put_ex(scene, key, i)) {
+    seq_cache_unlock(scene);
+    return;
+  }
+  /* Copy the key, it may be recycled by another thread once the cache is unlocked. */
+  SeqCacheKey key_copy = *key;
+  const bool use_disk_cache = !key_copy.is_temp_cache &&
+                              seq_disk_cache_is_enabled(context->bmain);
+  if (use_disk_cache && cache->disk_cache == nullptr) {
+    cache->disk_cache = seq_disk_cache_create(context->bmain, context->scene);
+  }
   seq_cache_unlock(scene);
 
-  if (!key->is_temp_cache) {
-    if (seq_disk_cache_is_enabled(context->bmain)) {
-      if (cache->disk_cache == nullptr) {
-        seq_disk_cache_create(context->bmain, context->scene);
-      }
-
-      seq_disk_cache_write_file(cache->disk_cache, key, i);
-      seq_disk_cache_enforce_limits(cache->disk_cache);
-    }
+  if (use_disk_cache) {
+    seq_disk_cache_write_file(cache->disk_cache, &key_copy, i);
+    seq_disk_cache_enforce_limits(cache->disk_cache);
   }
 }
 
@@ -916,20 +1083,36 @@ void SEQ_cache_iterate(
   }
 
   seq_cache_lock(scene);
-  bool interrupt = callback_init(userdata, BLI_ghash_len(cache->hash));
+  bool interrupt = callback_init(userdata, seq_cache_len(cache));
+
+  for (SeqCacheShard &shard : cache->shards) {
+    GHashIterator gh_iter;
+    BLI_ghashIterator_init(&gh_iter, shard.hash);
+
+    while (!BLI_ghashIterator_done(&gh_iter) && !interrupt) {
+      SeqCacheKey *key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
+      BLI_ghashIterator_step(&gh_iter);
+      BLI_assert(key->cache_owner == cache);
 
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
+      interrupt = callback_iter(userdata, key->seq, key->timeline_frame, key->type);
+    }
+  }
 
-  while (!BLI_ghashIterator_done(&gh_iter) && !interrupt) {
-    SeqCacheKey *key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
-    BLI_ghashIterator_step(&gh_iter);
-    BLI_assert(key->cache_owner == cache);
+  seq_cache_links_reset(cache);
+  seq_cache_unlock(scene);
+}
 
-    interrupt = callback_iter(userdata, key->seq, key->timeline_frame, key->type);
+void SEQ_cache_stats_get(Scene *scene, SeqCacheStats *r_stats)
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    *r_stats = {};
+    return;
   }
 
-  cache->last_key = nullptr;
+  seq_cache_lock(scene);
+  *r_stats = cache->stats;
+  r_stats->items_num = seq_cache_len(cache);
   seq_cache_unlock(scene);
 }
 
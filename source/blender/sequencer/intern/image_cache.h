@@ -25,11 +25,14 @@ typedef struct SeqCacheKey {
   void *userkey;
   struct SeqCacheKey *link_prev; /* Used for linking intermediate items to final frame. */
   struct SeqCacheKey *link_next; /* Used for linking intermediate items to final frame. */
+  struct SeqCacheKey *lru_prev;  /* Neighbors in the list of recently used permanent keys. */
+  struct SeqCacheKey *lru_next;
   struct Sequence *seq;
   struct SeqRenderData context;
   float frame_index;    /* Usually same as timeline_frame. Mapped to media for RAW entries. */
   float timeline_frame; /* Only for reference - used for freeing when cache is full. */
   float cost;           /* In short: render time(s) divided by playback frame duration(s) */
+  double creation_time; /* Time when the image was put into the cache, in seconds. */
   bool is_temp_cache;   /* this cache entry will be freed before rendering next frame */
   /* ID of task for assigning temp cache entries to particular task(thread, etc.) */
   eSeqTaskId task_id;
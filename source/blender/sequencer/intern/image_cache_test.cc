@@ -0,0 +1,243 @@
+/* SPDX-FileCopyrightText: 2023 Blender Foundation
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "CLG_log.h"
+
+#include "BKE_idtype.h"
+#include "BKE_main.h"
+#include "BKE_scene.h"
+
+#include "BLI_listbase.h"
+#include "BLI_threads.h"
+
+#include "DNA_scene_types.h"
+#include "DNA_sequence_types.h"
+#include "DNA_space_types.h"
+#include "DNA_userdef_types.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "SEQ_relations.h"
+#include "SEQ_render.h"
+#include "SEQ_sequencer.h"
+
+#include "image_cache.h"
+
+namespace blender::seq::tests {
+
+/* Number of render tasks, like the main render and prefetch workers. */
+static constexpr int tasks_num = 4;
+static constexpr int frames_num = 8 * tasks_num;
+/* Every frame is stored in the cache as a chain of these types. */
+static constexpr int chain_types[] = {
+    SEQ_CACHE_STORE_PREPROCESSED, SEQ_CACHE_STORE_COMPOSITE, SEQ_CACHE_STORE_FINAL_OUT};
+static constexpr int chain_length = ARRAY_SIZE(chain_types);
+
+class ImageCacheTest : public testing::Test {
+  friend struct PrefetchTaskData;
+
+ protected:
+  Main *bmain;
+  Scene *scene;
+  Sequence *seq;
+  int memcachelimit;
+
+  void SetUp() override
+  {
+    CLG_init();
+    BKE_idtype_init();
+    IMB_init();
+
+    bmain = BKE_main_new();
+    scene = BKE_scene_add(bmain, "Scene");
+    Editing *ed = SEQ_editing_ensure(scene);
+    ed->cache_flag = SEQ_CACHE_STORE_PREPROCESSED | SEQ_CACHE_STORE_COMPOSITE |
+                     SEQ_CACHE_STORE_FINAL_OUT;
+    seq = SEQ_sequence_alloc(ed->seqbasep, 1, 1, SEQ_TYPE_ADJUSTMENT);
+    seq->len = frames_num;
+    memcachelimit = U.memcachelimit;
+  }
+
+  void TearDown() override
+  {
+    U.memcachelimit = memcachelimit;
+    BKE_main_free(bmain);
+    IMB_exit();
+    CLG_exit();
+  }
+
+  SeqRenderData render_data(const int task_index) const
+  {
+    SeqRenderData context;
+    SEQ_render_new_render_data(bmain, nullptr, scene, 64, 64, SEQ_RENDER_SIZE_SCENE, 0, &context);
+    context.task_id = eSeqTaskId(SEQ_TASK_MAIN_RENDER + task_index);
+    return context;
+  }
+
+  /** Every task renders different frames, which are stored in the cache in between. */
+  static int task_frame(const int task_index, const int i)
+  {
+    return 1 + task_index + i * tasks_num;
+  }
+
+  void put(const SeqRenderData &context, const int timeline_frame, const int type) const
+  {
+    /* One megabyte per image, so the cache limit can be set with enough precision. */
+    ImBuf *ibuf = IMB_allocImBuf(512, 512, 32, IB_rect);
+    seq_cache_put(&context, seq, float(timeline_frame), type, ibuf);
+    IMB_freeImBuf(ibuf);
+  }
+
+  bool is_cached(const int timeline_frame, const int type) const
+  {
+    const SeqRenderData context = this->render_data(0);
+    ImBuf *ibuf = seq_cache_get(&context, seq, float(timeline_frame), type);
+    IMB_freeImBuf(ibuf);
+    return ibuf != nullptr;
+  }
+
+  /**
+   * Count the frames that are still in the cache. Every frame has to be either fully cached or
+   * evicted with its whole chain.
+   */
+  int cached_frames_num() const
+  {
+    int cached_num = 0;
+    for (int frame = 1; frame <= frames_num; frame++) {
+      int cached_types_num = 0;
+      for (const int type : chain_types) {
+        cached_types_num += this->is_cached(frame, type);
+      }
+      EXPECT_TRUE(ELEM(cached_types_num, 0, chain_length)) << "frame " << frame;
+      cached_num += cached_types_num == chain_length;
+    }
+    return cached_num;
+  }
+
+  /** Render the chains of all frames in concurrent tasks. */
+  void run_prefetch_tasks(bool render_same_frames) const;
+
+  /** Number of images in the cache, counting duplicates of the same key. */
+  int cached_items_num() const
+  {
+    size_t items_num = 0;
+    SEQ_cache_iterate(
+        scene,
+        &items_num,
+        [](void *userdata, size_t item_count) {
+          *static_cast<size_t *>(userdata) = item_count;
+          /* Interrupt, only the count is needed. */
+          return true;
+        },
+        [](void * /*userdata*/, Sequence * /*seq*/, int /*timeline_frame*/, int /*type*/) {
+          return true;
+        });
+    return int(items_num);
+  }
+
+  /** Set the cache limit so that evicting a single chain is enough to make room. */
+  void recycle_one_chain() const
+  {
+    U.memcachelimit = int(MEM_get_memory_in_use() / (1024 * 1024)) - 1;
+    EXPECT_TRUE(seq_cache_recycle_item(scene));
+  }
+
+  void recycle_all_chains()
+  {
+    for (int expected_num = frames_num; expected_num > 0; expected_num--) {
+      EXPECT_EQ(this->cached_frames_num(), expected_num);
+      this->recycle_one_chain();
+    }
+    EXPECT_EQ(this->cached_frames_num(), 0);
+  }
+};
+
+TEST_F(ImageCacheTest, InterleavedTasksKeepSeparateChains)
+{
+  /* Store the chains of all tasks step by step, like concurrent prefetch workers do. */
+  for (int i = 0; i < frames_num / tasks_num; i++) {
+    for (const int type : chain_types) {
+      for (int task_index = 0; task_index < tasks_num; task_index++) {
+        this->put(this->render_data(task_index), task_frame(task_index, i), type);
+      }
+    }
+  }
+  this->recycle_all_chains();
+}
+
+TEST_F(ImageCacheTest, RecycleLeastRecentlyUsed)
+{
+  const SeqRenderData context = this->render_data(0);
+  for (int frame = 1; frame <= frames_num; frame++) {
+    for (const int type : chain_types) {
+      this->put(context, frame, type);
+    }
+  }
+
+  /* Viewing the first frame again keeps it, while the frames that were used less recently are
+   * recycled. Up to 8 of those are compared by their render cost, which depends on timing. */
+  const int recycle_candidates_num = 8;
+  EXPECT_TRUE(this->is_cached(1, SEQ_CACHE_STORE_FINAL_OUT));
+  for (int i = 0; i < frames_num - recycle_candidates_num; i++) {
+    this->recycle_one_chain();
+  }
+  EXPECT_TRUE(this->is_cached(1, SEQ_CACHE_STORE_FINAL_OUT));
+  EXPECT_EQ(this->cached_frames_num(), recycle_candidates_num);
+}
+
+struct PrefetchTaskData {
+  const ImageCacheTest *test;
+  SeqRenderData context;
+  int task_index;
+  /** Render the frames of the first task, like workers that race for the same frames. */
+  bool render_same_frames;
+
+  void run() const
+  {
+    const int frames_task_index = render_same_frames ? 0 : task_index;
+    for (int i = 0; i < frames_num / tasks_num; i++) {
+      for (const int type : chain_types) {
+        test->put(context, ImageCacheTest::task_frame(frames_task_index, i), type);
+      }
+    }
+  }
+};
+
+void ImageCacheTest::run_prefetch_tasks(const bool render_same_frames) const
+{
+  PrefetchTaskData tasks[tasks_num];
+  ListBase threads;
+  BLI_threadpool_init(
+      &threads,
+      [](void *data) -> void * {
+        static_cast<const PrefetchTaskData *>(data)->run();
+        return nullptr;
+      },
+      tasks_num);
+  for (int task_index = 0; task_index < tasks_num; task_index++) {
+    tasks[task_index] = {this, this->render_data(task_index), task_index, render_same_frames};
+    BLI_threadpool_insert(&threads, &tasks[task_index]);
+  }
+  BLI_threadpool_end(&threads);
+}
+
+TEST_F(ImageCacheTest, ConcurrentPrefetch)
+{
+  this->run_prefetch_tasks(false);
+  this->recycle_all_chains();
+}
+
+TEST_F(ImageCacheTest, ConcurrentPutSameFrames)
+{
+  this->run_prefetch_tasks(true);
+  /* Images that are put by several tasks at the same time are only stored once. */
+  EXPECT_EQ(this->cached_items_num(), frames_num / tasks_num * chain_length);
+}
+
+}  // namespace blender::seq::tests
@@ -19,6 +19,8 @@
 #include "DNA_windowmanager_types.h"
 
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 
 #include "IMB_imbuf.h"
@@ -49,25 +51,44 @@
 #include "prefetch.h"
 #include "render.h"
 
+/**
+ * Renders one frame at a time into the shared cache. Every worker has its own depsgraph, so
+ * frames of one batch can be animated and rendered independently of each other.
+ */
+struct PrefetchWorker {
+  /** Built by the prefetch job when the worker is first used, see #seq_prefetch_worker_init. */
+  Depsgraph *depsgraph;
+  Scene *scene_eval;
+
+  /* context */
+  SeqRenderData context;
+  SeqRenderData context_cpy;
+
+  /* Frame rendered by this worker in the current batch. */
+  float cfra;
+  bool skip_frame;
+};
+
 struct PrefetchJob {
   PrefetchJob *next, *prev;
 
   Main *bmain;
   Main *bmain_eval;
   Scene *scene;
-  Scene *scene_eval;
-  Depsgraph *depsgraph;
+  /** Render settings of the context that started the job. */
+  SeqRenderData context;
+  /** Original meta strip that is shown when the job was started, null for the top level. */
+  Sequence *active_meta;
 
   ThreadMutex prefetch_suspend_mutex;
   ThreadCondition prefetch_suspend_cond;
 
   ListBase threads;
 
-  /* context */
-  SeqRenderData context;
-  SeqRenderData context_cpy;
-  ListBase *seqbasep;
-  ListBase *seqbasep_cpy;
+  PrefetchWorker workers[SEQ_PREFETCH_THREADS_MAX];
+  int num_workers;
+  /** The worker depsgraphs have to be rebuilt, because the job was started again. */
+  bool depsgraphs_outdated;
 
   /* prefetch area */
   float cfra;
@@ -162,7 +183,14 @@ SeqRenderData *seq_prefetch_get_original_context(const SeqRenderData *context)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
 
-  return &pfjob->context;
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    if (pfjob->workers[i].scene_eval == context->scene) {
+      return &pfjob->workers[i].context;
+    }
+  }
+
+  BLI_assert_unreachable();
+  return &pfjob->workers[0].context;
 }
 
 static bool seq_prefetch_is_cache_full(Scene *scene)
@@ -180,50 +208,44 @@ static float seq_prefetch_cfra(PrefetchJob *pfjob)
 {
   return pfjob->cfra + pfjob->num_frames_prefetched;
 }
-static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchJob *pfjob)
+static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchWorker *worker)
 {
-  return BKE_animsys_eval_context_construct(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+  return BKE_animsys_eval_context_construct(worker->depsgraph, worker->cfra);
 }
 
 void seq_prefetch_get_time_range(Scene *scene, int *start, int *end)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
 
+  /* Include frames, that are being rendered by other workers of current batch. */
   *start = pfjob->cfra;
-  *end = seq_prefetch_cfra(pfjob);
+  *end = seq_prefetch_cfra(pfjob) + pfjob->num_workers - 1;
 }
 
-static void seq_prefetch_free_depsgraph(PrefetchJob *pfjob)
+static int seq_prefetch_num_workers_get(const Editing *ed)
 {
-  if (pfjob->depsgraph != nullptr) {
-    DEG_graph_free(pfjob->depsgraph);
+  if (ed->prefetch_threads > 0) {
+    return min_ii(ed->prefetch_threads, SEQ_PREFETCH_THREADS_MAX);
   }
-  pfjob->depsgraph = nullptr;
-  pfjob->scene_eval = nullptr;
+
+  /* Rendering of single frame is multi-threaded too, so don't use all cores for frames. */
+  return clamp_i(BLI_system_thread_count() / 4, 1, SEQ_PREFETCH_THREADS_MAX);
 }
 
-static void seq_prefetch_update_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_free_depsgraph(PrefetchJob *pfjob)
 {
-  DEG_evaluate_on_framechange(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+  for (PrefetchWorker &worker : pfjob->workers) {
+    if (worker.depsgraph != nullptr) {
+      DEG_graph_free(worker.depsgraph);
+    }
+    worker.depsgraph = nullptr;
+    worker.scene_eval = nullptr;
+  }
 }
 
-static void seq_prefetch_init_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_update_depsgraph(PrefetchWorker *worker)
 {
-  Main *bmain = pfjob->bmain_eval;
-  Scene *scene = pfjob->scene;
-  ViewLayer *view_layer = BKE_view_layer_default_render(scene);
-
-  pfjob->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
-  DEG_debug_name_set(pfjob->depsgraph, "SEQUENCER PREFETCH");
-
-  /* Make sure there is a correct evaluated scene pointer. */
-  DEG_graph_build_for_render_pipeline(pfjob->depsgraph);
-
-  /* Update immediately so we have proper evaluated scene. */
-  seq_prefetch_update_depsgraph(pfjob);
-
-  pfjob->scene_eval = DEG_get_evaluated_scene(pfjob->depsgraph);
-  pfjob->scene_eval->ed->cache_flag = 0;
+  DEG_evaluate_on_framechange(worker->depsgraph, worker->cfra);
 }
 
 static void seq_prefetch_update_area(PrefetchJob *pfjob)
@@ -274,59 +296,47 @@ void SEQ_prefetch_stop(Scene *scene)
   }
 }
 
-static void seq_prefetch_update_context(const SeqRenderData *context)
+static void seq_prefetch_update_context(PrefetchJob *pfjob, const int worker_index)
 {
-  PrefetchJob *pfjob;
-  pfjob = seq_prefetch_job_get(context->scene);
+  PrefetchWorker *worker = &pfjob->workers[worker_index];
+  const SeqRenderData *context = &pfjob->context;
+  const eSeqTaskId task_id = eSeqTaskId(SEQ_TASK_PREFETCH_RENDER + worker_index);
 
   SEQ_render_new_render_data(pfjob->bmain_eval,
-                             pfjob->depsgraph,
-                             pfjob->scene_eval,
+                             worker->depsgraph,
+                             worker->scene_eval,
                              context->rectx,
                              context->recty,
                              context->preview_render_size,
                              false,
-                             &pfjob->context_cpy);
-  pfjob->context_cpy.is_prefetch_render = true;
-  pfjob->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
+                             &worker->context_cpy);
+  worker->context_cpy.is_prefetch_render = true;
+  worker->context_cpy.task_id = task_id;
 
   SEQ_render_new_render_data(pfjob->bmain,
-                             pfjob->depsgraph,
+                             worker->depsgraph,
                              pfjob->scene,
                              context->rectx,
                              context->recty,
                              context->preview_render_size,
                              false,
-                             &pfjob->context);
-  pfjob->context.is_prefetch_render = false;
+                             &worker->context);
+  worker->context.is_prefetch_render = false;
 
   /* Same ID as prefetch context, because context will be swapped, but we still
    * want to assign this ID to cache entries created in this thread.
-   * This is to allow "temp cache" work correctly for both threads.
+   * This is to allow "temp cache" work correctly for all threads.
    */
-  pfjob->context.task_id = SEQ_TASK_PREFETCH_RENDER;
-}
-
-static void seq_prefetch_update_scene(Scene *scene)
-{
-  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
-
-  if (!pfjob) {
-    return;
-  }
-
-  pfjob->scene = scene;
-  seq_prefetch_free_depsgraph(pfjob);
-  seq_prefetch_init_depsgraph(pfjob);
+  worker->context.task_id = task_id;
 }
 
-static void seq_prefetch_update_active_seqbase(PrefetchJob *pfjob)
+static void seq_prefetch_update_active_seqbase(PrefetchJob *pfjob, PrefetchWorker *worker)
 {
-  MetaStack *ms_orig = SEQ_meta_stack_active_get(SEQ_editing_get(pfjob->scene));
-  Editing *ed_eval = SEQ_editing_get(pfjob->scene_eval);
+  Scene *scene_eval = worker->scene_eval;
+  Editing *ed_eval = SEQ_editing_get(scene_eval);
 
-  if (ms_orig != nullptr) {
-    Sequence *meta_eval = seq_prefetch_get_original_sequence(ms_orig->parseq, pfjob->scene_eval);
+  if (pfjob->active_meta != nullptr) {
+    Sequence *meta_eval = seq_prefetch_get_original_sequence(pfjob->active_meta, scene_eval);
     SEQ_seqbase_active_set(ed_eval, &meta_eval->seqbase);
   }
   else {
@@ -334,6 +344,37 @@ static void seq_prefetch_update_active_seqbase(PrefetchJob *pfjob)
   }
 }
 
+/**
+ * Build the depsgraph of a worker when it is used for the first time. This runs in the prefetch
+ * job, building the depsgraphs of all workers when prefetching starts would block the UI.
+ */
+static void seq_prefetch_worker_init(PrefetchJob *pfjob, const int worker_index)
+{
+  PrefetchWorker *worker = &pfjob->workers[worker_index];
+  if (worker->depsgraph != nullptr) {
+    return;
+  }
+
+  Main *bmain = pfjob->bmain_eval;
+  Scene *scene = pfjob->scene;
+  ViewLayer *view_layer = BKE_view_layer_default_render(scene);
+
+  worker->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
+  DEG_debug_name_set(worker->depsgraph, "SEQUENCER PREFETCH");
+
+  /* Make sure there is a correct evaluated scene pointer. */
+  DEG_graph_build_for_render_pipeline(worker->depsgraph);
+
+  /* Update immediately so we have proper evaluated scene. */
+  seq_prefetch_update_depsgraph(worker);
+
+  worker->scene_eval = DEG_get_evaluated_scene(worker->depsgraph);
+  worker->scene_eval->ed->cache_flag = 0;
+
+  seq_prefetch_update_context(pfjob, worker_index);
+  seq_prefetch_update_active_seqbase(pfjob, worker);
+}
+
 static void seq_prefetch_resume(Scene *scene)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
@@ -362,12 +403,12 @@ void seq_prefetch_free(Scene *scene)
   scene->ed->prefetch_job = nullptr;
 }
 
-static bool seq_prefetch_seq_has_disk_cache(PrefetchJob *pfjob,
+static bool seq_prefetch_seq_has_disk_cache(PrefetchWorker *worker,
                                             Sequence *seq,
                                             bool can_have_final_image)
 {
-  SeqRenderData *ctx = &pfjob->context_cpy;
-  float cfra = seq_prefetch_cfra(pfjob);
+  SeqRenderData *ctx = &worker->context_cpy;
+  float cfra = worker->cfra;
 
   ImBuf *ibuf = seq_cache_get(ctx, seq, cfra, SEQ_CACHE_STORE_PREPROCESSED);
   if (ibuf != nullptr) {
@@ -394,28 +435,28 @@ static bool seq_prefetch_seq_has_disk_cache(PrefetchJob *pfjob,
   return false;
 }
 
-static bool seq_prefetch_scene_strip_is_rendered(PrefetchJob *pfjob,
+static bool seq_prefetch_scene_strip_is_rendered(PrefetchWorker *worker,
                                                  ListBase *channels,
                                                  ListBase *seqbase,
                                                  SeqCollection *scene_strips,
                                                  bool is_recursive_check)
 {
-  float cfra = seq_prefetch_cfra(pfjob);
+  float cfra = worker->cfra;
   Sequence *seq_arr[MAXSEQ + 1];
-  int count = seq_get_shown_sequences(pfjob->scene_eval, channels, seqbase, cfra, 0, seq_arr);
+  int count = seq_get_shown_sequences(worker->scene_eval, channels, seqbase, cfra, 0, seq_arr);
 
   /* Iterate over rendered strips. */
   for (int i = 0; i < count; i++) {
     Sequence *seq = seq_arr[i];
     if (seq->type == SEQ_TYPE_META &&
-        seq_prefetch_scene_strip_is_rendered(pfjob, channels, &seq->seqbase, scene_strips, true))
+        seq_prefetch_scene_strip_is_rendered(worker, channels, &seq->seqbase, scene_strips, true))
     {
       return true;
     }
 
     /* Disable prefetching 3D scene strips, but check for disk cache. */
     if (seq->type == SEQ_TYPE_SCENE && (seq->flag & SEQ_SCENE_STRIPS) == 0 &&
-        !seq_prefetch_seq_has_disk_cache(pfjob, seq, !is_recursive_check))
+        !seq_prefetch_seq_has_disk_cache(worker, seq, !is_recursive_check))
     {
       return true;
     }
@@ -444,10 +485,12 @@ static SeqCollection *query_scene_strips(ListBase *seqbase)
 
 /* Prefetch must avoid rendering scene strips, because rendering in background locks UI and can
  * make it unresponsive for long time periods. */
-static bool seq_prefetch_must_skip_frame(PrefetchJob *pfjob, ListBase *channels, ListBase *seqbase)
+static bool seq_prefetch_must_skip_frame(PrefetchWorker *worker,
+                                         ListBase *channels,
+                                         ListBase *seqbase)
 {
   SeqCollection *scene_strips = query_scene_strips(seqbase);
-  if (seq_prefetch_scene_strip_is_rendered(pfjob, channels, seqbase, scene_strips, false)) {
+  if (seq_prefetch_scene_strip_is_rendered(worker, channels, seqbase, scene_strips, false)) {
     SEQ_collection_free(scene_strips);
     return true;
   }
@@ -475,37 +518,81 @@ static void seq_prefetch_do_suspend(PrefetchJob *pfjob)
   BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
 }
 
+/* Evaluate scene copy of worker for its frame and check whether the frame can be prefetched. */
+static void seq_prefetch_worker_evaluate(PrefetchJob *pfjob, PrefetchWorker *worker)
+{
+  worker->scene_eval->ed->prefetch_job = nullptr;
+
+  seq_prefetch_update_depsgraph(worker);
+  AnimData *adt = BKE_animdata_from_id(&worker->context_cpy.scene->id);
+  AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(worker);
+  BKE_animsys_evaluate_animdata(
+      &worker->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
+
+  /* This is quite hacky solution:
+   * We need cross-reference original scene with copy for cache.
+   * However depsgraph must not have this data, because it will try to kill this job.
+   * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
+   * Set to nullptr before return!
+   */
+  worker->scene_eval->ed->prefetch_job = pfjob;
+
+  ListBase *seqbase = SEQ_active_seqbase_get(SEQ_editing_get(worker->scene_eval));
+  ListBase *channels = SEQ_channels_displayed_get(SEQ_editing_get(worker->scene_eval));
+  worker->skip_frame = seq_prefetch_must_skip_frame(worker, channels, seqbase);
+}
+
+static void seq_prefetch_worker_render(PrefetchJob *pfjob, PrefetchWorker *worker)
+{
+  if (worker->skip_frame) {
+    return;
+  }
+
+  ImBuf *ibuf = SEQ_render_give_ibuf(&worker->context_cpy, worker->cfra, 0);
+  seq_cache_free_temp_cache(pfjob->scene, worker->context.task_id, worker->cfra);
+  IMB_freeImBuf(ibuf);
+}
+
 static void *seq_prefetch_frames(void *job)
 {
   PrefetchJob *pfjob = (PrefetchJob *)job;
 
+  if (pfjob->depsgraphs_outdated) {
+    seq_prefetch_free_depsgraph(pfjob);
+    pfjob->depsgraphs_outdated = false;
+  }
+
   while (seq_prefetch_cfra(pfjob) <= pfjob->scene->r.efra) {
-    pfjob->scene_eval->ed->prefetch_job = nullptr;
-
-    seq_prefetch_update_depsgraph(pfjob);
-    AnimData *adt = BKE_animdata_from_id(&pfjob->context_cpy.scene->id);
-    AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(pfjob);
-    BKE_animsys_evaluate_animdata(
-        &pfjob->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
-
-    /* This is quite hacky solution:
-     * We need cross-reference original scene with copy for cache.
-     * However depsgraph must not have this data, because it will try to kill this job.
-     * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
-     * Set to nullptr before return!
-     */
-    pfjob->scene_eval->ed->prefetch_job = pfjob;
+    /* Claim batch of consecutive frames, one per worker. Depsgraph evaluation is cheap compared
+     * to rendering, so it is done here and only rendering runs in parallel. */
+    int num_frames = 0;
+    bool skip_batch = true;
+    for (; num_frames < pfjob->num_workers; num_frames++) {
+      const float cfra = seq_prefetch_cfra(pfjob) + num_frames;
+      if (cfra > pfjob->scene->r.efra) {
+        break;
+      }
+      PrefetchWorker *worker = &pfjob->workers[num_frames];
+      worker->cfra = cfra;
+      seq_prefetch_worker_init(pfjob, num_frames);
+      seq_prefetch_worker_evaluate(pfjob, worker);
+      skip_batch &= worker->skip_frame;
+    }
 
-    ListBase *seqbase = SEQ_active_seqbase_get(SEQ_editing_get(pfjob->scene_eval));
-    ListBase *channels = SEQ_channels_displayed_get(SEQ_editing_get(pfjob->scene_eval));
-    if (seq_prefetch_must_skip_frame(pfjob, channels, seqbase)) {
-      pfjob->num_frames_prefetched++;
+    if (skip_batch) {
+      pfjob->num_frames_prefetched += num_frames;
       continue;
     }
 
-    ImBuf *ibuf = SEQ_render_give_ibuf(&pfjob->context_cpy, seq_prefetch_cfra(pfjob), 0);
-    seq_cache_free_temp_cache(pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
-    IMB_freeImBuf(ibuf);
+    blender::threading::parallel_for(
+        blender::IndexRange(num_frames), 1, [&](const blender::IndexRange range) {
+          for (const int i : range) {
+            seq_prefetch_worker_render(pfjob, &pfjob->workers[i]);
+          }
+        });
+
+    /* Continue from last frame of the batch. */
+    pfjob->num_frames_prefetched += num_frames - 1;
 
     /* Suspend thread if there is nothing to be prefetched. */
     seq_prefetch_do_suspend(pfjob);
@@ -524,9 +611,16 @@ static void *seq_prefetch_frames(void *job)
     pfjob->num_frames_prefetched++;
   }
 
-  seq_cache_free_temp_cache(pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    PrefetchWorker *worker = &pfjob->workers[i];
+    if (worker->scene_eval == nullptr) {
+      /* Not used before the job ended. */
+      continue;
+    }
+    seq_cache_free_temp_cache(pfjob->scene, worker->context.task_id, seq_prefetch_cfra(pfjob));
+    worker->scene_eval->ed->prefetch_job = nullptr;
+  }
   pfjob->running = false;
-  pfjob->scene_eval->ed->prefetch_job = nullptr;
 
   return nullptr;
 }
@@ -545,11 +639,16 @@ static PrefetchJob *seq_prefetch_start_ex(const SeqRenderData *context, float cf
       BLI_condition_init(&pfjob->prefetch_suspend_cond);
 
       pfjob->bmain_eval = BKE_main_new();
-      pfjob->scene = context->scene;
-      seq_prefetch_init_depsgraph(pfjob);
     }
   }
   pfjob->bmain = context->bmain;
+  pfjob->scene = context->scene;
+  pfjob->context = *context;
+  pfjob->num_workers = seq_prefetch_num_workers_get(context->scene->ed);
+  MetaStack *ms_orig = SEQ_meta_stack_active_get(SEQ_editing_get(context->scene));
+  pfjob->active_meta = ms_orig ? ms_orig->parseq : nullptr;
+  /* The depsgraphs are rebuilt by the job, so that starting it does not block the UI. */
+  pfjob->depsgraphs_outdated = true;
 
   pfjob->cfra = cfra;
   pfjob->num_frames_prefetched = 1;
@@ -558,10 +657,6 @@ static PrefetchJob *seq_prefetch_start_ex(const SeqRenderData *context, float cf
   pfjob->stop = false;
   pfjob->running = true;
 
-  seq_prefetch_update_scene(context->scene);
-  seq_prefetch_update_context(context);
-  seq_prefetch_update_active_seqbase(pfjob);
-
   BLI_threadpool_remove(&pfjob->threads, pfjob);
   BLI_threadpool_insert(&pfjob->threads, pfjob);
 
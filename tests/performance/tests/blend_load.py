@@ -13,10 +13,15 @@ def _run(filepath):
     bpy.ops.wm.open_mainfile(filepath=filepath)
     bpy.ops.wm.read_homefile(use_empty=True, use_factory_startup=True)
 
-    # Measure loading the second time
-    start_time = time.time()
-    bpy.ops.wm.open_mainfile(filepath=filepath)
-    elapsed_time = time.time() - start_time
+    # Measure loading a few more times, taking the fastest to reduce noise
+    # from other processes on large production files.
+    num_iterations = 3
+    elapsed_time = float('inf')
+    for _ in range(num_iterations):
+        start_time = time.time()
+        bpy.ops.wm.open_mainfile(filepath=filepath)
+        elapsed_time = min(elapsed_time, time.time() - start_time)
+        bpy.ops.wm.read_homefile(use_empty=True, use_factory_startup=True)
 
     result = {'time': elapsed_time}
     return result
@@ -0,0 +1,111 @@
+# SPDX-FileCopyrightText: 2023 Blender Foundation
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+
+LOG_KEY = "SEQUENCER_PERFORMANCE_OUTPUT: "
+
+
+def _run(args):
+    import bpy
+    import time
+
+    num_channels = args['num_channels']
+    blend_type = args['blend_type']
+    use_float = args['use_float']
+
+    # Build a 4K timeline with overlapping strips, blended over each other.
+    scene = bpy.context.scene
+    scene.render.resolution_x = 3840
+    scene.render.resolution_y = 2160
+    scene.render.resolution_percentage = 100
+    scene.frame_start = 1
+    scene.frame_end = 100
+
+    ed = scene.sequence_editor_create()
+    for channel in range(1, num_channels + 1):
+        strip = ed.sequences.new_effect(
+            name="Color {}".format(channel),
+            type='COLOR',
+            channel=channel,
+            frame_start=scene.frame_start,
+            frame_end=scene.frame_end + 1)
+        strip.color = (channel / num_channels, 0.5, 1.0 - channel / num_channels)
+        strip.use_float = use_float
+        if channel > 1:
+            strip.blend_type = blend_type
+            strip.blend_alpha = 0.5
+
+    def play_back(window):
+        # Render the sequencer the same way as viewport playback does. Unlike a regular render,
+        # this does not clear the cache before every frame.
+        with bpy.context.temp_override(window=window):
+            for frame in range(scene.frame_start, scene.frame_end + 1):
+                scene.frame_set(frame)
+                bpy.ops.render.opengl(sequencer=True)
+
+    def measure():
+        window = bpy.context.window_manager.windows[0]
+        num_frames = scene.frame_end + 1 - scene.frame_start
+
+        # Play back the timeline twice: first filling the cache, then reading from it.
+        result = {}
+        for pass_name in ('time', 'time_cached'):
+            hits, misses, evictions = ed.cache_hits, ed.cache_misses, ed.cache_evictions
+            start_time = time.perf_counter()
+            play_back(window)
+            result[pass_name] = (time.perf_counter() - start_time) / num_frames
+
+        # Cache statistics of the second pass, which should only read from the cache.
+        result['cache_hits'] = ed.cache_hits - hits
+        result['cache_misses'] = ed.cache_misses - misses
+        result['cache_evictions'] = ed.cache_evictions - evictions
+
+        print(f"{LOG_KEY}{result}")
+        bpy.ops.wm.quit_blender()
+
+    # OpenGL rendering needs a window, which only exists once the event loop runs.
+    bpy.app.timers.register(measure, first_interval=0.0)
+
+
+class SequencerTest(api.Test):
+    def __init__(self, num_channels, blend_type='ALPHA_OVER', use_float=False):
+        self.num_channels = num_channels
+        self.blend_type = blend_type
+        self.use_float = use_float
+
+    def name(self):
+        if self.blend_type == 'ALPHA_OVER' and not self.use_float:
+            return "4k_{}_strips".format(self.num_channels)
+        return "4k_{}_strips_{}_{}".format(
+            self.num_channels, self.blend_type.lower(), "float" if self.use_float else "byte")
+
+    def category(self):
+        return "sequencer"
+
+    def run(self, env, device_id):
+        args = {
+            'num_channels': self.num_channels,
+            'blend_type': self.blend_type,
+            'use_float': self.use_float,
+        }
+        _, log = env.run_in_blender(_run, args, foreground=True)
+        for line in log:
+            if line.startswith(LOG_KEY):
+                return eval(line[len(LOG_KEY):])
+
+        raise Exception("No sequencer performance result found in log.")
+
+
+def generate(env):
+    tests = [SequencerTest(num_channels) for num_channels in (1, 4, 16)]
+
+    # Cost of individual blend effects, for byte and float images.
+    for blend_type in ('ALPHA_OVER', 'CROSS', 'GAMMA_CROSS', 'ADD', 'SUBTRACT', 'MULTIPLY'):
+        for use_float in (False, True):
+            if blend_type == 'ALPHA_OVER' and not use_float:
+                continue
+            tests.append(SequencerTest(4, blend_type, use_float))
+
+    return tests